@@ -5,15 +5,19 @@
 #include <pluginlib/class_loader.h>
 #include <aerial_robot_control/control/base/base.h>
 #include <aerial_robot_control/flight_navigation.h>
+#include <aerial_robot_control/telemetry/recorder.h>
 #include <aerial_robot_estimation/state_estimation.h>
 #include <aerial_robot_model/model/aerial_robot_model_ros.h>
+#include <aerial_robot_model/utils/callback_scheduler.h>
 
 using namespace std;
 
 class AerialRobotBase
 {
  public:
-  AerialRobotBase(ros::NodeHandle nh, ros::NodeHandle nh_private);
+  /* spin_callbacks: service the subscribers, services and timers of the plugins with the own spinner,
+     false if they are already serviced by the threads of a nodelet manager */
+  AerialRobotBase(ros::NodeHandle nh, ros::NodeHandle nh_private, bool spin_callbacks = true);
   ~AerialRobotBase();
 
   void mainFunc(const ros::TimerEvent & e);
@@ -23,6 +27,8 @@ class AerialRobotBase
   ros::NodeHandle nhp_;
   ros::Timer main_timer_;
 
+  // declared first to keep the queues alive until all plugins are destroyed
+  boost::shared_ptr<aerial_robot_model::CallbackScheduler> callback_scheduler_;
   boost::shared_ptr<aerial_robot_model::RobotModelRos> robot_model_ros_;
   boost::shared_ptr<aerial_robot_estimation::StateEstimator>  estimator_;
 
@@ -32,6 +38,14 @@ class AerialRobotBase
   pluginlib::ClassLoader<aerial_robot_control::ControlBase> controller_loader_;
   boost::shared_ptr<aerial_robot_control::ControlBase> controller_;
 
+  // telemetry of estimator, navigator, controller and robot model at the main rate
+  boost::shared_ptr<aerial_robot_control::telemetry::Recorder> telemetry_recorder_;
+  int cog_telemetry_channel_, baselink_telemetry_channel_, target_telemetry_channel_, model_telemetry_channel_, overhead_telemetry_channel_;
+  double telemetry_overhead_; // [sec] of recordTelemetry() in the previous loop
+  double telemetry_overhead_limit_;
+  void initTelemetry(double main_rate);
+  void recordTelemetry();
+
   ros::AsyncSpinner callback_spinner_; // Use 4 threads
   ros::AsyncSpinner main_loop_spinner_; // Use 1 threads
   ros::CallbackQueue main_loop_queue_;
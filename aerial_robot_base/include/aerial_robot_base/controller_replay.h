@@ -0,0 +1,129 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <pluginlib/class_loader.h>
+#include <aerial_robot_control/control/base/base.h>
+#include <aerial_robot_control/flight_navigation.h>
+#include <aerial_robot_estimation/state_estimation.h>
+#include <aerial_robot_model/model/aerial_robot_model_ros.h>
+#include <sensor_msgs/JointState.h>
+#include <spinal/FourAxisCommand.h>
+#include <spinal/RollPitchYawTerms.h>
+
+namespace aerial_robot_base
+{
+  /* input of one control tick */
+  struct ReplayInput
+  {
+    double stamp;
+    tf::Vector3 cog_pos, cog_vel, cog_euler, cog_omega;
+    tf::Vector3 baselink_pos, baselink_vel, baselink_euler, baselink_omega;
+    tf::Vector3 target_pos, target_vel, target_acc, target_rpy, target_omega, target_ang_acc;
+    uint8_t navi_state;
+    uint8_t xy_control_mode;
+    sensor_msgs::JointState joint_state; // empty: keep the previous joint angles
+  };
+
+  /* compute time of controller update() [sec] */
+  struct ReplayTiming
+  {
+    int ticks = 0;
+    double mean = 0;
+    double max = 0;
+    double p99 = 0;
+  };
+
+  /*
+    closed-loop replay of a controller plugin with the simulated time:
+    - the robot model, estimator, navigator and controller plugins are loaded from the same rosparams as AerialRobotBase,
+      and the controller runs with "controller/replay" to do the work of its background threads in update()
+    - each tick sets the estimated states, the navigation target and the joint angles, calls update() of the controller,
+      and flattens the published commands (four_axes/command, rpy/gain, gimbals_ctrl) into a text trace
+    - the global callback queue is never spun, so the plugins only see the replayed inputs
+  */
+  class ControllerReplay
+  {
+  public:
+    ControllerReplay(ros::NodeHandle nh, ros::NodeHandle nhp);
+    ~ControllerReplay();
+
+    bool initialized() const { return controller_ != nullptr; }
+
+    /* sinusoidal motion around a hovering target from ~scenario params */
+    bool synthesizeInputs(std::vector<ReplayInput>& inputs);
+    /* control loop inputs recorded by the telemetry of AerialRobotBase */
+    bool loadTelemetry(const std::string& path, std::vector<ReplayInput>& inputs);
+
+    /* one trace line per output message: "<tick> <topic> <values>" */
+    bool run(const std::vector<ReplayInput>& inputs, std::vector<std::string>& trace);
+    const ReplayTiming& getTiming() const { return timing_; }
+
+    static bool writeTrace(const std::string& path, const std::vector<std::string>& trace);
+    static bool readTrace(const std::string& path, std::vector<std::string>& trace);
+    /* bit-exact if tolerance is zero, otherwise absolute tolerance on each value */
+    static bool compareTraces(const std::vector<std::string>& golden, const std::vector<std::string>& trace,
+                              double tolerance, std::string& error);
+
+  private:
+    ros::NodeHandle nh_;
+    ros::NodeHandle nhp_;
+
+    boost::shared_ptr<aerial_robot_model::RobotModelRos> robot_model_ros_;
+    boost::shared_ptr<aerial_robot_estimation::StateEstimator> estimator_;
+    pluginlib::ClassLoader<aerial_robot_navigation::BaseNavigator> navigator_loader_;
+    boost::shared_ptr<aerial_robot_navigation::BaseNavigator> navigator_;
+    pluginlib::ClassLoader<aerial_robot_control::ControlBase> controller_loader_;
+    boost::shared_ptr<aerial_robot_control::ControlBase> controller_;
+
+    // outputs of the controller, delivered intra-process to this queue
+    ros::CallbackQueue output_queue_;
+    std::vector<ros::Subscriber> output_subs_;
+    std::vector<std::string> tick_trace_;
+    int tick_;
+
+    double main_rate_;
+    ReplayTiming timing_;
+
+    void setInput(const ReplayInput& input);
+    void fourAxisCommandCallback(const spinal::FourAxisCommandConstPtr& msg);
+    void rpyGainCallback(const spinal::RollPitchYawTermsConstPtr& msg);
+    void gimbalControlCallback(const sensor_msgs::JointStateConstPtr& msg);
+    void addTrace(const std::string& topic, const std::vector<double>& values);
+  };
+};
@@ -1,6 +1,8 @@
 #include <aerial_robot_base/aerial_robot_base.h>
+#include <array>
+#include <ctime>
 
-AerialRobotBase::AerialRobotBase(ros::NodeHandle nh, ros::NodeHandle nh_private)
+AerialRobotBase::AerialRobotBase(ros::NodeHandle nh, ros::NodeHandle nh_private, bool spin_callbacks)
   : nh_(nh), nhp_(nh_private), callback_spinner_(4), main_loop_spinner_(1, &main_loop_queue_),
     controller_loader_("aerial_robot_control", "aerial_robot_control::ControlBase"),
     navigator_loader_("aerial_robot_control", "aerial_robot_navigation::BaseNavigator")
@@ -12,6 +14,11 @@ AerialRobotBase::AerialRobotBase(ros::NodeHandle nh, ros::NodeHandle nh_private)
   double main_rate;
   nhp_.param ("main_rate", main_rate, 0.0);
 
+  // callback groups: dedicated queues and threads for sensor, model, command and diagnostics callbacks of the plugins, opt-in
+  bool callback_groups;
+  nhp_.param ("callback_groups/enable", callback_groups, false);
+  if(callback_groups) callback_scheduler_ = boost::make_shared<aerial_robot_model::CallbackScheduler>(nh_, nhp_);
+
   // robot model
   robot_model_ros_ = boost::make_shared<aerial_robot_model::RobotModelRos>(nh_, nhp_);
   auto robot_model = robot_model_ros_->getRobotModel();
@@ -53,6 +60,9 @@ AerialRobotBase::AerialRobotBase(ros::NodeHandle nh, ros::NodeHandle nh_private)
       ROS_ERROR("The plugin failed to load for some reason. Error: %s", ex.what());
     }
 
+  // telemetry
+  initTelemetry(main_rate);
+
   if(param_verbose) cout << nhp_.getNamespace() << ": main_rate is " << main_rate << endl;
   if(main_rate <= 0)
     ROS_ERROR_STREAM("mian rate is negative, can not run the main timer");
@@ -69,10 +79,11 @@ AerialRobotBase::AerialRobotBase(ros::NodeHandle nh, ros::NodeHandle nh_private)
 
 
   // note2: callback_spinner_ calls following items with 4 threads
-  //  - all subscribers (joint state for robot model, sensor for state estimation, uav/nav for navigation)
+  //  - subscribers, timers and service servers not assigned to a callback group of callback_scheduler_
   //  - statePublish timer in state estimator for publish odometry and tf
-  //  - service server
-  callback_spinner_.start();
+  //  - all subscribers (joint state for robot model, sensor for state estimation, uav/nav for navigation) if callback groups are disabled
+  // note3: in a nodelet manager, these are called by the worker threads of the manager instead
+  if(spin_callbacks) callback_spinner_.start();
 
 }
 
@@ -83,10 +94,166 @@ AerialRobotBase::~AerialRobotBase()
   // what():  boost: mutex lock failed in pthread_mutex_lock: Invalid argument
   main_timer_.stop();
   main_loop_spinner_.stop();
+  if(telemetry_recorder_) telemetry_recorder_->close();
+  if(callback_scheduler_) callback_scheduler_->stop();
 }
 
 void AerialRobotBase::mainFunc(const ros::TimerEvent & e)
 {
+  // one model update per control loop from the joint states received since the last loop, applied in the model update thread
+  if(robot_model_ros_->getUpdateMode() == aerial_robot_model::model_update::COALESCE) robot_model_ros_->requestUpdate();
+
   navigator_->update();
   controller_->update();
+
+  if(telemetry_recorder_) recordTelemetry();
+}
+
+void AerialRobotBase::initTelemetry(double main_rate)
+{
+  ros::NodeHandle telemetry_nh(nhp_, "telemetry");
+  bool enable;
+  telemetry_nh.param("enable", enable, false);
+  if(!enable || !controller_) return;
+
+  std::string directory;
+  std::string default_directory = getenv("ROS_HOME") ? std::string(getenv("ROS_HOME")) : std::string(getenv("HOME") ? getenv("HOME") : "/tmp") + "/.ros";
+  telemetry_nh.param("directory", directory, default_directory);
+  int buffer_size;
+  telemetry_nh.param("buffer_size", buffer_size, 4096);
+  // ratio to the main loop period
+  double overhead_limit_rate;
+  telemetry_nh.param("overhead_limit_rate", overhead_limit_rate, 0.05);
+  telemetry_overhead_limit_ = main_rate > 0 ? overhead_limit_rate / main_rate : 0;
+
+  telemetry_recorder_ = boost::make_shared<aerial_robot_control::telemetry::Recorder>(buffer_size);
+
+  auto axis_fields = [](const std::vector<std::string>& names)
+    {
+      std::vector<std::string> fields;
+      for(const auto& name: names)
+        for(const auto axis: {"x", "y", "z"}) fields.push_back(name + "/" + axis);
+      return fields;
+    };
+  auto rpy_fields = [](const std::string& name)
+    {
+      return std::vector<std::string>{name + "/roll", name + "/pitch", name + "/yaw"};
+    };
+
+  std::vector<std::string> state_fields = axis_fields({"pos", "vel"});
+  for(const auto& name: {"euler", "omega"})
+    {
+      auto fields = rpy_fields(name);
+      state_fields.insert(state_fields.end(), fields.begin(), fields.end());
+    }
+  cog_telemetry_channel_ = telemetry_recorder_->addChannel("estimator/cog", state_fields);
+  baselink_telemetry_channel_ = telemetry_recorder_->addChannel("estimator/baselink", state_fields);
+
+  std::vector<std::string> target_fields = axis_fields({"pos", "vel", "acc"});
+  for(const auto& name: {"rpy", "omega", "ang_acc"})
+    {
+      auto fields = rpy_fields(name);
+      target_fields.insert(target_fields.end(), fields.begin(), fields.end());
+    }
+  target_fields.push_back("navi_state");
+  target_fields.push_back("xy_control_mode");
+  target_telemetry_channel_ = telemetry_recorder_->addChannel("navigator/target", target_fields);
+
+  auto robot_model = robot_model_ros_->getRobotModel();
+  std::vector<std::string> model_fields = {"revision", "mass", "cog/x", "cog/y", "cog/z"};
+  for(const auto& name: robot_model->getJointNames())
+    {
+      if(model_fields.size() == aerial_robot_control::telemetry::MAX_FIELDS) break;
+      model_fields.push_back("joint/" + name);
+    }
+  model_telemetry_channel_ = telemetry_recorder_->addChannel("model", model_fields);
+
+  overhead_telemetry_channel_ = telemetry_recorder_->addChannel("telemetry", {"overhead", "max_record_time", "mean_record_time", "recorded", "dropped", "written"});
+
+  controller_->addTelemetryChannels(*telemetry_recorder_);
+
+  char stamp[32];
+  time_t now = time(nullptr);
+  strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+  std::string path = directory + "/aerial_robot_telemetry_" + std::string(stamp) + ".artl";
+  if(telemetry_recorder_->open(path))
+    ROS_INFO_STREAM("record telemetry to " << path);
+  else
+    {
+      ROS_ERROR_STREAM("can not open the telemetry log " << path);
+      telemetry_recorder_.reset();
+    }
+
+  telemetry_overhead_ = 0;
+}
+
+void AerialRobotBase::recordTelemetry()
+{
+  ros::WallTime start = ros::WallTime::now();
+  double stamp = ros::Time::now().toSec();
+
+  // fixed-size buffer, no allocation in the main loop
+  std::array<double, aerial_robot_control::telemetry::MAX_FIELDS> values;
+  auto fill = [&values](size_t& n, const tf::Vector3& v)
+    {
+      values[n++] = v.x();
+      values[n++] = v.y();
+      values[n++] = v.z();
+    };
+
+  int estimate_mode = estimator_->getEstimateMode();
+  for(const auto frame: {Frame::COG, Frame::BASELINK})
+    {
+      size_t n = 0;
+      fill(n, estimator_->getPos(frame, estimate_mode));
+      fill(n, estimator_->getVel(frame, estimate_mode));
+      fill(n, estimator_->getEuler(frame, estimate_mode));
+      fill(n, estimator_->getAngularVel(frame, estimate_mode));
+      telemetry_recorder_->record(frame == Frame::COG ? cog_telemetry_channel_ : baselink_telemetry_channel_, stamp, values.data(), n);
+    }
+
+  // one lock-free snapshot, consistent with the setpoint used by the controller in this tick
+  const aerial_robot_navigation::TargetSetpoint setpoint = navigator_->getTargetSetpoint();
+  size_t n = 0;
+  fill(n, setpoint.pos);
+  fill(n, setpoint.vel);
+  fill(n, setpoint.acc);
+  fill(n, setpoint.rpy);
+  fill(n, setpoint.omega);
+  fill(n, setpoint.ang_acc);
+  values[n++] = navigator_->getNaviState();
+  values[n++] = navigator_->getXyControlMode();
+  telemetry_recorder_->record(target_telemetry_channel_, stamp, values.data(), n);
+
+  // the model may be updated in the model update thread, read its last published state instead of the model itself
+  const auto snapshot = robot_model_ros_->getSnapshot();
+  if(snapshot)
+    {
+      auto robot_model = robot_model_ros_->getRobotModel();
+      const KDL::JntArray& joint_positions = snapshot->joint_positions;
+      const auto& joint_index_map = robot_model->getJointIndexMap();
+      n = 0;
+      values[n++] = snapshot->revision;
+      values[n++] = snapshot->mass;
+      for(int i = 0; i < 3; i++) values[n++] = snapshot->cog.p(i);
+      for(const auto& name: robot_model->getJointNames())
+        {
+          if(n == values.size()) break;
+          auto it = joint_index_map.find(name);
+          values[n++] = (it != joint_index_map.end() && it->second < joint_positions.rows()) ? joint_positions(it->second) : 0;
+        }
+      telemetry_recorder_->record(model_telemetry_channel_, stamp, values.data(), n);
+    }
+
+  controller_->recordTelemetry(*telemetry_recorder_, stamp);
+
+  // overhead of the previous loop, the current one is measured after this record
+  aerial_robot_control::telemetry::RecorderStats stats = telemetry_recorder_->getStats();
+  const double overhead[] = {telemetry_overhead_, stats.max_record_time, stats.mean_record_time,
+                             (double)stats.recorded, (double)stats.dropped, (double)stats.written};
+  telemetry_recorder_->record(overhead_telemetry_channel_, stamp, overhead, 6);
+
+  telemetry_overhead_ = (ros::WallTime::now() - start).toSec();
+  if(telemetry_overhead_limit_ > 0 && telemetry_overhead_ > telemetry_overhead_limit_)
+    ROS_WARN_THROTTLE(1.0, "telemetry takes %f ms in the main loop, exceeds %f ms", telemetry_overhead_ * 1000, telemetry_overhead_limit_ * 1000);
 }
@@ -0,0 +1,445 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <aerial_robot_base/controller_replay.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace aerial_robot_base;
+
+ControllerReplay::ControllerReplay(ros::NodeHandle nh, ros::NodeHandle nhp)
+  : nh_(nh), nhp_(nhp),
+    navigator_loader_("aerial_robot_control", "aerial_robot_navigation::BaseNavigator"),
+    controller_loader_("aerial_robot_control", "aerial_robot_control::ControlBase"),
+    tick_(0)
+{
+  nhp_.param ("main_rate", main_rate_, 40.0);
+
+  // the background threads of the controllers are replaced by the work in update()
+  nh_.setParam("controller/replay", true);
+
+  // robot model
+  robot_model_ros_ = boost::make_shared<aerial_robot_model::RobotModelRos>(nh_, nhp_);
+  auto robot_model = robot_model_ros_->getRobotModel();
+
+  // estimator, including the sensor plugins which are casted by some controllers
+  estimator_ = boost::make_shared<aerial_robot_estimation::StateEstimator>();
+  estimator_->initialize(nh_, nhp_, robot_model);
+
+  // navigation
+  std::string navi_plugin_name;
+  if(nh_.getParam("flight_navigation_plugin_name", navi_plugin_name))
+    {
+      try
+        {
+          navigator_ = navigator_loader_.createInstance(navi_plugin_name);
+        }
+      catch(pluginlib::PluginlibException& ex)
+        {
+          ROS_ERROR("The plugin failed to load for some reason. Error: %s", ex.what());
+          return;
+        }
+    }
+  else
+    {
+      navigator_ = boost::make_shared<aerial_robot_navigation::BaseNavigator>();
+    }
+  navigator_->initialize(nh_, nhp_, robot_model, estimator_, 1 / main_rate_);
+
+  // outputs, subscribed before the controller advertises them
+  ros::SubscribeOptions ops;
+  std::vector<std::string> outputs;
+  nhp_.param("outputs", outputs, std::vector<std::string>{"four_axes/command", "rpy/gain", "gimbals_ctrl"});
+  for(const auto& topic: outputs)
+    {
+      if(topic == "four_axes/command")
+        ops.init<spinal::FourAxisCommand>(topic, 100, boost::bind(&ControllerReplay::fourAxisCommandCallback, this, _1));
+      else if(topic == "rpy/gain")
+        ops.init<spinal::RollPitchYawTerms>(topic, 100, boost::bind(&ControllerReplay::rpyGainCallback, this, _1));
+      else if(topic == "gimbals_ctrl")
+        ops.init<sensor_msgs::JointState>(topic, 100, boost::bind(&ControllerReplay::gimbalControlCallback, this, _1));
+      else
+        {
+          ROS_ERROR_STREAM("controller replay: unsupported output topic " << topic);
+          continue;
+        }
+      ops.callback_queue = &output_queue_;
+      output_subs_.push_back(nh_.subscribe(ops));
+    }
+
+  // controller
+  try
+    {
+      std::string aerial_robot_control_name;
+      nh_.param ("aerial_robot_control_name", aerial_robot_control_name, std::string("aerial_robot_control/flatness_pid"));
+      controller_ = controller_loader_.createInstance(aerial_robot_control_name);
+      controller_->initialize(nh_, nhp_, robot_model, estimator_, navigator_, 1 / main_rate_);
+    }
+  catch(pluginlib::PluginlibException& ex)
+    {
+      ROS_ERROR("The plugin failed to load for some reason. Error: %s", ex.what());
+      controller_.reset();
+    }
+}
+
+ControllerReplay::~ControllerReplay()
+{
+  // the plugins are destroyed before their class loaders
+  controller_.reset();
+  navigator_.reset();
+}
+
+bool ControllerReplay::synthesizeInputs(std::vector<ReplayInput>& inputs)
+{
+  ros::NodeHandle scenario_nh(nhp_, "scenario");
+  double start_time, duration, frequency, joint_amplitude, joint_frequency;
+  std::vector<double> target_pos, amplitude, joint_positions;
+  std::vector<std::string> joint_names;
+  scenario_nh.param("start_time", start_time, 1.0); // zero time is invalid in ros
+  scenario_nh.param("duration", duration, 10.0);
+  scenario_nh.param("frequency", frequency, 0.5);
+  scenario_nh.param("target_pos", target_pos, std::vector<double>{0, 0, 1.0});
+  scenario_nh.param("amplitude", amplitude, std::vector<double>{0.02, 0.02, 0.02, 0.02, 0.02, 0.05}); // x, y, z, roll, pitch, yaw
+  scenario_nh.param("joint_names", joint_names, std::vector<std::string>());
+  scenario_nh.param("joint_positions", joint_positions, std::vector<double>());
+  scenario_nh.param("joint_amplitude", joint_amplitude, 0.0);
+  scenario_nh.param("joint_frequency", joint_frequency, 0.1);
+
+  if(target_pos.size() != 3 || amplitude.size() != 6 || joint_names.size() != joint_positions.size())
+    {
+      ROS_ERROR("controller replay: invalid scenario, target_pos: 3, amplitude: 6, joint_positions: same size as joint_names");
+      return false;
+    }
+
+  const double omega = 2 * M_PI * frequency;
+  const double joint_omega = 2 * M_PI * joint_frequency;
+  const int ticks = std::lround(duration * main_rate_);
+  inputs.resize(ticks);
+  for(int i = 0; i < ticks; i++)
+    {
+      ReplayInput& input = inputs.at(i);
+      const double t = i / main_rate_;
+      input.stamp = start_time + t;
+
+      // each axis with a different phase
+      double value[6], rate[6];
+      for(int j = 0; j < 6; j++)
+        {
+          value[j] = amplitude.at(j) * std::sin(omega * t + j * M_PI / 3);
+          rate[j] = amplitude.at(j) * omega * std::cos(omega * t + j * M_PI / 3);
+        }
+
+      input.target_pos.setValue(target_pos.at(0), target_pos.at(1), target_pos.at(2));
+      input.target_vel.setZero();
+      input.target_acc.setZero();
+      input.target_rpy.setZero();
+      input.target_omega.setZero();
+      input.target_ang_acc.setZero();
+
+      input.cog_pos = input.target_pos + tf::Vector3(value[0], value[1], value[2]);
+      input.cog_vel.setValue(rate[0], rate[1], rate[2]);
+      input.cog_euler.setValue(value[3], value[4], value[5]);
+      input.cog_omega.setValue(rate[3], rate[4], rate[5]);
+      input.baselink_pos = input.cog_pos;
+      input.baselink_vel = input.cog_vel;
+      input.baselink_euler = input.cog_euler;
+      input.baselink_omega = input.cog_omega;
+
+      input.navi_state = i == 0 ? aerial_robot_navigation::TAKEOFF_STATE : aerial_robot_navigation::HOVER_STATE;
+      input.xy_control_mode = aerial_robot_navigation::POS_CONTROL_MODE;
+
+      if(joint_names.empty()) continue;
+      // the joint angles are sent only when they change
+      if(i > 0 && joint_amplitude == 0) continue;
+      input.joint_state.name = joint_names;
+      input.joint_state.position = joint_positions;
+      for(auto& position: input.joint_state.position)
+        position += joint_amplitude * std::sin(joint_omega * t);
+    }
+
+  return true;
+}
+
+bool ControllerReplay::loadTelemetry(const std::string& path, std::vector<ReplayInput>& inputs)
+{
+  aerial_robot_control::telemetry::Reader reader;
+  if(!reader.open(path))
+    {
+      ROS_ERROR_STREAM("controller replay: " << reader.getError());
+      return false;
+    }
+
+  auto vector = [](const std::vector<double>& values, size_t offset)
+    {
+      return tf::Vector3(values.at(offset), values.at(offset + 1), values.at(offset + 2));
+    };
+
+  ReplayInput input;
+  bool cog = false, baselink = false, target = false;
+  std::vector<double> prev_joints;
+  aerial_robot_control::telemetry::Sample sample;
+  inputs.clear();
+  while(reader.next(sample))
+    {
+      const auto& channels = reader.getChannels();
+      auto channel = std::find_if(channels.begin(), channels.end(),
+                                  [&sample](const aerial_robot_control::telemetry::Channel& c) { return c.id == sample.channel; });
+      if(channel == channels.end()) continue;
+      const auto& values = sample.values;
+
+      // the channels are recorded in this order in each loop of AerialRobotBase
+      if(channel->name == "estimator/cog" && values.size() >= 12)
+        {
+          input.cog_pos = vector(values, 0);
+          input.cog_vel = vector(values, 3);
+          input.cog_euler = vector(values, 6);
+          input.cog_omega = vector(values, 9);
+          cog = true;
+        }
+      else if(channel->name == "estimator/baselink" && values.size() >= 12)
+        {
+          input.baselink_pos = vector(values, 0);
+          input.baselink_vel = vector(values, 3);
+          input.baselink_euler = vector(values, 6);
+          input.baselink_omega = vector(values, 9);
+          baselink = true;
+        }
+      else if(channel->name == "navigator/target" && values.size() >= 20)
+        {
+          input.target_pos = vector(values, 0);
+          input.target_vel = vector(values, 3);
+          input.target_acc = vector(values, 6);
+          input.target_rpy = vector(values, 9);
+          input.target_omega = vector(values, 12);
+          input.target_ang_acc = vector(values, 15);
+          input.navi_state = static_cast<uint8_t>(values.at(18));
+          input.xy_control_mode = static_cast<uint8_t>(values.at(19));
+          target = true;
+        }
+      else if(channel->name == "model" && cog && baselink && target)
+        {
+          // revision, mass, cog/x, cog/y, cog/z, joint/<name>...
+          input.stamp = sample.stamp;
+          input.joint_state = sensor_msgs::JointState();
+          std::vector<double> joints(values.begin() + std::min<size_t>(5, values.size()), values.end());
+          if(joints != prev_joints)
+            {
+              for(size_t i = 5; i < channel->fields.size() && i < values.size(); i++)
+                {
+                  input.joint_state.name.push_back(channel->fields.at(i).substr(std::string("joint/").size()));
+                  input.joint_state.position.push_back(values.at(i));
+                }
+              prev_joints = joints;
+            }
+          inputs.push_back(input);
+          cog = baselink = target = false;
+        }
+    }
+
+  if(!reader.getError().empty())
+    ROS_WARN_STREAM("controller replay: " << reader.getError() << ", replay " << inputs.size() << " ticks");
+
+  return !inputs.empty();
+}
+
+void ControllerReplay::setInput(const ReplayInput& input)
+{
+  ros::Time::setNow(ros::Time(input.stamp));
+
+  if(!input.joint_state.name.empty())
+    robot_model_ros_->getRobotModel()->updateRobotModel(input.joint_state);
+
+  int estimate_mode = estimator_->getEstimateMode();
+  estimator_->setPos(Frame::COG, estimate_mode, input.cog_pos);
+  estimator_->setVel(Frame::COG, estimate_mode, input.cog_vel);
+  estimator_->setEuler(Frame::COG, estimate_mode, input.cog_euler);
+  estimator_->setAngularVel(Frame::COG, estimate_mode, input.cog_omega);
+  estimator_->setPos(Frame::BASELINK, estimate_mode, input.baselink_pos);
+  estimator_->setVel(Frame::BASELINK, estimate_mode, input.baselink_vel);
+  estimator_->setEuler(Frame::BASELINK, estimate_mode, input.baselink_euler);
+  estimator_->setAngularVel(Frame::BASELINK, estimate_mode, input.baselink_omega);
+  estimator_->updateQueue(input.stamp, input.cog_euler.x(), input.cog_euler.y(), input.cog_omega);
+
+  navigator_->setTargetPos(input.target_pos);
+  navigator_->setTargetVel(input.target_vel);
+  navigator_->setTargetAcc(input.target_acc);
+  navigator_->setTargetRoll(input.target_rpy.x());
+  navigator_->setTargetPitch(input.target_rpy.y());
+  navigator_->setTargetYaw(input.target_rpy.z());
+  navigator_->setTargetOmega(input.target_omega);
+  navigator_->setTargetAngAcc(input.target_ang_acc);
+  navigator_->setNaviState(input.navi_state);
+  navigator_->setXyControlMode(input.xy_control_mode);
+}
+
+bool ControllerReplay::run(const std::vector<ReplayInput>& inputs, std::vector<std::string>& trace)
+{
+  trace.clear();
+  timing_ = ReplayTiming();
+  if(!controller_) return false;
+
+  std::vector<double> durations;
+  durations.reserve(inputs.size());
+  for(tick_ = 0; tick_ < inputs.size(); tick_++)
+    {
+      setInput(inputs.at(tick_));
+
+      ros::WallTime start = ros::WallTime::now();
+      controller_->update();
+      durations.push_back((ros::WallTime::now() - start).toSec());
+
+      // intra-process messages are already in the queue
+      tick_trace_.clear();
+      output_queue_.callAvailable();
+      trace.insert(trace.end(), tick_trace_.begin(), tick_trace_.end());
+    }
+
+  if(durations.empty()) return false;
+
+  timing_.ticks = durations.size();
+  for(const auto d: durations) timing_.mean += d;
+  timing_.mean /= durations.size();
+  std::sort(durations.begin(), durations.end());
+  timing_.max = durations.back();
+  timing_.p99 = durations.at(std::min(durations.size() - 1, (size_t)std::ceil(0.99 * durations.size()) - 1));
+
+  return true;
+}
+
+void ControllerReplay::addTrace(const std::string& topic, const std::vector<double>& values)
+{
+  std::string line = std::to_string(tick_) + " " + topic;
+  char buf[32];
+  for(const auto v: values)
+    {
+      // round-trip precision for the bit-exact comparison
+      std::snprintf(buf, sizeof(buf), " %.17g", v);
+      line += buf;
+    }
+  tick_trace_.push_back(line);
+}
+
+void ControllerReplay::fourAxisCommandCallback(const spinal::FourAxisCommandConstPtr& msg)
+{
+  std::vector<double> values(msg->angles.begin(), msg->angles.end());
+  values.insert(values.end(), msg->base_thrust.begin(), msg->base_thrust.end());
+  addTrace("four_axes/command", values);
+}
+
+void ControllerReplay::rpyGainCallback(const spinal::RollPitchYawTermsConstPtr& msg)
+{
+  std::vector<double> values;
+  for(const auto& m: msg->motors)
+    values.insert(values.end(), {(double)m.roll_p, (double)m.roll_i, (double)m.roll_d,
+                                 (double)m.pitch_p, (double)m.pitch_i, (double)m.pitch_d, (double)m.yaw_d});
+  addTrace("rpy/gain", values);
+}
+
+void ControllerReplay::gimbalControlCallback(const sensor_msgs::JointStateConstPtr& msg)
+{
+  addTrace("gimbals_ctrl", msg->position);
+}
+
+bool ControllerReplay::writeTrace(const std::string& path, const std::vector<std::string>& trace)
+{
+  std::ofstream ofs(path);
+  if(!ofs) return false;
+  for(const auto& line: trace) ofs << line << "\n";
+  return ofs.good();
+}
+
+bool ControllerReplay::readTrace(const std::string& path, std::vector<std::string>& trace)
+{
+  std::ifstream ifs(path);
+  if(!ifs) return false;
+  trace.clear();
+  std::string line;
+  while(std::getline(ifs, line))
+    if(!line.empty()) trace.push_back(line);
+  return true;
+}
+
+bool ControllerReplay::compareTraces(const std::vector<std::string>& golden, const std::vector<std::string>& trace,
+                                     double tolerance, std::string& error)
+{
+  for(size_t i = 0; i < std::max(golden.size(), trace.size()); i++)
+    {
+      if(i >= golden.size() || i >= trace.size())
+        {
+          error = "different length: " + std::to_string(golden.size()) + " lines in golden, " + std::to_string(trace.size()) + " lines in trace";
+          return false;
+        }
+
+      std::istringstream g(golden.at(i)), t(trace.at(i));
+      std::string g_tick, g_topic, t_tick, t_topic;
+      g >> g_tick >> g_topic;
+      t >> t_tick >> t_topic;
+      if(g_tick != t_tick || g_topic != t_topic)
+        {
+          error = "line " + std::to_string(i + 1) + ": expected output " + g_topic + " at tick " + g_tick + ", but " + t_topic + " at tick " + t_tick;
+          return false;
+        }
+
+      std::vector<std::string> g_values, t_values;
+      std::string v;
+      while(g >> v) g_values.push_back(v);
+      while(t >> v) t_values.push_back(v);
+      if(g_values.size() != t_values.size())
+        {
+          error = "line " + std::to_string(i + 1) + ": different number of values in " + g_topic + " at tick " + g_tick;
+          return false;
+        }
+
+      for(size_t j = 0; j < g_values.size(); j++)
+        {
+          // %.17g is round-trip, so the bit-exact comparison is the string comparison (also for nan)
+          if(g_values.at(j) == t_values.at(j)) continue;
+
+          double g_value = std::strtod(g_values.at(j).c_str(), nullptr);
+          double t_value = std::strtod(t_values.at(j).c_str(), nullptr);
+          if(tolerance > 0 && std::fabs(g_value - t_value) <= tolerance) continue;
+
+          error = "line " + std::to_string(i + 1) + " (" + g_topic + " at tick " + g_tick + "): value " + std::to_string(j) +
+            ", expected " + g_values.at(j) + ", actual " + t_values.at(j);
+          return false;
+        }
+    }
+
+  return true;
+}
@@ -0,0 +1,160 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* convert a telemetry log of AerialRobotBase to csv files (one per channel) or to a bag */
+
+#include <aerial_robot_control/telemetry/recorder.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <rosbag/bag.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <std_msgs/String.h>
+
+using namespace aerial_robot_control;
+
+namespace
+{
+  void usage(const char* name)
+  {
+    std::cerr << "usage: " << name << " LOG [--csv PREFIX] [--bag FILE]" << std::endl
+              << "  --csv PREFIX: write PREFIX_<channel>.csv for each channel (default: LOG without extension)" << std::endl
+              << "  --bag FILE: write the channels as std_msgs/Float64MultiArray in /telemetry/<channel>" << std::endl
+              << "              and the field names as std_msgs/String in /telemetry/schema" << std::endl;
+  }
+
+  std::string fileName(std::string channel)
+  {
+    std::replace(channel.begin(), channel.end(), '/', '_');
+    return channel;
+  }
+};
+
+int main(int argc, char** argv)
+{
+  if(argc < 2)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+
+  std::string log = argv[1];
+  std::string csv_prefix, bag_file;
+  for(int i = 2; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if(arg == "--csv" && i + 1 < argc) csv_prefix = argv[++i];
+      else if(arg == "--bag" && i + 1 < argc) bag_file = argv[++i];
+      else
+        {
+          usage(argv[0]);
+          return 1;
+        }
+    }
+  if(csv_prefix.empty() && bag_file.empty()) csv_prefix = log.substr(0, log.rfind(".artl"));
+
+  telemetry::Reader reader;
+  if(!reader.open(log))
+    {
+      std::cerr << reader.getError() << std::endl;
+      return 1;
+    }
+
+  rosbag::Bag bag;
+  if(!bag_file.empty()) bag.open(bag_file, rosbag::bagmode::Write);
+
+  std::map<uint16_t, std::ofstream> csv_files;
+  size_t schema_num = 0;
+  size_t sample_num = 0;
+  telemetry::Sample sample;
+  while(reader.next(sample))
+    {
+      const auto& channels = reader.getChannels();
+      if(sample.channel >= channels.size())
+        {
+          std::cerr << "sample of the undefined channel " << sample.channel << std::endl;
+          continue;
+        }
+      const auto& channel = channels.at(sample.channel);
+      ros::Time stamp(sample.stamp);
+
+      // the schema of the new channels
+      for(; bag.isOpen() && schema_num < channels.size(); schema_num++)
+        {
+          std_msgs::String schema;
+          schema.data = channels.at(schema_num).name + ":";
+          for(const auto& field: channels.at(schema_num).fields) schema.data += " " + field;
+          bag.write("/telemetry/schema", stamp, schema);
+        }
+
+      if(!csv_prefix.empty())
+        {
+          auto it = csv_files.find(sample.channel);
+          if(it == csv_files.end())
+            {
+              std::string path = csv_prefix + "_" + fileName(channel.name) + ".csv";
+              it = csv_files.emplace(sample.channel, std::ofstream(path)).first;
+              it->second << std::setprecision(17) << "stamp";
+              for(const auto& field: channel.fields) it->second << "," << field;
+              it->second << std::endl;
+            }
+          it->second << sample.stamp;
+          for(const auto value: sample.values) it->second << "," << value;
+          it->second << "\n";
+        }
+
+      if(bag.isOpen())
+        {
+          std_msgs::Float64MultiArray msg;
+          msg.layout.dim.resize(1);
+          msg.layout.dim.at(0).label = channel.name;
+          msg.layout.dim.at(0).size = sample.values.size();
+          msg.layout.dim.at(0).stride = sample.values.size();
+          msg.data = sample.values;
+          bag.write("/telemetry/" + channel.name, stamp, msg);
+        }
+
+      sample_num++;
+    }
+
+  if(!reader.getError().empty()) std::cerr << "stop at " << reader.getError() << std::endl;
+  if(bag.isOpen()) bag.close();
+
+  std::cout << "convert " << sample_num << " samples of " << reader.getChannels().size()
+            << " channels (log version " << reader.getVersion() << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <aerial_robot_base/controller_replay.h>
+#include <gtest/gtest.h>
+
+using namespace aerial_robot_base;
+
+/*
+  rosparams (private):
+  - telemetry: replay the inputs of a telemetry log, otherwise synthesize them with ~scenario
+  - golden: compare with this reference trace, otherwise (also if empty) check the determinism by replaying twice
+  - golden_out: write the trace (record mode, used without golden), skipped if empty
+  - tolerance: absolute tolerance of each value, zero for the bit-exact comparison
+  - max_mean_time: upper bound of the mean compute time of update() [sec], zero to skip
+*/
+class ControllerReplayTest : public testing::Test
+{
+protected:
+  ros::NodeHandle nh_;
+  ros::NodeHandle nhp_;
+
+  virtual void SetUp()
+  {
+    ::testing::Test::SetUp();
+    nhp_ = ros::NodeHandle ("~");
+  }
+
+  bool replay(std::vector<std::string>& trace, ReplayTiming& timing)
+  {
+    ControllerReplay replay(nh_, nhp_);
+    if(!replay.initialized()) return false;
+
+    std::vector<ReplayInput> inputs;
+    std::string telemetry;
+    if(nhp_.getParam("telemetry", telemetry))
+      {
+        if(!replay.loadTelemetry(telemetry, inputs)) return false;
+      }
+    else if(!replay.synthesizeInputs(inputs)) return false;
+
+    if(!replay.run(inputs, trace)) return false;
+    timing = replay.getTiming();
+    ROS_INFO("replay %d ticks, %zu outputs, compute time of update(): mean %f ms, max %f ms, p99 %f ms",
+             timing.ticks, trace.size(), timing.mean * 1000, timing.max * 1000, timing.p99 * 1000);
+    return true;
+  }
+};
+
+TEST_F(ControllerReplayTest, CompareTrace)
+{
+  std::vector<std::string> trace;
+  ReplayTiming timing;
+  ASSERT_TRUE(replay(trace, timing));
+  ASSERT_FALSE(trace.empty());
+
+  std::string golden_out;
+  if(nhp_.getParam("golden_out", golden_out) && !golden_out.empty())
+    {
+      ASSERT_TRUE(ControllerReplay::writeTrace(golden_out, trace));
+    }
+
+  double tolerance;
+  nhp_.param("tolerance", tolerance, 0.0);
+  std::vector<std::string> golden;
+  std::string golden_path, error;
+  if(nhp_.getParam("golden", golden_path) && !golden_path.empty())
+    {
+      ASSERT_TRUE(ControllerReplay::readTrace(golden_path, golden)) << "no golden trace " << golden_path << ", record it by record_golden:=true";
+    }
+  else
+    {
+      ReplayTiming second_timing;
+      ASSERT_TRUE(replay(golden, second_timing));
+    }
+  EXPECT_TRUE(ControllerReplay::compareTraces(golden, trace, tolerance, error)) << error;
+
+  double max_mean_time;
+  nhp_.param("max_mean_time", max_mean_time, 0.0);
+  if(max_mean_time > 0)
+    {
+      EXPECT_LT(timing.mean, max_mean_time);
+    }
+}
+
+int main(int argc, char **argv)
+{
+  ros::init (argc, argv, "controller_replay_test");
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
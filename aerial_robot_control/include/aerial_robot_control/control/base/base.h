@@ -37,8 +37,10 @@
 
 
 #include <aerial_robot_control/flight_navigation.h>
+#include <aerial_robot_control/telemetry/recorder.h>
 #include <aerial_robot_estimation/state_estimation.h>
 #include <aerial_robot_model/model/aerial_robot_model.h>
+#include <aerial_robot_model/utils/callback_scheduler.h>
 #include <ros/ros.h>
 #include <spinal/PwmInfo.h>
 #include <spinal/UavInfo.h>
@@ -59,7 +61,7 @@ namespace aerial_robot_control
                             boost::shared_ptr<aerial_robot_navigation::BaseNavigator> navigator,
                             double ctrl_loop_du)
     {
-      nh_ = nh;
+      nh_ = aerial_robot_model::CallbackScheduler::nodeHandle(nh, aerial_robot_model::callback_group::COMMAND);
       nhp_ = nhp;
       motor_info_pub_ = nh_.advertise<spinal::PwmInfo>("motor_info", 10);
       uav_info_pub_ = nh_.advertise<spinal::UavInfo>("uav_info", 10);
@@ -78,6 +80,7 @@ namespace aerial_robot_control
 
       ros::NodeHandle control_nh(nh_, "controller");
       getParam<bool>(control_nh, "control_verbose", control_verbose_, false);
+      getParam<bool>(control_nh, "replay", replay_, false); // run the background workers in the control loop for the deterministic replay
 
       ros::NodeHandle motor_nh(nh_, "motor_info");
       getParam<double>(motor_nh, "max_pwm", max_pwm_, 0.0);
@@ -168,6 +171,10 @@ namespace aerial_robot_control
       control_timestamp_ = -1;
     }
 
+    /* telemetry of the controller: register the channels once, and record them after each update() in the control loop */
+    virtual void addTelemetryChannels(telemetry::Recorder& recorder) {}
+    virtual void recordTelemetry(telemetry::Recorder& recorder, double stamp) {}
+
   protected:
     ros::NodeHandle nh_;
     ros::NodeHandle nhp_;
@@ -196,6 +203,7 @@ namespace aerial_robot_control
     int estimate_mode_;
     bool param_verbose_;
     bool control_verbose_;
+    bool replay_;
 
     template<class T> void getParam(ros::NodeHandle nh, std::string param_name, T& param, T default_value)
     {
@@ -37,6 +37,7 @@
 
 #include <aerial_robot_control/control/base/base.h>
 #include <aerial_robot_control/control/utils/pid.h>
+#include <aerial_robot_control/control/utils/pid_bank.h>
 #include <aerial_robot_control/PIDConfig.h>
 #include <aerial_robot_msgs/DynamicReconfigureLevels.h>
 #include <aerial_robot_msgs/PoseControlPid.h>
@@ -67,12 +68,20 @@ namespace aerial_robot_control
     virtual bool update() override;
     virtual void reset() override;
 
+    virtual void addTelemetryChannels(telemetry::Recorder& recorder) override;
+    virtual void recordTelemetry(telemetry::Recorder& recorder, double stamp) override;
+
   protected:
     ros::Publisher pid_pub_;
 
-    std::vector<PID> pid_controllers_;
+    PIDBank pid_controllers_;
     std::vector<boost::shared_ptr<PidControlDynamicConfig> > pid_reconf_servers_;
     aerial_robot_msgs::PoseControlPid pid_msg_;
+    double pid_pub_interval_;
+    double pid_pub_stamp_;
+    bool pid_pub_due_; // whether the debug message is filled and published in this control tick
+    int pid_telemetry_channel_;
+    int pid_gain_telemetry_channel_;
 
     bool need_yaw_d_control_;
     bool start_rp_integration_;
@@ -90,6 +99,7 @@ namespace aerial_robot_control
 
     virtual void controlCore();
     virtual void sendCmd();
+    void setPidMsg();
 
 
     void cfgPidCallback(aerial_robot_control::PIDConfig &config, uint32_t level, std::vector<int> controller_indices);
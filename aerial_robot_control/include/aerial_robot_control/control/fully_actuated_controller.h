@@ -36,6 +36,7 @@
 
 #include <aerial_robot_msgs/WrenchAllocationMatrix.h>
 #include <aerial_robot_control/control/base/pose_linear_controller.h>
+#include <limits>
 #include <spinal/FourAxisCommand.h>
 #include <spinal/RollPitchYawTerms.h>
 #include <spinal/TorqueAllocationMatrixInv.h>
@@ -61,6 +62,9 @@ namespace aerial_robot_control
     virtual void controlCore() override;
     virtual void sendCmd() override;
 
+    virtual void addTelemetryChannels(telemetry::Recorder& recorder) override;
+    virtual void recordTelemetry(telemetry::Recorder& recorder, double stamp) override;
+
   private:
     ros::Publisher flight_cmd_pub_; //for spinal
     ros::Publisher rpy_gain_pub_; //for spinal
@@ -72,6 +76,7 @@ namespace aerial_robot_control
 
     Eigen::MatrixXd q_mat_;
     Eigen::MatrixXd q_mat_inv_;
+    uint64_t q_mat_revision_; // robot model revision of q_mat_ and q_mat_inv_
 
     std::vector<float> target_base_thrust_;
     double candidate_yaw_term_;
@@ -79,6 +84,9 @@ namespace aerial_robot_control
     double torque_allocation_matrix_inv_pub_interval_;
     double wrench_allocation_matrix_pub_interval_;
 
+    int allocation_telemetry_channel_;
+    int allocation_terms_telemetry_channel_;
+
     void setAttitudeGains();
     void rosParamInit();
 
@@ -35,6 +35,7 @@
 #pragma once
 
 #include <aerial_robot_control/control/base/pose_linear_controller.h>
+#include <limits>
 #include <spinal/FourAxisCommand.h>
 #include <spinal/RollPitchYawTerms.h>
 #include <spinal/TorqueAllocationMatrixInv.h>
@@ -65,6 +66,7 @@ namespace aerial_robot_control
 
     Eigen::MatrixXd q_mat_;
     Eigen::MatrixXd q_mat_inv_;
+    uint64_t q_mat_revision_; // robot model revision of q_mat_ and q_mat_inv_
 
     double target_roll_, target_pitch_; // under-actuated
     double candidate_yaw_term_;
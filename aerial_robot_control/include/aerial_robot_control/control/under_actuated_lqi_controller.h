@@ -43,10 +43,22 @@
 #include <spinal/RollPitchYawTerms.h>
 #include <spinal/PMatrixPseudoInverseWithInertia.h>
 #include <ros/ros.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 namespace aerial_robot_control
 {
+  /* LQI gains and the allocation inverse generated from the same robot model revision */
+  struct LQIGains
+  {
+    uint64_t model_revision;
+    std::vector<Eigen::Vector3d> pitch_gains, roll_gains, yaw_gains, z_gains;
+    Eigen::MatrixXd q_mat_inv;
+  };
+
   class UnderActuatedLQIController: public PoseLinearController
   {
 
@@ -62,6 +74,9 @@ namespace aerial_robot_control
 
     void activate() override;
 
+    virtual void addTelemetryChannels(telemetry::Recorder& recorder) override;
+    virtual void recordTelemetry(telemetry::Recorder& recorder, double stamp) override;
+
   protected:
 
     ros::Publisher flight_cmd_pub_; // for spinal
@@ -84,11 +99,23 @@ namespace aerial_robot_control
     Eigen::Vector3d lqi_roll_pitch_weight_, lqi_yaw_weight_, lqi_z_weight_;
     std::vector<double> r_; // matrix R
 
-    std::vector<Eigen::Vector3d> pitch_gains_, roll_gains_, yaw_gains_, z_gains_;
+    std::vector<Eigen::Vector3d> pitch_gains_, roll_gains_, yaw_gains_, z_gains_; // working copy in the gain generator
+    Eigen::MatrixXd q_mat_inv_; // working copy in the gain generator
+
+    std::shared_ptr<const LQIGains> gains_; // exchanged atomically between gain generator and control loop
+    std::shared_ptr<const LQIGains> control_gains_; // snapshot used in one control tick
+    uint64_t gain_model_revision_;
+    int gain_lqi_mode_;
+    std::atomic<bool> lqi_weight_updated_;
+    std::mutex gain_mutex_; // solve and commit of the gains from the gain generator, activate() and dynamic reconfigure
+    std::array<int, 4> lqi_gain_telemetry_channels_; // roll, pitch, yaw, z
+    int lqi_allocation_telemetry_channel_;
 
     bool gyro_moment_compensation_;
 
     bool realtime_update_;
+    double gain_generate_rate_;
+    double gain_generate_timestamp_; // last generation in the control loop (replay)
     std::thread gain_generator_thread_;
 
     //private functions
@@ -105,12 +132,16 @@ namespace aerial_robot_control
     virtual void sendCmd() override;
     virtual void sendFourAxisCommand();
 
-    Eigen::MatrixXd getQInv();
+    Eigen::MatrixXd calcQInv(const Eigen::MatrixXd& P, const Eigen::Matrix3d& inertia);
+    void commitGain(const uint64_t model_revision);
+    bool updateGain(); // optimalGain, clampGain, commitGain and publishGain, with gain_mutex_ locked
+    void loadGain() { control_gains_ = std::atomic_load(&gains_); }
     virtual void allocateYawTerm();
     void cfgLQICallback(aerial_robot_control::LQIConfig &config, uint32_t level); //dynamic reconfigure
 
     void sendRotationalInertiaComp();
 
     void gainGeneratorFunc();
+    void generateGain();
   };
 };
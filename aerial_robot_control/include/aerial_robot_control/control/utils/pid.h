@@ -103,6 +103,9 @@ namespace aerial_robot_control
     const double& getLimitP() const { return limit_p_; }
     const double& getLimitI() const { return limit_i_; }
     const double& getLimitD() const { return limit_d_; }
+    const double& getLimitErrP() const { return limit_err_p_; }
+    const double& getLimitErrI() const { return limit_err_i_; }
+    const double& getLimitErrD() const { return limit_err_d_; }
     void setLimitSum(const double limit_sum) {limit_sum_ = limit_sum; }
     void setLimitP(const double limit_p) {limit_p_ = limit_p; }
     void setLimitI(const double limit_i) {limit_i_ = limit_i; }
@@ -0,0 +1,236 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <aerial_robot_control/control/utils/pid.h>
+#include <Eigen/Core>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace aerial_robot_control
+{
+  /*
+    Structure-of-arrays bank of PID loops.
+    All axes are updated in one vectorized pass with the same clamping and
+    anti-windup semantics as aerial_robot_control::PID::update().
+    Single axes are accessed through a light handle (PIDBank::Axis) which
+    exposes the same interface as PID, so derived controllers can keep using
+    pid_controllers_.at(Z).getErrI() etc.
+   */
+  class PIDBank
+  {
+  public:
+    static constexpr int MAX_AXIS_NUM = 8;
+    /* bounded size, so that all the temporaries in update() stay on the stack */
+    using Array = Eigen::Array<double, Eigen::Dynamic, 1, Eigen::ColMajor, MAX_AXIS_NUM, 1>;
+    using Mask = Eigen::Array<bool, Eigen::Dynamic, 1, Eigen::ColMajor, MAX_AXIS_NUM, 1>;
+
+    class Axis
+    {
+    public:
+      Axis(PIDBank* bank, const int index): bank_(bank), i_(index) {}
+
+      void update(const double err_p, const double du, const double err_d, const double feedforward_term = 0)
+      {
+        bank_->updateAxis(i_, err_p, du, err_d, feedforward_term);
+      }
+
+      double result() const { return bank_->result_(i_); }
+      void reset() { bank_->resetAxis(i_); }
+
+      const double& getPGain() const { return bank_->p_gain_(i_); }
+      const double& getIGain() const { return bank_->i_gain_(i_); }
+      const double& getDGain() const { return bank_->d_gain_(i_); }
+      void setPGain(const double p_gain) { bank_->p_gain_(i_) = p_gain; }
+      void setIGain(const double i_gain) { bank_->i_gain_(i_) = i_gain; }
+      void setDGain(const double d_gain) { bank_->d_gain_(i_) = d_gain; }
+      void setGains(const double p_gain, const double i_gain, const double d_gain)
+      {
+        setPGain(p_gain);
+        setIGain(i_gain);
+        setDGain(d_gain);
+      }
+
+      const double& getLimitSum() const { return bank_->limit_sum_(i_); }
+      const double& getLimitP() const { return bank_->limit_p_(i_); }
+      const double& getLimitI() const { return bank_->limit_i_(i_); }
+      const double& getLimitD() const { return bank_->limit_d_(i_); }
+      const double& getLimitErrP() const { return bank_->limit_err_p_(i_); }
+      const double& getLimitErrI() const { return bank_->limit_err_i_(i_); }
+      const double& getLimitErrD() const { return bank_->limit_err_d_(i_); }
+      void setLimitSum(const double limit_sum) { bank_->limit_sum_(i_) = limit_sum; }
+      void setLimitP(const double limit_p) { bank_->limit_p_(i_) = limit_p; }
+      void setLimitI(const double limit_i) { bank_->limit_i_(i_) = limit_i; }
+      void setLimitD(const double limit_d) { bank_->limit_d_(i_) = limit_d; }
+      void setLimitErrP(const double limit_err_p) { bank_->limit_err_p_(i_) = limit_err_p; }
+      void setLimitErrI(const double limit_err_i) { bank_->limit_err_i_(i_) = limit_err_i; }
+      void setLimitErrD(const double limit_err_d) { bank_->limit_err_d_(i_) = limit_err_d; }
+      void setLimits(const double limit_sum, const double limit_p, const double limit_i, const double limit_d, const double limit_err_p, const double limit_err_i, const double limit_err_d)
+      {
+        setLimitSum(limit_sum);
+        setLimitP(limit_p);
+        setLimitI(limit_i);
+        setLimitD(limit_d);
+        setLimitErrP(limit_err_p);
+        setLimitErrI(limit_err_i);
+        setLimitErrD(limit_err_d);
+      }
+
+      const std::string getName() const { return bank_->names_.at(i_); }
+      const double& getErrP() const { return bank_->err_p_(i_); }
+      const double& getErrI() const { return bank_->err_i_(i_); }
+      const double& getPrevErrI() const { return bank_->err_i_prev_(i_); }
+      const double& getErrD() const { return bank_->err_d_(i_); }
+      void setErrP(const double err_p) { bank_->err_p_(i_) = err_p; }
+      void setErrI(const double err_i) { bank_->err_i_(i_) = err_i; }
+
+      const double& getPTerm() const { return bank_->p_term_(i_); }
+      const double& getITerm() const { return bank_->i_term_(i_); }
+      const double& getDTerm() const { return bank_->d_term_(i_); }
+
+    private:
+      PIDBank* bank_;
+      int i_;
+    };
+
+    PIDBank() = default;
+    PIDBank(const PIDBank&) = delete; // handles keep a raw pointer to the bank
+    PIDBank& operator=(const PIDBank&) = delete;
+
+    /* configuration phase: copy gains and limits from a scalar PID */
+    void push_back(const PID& pid)
+    {
+      const int n = size();
+      if(n >= MAX_AXIS_NUM) throw std::length_error("PIDBank: exceed the max axis number");
+      names_.push_back(pid.getName());
+      for(auto array: {&result_, &p_gain_, &i_gain_, &d_gain_, &p_term_, &i_term_, &d_term_,
+            &err_p_, &err_i_, &err_i_prev_, &err_d_,
+            &limit_sum_, &limit_p_, &limit_i_, &limit_d_,
+            &limit_err_p_, &limit_err_i_, &limit_err_d_})
+        {
+          array->conservativeResize(n + 1);
+          (*array)(n) = 0;
+        }
+
+      p_gain_(n) = pid.getPGain();
+      i_gain_(n) = pid.getIGain();
+      d_gain_(n) = pid.getDGain();
+      limit_sum_(n) = pid.getLimitSum();
+      limit_p_(n) = pid.getLimitP();
+      limit_i_(n) = pid.getLimitI();
+      limit_d_(n) = pid.getLimitD();
+      limit_err_p_(n) = pid.getLimitErrP();
+      limit_err_i_(n) = pid.getLimitErrI();
+      limit_err_d_(n) = pid.getLimitErrD();
+
+      active_ = Mask::Constant(n + 1, true);
+    }
+
+    size_t size() const { return names_.size(); }
+
+    Axis at(const int index)
+    {
+      if(index < 0 || static_cast<size_t>(index) >= size()) throw std::out_of_range("PIDBank: invalid axis index " + std::to_string(index));
+      return Axis(this, index);
+    }
+
+    /* the update mask, axes with false keep their previous state */
+    Mask& active() { return active_; }
+
+    /* vectorized update of all (active) axes, same semantics as PID::update() */
+    void update(const Array& err_p, const Array& du, const Array& err_d, const Array& feedforward_term)
+    {
+      const Array err_p_new = err_p.max(-limit_err_p_).min(limit_err_p_);
+      const Array err_i_new = (err_i_ + err_p_new * du).max(-limit_err_i_).min(limit_err_i_);
+      const Array err_d_new = err_d.max(-limit_err_d_).min(limit_err_d_);
+
+      const Array p_term = (err_p_new * p_gain_).max(-limit_p_).min(limit_p_);
+      const Array i_term = (err_i_new * i_gain_).max(-limit_i_).min(limit_i_);
+      const Array d_term = (err_d_new * d_gain_).max(-limit_d_).min(limit_d_);
+      const Array result = (p_term + i_term + d_term + feedforward_term).max(-limit_sum_).min(limit_sum_);
+
+      err_i_prev_ = active_.select(err_i_, err_i_prev_);
+      err_p_ = active_.select(err_p_new, err_p_);
+      err_i_ = active_.select(err_i_new, err_i_);
+      err_d_ = active_.select(err_d_new, err_d_);
+      p_term_ = active_.select(p_term, p_term_);
+      i_term_ = active_.select(i_term, i_term_);
+      d_term_ = active_.select(d_term, d_term_);
+      result_ = active_.select(result, result_);
+    }
+
+    void reset()
+    {
+      err_i_.setZero();
+      err_i_prev_.setZero();
+      result_.setZero();
+    }
+
+  private:
+    std::vector<std::string> names_;
+    Mask active_;
+
+    Array result_;
+    Array p_gain_, i_gain_, d_gain_;
+    Array p_term_, i_term_, d_term_;
+    Array err_p_, err_i_, err_i_prev_, err_d_;
+    Array limit_sum_, limit_p_, limit_i_, limit_d_;
+    Array limit_err_p_, limit_err_i_, limit_err_d_;
+
+    void updateAxis(const int i, const double err_p, const double du, const double err_d, const double feedforward_term)
+    {
+      err_p_(i) = clamp(err_p, -limit_err_p_(i), limit_err_p_(i));
+      err_i_prev_(i) = err_i_(i);
+      err_i_(i) = clamp(err_i_(i) + err_p_(i) * du, -limit_err_i_(i), limit_err_i_(i));
+      err_d_(i) = clamp(err_d, -limit_err_d_(i), limit_err_d_(i));
+
+      p_term_(i) = clamp(err_p_(i) * p_gain_(i), -limit_p_(i), limit_p_(i));
+      i_term_(i) = clamp(err_i_(i) * i_gain_(i), -limit_i_(i), limit_i_(i));
+      d_term_(i) = clamp(err_d_(i) * d_gain_(i), -limit_d_(i), limit_d_(i));
+
+      result_(i) = clamp(p_term_(i) + i_term_(i) + d_term_(i) + feedforward_term, -limit_sum_(i), limit_sum_(i));
+    }
+
+    void resetAxis(const int i)
+    {
+      err_i_(i) = 0;
+      err_i_prev_(i) = 0;
+      result_(i) = 0;
+    }
+  };
+
+};
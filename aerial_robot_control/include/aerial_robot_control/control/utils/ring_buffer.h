@@ -0,0 +1,92 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace aerial_robot_control
+{
+  /* lock-free bounded queue between one producer and one consumer, the producer never blocks:
+     push fails if the queue is full */
+  template<class T> class RingBuffer
+  {
+  public:
+    RingBuffer(size_t capacity): slots_(capacity + 1), head_(0), tail_(0) {}
+
+    /* producer: fill the next free slot in place, return false if full */
+    template<class F> bool push(F&& fill)
+    {
+      const size_t tail = tail_.load(std::memory_order_relaxed);
+      const size_t next = increment(tail);
+      if(next == head_.load(std::memory_order_acquire)) return false;
+
+      fill(slots_[tail]);
+      tail_.store(next, std::memory_order_release);
+      return true;
+    }
+
+    /* consumer: return nullptr if empty, the slot is valid until pop() */
+    const T* front() const
+    {
+      const size_t head = head_.load(std::memory_order_relaxed);
+      if(head == tail_.load(std::memory_order_acquire)) return nullptr;
+      return &slots_[head];
+    }
+
+    void pop()
+    {
+      head_.store(increment(head_.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    size_t capacity() const { return slots_.size() - 1; }
+
+    size_t size() const
+    {
+      const size_t head = head_.load(std::memory_order_acquire);
+      const size_t tail = tail_.load(std::memory_order_acquire);
+      return tail >= head ? tail - head : tail + slots_.size() - head;
+    }
+
+  private:
+    size_t increment(size_t index) const { return index + 1 == slots_.size() ? 0 : index + 1; }
+
+    std::vector<T> slots_; // one slot is kept empty to distinguish full from empty
+    alignas(64) std::atomic<size_t> head_; // owned by the consumer
+    alignas(64) std::atomic<size_t> tail_; // owned by the producer
+  };
+}
@@ -0,0 +1,157 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace aerial_robot_control
+{
+  /*
+    seqlock between one writer and any number of readers:
+    - the writer never waits, a reader retries while a write is in progress
+    - the value is copied word by word through atomics, so T has to be trivially copyable
+  */
+  template<class T> class SeqLock
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+  public:
+    SeqLock(): seq_(0)
+    {
+      for(auto& word: data_) word.store(0, std::memory_order_relaxed);
+    }
+
+    /* only from one thread at a time */
+    void store(const T& value)
+    {
+      uint64_t words[WORDS] = {};
+      std::memcpy(words, &value, sizeof(T));
+
+      const uint64_t seq = seq_.load(std::memory_order_relaxed);
+      seq_.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for(size_t i = 0; i < WORDS; i++) data_[i].store(words[i], std::memory_order_relaxed);
+      seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+      uint64_t words[WORDS];
+      uint64_t begin, end;
+      do
+        {
+          begin = seq_.load(std::memory_order_acquire);
+          for(size_t i = 0; i < WORDS; i++) words[i] = data_[i].load(std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_acquire);
+          end = seq_.load(std::memory_order_relaxed);
+        }
+      while((begin & 1) || begin != end);
+
+      T value;
+      std::memcpy(&value, words, sizeof(T));
+      return value;
+    }
+
+  private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> seq_; // odd while a write is in progress
+    std::atomic<uint64_t> data_[WORDS];
+  };
+
+  /*
+    single-writer arbiter for a setpoint modified from several threads:
+    - writers modify the working copy in a transaction, nested transactions are merged
+    - the outermost transaction publishes the complete setpoint with a new version
+    - the transactions are serialized, so the seqlock has a single writer
+    - the control loop and any other reader get the published setpoint without lock
+  */
+  template<class T> class SetpointArbiter
+  {
+  public:
+    struct Versioned
+    {
+      T value;
+      uint64_t version = 0;
+    };
+
+    class Transaction
+    {
+    public:
+      Transaction(SetpointArbiter& arbiter): arbiter_(arbiter), lock_(arbiter.mutex_) { arbiter_.depth_++; }
+      ~Transaction() { if(--arbiter_.depth_ == 0) arbiter_.publish(); }
+      Transaction(const Transaction&) = delete;
+      Transaction& operator=(const Transaction&) = delete;
+
+      T* operator->() { return &arbiter_.working_; }
+      T& operator*() { return arbiter_.working_; }
+
+    private:
+      SetpointArbiter& arbiter_;
+      std::lock_guard<std::recursive_mutex> lock_;
+    };
+
+    SetpointArbiter(const T& value = T()): working_(value), depth_(0), version_(0) { publish(); }
+
+    Transaction write() { return Transaction(*this); }
+
+    /* copy of the working setpoint, for the writers */
+    T get() const
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      return working_;
+    }
+
+    /* latest published setpoint, lock-free */
+    Versioned snapshot() const { return published_.load(); }
+
+  private:
+    void publish()
+    {
+      published_.store(Versioned{working_, ++version_});
+    }
+
+    mutable std::recursive_mutex mutex_;
+    T working_;
+    int depth_;
+    uint64_t version_;
+    SeqLock<Versioned> published_;
+  };
+}
@@ -3,11 +3,18 @@
 #include <aerial_robot_estimation/sensor/base_plugin.h>
 #include <aerial_robot_estimation/sensor/gps.h>
 #include <aerial_robot_estimation/state_estimation.h>
+#include <aerial_robot_model/model/transformation_planner.h>
+#include <aerial_robot_model/utils/callback_scheduler.h>
 #include <aerial_robot_msgs/FlightNav.h>
 #include <angles/angles.h>
 #include <geometry_msgs/Vector3Stamped.h>
 #include <geometry_msgs/PoseStamped.h>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <pluginlib/class_loader.h>
 #include <ros/ros.h>
+#include <sensor_msgs/JointState.h>
 #include <sensor_msgs/Joy.h>
 #include <spinal/FlightConfigCmd.h>
 #include <std_msgs/Empty.h>
@@ -15,17 +22,13 @@
 #include <std_msgs/Int8.h>
 #include <std_msgs/UInt8.h>
 #include <nav_msgs/Path.h>
+#include <aerial_robot_control/control/utils/setpoint_channel.h>
+#include <aerial_robot_control/navigation_state_machine.h>
 #include <aerial_robot_control/trajectory/trajectory_reference/polynomial_trajectory.hpp>
+#include <aerial_robot_control/trajectory/trajectory_reference/receding_horizon_reference.hpp>
 
 namespace aerial_robot_navigation
 {
-  /* control mode */
-  enum control_mode
-    {
-      POS_CONTROL_MODE,
-      VEL_CONTROL_MODE,
-      ACC_CONTROL_MODE
-    };
   /* control frame */
   enum control_frame
     {
@@ -33,17 +36,13 @@ namespace aerial_robot_navigation
       LOCAL_FRAME /* head frame which is identical with imu head direction */
     };
 
-  // navi state
-  enum flight_state
-    {
-      ARM_OFF_STATE,
-      START_STATE,
-      ARM_ON_STATE,
-      TAKEOFF_STATE,
-      LAND_STATE,
-      HOVER_STATE,
-      STOP_STATE
-    };
+  struct TargetSetpoint
+  {
+    TargetSetpoint(): pos(0, 0, 0), vel(0, 0, 0), acc(0, 0, 0), rpy(0, 0, 0), omega(0, 0, 0), ang_acc(0, 0, 0) {}
+
+    tf::Vector3 pos, vel, acc;
+    tf::Vector3 rpy, omega, ang_acc;
+  };
 
   class BaseNavigator
   {
@@ -60,67 +59,80 @@ namespace aerial_robot_navigation
 
     ros::Publisher& getFlightConfigPublisher() { return flight_config_pub_; }
 
-    inline uint8_t getNaviState(){  return navi_state_;}
-    inline void setNaviState(const uint8_t  state){ navi_state_ = state;}
+    inline uint8_t getNaviState(){  return state_machine_.getState();}
+    inline void setNaviState(const uint8_t  state){ auto target = target_.write(); state_machine_.setState(state);}
 
-    inline uint8_t getXyControlMode(){  return (uint8_t)xy_control_mode_;}
-    inline void setXyControlMode(uint8_t mode){  xy_control_mode_ = mode;}
+    inline uint8_t getXyControlMode(){  return (uint8_t)state_machine_.getXyControlMode();}
+    inline void setXyControlMode(uint8_t mode){ auto target = target_.write(); state_machine_.setXyControlMode(mode);}
 
     inline uint8_t getControlframe(){  return (uint8_t)control_frame_;}
     inline void setControlframe(uint8_t frame_type){  control_frame_ = frame_type;}
 
     inline bool getXyVelModePosCtrlTakeoff(){  return xy_vel_mode_pos_ctrl_takeoff_;}
-    inline bool getForceLandingFlag() {return force_landing_flag_;}
-    inline double getForceLandingStartTime() {return force_landing_start_time_.toSec();}
-
-    inline tf::Vector3 getTargetPos() {return target_pos_;}
-    inline tf::Vector3 getTargetVel() {return target_vel_;}
-    inline tf::Vector3 getTargetAcc() {return target_acc_;}
-    inline tf::Vector3 getTargetRPY() {return target_rpy_;}
-    inline tf::Vector3 getTargetOmega() {return target_omega_;}
-    inline tf::Vector3 getTargetAngAcc() {return target_ang_acc_;}
+    inline bool getForceLandingFlag() {return state_machine_.getForceLandingFlag();}
+    inline double getForceLandingStartTime() {return state_machine_.getForceLandingStartTime();}
+
+    /* published targets without lock, read the whole setpoint for several fields of the same command */
+    inline tf::Vector3 getTargetPos() {return target_.snapshot().value.pos;}
+    inline tf::Vector3 getTargetVel() {return target_.snapshot().value.vel;}
+    inline tf::Vector3 getTargetAcc() {return target_.snapshot().value.acc;}
+    inline tf::Vector3 getTargetRPY() {return target_.snapshot().value.rpy;}
+    inline tf::Vector3 getTargetOmega() {return target_.snapshot().value.omega;}
+    inline tf::Vector3 getTargetAngAcc() {return target_.snapshot().value.ang_acc;}
+
+    /* coherent and lock-free target for the control loop, the version increases with every published command */
+    inline TargetSetpoint getTargetSetpoint(uint64_t* version = nullptr) const
+    {
+      aerial_robot_control::SetpointArbiter<TargetSetpoint>::Versioned published = target_.snapshot();
+      if(version) *version = published.version;
+      return published.value;
+    }
 
-    inline void setTargetPos(tf::Vector3 pos) { target_pos_ = pos; }
+    inline void setTargetPos(tf::Vector3 pos) { target_.write()->pos = pos; }
     inline void setTargetPos(double x, double y, double z) { setTargetPos(tf::Vector3(x, y, z)); }
-    inline void addTargetPos(tf::Vector3 diff_pos) { target_pos_ += diff_pos; }
+    inline void addTargetPos(tf::Vector3 diff_pos) { target_.write()->pos += diff_pos; }
     inline void addTargetPos(double x, double y, double z) { addTargetPos(tf::Vector3(x, y, z)); }
-    inline void setTargetVel(tf::Vector3 vel) { target_vel_ = vel; }
+    inline void setTargetVel(tf::Vector3 vel) { target_.write()->vel = vel; }
     inline void setTargetVel(double x, double y, double z) { setTargetVel(tf::Vector3(x, y, z)); }
     inline void setTargetZeroVel() { setTargetVel(0,0,0); }
-    inline void setTargetAcc(tf::Vector3 vel) { target_acc_ = vel; }
+    inline void setTargetAcc(tf::Vector3 vel) { target_.write()->acc = vel; }
     inline void setTargetAcc(double x, double y, double z) { setTargetAcc(tf::Vector3(x, y, z)); }
     inline void setTargetZeroAcc() { setTargetAcc(tf::Vector3(0,0,0)); }
 
-    inline void setTargetRoll(float value) { target_rpy_.setX(value); }
-    inline void setTargetOmega(tf::Vector3 omega) { target_omega_ = omega; }
+    inline void setTargetRoll(float value) { target_.write()->rpy.setX(value); }
+    inline void setTargetOmega(tf::Vector3 omega) { target_.write()->omega = omega; }
     inline void setTargetOmega(double x, double y, double z) { setTargetOmega(tf::Vector3(x, y, z)); }
     inline void setTargetZeroOmega() { setTargetOmega(0,0,0); }
-    inline void setTargetOmegaX(float value) { target_omega_.setX(value); }
-    inline void setTargetPitch(float value) { target_rpy_.setY(value); }
-    inline void setTargetOmegaY(float value) { target_omega_.setY(value); }
-    inline void setTargetYaw(float value) { target_rpy_.setZ(value); }
-    inline void addTargetYaw(float value) { setTargetYaw(angles::normalize_angle(target_rpy_.z() + value)); }
-    inline void setTargetOmegaZ(float value) { target_omega_.setZ(value); }
-    inline void setTargetAngAcc(tf::Vector3 acc) { target_ang_acc_ = acc; }
+    inline void setTargetOmegaX(float value) { target_.write()->omega.setX(value); }
+    inline void setTargetPitch(float value) { target_.write()->rpy.setY(value); }
+    inline void setTargetOmegaY(float value) { target_.write()->omega.setY(value); }
+    inline void setTargetYaw(float value) { target_.write()->rpy.setZ(value); }
+    inline void addTargetYaw(float value)
+    {
+      auto target = target_.write();
+      target->rpy.setZ(angles::normalize_angle(target->rpy.z() + value));
+    }
+    inline void setTargetOmegaZ(float value) { target_.write()->omega.setZ(value); }
+    inline void setTargetAngAcc(tf::Vector3 acc) { target_.write()->ang_acc = acc; }
     inline void setTargetAngAcc(double x, double y, double z) { setTargetAngAcc(tf::Vector3(x, y, z)); }
     inline void setTargetZeroAngAcc() { setTargetAngAcc(tf::Vector3(0,0,0)); }
-    inline void setTargetAngAccX(double value) { target_ang_acc_.setX(value); }
-    inline void setTargetAngAccY(double value) { target_ang_acc_.setY(value); }
-    inline void setTargetAngAccZ(double value) { target_ang_acc_.setZ(value); }
-
-    inline void setTargetPosX( float value){  target_pos_.setX(value);}
-    inline void setTargetVelX( float value){  target_vel_.setX(value);}
-    inline void setTargetAccX( float value){  target_acc_.setX(value);}
-    inline void setTargetPosY( float value){  target_pos_.setY(value);}
-    inline void setTargetVelY( float value){  target_vel_.setY(value);}
-    inline void setTargetAccY( float value){  target_acc_.setY(value);}
-    inline void setTargetPosZ( float value){  target_pos_.setZ(value);}
-    inline void setTargetVelZ( float value){  target_vel_.setZ(value);}
-    inline void setTargetAccZ( float value){  target_acc_.setZ(value);}
-    inline void addTargetPosZ( float value){  target_pos_ += tf::Vector3(0, 0, value);}
-
-    inline void setTeleopFlag(bool teleop_flag) { teleop_flag_ = teleop_flag; }
-    inline bool getTeleopFlag() { return teleop_flag_; }
+    inline void setTargetAngAccX(double value) { target_.write()->ang_acc.setX(value); }
+    inline void setTargetAngAccY(double value) { target_.write()->ang_acc.setY(value); }
+    inline void setTargetAngAccZ(double value) { target_.write()->ang_acc.setZ(value); }
+
+    inline void setTargetPosX( float value){  target_.write()->pos.setX(value);}
+    inline void setTargetVelX( float value){  target_.write()->vel.setX(value);}
+    inline void setTargetAccX( float value){  target_.write()->acc.setX(value);}
+    inline void setTargetPosY( float value){  target_.write()->pos.setY(value);}
+    inline void setTargetVelY( float value){  target_.write()->vel.setY(value);}
+    inline void setTargetAccY( float value){  target_.write()->acc.setY(value);}
+    inline void setTargetPosZ( float value){  target_.write()->pos.setZ(value);}
+    inline void setTargetVelZ( float value){  target_.write()->vel.setZ(value);}
+    inline void setTargetAccZ( float value){  target_.write()->acc.setZ(value);}
+    inline void addTargetPosZ( float value){  target_.write()->pos += tf::Vector3(0, 0, value);}
+
+    inline void setTeleopFlag(bool teleop_flag) { auto target = target_.write(); state_machine_.setTeleopFlag(teleop_flag); }
+    inline bool getTeleopFlag() { return state_machine_.getTeleopFlag(); }
 
     inline const double getInitHeight() const { return init_height_;  }
     inline void setInitHeight(double height) { init_height_ = height; }
@@ -132,12 +144,16 @@ namespace aerial_robot_navigation
 
     void generateNewTrajectory(geometry_msgs::PoseStamped pose);
 
+    /* reference of the last replanning from its start until the goal, sampled by "trajectory_preview_du" (state.t is the sample time),
+       for the feedforward of the controllers over their own horizon. null without the trajectory replanning. thread-safe */
+    std::shared_ptr<const std::vector<agi::QuadState> > getReferencePreview() const { return std::atomic_load(&reference_preview_); }
+
     static constexpr uint8_t POS_CONTROL_COMMAND = 0;
     static constexpr uint8_t VEL_CONTROL_COMMAND = 1;
 
     // abnormal state
-    static constexpr uint8_t LOW_BATTERY_STATE = 0x10;
-    static constexpr uint8_t FORCE_LANDING_STATE = 0x11;
+    static constexpr uint8_t LOW_BATTERY_STATE = NavigationStateMachine::LOW_BATTERY_STATE;
+    static constexpr uint8_t FORCE_LANDING_STATE = NavigationStateMachine::FORCE_LANDING_STATE;
 
     // battery check
     static constexpr float VOLTAGE_100P =  4.2;
@@ -239,6 +255,7 @@ namespace aerial_robot_navigation
     ros::Subscriber navi_sub_;
     ros::Subscriber pose_sub_;
     ros::Subscriber simple_move_base_goal_sub_;
+    ros::Subscriber waypoints_sub_;
     ros::Subscriber battery_sub_;
     ros::Subscriber flight_status_ack_sub_;
     ros::Subscriber takeoff_sub_;
@@ -256,40 +273,29 @@ namespace aerial_robot_navigation
 
     bool param_verbose_;
 
-    uint8_t navi_state_;
+    /* flight state logic, only accessed in a target transaction except the getters */
+    NavigationStateMachine state_machine_;
 
-    int  xy_control_mode_;
-    int  prev_xy_control_mode_;
     bool xy_vel_mode_pos_ctrl_takeoff_;
 
     double loop_du_;
     int  control_frame_;
     int estimate_mode_;
-    bool  force_att_control_flag_;
     bool trajectory_mode_;
     bool lock_teleop_;
-    ros::Time force_landing_start_time_;
 
-    double hover_convergent_start_time_;
-    double hover_convergent_duration_;
-    double land_check_start_time_;
-    double land_check_duration_;
     double trajectory_reset_time_;
     double trajectory_reset_duration_;
     double teleop_reset_time_;
     double teleop_reset_duration_;
-    double z_convergent_thresh_;
-    double xy_convergent_thresh_;
-    double land_pos_convergent_thresh_;
-    double land_vel_convergent_thresh_;
 
-    /* target value */
-    tf::Vector3 target_pos_, target_vel_, target_acc_;
-    tf::Vector3 target_rpy_, target_omega_, target_ang_acc_;
+    /* target value: modified in short transactions from the callbacks and the main loop,
+       published as a whole to the controller. the getters above return the published value,
+       inside a transaction use the working copy instead */
+    aerial_robot_control::SetpointArbiter<TargetSetpoint> target_;
 
     double takeoff_height_;
     double init_height_;
-    double land_height_;
     double land_descend_vel_;
 
     /* auto vel nav */
@@ -306,12 +312,8 @@ namespace aerial_robot_navigation
     double gps_waypoint_threshold_;
 
     /* teleop */
-    bool teleop_flag_;
     bool xy_control_flag_;
-    bool force_landing_flag_;
     bool joy_udp_;
-    bool check_joy_stick_heart_beat_;
-    bool joy_stick_heart_beat_;
 
     double max_teleop_xy_vel_;
     double max_teleop_z_vel_;
@@ -319,9 +321,6 @@ namespace aerial_robot_navigation
     double max_teleop_rp_angle_;
 
     double joy_stick_deadzone_;
-    double joy_stick_prev_time_;
-    double joy_stick_heart_beat_du_;
-    double force_landing_to_halt_du_;
     bool force_landing_auto_stop_flag_;
 
     std::string teleop_local_frame_;
@@ -331,25 +330,63 @@ namespace aerial_robot_navigation
     double trajectory_mean_yaw_rate_;
     double trajectory_min_du_;
     bool enable_latch_yaw_trajectory_;
-    std::shared_ptr<agi::MinJerkTrajectory> traj_generator_ptr_;
+    std::shared_ptr<agi::MinJerkTrajectory> traj_generator_ptr_; // only accessed in a target transaction, built outside and swapped in
+    bool trajectory_replanning_;
+    agi::RecedingHorizonReference receding_horizon_; // only accessed in a target transaction
+    /* the replanning is solved in a worker thread and handed over with std::atomic_store/atomic_exchange */
+    struct ReplanSolution: agi::RecedingHorizonReference::Solution
+    {
+      std::shared_ptr<const std::vector<agi::QuadState> > preview; // sampled in the worker, published if the solution is applied
+    };
+    std::atomic<bool> replan_busy_;
+    std::shared_ptr<ReplanSolution> replan_solution_;
+    double reference_preview_du_;
+    std::shared_ptr<const std::vector<agi::QuadState> > reference_preview_; // exchanged atomically
 
     /* battery info */
     double low_voltage_thre_;
-    bool low_voltage_flag_;
     double high_voltage_cell_thre_;
-    bool high_voltage_flag_;
     int bat_cell_;
     double bat_resistance_;
     double bat_resistance_voltage_rate_;
     double hovering_current_;
 
+    /* transformation: joint space path planned in a dedicated model instance, only for the transformable robots */
+    bool transformation_planning_;
+    aerial_robot_model::transformable::TransformationPlannerParams transformation_params_;
+    std::shared_ptr<pluginlib::ClassLoader<aerial_robot_model::RobotModel> > transformation_model_loader_;
+    std::shared_ptr<aerial_robot_model::transformable::TransformationPlanner> transformation_planner_;
+    ros::Subscriber transformation_target_sub_;
+    ros::Publisher transformation_joint_pub_;
+    std::mutex transformation_mutex_;
+    aerial_robot_model::transformable::TransformationTrajectory transformation_trajectory_; // guarded by transformation_mutex_
+    sensor_msgs::JointState transformation_joint_msg_; // preallocated for the trajectory, guarded by transformation_mutex_
+    double transformation_start_time_;
+    std::future<void> replan_future_;
+    std::future<void> transformation_future_; // declared last to wait for the planning before the destruction of the others
+
     virtual void rosParamInit();
+    void initTransformationPlanner();
+    void transformationTargetCallback(const sensor_msgs::JointStateConstPtr& msg);
+    void updateTransformation();
+    void updateReplanning(double t);
     void poseCallback(const geometry_msgs::PoseStampedConstPtr & msg);
     void simpleMoveBaseGoalCallback(const geometry_msgs::PoseStampedConstPtr & msg);
+    void waypointsCallback(const nav_msgs::PathConstPtr & msg);
     void naviCallback(const aerial_robot_msgs::FlightNavConstPtr & msg);
     void joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg);
     void batteryCheckCallback(const std_msgs::Float32ConstPtr &msg);
 
+    agi::QuadState getTargetQuadState();
+    void setTargetFromTrajectory(const agi::QuadState& target_state);
+    void publishTrajectoryPath(const std::vector<agi::QuadState>& states);
+
+    /* feed an event to the state machine and apply its outputs */
+    NavigationOutput handleEvent(NavigationEvent::Type type, int value = 0);
+    void applyNavigationOutput(const NavigationOutput& output);
+    void sendFlightConfigCmd(uint8_t cmd);
+    void initTakeoffTarget();
+
     virtual void halt() {}
     virtual void reset()
     {
@@ -358,58 +395,17 @@ namespace aerial_robot_navigation
 
       trajectory_mode_ = false;
       init_height_ = 0;
-      land_height_ = 0;
     }
 
     void startTakeoff()
     {
-      if(getNaviState() == TAKEOFF_STATE) return;
-
-      if(getNaviState() == ARM_ON_STATE)
-        {
-          setNaviState(TAKEOFF_STATE);
-          ROS_INFO("Takeoff state");
-        }
+      handleEvent(NavigationEvent::TAKEOFF);
     }
 
     void motorArming()
     {
       /* z(altitude) */
-      /* check whether there is the fusion for the altitude */
-      if(!estimator_->getStateStatus(State::Z_BASE, estimate_mode_))
-        {
-          ROS_ERROR("Flight Navigation: No correct sensor fusion for z(altitude), can not fly");
-          return;
-        }
-
-      for(const auto& handler: estimator_->getGpsHandlers())
-        {
-          if(handler->getStatus() == Status::ACTIVE)
-            {
-              ros::NodeHandle nh(nh_, "navigation");
-              nh.param("outdoor_takeoff_height", takeoff_height_, 1.2);
-              nh.param("outdoor_hover_convergent_duration", hover_convergent_duration_, 0.5);
-              nh.param("outdoor_xy_convergent_thresh", xy_convergent_thresh_, 0.6);
-              nh.param("outdoor_z_convergent_thresh", z_convergent_thresh_, 0.05);
-
-              ROS_WARN_STREAM("update the navigation parameters for outdoor flight, takeoff height: " << takeoff_height_ << "; outdoor_hover_convergent_duration: " << hover_convergent_duration_ << "; outdoor_xy_convergent_thresh: " << xy_convergent_thresh_ << "; outdoor_z_convergent_thresh: " << z_convergent_thresh_);
-
-              break;
-            }
-        }
-
-      setNaviState(START_STATE);
-      trajectory_mode_ = false;
-      setTargetXyFromCurrentState();
-      setTargetPosZ(takeoff_height_);
-      setTargetVelZ(0);
-      setTargetAccZ(0);
-      setInitHeight(estimator_->getPos(Frame::COG, estimate_mode_).z());
-      setTargetYawFromCurrentState();
-
-      ROS_INFO_STREAM("init height for takeoff: " << init_height_);
-
-      ROS_INFO("Start state");
+      handleEvent(NavigationEvent::ARM, estimator_->getStateStatus(State::Z_BASE, estimate_mode_));
     }
 
     virtual void updateLandCommand();
@@ -427,23 +423,13 @@ namespace aerial_robot_navigation
     void flightStatusAckCallback(const std_msgs::UInt8ConstPtr& ack_msg)
     {
       if(ack_msg->data == spinal::FlightConfigCmd::ARM_OFF_CMD)
-        {//  arming off
-          ROS_INFO("STOP RES From AERIAL ROBOT");
-          setNaviState(ARM_OFF_STATE);
-        }
+        handleEvent(NavigationEvent::ARM_OFF_ACK);
 
       if(ack_msg->data == spinal::FlightConfigCmd::ARM_ON_CMD)
-        {//  arming on
-          ROS_INFO("START RES From AERIAL ROBOT");
-          setNaviState(ARM_ON_STATE);
-        }
+        handleEvent(NavigationEvent::ARM_ON_ACK);
 
       if(ack_msg->data == spinal::FlightConfigCmd::FORCE_LANDING_CMD)
-        {//  get the first force landing message from spinal
-          ROS_INFO("FORCE LANDING MSG From AERIAL ROBOT");
-
-          force_landing_flag_ = true;
-        }
+        handleEvent(NavigationEvent::FORCE_LANDING_ACK);
     }
 
     void takeoffCallback(const std_msgs::EmptyConstPtr & msg)
@@ -458,73 +444,28 @@ namespace aerial_robot_navigation
 
     void landCallback(const std_msgs::EmptyConstPtr & msg)
     {
-      if(force_att_control_flag_) return;
-
-      if(!teleop_flag_) return;
-
-      setNaviState(LAND_STATE);
-      ROS_INFO("Land state");
+      handleEvent(NavigationEvent::LAND);
     }
 
     void haltCallback(const std_msgs::EmptyConstPtr & msg)
     {
-      if(!teleop_flag_) return;
-
-      force_landing_flag_ = true;
-      setNaviState(STOP_STATE);
-
-      ROS_INFO("Halt state");
+      handleEvent(NavigationEvent::HALT);
     }
 
     void forceLandingCallback(const std_msgs::EmptyConstPtr & msg)
     {
-      spinal::FlightConfigCmd flight_config_cmd;
-      flight_config_cmd.cmd = spinal::FlightConfigCmd::FORCE_LANDING_CMD;
-      flight_config_pub_.publish(flight_config_cmd);
-      force_landing_flag_ = true;
-
-      ROS_INFO("Force Landing state");
+      handleEvent(NavigationEvent::FORCE_LANDING);
     }
 
     void xyControlModeCallback(const std_msgs::Int8ConstPtr & msg)
     {
-      if(getNaviState() > START_STATE)
-        {
-          if(msg->data == 0)
-            {
-              setTargetXyFromCurrentState();
-              setTargetZeroVel();
-              setTargetZeroAcc();
-              xy_control_mode_ = POS_CONTROL_MODE;
-              ROS_INFO("x/y position control mode");
-            }
-          if(msg->data == 1)
-            {
-              setTargetZeroVel();
-              setTargetZeroAcc();
-              xy_control_mode_ = VEL_CONTROL_MODE;
-              ROS_INFO("x/y velocity control mode");
-            }
-          if(msg->data == 2)
-            {
-              xy_control_mode_ = ACC_CONTROL_MODE;
-              ROS_INFO("x/y acceleration control mode");
-            }
-        }
+      handleEvent(NavigationEvent::XY_CONTROL_MODE, msg->data);
     }
 
     void stopTeleopCallback(const std_msgs::UInt8ConstPtr & stop_msg)
     {
-      if(stop_msg->data == 1)
-        {
-          ROS_WARN("stop teleop control");
-          teleop_flag_ = false;
-        }
-      else if(stop_msg->data == 0)
-        {
-          ROS_WARN("start teleop control");
-          teleop_flag_ = true;
-        }
+      if(stop_msg->data == 1) handleEvent(NavigationEvent::TELEOP, false);
+      else if(stop_msg->data == 0) handleEvent(NavigationEvent::TELEOP, true);
     }
 
     void setTargetXyFromCurrentState()
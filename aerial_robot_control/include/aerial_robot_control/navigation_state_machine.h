@@ -0,0 +1,225 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace aerial_robot_navigation
+{
+  /* control mode */
+  enum control_mode
+    {
+      POS_CONTROL_MODE,
+      VEL_CONTROL_MODE,
+      ACC_CONTROL_MODE
+    };
+
+  // navi state
+  enum flight_state
+    {
+      ARM_OFF_STATE,
+      START_STATE,
+      ARM_ON_STATE,
+      TAKEOFF_STATE,
+      LAND_STATE,
+      HOVER_STATE,
+      STOP_STATE
+    };
+
+  struct NavigationConfig
+  {
+    double hover_convergent_duration = 1.0;
+    double z_convergent_thresh = 0.05;
+    double xy_convergent_thresh = 0.15;
+    double land_check_duration = 0.5;
+    double land_pos_convergent_thresh = 0.02;
+    double land_vel_convergent_thresh = 0.05;
+    double force_landing_to_halt_du = 1.0;
+    bool check_joy_stick_heart_beat = false;
+    double joy_stick_heart_beat_du = 2.0;
+  };
+
+  struct NavigationEvent
+  {
+    enum Type : uint8_t
+      {
+        ARM,               // value: 1 if the altitude is estimated
+        TAKEOFF,
+        LAND,
+        HALT,
+        FORCE_LANDING,
+        ARM_ON_ACK,
+        ARM_OFF_ACK,
+        FORCE_LANDING_ACK,
+        XY_CONTROL_MODE,   // value: control_mode
+        TELEOP,            // value: 1 to enable, 0 to disable
+        BATTERY,           // value: LOW_VOLTAGE | HIGH_VOLTAGE
+        JOY,               // heartbeat, value: 1 if the halt button is held
+        JOY_START,
+        JOY_ATT_MODE,
+        JOY_VEL_MODE,
+        JOY_POS_MODE,
+        LANDING_PREPARED,
+        TYPE_NUM
+      };
+
+    static constexpr int LOW_VOLTAGE = 0x01;
+    static constexpr int HIGH_VOLTAGE = 0x02;
+
+    Type type;
+    double stamp; // time of the event, for the joystick the stamp of the message
+    int value;
+  };
+
+  /* sensor status at each update, sampled by the caller */
+  struct NavigationInput
+  {
+    double stamp;
+    bool xy_estimation = true; // x and y are estimated
+    bool unhealth = false; // sensor unhealth level 3
+    double delta[3] = {0, 0, 0}; // target - current cog position
+    double z = 0; // current cog height
+    double vz = 0; // current cog vertical velocity
+  };
+
+  struct NavigationOutput
+  {
+    /* side effects for the caller, applied after the transition */
+    enum Action : uint32_t
+      {
+        SEND_ARM_ON_CMD = 1 << 0,
+        SEND_ARM_OFF_CMD = 1 << 1,
+        SEND_FORCE_LANDING_CMD = 1 << 2,
+        START_SENSOR_FUSION = 1 << 3,
+        SET_FLYING = 1 << 4,
+        SET_FORCE_ATT_CONTROL = 1 << 5,
+        INIT_TAKEOFF_TARGET = 1 << 6, // xy and yaw from the current state, z to the takeoff height
+        HOLD_XY_TARGET = 1 << 7, // xy from the current state
+        HOLD_Z_TARGET = 1 << 8, // z from the current state
+        HOLD_YAW_TARGET = 1 << 9, // yaw from the current state
+        ZERO_VEL_ACC_TARGET = 1 << 10,
+        UPDATE_LAND_COMMAND = 1 << 11,
+        RESET = 1 << 12,
+        HALT = 1 << 13,
+        PREPARE_LANDING = 1 << 14,
+      };
+
+    uint32_t actions = 0;
+    uint8_t prev_state = ARM_OFF_STATE;
+    uint8_t state = ARM_OFF_STATE;
+
+    bool has(Action action) const { return actions & action; }
+    bool transition() const { return prev_state != state; }
+  };
+
+  /*
+    flight state logic of the navigator without ROS: takeoff, hover, land,
+    force landing, battery, joystick heartbeat and xy control mode fallback.
+    Time only comes from the events and inputs, so the same sequence always
+    gives the same transitions and outputs. Not thread-safe.
+  */
+  class NavigationStateMachine
+  {
+  public:
+    enum LogLevel { INFO, WARN, ERROR };
+    using Logger = std::function<void(LogLevel, const std::string&)>;
+
+    static constexpr uint8_t LOW_BATTERY_STATE = 0x10;
+    static constexpr uint8_t FORCE_LANDING_STATE = 0x11;
+
+    NavigationStateMachine();
+
+    void setConfig(const NavigationConfig& config) { config_ = config; }
+    const NavigationConfig& getConfig() const { return config_; }
+    void setLogger(Logger logger) { logger_ = logger; }
+
+    /* hover until LANDING_PREPARED before landing, e.g. to level the joints */
+    void setLandingPreparation(bool flag) { landing_preparation_ = flag; }
+
+    NavigationOutput handle(const NavigationEvent& event);
+    NavigationOutput update(const NavigationInput& input);
+
+    uint8_t getState() const { return state_; }
+    void setState(uint8_t state) { state_ = state; }
+    int getXyControlMode() const { return xy_control_mode_; }
+    void setXyControlMode(int mode) { xy_control_mode_ = mode; }
+    /* mode restored when the xy estimation is established again */
+    void setPrevXyControlMode(int mode) { prev_xy_control_mode_ = mode; }
+    bool getForceLandingFlag() const { return force_landing_; }
+    bool getForceAttControlFlag() const { return force_att_control_; }
+    bool getLowVoltageFlag() const { return low_voltage_; }
+    bool getHighVoltageFlag() const { return high_voltage_; }
+    bool getTeleopFlag() const { return teleop_; }
+    void setTeleopFlag(bool flag) { teleop_ = flag; }
+    double getLandHeight() const { return land_height_; }
+    void setLandHeight(double height) { land_height_ = height; }
+    double getForceLandingStartTime() const { return force_landing_start_time_; }
+    bool preparingLanding() const { return preparing_landing_; }
+    bool landingPrepared() const { return landing_prepared_; }
+
+    /* state for the flight_state topic */
+    uint8_t getPublishedState() const;
+
+  private:
+    void log(LogLevel level, const std::string& msg) const { if(logger_) logger_(level, msg); }
+    void transit(NavigationOutput& output, uint8_t state) { state_ = state; output.state = state; }
+
+    NavigationConfig config_;
+    Logger logger_;
+    bool landing_preparation_;
+
+    uint8_t state_;
+    int xy_control_mode_;
+    int prev_xy_control_mode_;
+    bool force_att_control_;
+    bool force_landing_;
+    bool low_voltage_;
+    bool high_voltage_;
+    bool teleop_;
+    bool joy_stick_heart_beat_;
+    bool ready_;
+    bool preparing_landing_;
+    bool landing_prepared_;
+
+    double joy_stick_prev_time_;
+    double force_landing_start_time_;
+    double hover_convergent_start_time_;
+    double land_check_start_time_;
+    double land_height_;
+  };
+};
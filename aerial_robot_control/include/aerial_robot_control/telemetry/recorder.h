@@ -0,0 +1,184 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <aerial_robot_control/control/utils/ring_buffer.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aerial_robot_control
+{
+  namespace telemetry
+  {
+    /*
+      binary log (native byte order):
+      - header: "ARTL", uint16 version, uint16 reserved
+      - channel definition: uint8 CHANNEL, uint16 id, string name, uint16 field num, field names (string: uint16 length + chars)
+      - sample: uint8 SAMPLE, uint16 channel id, uint16 value num, double stamp, double values
+      a channel definition is always written before the samples of the channel.
+    */
+    constexpr char MAGIC[4] = {'A', 'R', 'T', 'L'};
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t MAX_FIELDS = 64;
+
+    enum : uint8_t {CHANNEL = 1, SAMPLE = 2};
+
+    struct Channel
+    {
+      uint16_t id;
+      std::string name;
+      std::vector<std::string> fields;
+    };
+
+    struct Sample
+    {
+      uint16_t channel;
+      double stamp;
+      std::vector<double> values;
+    };
+
+    struct RecorderStats
+    {
+      uint64_t recorded = 0;
+      uint64_t dropped = 0; // ring buffer full
+      uint64_t written = 0;
+      double max_record_time = 0; // [sec] of record() on the producer threads
+      double mean_record_time = 0;
+    };
+
+    /*
+      recorder with a lock-free ring buffer per producer thread, drained by a background writer:
+      - record() never blocks and never allocates after the first call in each thread, the sample is dropped if the buffer is full
+      - addChannel(), open() and close() take locks and are not for the real-time threads
+    */
+    class Recorder
+    {
+    public:
+      Recorder(size_t buffer_size = 4096, double write_period = 0.01);
+      ~Recorder();
+
+      bool open(const std::string& path);
+      /* write the remaining samples and close the file */
+      void close();
+      bool isOpen() const { return running_; }
+
+      /* return the channel id, or -1 if there are too many fields */
+      int addChannel(const std::string& name, const std::vector<std::string>& fields);
+
+      bool record(int channel, double stamp, const double* values, size_t size);
+      bool record(int channel, double stamp, const std::vector<double>& values)
+      {
+        return record(channel, stamp, values.data(), values.size());
+      }
+
+      RecorderStats getStats() const;
+
+    private:
+      struct Slot
+      {
+        uint16_t channel;
+        uint16_t size;
+        double stamp;
+        double values[MAX_FIELDS];
+      };
+
+      struct Producer
+      {
+        Producer(size_t buffer_size): buffer(buffer_size) {}
+        RingBuffer<Slot> buffer;
+        std::atomic<uint64_t> recorded{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> record_time_sum{0}; // [nsec]
+        std::atomic<uint64_t> record_time_max{0};
+      };
+
+      const uint64_t id_; // key of the producer of each thread
+      const size_t buffer_size_;
+      const double write_period_;
+
+      mutable std::mutex producers_mutex_;
+      std::vector<std::unique_ptr<Producer> > producers_;
+
+      std::mutex channels_mutex_;
+      std::vector<Channel> channels_;
+
+      std::mutex file_mutex_;
+      FILE* file_;
+      std::thread writer_;
+      std::mutex wake_mutex_;
+      std::condition_variable wake_; // only to stop the writer, the producers never notify
+      std::atomic<bool> running_;
+      std::atomic<uint64_t> written_;
+
+      Producer* producer();
+      void writerFunc();
+      void drain();
+      void writeChannel(const Channel& channel);
+    };
+
+    class Reader
+    {
+    public:
+      Reader(): file_(nullptr), version_(0) {}
+      ~Reader() { close(); }
+
+      bool open(const std::string& path);
+      void close();
+
+      /* next sample, the channel definitions before it are added to channels() */
+      bool next(Sample& sample);
+
+      uint16_t getVersion() const { return version_; }
+      const std::vector<Channel>& getChannels() const { return channels_; }
+      const std::string& getError() const { return error_; }
+
+    private:
+      FILE* file_;
+      uint16_t version_;
+      std::vector<Channel> channels_;
+      std::string error_;
+
+      bool readString(std::string& str);
+    };
+  };
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "aerial_robot_control/trajectory/math/types.hpp"
+#include "aerial_robot_control/trajectory/trajectory_reference/polynomial.hpp"
+
+namespace agi {
+
+/* Piecewise polynomial with one segment between each pair of constraints.
+/  The segment order follows from the highest weighted derivative r as 2r-1,
+/  which is the optimal order for the unconstrained segments. Derivatives up
+/  to r-1 are continuous at the knots. Instead of a dense QP over all
+/  coefficients, the free knot derivatives are solved in closed form: each
+/  segment couples only its two knots, so the problem is block-tridiagonal.
+/  The interface mirrors Polynomial to be used as PolyType.
+*/
+class PiecewisePolynomial {
+ public:
+  // Factorization of the knot system. It depends only on the durations, the
+  // free derivatives and the weights, so polynomials with the same order and
+  // weights over the same knots can share it and solve only the right hand
+  // side. Not thread safe, share only between polynomials solved together.
+  struct Factorization {
+    std::vector<Scalar> durations;
+    Matrix<> free_mask;            // 1 for free derivatives, per knot.
+    std::vector<Matrix<>> P;       // Selection of the free derivatives.
+    std::vector<Matrix<>> Q;       // Segment cost Hessians.
+    std::vector<Matrix<>> A;       // Diagonal blocks of the full system.
+    std::vector<Matrix<>> U;       // Free off-diagonal blocks.
+    std::vector<Matrix<>> Y;       // D^-1 U of the elimination.
+    std::vector<Eigen::LDLT<Matrix<>>> D;
+  };
+
+  PiecewisePolynomial(const int order = 7,
+                      const Vector<>& weights = Vector<4>(0, 0, 0, 1),
+                      const int continuity = -1);
+  PiecewisePolynomial(const PiecewisePolynomial& rhs) = default;
+  ~PiecewisePolynomial() = default;
+
+  bool scale(const Scalar start_time = NAN, const Scalar duration = NAN);
+  int addConstraint(const Scalar time, const Vector<>& constraint);
+  bool solve();
+  bool eval(const Scalar time, Ref<Vector<>> state) const;
+  bool eval(ConstRef<ArrayVector<>> times, Ref<Matrix<>> states) const;
+  Scalar operator()(const Scalar time, const int order = 0) const;
+
+  inline int order() const noexcept { return order_; }
+  inline int size() const noexcept { return order_ + 1; }
+  inline int segments() const noexcept { return (int)coeffs_.size(); }
+  bool solved() const;
+
+  int findSegment(const Scalar time) const;
+  std::vector<Scalar> segmentDurations() const;
+  Matrix<> knotDerivatives() const { return d_; }
+  Matrix<> coeffs(const int segment) const { return coeffs_.at(segment); }
+
+  // Weighted derivative cost of the last solution and its gradient with
+  // respect to the segment durations, both in real time.
+  Scalar cost() const;
+  Vector<> costGradient() const;
+
+  void reset();
+
+  // Reuse the factorization between solves with unchanged durations, nullptr
+  // to factorize on every solve.
+  void shareFactorization(
+    const std::shared_ptr<Factorization>& factorization) {
+    factorization_ = factorization;
+  }
+
+ private:
+  struct Knot {
+    Scalar t;
+    Vector<> value;  // Fixed derivatives, NaN if free.
+  };
+
+  bool factorize(const Matrix<>& free_mask, Factorization* F) const;
+  void segmentCost(const int segment, Scalar* cost, Scalar* gradient) const;
+  Scalar tauFromTime(const Scalar t) const;
+
+  const int r_;
+  const int order_;
+  const int continuity_;
+  const Array<> alpha_;
+
+  Vector<> weights_;  // Weights on derivatives starting from velocity.
+  Matrix<> M_inv_;    // Scaled knot derivatives to segment coefficients.
+  std::vector<Matrix<>> K_;  // Segment cost for each weighted derivative.
+
+  std::vector<Knot> knots_;
+
+  // Solution
+  std::vector<Scalar> knots_tau_;
+  std::vector<Scalar> durations_;
+  Matrix<> d_;  // Knot derivatives in real time, one column per knot.
+  std::vector<Matrix<>> coeffs_;  // Derivative coefficients per segment.
+  mutable int segment_hint_{0};
+  std::shared_ptr<Factorization> factorization_;
+
+  Scalar t_scale_{1.0};
+  Scalar t_offset_{0.0};
+};
+
+}  // namespace agi
@@ -4,6 +4,36 @@
 
 namespace agi {
 
+Array<> createExponents(const int order);
+Array<> createAlpha(const int order);
+
+/* Horner-form evaluation of sum_i c[i] * tau^i.
+/  The fixed-order kernels let the compiler unroll the common orders.
+*/
+template<int N>
+inline Scalar horner(const Scalar* c, const Scalar tau) {
+  Scalar r = c[N - 1];
+  for (int i = N - 2; i >= 0; --i) r = r * tau + c[i];
+  return r;
+}
+
+inline Scalar horner(const Scalar* c, const int n, const Scalar tau) {
+  switch (n) {
+    case 6:
+      return horner<6>(c, tau);
+    case 8:
+      return horner<8>(c, tau);
+    case 12:
+      return horner<12>(c, tau);
+    default:
+      break;
+  }
+
+  Scalar r = c[n - 1];
+  for (int i = n - 2; i >= 0; --i) r = r * tau + c[i];
+  return r;
+}
+
 template<typename Solver = Eigen::HouseholderQR<Matrix<>>>
 class Polynomial {
  public:
@@ -17,6 +47,8 @@ class Polynomial {
   int addConstraint(const Scalar time, const Vector<>& constraint);
   bool solve();
   bool eval(const Scalar time, Ref<Vector<>> state) const;
+  // Batch evaluation: column i of states holds the derivatives at times(i).
+  bool eval(ConstRef<ArrayVector<>> times, Ref<Matrix<>> states) const;
   Scalar operator()(const Scalar time, const int order = 0) const;
 
   inline int order() const noexcept { return order_; }
@@ -29,6 +61,7 @@ class Polynomial {
   Matrix<> exponents() const { return exponents_.transpose(); }
   Matrix<> alpha() const { return alpha_.transpose(); }
   Vector<> coeffs() const { return c_; }
+  Matrix<> derivativeCoeffs() const { return dc_; }
 
   Scalar tauFromTime(const Scalar t) const;
   Vector<> tauVector(const Scalar tau, const int order = 0) const;
@@ -41,10 +74,14 @@ class Polynomial {
  private:
   Matrix<> createH(const Vector<>& weights) const;
   bool solve(const Matrix<>& H, const Matrix<>& A, const Vector<>& b);
+  void updateDerivativeCoeffs();
 
   const int order_;
   const int continuity_;
   Vector<> c_;
+  // Coefficients of each derivative in tau (column k: k-th derivative),
+  // zero padded, for Horner-form evaluation.
+  Matrix<> dc_;
   const Array<> exponents_;
   const Array<> alpha_;
 
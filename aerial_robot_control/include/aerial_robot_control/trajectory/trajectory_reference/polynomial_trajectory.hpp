@@ -2,6 +2,7 @@
 #pragma once
 
 #include "aerial_robot_control/trajectory/reference_base.hpp"
+#include "aerial_robot_control/trajectory/trajectory_reference/piecewise_polynomial.hpp"
 #include "aerial_robot_control/trajectory/trajectory_reference/polynomial.hpp"
 #include "aerial_robot_control/trajectory/types/quadrotor.hpp"
 
@@ -24,6 +25,10 @@ class PolynomialTrajectory : public ReferenceBase {
   using ReferenceBase::getSetpoint;
   Setpoint getSetpoint(const QuadState& state, const Scalar time) override;
   QuadState getState(const Scalar time) const;
+  // Batch sampling, evaluating all axes for all times in one pass.
+  // Times are expected in ascending order.
+  bool getStates(const std::vector<Scalar>& times,
+                 std::vector<QuadState>& states) const;
   virtual Setpoint getStartSetpoint() override final;
   virtual Setpoint getEndSetpoint() override final;
 
@@ -48,6 +53,8 @@ class PolynomialTrajectory : public ReferenceBase {
   void setForwardHeading(const bool forward);
 
  protected:
+  void fillAttitude(QuadState& state, const Vector<3>& yaw) const;
+
   template<typename EvalFunc, typename CompFunc>
   Scalar findTime(const Scalar dt, const Scalar dt_min, const Scalar t_start,
                   const Scalar t_end, EvalFunc eval, CompFunc comp) const;
@@ -115,4 +122,54 @@ class ClosedFormMinJerkTrajectory
                            "Closed-Form Mininum Jerk Trajectory") {}
 };
 
+// Piecewise Minimum-Snap with Segment Time Allocation
+// Unlimited if default constructed.
+struct TrajectoryLimits {
+  TrajectoryLimits() = default;
+  TrajectoryLimits(const Quadrotor& quad, const Scalar v_max = INF);
+
+  Scalar v_max{INF};
+  Scalar a_max{INF};
+  Scalar j_max{INF};
+  Scalar thrust_min{-INF};  // Mass-normalized collective thrust.
+  Scalar thrust_max{INF};
+};
+
+class PiecewiseMinSnapTrajectory
+  : public PolynomialTrajectory<PiecewisePolynomial> {
+ public:
+  PiecewiseMinSnapTrajectory(
+    const std::vector<QuadState>& states, const int continuity = 3,
+    const std::string& name = "Piecewise Minimum Snap Trajectory")
+    : PolynomialTrajectory(states, Vector<4>(0, 0, 0, 1), 7, continuity,
+                           name) {
+    shareFactorization();
+  }
+  PiecewiseMinSnapTrajectory(const PiecewiseMinSnapTrajectory& rhs)
+    : PolynomialTrajectory(rhs) {
+    shareFactorization();
+  }
+
+  std::vector<Scalar> segmentDurations() const;
+  bool setSegmentDurations(const std::vector<Scalar>& durations);
+  Scalar cost() const;
+
+  // Ratio by which all segments have to be stretched to meet the limits.
+  Scalar limitRatio(const TrajectoryLimits& limits,
+                    const int samples_per_segment = 20) const;
+  // Distribute the duration among the segments by projected gradient descent
+  // on the snap cost, then scale the whole trajectory to the limits.
+  // Each iteration re-solves the position axes, in total about 8 ms for 20
+  // waypoints, so call it on replanning and not at control rate.
+  Scalar optimizeSegmentDurations(const TrajectoryLimits& limits,
+                                  const int iterations = 50,
+                                  const Scalar tolerance = 1e-4);
+
+ private:
+  // The position axes share one factorization, yaw has its own order.
+  void shareFactorization();
+  bool solveSegmentDurations(const std::vector<Scalar>& durations,
+                             const bool solve_yaw);
+};
+
 }  // namespace agi
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "aerial_robot_control/trajectory/math/types.hpp"
+#include "aerial_robot_control/trajectory/trajectory_reference/polynomial_trajectory.hpp"
+#include "aerial_robot_control/trajectory/types/quad_state.hpp"
+
+namespace agi {
+
+struct RecedingHorizonParams {
+  Scalar replan_period{0.1};  // Minimum time between two solves.
+  Scalar horizon{1.0};        // Horizon of getPreview().
+  Scalar preview_dt{0.1};
+  Scalar solve_delay{0.0};    // Start of a new solution after the request.
+  Scalar mean_vel{0.5};       // Nominal velocity of the time allocation.
+  Scalar mean_yaw_rate{INF};  // Nominal yaw rate, yaw is ignored if infinite.
+  Scalar min_duration{0.0};   // Minimum duration to reach the goal.
+  int allocation_iterations{10};  // Relative segment time allocation.
+  TrajectoryLimits limits;
+};
+
+/* Reference generator re-solving a piecewise minimum-snap trajectory from
+/  its own current reference state whenever the waypoints change. Waypoint
+/  and goal updates can be streamed at any rate: they are collected and
+/  solved at most once per replan period, and the new trajectory starts from
+/  the position, velocity, acceleration and jerk of the previous one, so the
+/  reference stays continuous up to the jerk. Durations are allocated from
+/  the nominal velocities and stretched until the limits hold. Waypoint
+/  times are ignored, the last waypoint is the goal, reached at rest.
+/  Not thread-safe, the owner has to serialize the calls. To keep the solve
+/  out of a real-time loop, split update() into prepare(), the static
+/  solve() on another thread and apply(): the current trajectory is followed
+/  until the solution starts solve_delay after the request.
+*/
+class RecedingHorizonReference {
+ public:
+  RecedingHorizonReference(
+    const RecedingHorizonParams& params = RecedingHorizonParams());
+
+  // Hold the given state and drop all waypoints.
+  void reset(const QuadState& state);
+  // Replace the remaining waypoints.
+  void setGoal(const QuadState& goal);
+  void setWaypoints(const std::vector<QuadState>& waypoints);
+  void addWaypoint(const QuadState& waypoint);
+
+  // Re-solve at time t if the waypoints changed and the replan period has
+  // passed, returns true if there is a new trajectory.
+  bool update(const Scalar t);
+
+  struct Problem {
+    QuadState start;
+    std::vector<QuadState> waypoints;
+    RecedingHorizonParams params;
+    int revision{0};
+  };
+  struct Solution {
+    std::shared_ptr<PiecewiseMinSnapTrajectory> trajectory;
+    int revision{0};
+  };
+  // Take the problem if update() would re-solve at time t.
+  bool prepare(const Scalar t, Problem& problem);
+  // Solve without access to the reference, nullptr trajectory on failure.
+  static Solution solve(const Problem& problem);
+  // Install the solution unless the waypoints changed since prepare().
+  bool apply(const Solution& solution);
+
+  QuadState getState(const Scalar t) const;
+  // Reference from t over the horizon, sampled with the preview dt.
+  bool getPreview(const Scalar t, std::vector<QuadState>& states) const;
+  // Samples of the whole current trajectory.
+  bool getStates(const Scalar dt, std::vector<QuadState>& states) const;
+
+  // Waypoints pending, a solution outstanding or trajectory not finished at
+  // time t.
+  bool active(const Scalar t) const;
+  Scalar getEndTime() const;
+  int replans() const { return replans_; }
+  size_t remainingWaypoints() const { return waypoints_.size(); }
+
+  const RecedingHorizonParams& params() const { return params_; }
+  void setParams(const RecedingHorizonParams& params) { params_ = params; }
+
+ private:
+  RecedingHorizonParams params_;
+
+  std::shared_ptr<PiecewiseMinSnapTrajectory> trajectory_;
+  // Followed until the start of trajectory_ after a delayed solution.
+  std::shared_ptr<PiecewiseMinSnapTrajectory> previous_;
+  QuadState hold_state_;  // Reference without a trajectory.
+
+  // Remaining waypoints, timed with the arrival of the last solution or NaN
+  // if added since then.
+  std::vector<QuadState> waypoints_;
+  bool changed_{false};
+  bool pending_{false};  // Prepared and not applied yet.
+  int revision_{0};  // Incremented with every change of the waypoints.
+  Scalar last_replan_time_{-INF};
+  int replans_{0};
+};
+
+}  // namespace agi
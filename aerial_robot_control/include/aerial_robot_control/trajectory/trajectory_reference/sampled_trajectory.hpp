@@ -18,7 +18,11 @@ class SampledTrajectory : public ReferenceBase {
   Setpoint interpolateSetpoints(const Setpoint& setpoint_1,
                                 const Setpoint& setpoint_2,
                                 const Scalar x) const;
+  size_t findUpperIndex(const Scalar t) const;
+
   SetpointVector setpoints_;
+  // Segment hint for monotonic queries, falls back to binary search.
+  mutable size_t upper_index_{0};
 };
 
 }  // namespace agi
@@ -35,13 +35,18 @@
 
 
 #include <aerial_robot_control/control/base/pose_linear_controller.h>
+#include <array>
 
 namespace aerial_robot_control
 {
   PoseLinearController::PoseLinearController():
     ControlBase(),
-    pid_controllers_(0),
     pid_reconf_servers_(0),
+    pid_pub_interval_(0),
+    pid_pub_stamp_(0),
+    pid_pub_due_(true),
+    pid_telemetry_channel_(-1),
+    pid_gain_telemetry_channel_(-1),
     pos_(0,0,0), target_pos_(0,0,0),
     vel_(0,0,0), target_vel_(0,0,0),
     rpy_(0,0,0), target_rpy_(0,0,0),
@@ -178,6 +183,7 @@ namespace aerial_robot_control
     pid_reconf_servers_.back()->setCallback(boost::bind(&PoseLinearController::cfgPidCallback, this, _1, _2, std::vector<int>(1, YAW)));
 
 
+    getParam<double>(control_nh, "pid_pub_interval", pid_pub_interval_, 0.0); // 0: publish in every control tick
     pid_pub_ = nh_.advertise<aerial_robot_msgs::PoseControlPid>("debug/pose/pid", 10);
   }
 
@@ -186,7 +192,7 @@ namespace aerial_robot_control
     ControlBase::reset();
     start_rp_integration_ = false;
 
-    for(auto& controller: pid_controllers_) controller.reset();
+    pid_controllers_.reset();
   }
 
   bool PoseLinearController::update()
@@ -203,70 +209,67 @@ namespace aerial_robot_control
   {
     pos_ = estimator_->getPos(Frame::COG, estimate_mode_);
     vel_ = estimator_->getVel(Frame::COG, estimate_mode_);
-    target_pos_ = navigator_->getTargetPos();
-    target_vel_ = navigator_->getTargetVel();
-    target_acc_ = navigator_->getTargetAcc();
-
     rpy_ = estimator_->getEuler(Frame::COG, estimate_mode_);
     omega_ = estimator_->getAngularVel(Frame::COG, estimate_mode_);
-    target_rpy_ = navigator_->getTargetRPY();
-    target_omega_ = navigator_->getTargetOmega();
-    target_ang_acc_ = navigator_->getTargetAngAcc();
+
+    // all targets from the same navigator command
+    const aerial_robot_navigation::TargetSetpoint setpoint = navigator_->getTargetSetpoint();
+    target_pos_ = setpoint.pos;
+    target_vel_ = setpoint.vel;
+    target_acc_ = setpoint.acc;
+    target_rpy_ = setpoint.rpy;
+    target_omega_ = setpoint.omega;
+    target_ang_acc_ = setpoint.ang_acc;
 
     // time diff
     double du = ros::Time::now().toSec() - control_timestamp_;
+    pid_pub_due_ = ros::Time::now().toSec() - pid_pub_stamp_ >= pid_pub_interval_;
+
+    // all axes are updated in one vectorized pass of the PID bank
+    PIDBank::Array err_p = PIDBank::Array::Zero(pid_controllers_.size());
+    PIDBank::Array err_d = PIDBank::Array::Zero(pid_controllers_.size());
+    PIDBank::Array ff = PIDBank::Array::Zero(pid_controllers_.size());
+    PIDBank::Array du_array = PIDBank::Array::Constant(pid_controllers_.size(), du);
+    pid_controllers_.active().setConstant(true);
 
     // x & y
     switch(navigator_->getXyControlMode())
       {
       case aerial_robot_navigation::POS_CONTROL_MODE:
-        pid_controllers_.at(X).update(target_pos_.x() - pos_.x(), du, target_vel_.x() - vel_.x(), target_acc_.x());
-        pid_controllers_.at(Y).update(target_pos_.y() - pos_.y(), du, target_vel_.y() - vel_.y(), target_acc_.y());
+        err_p(X) = target_pos_.x() - pos_.x();
+        err_p(Y) = target_pos_.y() - pos_.y();
+        err_d(X) = target_vel_.x() - vel_.x();
+        err_d(Y) = target_vel_.y() - vel_.y();
         break;
       case aerial_robot_navigation::VEL_CONTROL_MODE:
-        pid_controllers_.at(X).update(0, du, target_vel_.x() - vel_.x(), target_acc_.x());
-        pid_controllers_.at(Y).update(0, du, target_vel_.y() - vel_.y(), target_acc_.y());
+        err_d(X) = target_vel_.x() - vel_.x();
+        err_d(Y) = target_vel_.y() - vel_.y();
         break;
       case aerial_robot_navigation::ACC_CONTROL_MODE:
-        pid_controllers_.at(X).update(0, du, 0, target_acc_.x());
-        pid_controllers_.at(Y).update(0, du, 0, target_acc_.y());
         break;
       default:
+        pid_controllers_.active()(X) = false;
+        pid_controllers_.active()(Y) = false;
         break;
       }
-
-    if(navigator_->getForceLandingFlag())
-      {
-        pid_controllers_.at(X).reset();
-        pid_controllers_.at(Y).reset();
-      }
+    ff(X) = target_acc_.x();
+    ff(Y) = target_acc_.y();
 
     // z
-    double err_z = target_pos_.z() - pos_.z();
-    double err_v_z = target_vel_.z() - vel_.z();
-    double du_z = du;
+    err_p(Z) = target_pos_.z() - pos_.z();
+    err_d(Z) = target_vel_.z() - vel_.z();
     double z_p_limit = pid_controllers_.at(Z).getLimitP();
 
     if(navigator_->getForceLandingFlag())
       {
         pid_controllers_.at(Z).setLimitP(0); // no p control in force landing phase
-        err_z = force_landing_descending_rate_;
-        err_v_z = 0;
+        err_p(Z) = force_landing_descending_rate_;
+        err_d(Z) = 0;
         target_acc_.setZ(0);
       }
-
-    pid_controllers_.at(Z).update(err_z, du_z, err_v_z, target_acc_.z());
-
-    if(pid_controllers_.at(Z).getErrI() < 0) pid_controllers_.at(Z).setErrI(0);
-
-    if(navigator_->getForceLandingFlag())
-      {
-        pid_controllers_.at(Z).setLimitP(z_p_limit); // revert z p limit
-        pid_controllers_.at(Z).setErrP(0); // for derived controller which use err_p in feedback control (e.g., LQI)
-      }
+    ff(Z) = target_acc_.z();
 
     // roll pitch
-    double du_rp = du;
     if(!start_rp_integration_)
       {
         if(pos_.z() - navigator_->getInitHeight () > start_rp_integration_height_)
@@ -277,24 +280,51 @@ namespace aerial_robot_control
             navigator_->getFlightConfigPublisher().publish(flight_config_cmd);
             ROS_WARN_ONCE("start roll/pitch I control");
           }
-        du_rp = 0;
+        du_array(ROLL) = 0;
+        du_array(PITCH) = 0;
       }
-    pid_controllers_.at(ROLL).update(target_rpy_.x() - rpy_.x(), du_rp, target_omega_.x() - omega_.x(), target_ang_acc_.x());
-    pid_controllers_.at(PITCH).update(target_rpy_.y() - rpy_.y(), du_rp, target_omega_.y() - omega_.y(), target_ang_acc_.y());
+    err_p(ROLL) = target_rpy_.x() - rpy_.x();
+    err_p(PITCH) = target_rpy_.y() - rpy_.y();
+    err_d(ROLL) = target_omega_.x() - omega_.x();
+    err_d(PITCH) = target_omega_.y() - omega_.y();
+    ff(ROLL) = target_ang_acc_.x();
+    ff(PITCH) = target_ang_acc_.y();
 
     // yaw
-    double err_yaw = angles::shortest_angular_distance(rpy_.z(), target_rpy_.z());
-    double err_omega_z = target_omega_.z() - omega_.z();
+    err_p(YAW) = angles::shortest_angular_distance(rpy_.z(), target_rpy_.z());
+    err_d(YAW) = target_omega_.z() - omega_.z();
     if(!need_yaw_d_control_)
       {
-        err_omega_z = target_omega_.z(); // part of the control in spinal
+        err_d(YAW) = target_omega_.z(); // part of the control in spinal
+      }
+    ff(YAW) = target_ang_acc_.z();
+
+    pid_controllers_.update(err_p, du_array, err_d, ff);
+
+    // post process
+    if(navigator_->getForceLandingFlag())
+      {
+        pid_controllers_.at(X).reset();
+        pid_controllers_.at(Y).reset();
+      }
+
+    if(pid_controllers_.at(Z).getErrI() < 0) pid_controllers_.at(Z).setErrI(0);
+
+    if(navigator_->getForceLandingFlag())
+      {
+        pid_controllers_.at(Z).setLimitP(z_p_limit); // revert z p limit
+        pid_controllers_.at(Z).setErrP(0); // for derived controller which use err_p in feedback control (e.g., LQI)
       }
-    pid_controllers_.at(YAW).update(err_yaw, du, err_omega_z, target_ang_acc_.z());
 
     // update
     control_timestamp_ = ros::Time::now().toSec();
 
     /* ros pub */
+    if(pid_pub_due_) setPidMsg();
+  }
+
+  void PoseLinearController::setPidMsg()
+  {
     pid_msg_.header.stamp.fromSec(estimator_->getImuLatestTimeStamp());
     pid_msg_.x.total.at(0) = pid_controllers_.at(X).result();
     pid_msg_.x.p_term.at(0) = pid_controllers_.at(X).getPTerm();
@@ -330,7 +360,7 @@ namespace aerial_robot_control
     pid_msg_.yaw.i_term.at(0) = pid_controllers_.at(YAW).getITerm();
     pid_msg_.yaw.d_term.at(0) = pid_controllers_.at(YAW).getDTerm();
     pid_msg_.yaw.target_p = target_rpy_.z();
-    pid_msg_.yaw.err_p = err_yaw;
+    pid_msg_.yaw.err_p = angles::shortest_angular_distance(rpy_.z(), target_rpy_.z());
     pid_msg_.yaw.target_d = target_omega_.z();
     pid_msg_.yaw.err_d = target_omega_.z() - omega_.z();
   }
@@ -338,9 +368,50 @@ namespace aerial_robot_control
   void PoseLinearController::sendCmd()
   {
     /* ros publish */
+    if(!pid_pub_due_) return;
+
+    pid_pub_stamp_ = ros::Time::now().toSec();
     pid_pub_.publish(pid_msg_);
   }
 
+  void PoseLinearController::addTelemetryChannels(telemetry::Recorder& recorder)
+  {
+    std::vector<std::string> pid_fields, gain_fields;
+    for(size_t i = 0; i < pid_controllers_.size(); i++)
+      {
+        const std::string name = pid_controllers_.at(i).getName();
+        for(const auto field: {"err_p", "err_i", "err_d", "p_term", "i_term", "d_term", "result"})
+          pid_fields.push_back(name + "/" + field);
+        for(const auto field: {"p_gain", "i_gain", "d_gain"})
+          gain_fields.push_back(name + "/" + field);
+      }
+
+    pid_telemetry_channel_ = recorder.addChannel("controller/pid", pid_fields);
+    pid_gain_telemetry_channel_ = recorder.addChannel("controller/pid_gain", gain_fields);
+  }
+
+  void PoseLinearController::recordTelemetry(telemetry::Recorder& recorder, double stamp)
+  {
+    std::array<double, telemetry::MAX_FIELDS> values; // no allocation in the control loop
+    size_t n = 0;
+    for(size_t i = 0; i < pid_controllers_.size(); i++)
+      {
+        const auto pid = pid_controllers_.at(i);
+        for(const double value: {pid.getErrP(), pid.getErrI(), pid.getErrD(), pid.getPTerm(), pid.getITerm(), pid.getDTerm(), pid.result()})
+          values[n++] = value;
+      }
+    recorder.record(pid_telemetry_channel_, stamp, values.data(), n);
+
+    n = 0;
+    for(size_t i = 0; i < pid_controllers_.size(); i++)
+      {
+        const auto pid = pid_controllers_.at(i);
+        for(const double value: {pid.getPGain(), pid.getIGain(), pid.getDGain()})
+          values[n++] = value;
+      }
+    recorder.record(pid_gain_telemetry_channel_, stamp, values.data(), n);
+  }
+
   void PoseLinearController::cfgPidCallback(aerial_robot_control::PIDConfig &config, uint32_t level, std::vector<int> controller_indices)
   {
     using Levels = aerial_robot_msgs::DynamicReconfigureLevels;
@@ -42,7 +42,10 @@ namespace aerial_robot_control
   FullyActuatedController::FullyActuatedController():
     PoseLinearController(),
     wrench_allocation_matrix_pub_stamp_(0),
-    torque_allocation_matrix_inv_pub_stamp_(0)
+    torque_allocation_matrix_inv_pub_stamp_(0),
+    q_mat_revision_(std::numeric_limits<uint64_t>::max()),
+    allocation_telemetry_channel_(-1),
+    allocation_terms_telemetry_channel_(-1)
   {
   }
 
@@ -90,13 +93,18 @@ namespace aerial_robot_control
     tf::Vector3 target_acc_cog = uav_rot.inverse() * target_acc_w;
 
 
-    //wrench allocation matrix
-    Eigen::Matrix3d inertia_inv = robot_model_->getInertia<Eigen::Matrix3d>().inverse();
-    double mass_inv =  1 / robot_model_->getMass();
-    Eigen::MatrixXd q_mat = robot_model_->calcWrenchMatrixOnCoG();
-    q_mat_.topRows(3) =  mass_inv * q_mat.topRows(3) ;
-    q_mat_.bottomRows(3) =  inertia_inv * q_mat.bottomRows(3);
-    q_mat_inv_ = aerial_robot_model::pseudoinverse(q_mat_);
+    //wrench allocation matrix, recalculated only when the robot model is updated
+    uint64_t model_revision = robot_model_->getRevision();
+    if(model_revision != q_mat_revision_)
+      {
+        Eigen::Matrix3d inertia_inv = robot_model_->getInertia<Eigen::Matrix3d>().inverse();
+        double mass_inv =  1 / robot_model_->getMass();
+        Eigen::MatrixXd q_mat = robot_model_->calcWrenchMatrixOnCoG();
+        q_mat_.topRows(3) =  mass_inv * q_mat.topRows(3) ;
+        q_mat_.bottomRows(3) =  inertia_inv * q_mat.bottomRows(3);
+        q_mat_inv_ = aerial_robot_model::pseudoinverse(q_mat_);
+        q_mat_revision_ = model_revision;
+      }
 
      Eigen::VectorXd target_thrust_x_term = q_mat_inv_.col(X) * target_acc_cog.x();
      Eigen::VectorXd target_thrust_y_term = q_mat_inv_.col(Y) * target_acc_cog.y();
@@ -183,6 +191,45 @@ namespace aerial_robot_control
     sendTorqueAllocationMatrixInv();
   }
 
+  void FullyActuatedController::addTelemetryChannels(telemetry::Recorder& recorder)
+  {
+    PoseLinearController::addTelemetryChannels(recorder);
+
+    std::vector<std::string> allocation_fields{"q_mat_revision", "yaw_term"}, term_fields;
+    for(int i = 0; i < motor_num_; i++)
+      {
+        const std::string rotor = "rotor" + std::to_string(i + 1);
+        allocation_fields.push_back(rotor + "/base_thrust");
+        for(const auto field: {"x_term", "y_term", "z_term"})
+          term_fields.push_back(rotor + "/" + field);
+      }
+
+    allocation_telemetry_channel_ = recorder.addChannel("controller/allocation", allocation_fields);
+    allocation_terms_telemetry_channel_ = recorder.addChannel("controller/allocation_terms", term_fields);
+  }
+
+  void FullyActuatedController::recordTelemetry(telemetry::Recorder& recorder, double stamp)
+  {
+    PoseLinearController::recordTelemetry(recorder, stamp);
+
+    std::array<double, telemetry::MAX_FIELDS> values; // no allocation in the control loop
+    size_t n = 0;
+    values[n++] = q_mat_revision_;
+    values[n++] = candidate_yaw_term_;
+    for(int i = 0; i < motor_num_ && n < values.size(); i++)
+      values[n++] = target_base_thrust_.at(i);
+    recorder.record(allocation_telemetry_channel_, stamp, values.data(), n);
+
+    n = 0;
+    for(int i = 0; i < motor_num_ && n + 3 <= values.size(); i++)
+      {
+        values[n++] = pid_msg_.x.total.at(i);
+        values[n++] = pid_msg_.y.total.at(i);
+        values[n++] = pid_msg_.z.total.at(i);
+      }
+    recorder.record(allocation_terms_telemetry_channel_, stamp, values.data(), n);
+  }
+
   void FullyActuatedController::sendFourAxisCommand()
   {
     spinal::FourAxisCommand flight_command_data;
@@ -39,7 +39,8 @@ namespace aerial_robot_control
 {
   UnderActuatedController::UnderActuatedController():
     PoseLinearController(),
-    torque_allocation_matrix_inv_pub_stamp_(0)
+    torque_allocation_matrix_inv_pub_stamp_(0),
+    q_mat_revision_(std::numeric_limits<uint64_t>::max())
   {
   }
 
@@ -78,18 +79,23 @@ namespace aerial_robot_control
   {
     PoseLinearController::controlCore();
 
-    // wrench allocation matrix
-    const std::vector<Eigen::Vector3d> rotors_origin = robot_model_->getRotorsOriginFromCog<Eigen::Vector3d>();
-    const std::vector<Eigen::Vector3d> rotors_normal = robot_model_->getRotorsNormalFromCog<Eigen::Vector3d>();
-    const auto& rotor_direction = robot_model_->getRotorDirection();
-    const double m_f_rate = robot_model_->getMFRate();
-    double uav_mass_inv = 1.0 / robot_model_->getMass();
-    Eigen::Matrix3d inertia_inv = robot_model_->getInertia<Eigen::Matrix3d>().inverse();
-    for (unsigned int i = 0; i < motor_num_; ++i) {
-      q_mat_(0, i) = rotors_normal.at(i).z() * uav_mass_inv;
-      q_mat_.block(1, i, 3, 1) = inertia_inv * (rotors_origin.at(i).cross(rotors_normal.at(i)) + m_f_rate * rotor_direction.at(i + 1) * rotors_normal.at(i));
-    }
-    q_mat_inv_ = aerial_robot_model::pseudoinverse(q_mat_);
+    // wrench allocation matrix, recalculated only when the robot model is updated
+    uint64_t model_revision = robot_model_->getRevision();
+    if(model_revision != q_mat_revision_)
+      {
+        const std::vector<Eigen::Vector3d> rotors_origin = robot_model_->getRotorsOriginFromCog<Eigen::Vector3d>();
+        const std::vector<Eigen::Vector3d> rotors_normal = robot_model_->getRotorsNormalFromCog<Eigen::Vector3d>();
+        const auto& rotor_direction = robot_model_->getRotorDirection();
+        const double m_f_rate = robot_model_->getMFRate();
+        double uav_mass_inv = 1.0 / robot_model_->getMass();
+        Eigen::Matrix3d inertia_inv = robot_model_->getInertia<Eigen::Matrix3d>().inverse();
+        for (unsigned int i = 0; i < motor_num_; ++i) {
+          q_mat_(0, i) = rotors_normal.at(i).z() * uav_mass_inv;
+          q_mat_.block(1, i, 3, 1) = inertia_inv * (rotors_origin.at(i).cross(rotors_normal.at(i)) + m_f_rate * rotor_direction.at(i + 1) * rotors_normal.at(i));
+        }
+        q_mat_inv_ = aerial_robot_model::pseudoinverse(q_mat_);
+        q_mat_revision_ = model_revision;
+      }
 
 
     tf::Vector3 target_acc_w(pid_controllers_.at(X).result(),
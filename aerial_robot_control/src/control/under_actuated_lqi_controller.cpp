@@ -38,11 +38,15 @@
 using namespace aerial_robot_control;
 
 UnderActuatedLQIController::UnderActuatedLQIController():
-  target_roll_(0), target_pitch_(0), candidate_yaw_term_(0)
+  target_roll_(0), target_pitch_(0), candidate_yaw_term_(0),
+  gain_model_revision_(0), gain_lqi_mode_(0), lqi_weight_updated_(false),
+  lqi_allocation_telemetry_channel_(-1),
+  gain_generate_rate_(15.0), gain_generate_timestamp_(0)
 {
   lqi_roll_pitch_weight_.setZero();
   lqi_yaw_weight_.setZero();
   lqi_z_weight_.setZero();
+  lqi_gain_telemetry_channels_.fill(-1);
 }
 
 
@@ -74,6 +78,9 @@ void UnderActuatedLQIController::initialize(ros::NodeHandle nh,
   roll_gains_.resize(motor_num_, Eigen::Vector3d(0,0,0));
   z_gains_.resize(motor_num_, Eigen::Vector3d(0,0,0));
   yaw_gains_.resize(motor_num_, Eigen::Vector3d(0,0,0));
+  q_mat_inv_ = Eigen::MatrixXd::Zero(motor_num_, 4);
+  commitGain(0);
+  loadGain();
 
   //message
   target_base_thrust_.resize(motor_num_);
@@ -87,59 +94,74 @@ void UnderActuatedLQIController::initialize(ros::NodeHandle nh,
   pid_msg_.yaw.d_term.resize(motor_num_);
 
   if (!robot_model_->isModelFixed()) realtime_update_ = true;
-  if (realtime_update_) {
+  // in replay, the gains are generated in the control loop with the simulated time
+  if (realtime_update_ && !replay_) {
     gain_generator_thread_ = std::thread(boost::bind(&UnderActuatedLQIController::gainGeneratorFunc, this));
   }
 }
 
 UnderActuatedLQIController::~UnderActuatedLQIController()
 {
-  if(realtime_update_) gain_generator_thread_.join();
+  if(gain_generator_thread_.joinable()) gain_generator_thread_.join();
 }
 
 void UnderActuatedLQIController::gainGeneratorFunc()
 {
-  double rate;
-  ros::NodeHandle control_nh(nh_, "controller");
-  ros::NodeHandle lqi_nh(control_nh, "lqi");
-  lqi_nh.param("gain_generate_rate", rate, 15.0);
-  ros::Rate loop_rate(rate);
+  ros::Rate loop_rate(gain_generate_rate_);
 
   while(ros::ok())
     {
-      if(checkRobotModel())
+      generateGain();
+      loop_rate.sleep();
+    }
+}
+
+void UnderActuatedLQIController::generateGain()
+{
+  std::lock_guard<std::mutex> lock(gain_mutex_);
+
+  if(checkRobotModel())
+    {
+      // solve only once per robot model revision (or LQI weight / mode change)
+      uint64_t model_revision = robot_model_->getRevision();
+      if(model_revision == gain_model_revision_ && lqi_mode_ == gain_lqi_mode_ && !lqi_weight_updated_)
         {
-          if(optimalGain())
-            {
-              clampGain();
-              publishGain();
-            }
-          else
-            ROS_ERROR_NAMED("LQI gain generator", "LQI gain generator: can not solve hamilton matrix");
+          publishGain();
         }
       else
         {
-          resetGain();
+          lqi_weight_updated_ = false;
+          updateGain();
         }
-
-      loop_rate.sleep();
+    }
+  else
+    {
+      resetGain();
     }
 }
 
+bool UnderActuatedLQIController::updateGain()
+{
+  uint64_t model_revision = robot_model_->getRevision();
+  if(!optimalGain())
+    {
+      ROS_ERROR_NAMED("LQI gain generator", "LQI gain generator: can not solve hamilton matrix");
+      return false;
+    }
+
+  clampGain();
+  commitGain(model_revision);
+  publishGain();
+  return true;
+}
 
 void UnderActuatedLQIController::activate()
 {
   ControlBase::activate();
 
-  // publish gains in start phase for general multirotor
-  if(optimalGain()) {
-    clampGain();
-    publishGain();
-    ROS_INFO_NAMED("LQI gain generator", "LQI gain generator: send LQI gains");
-  }
-  else {
-    ROS_ERROR_NAMED("LQI gain generator", "LQI gain generator: can not solve hamilton matrix");
-  }
+  // publish gains in start phase for general multirotor, wait for the solve in the gain generator if any
+  std::lock_guard<std::mutex> lock(gain_mutex_);
+  if(updateGain()) ROS_INFO_NAMED("LQI gain generator", "LQI gain generator: send LQI gains");
 }
 
 void UnderActuatedLQIController::sendCmd()
@@ -164,6 +186,17 @@ void UnderActuatedLQIController::controlCore()
 {
   PoseLinearController::controlCore();
 
+  if(realtime_update_ && replay_)
+    {
+      double now = ros::Time::now().toSec();
+      if(now - gain_generate_timestamp_ >= 1.0 / gain_generate_rate_)
+        {
+          generateGain();
+          gain_generate_timestamp_ = now;
+        }
+    }
+  loadGain();
+
   tf::Vector3 target_acc_w(pid_controllers_.at(X).result(),
                            pid_controllers_.at(Y).result(),
                            pid_controllers_.at(Z).result());
@@ -175,18 +208,17 @@ void UnderActuatedLQIController::controlCore()
   Eigen::VectorXd target_thrust_z_term = Eigen::VectorXd::Zero(motor_num_);
   for(int i = 0; i < motor_num_; i++)
     {
-      double p_term = z_gains_.at(i)[0] * pid_controllers_.at(Z).getErrP();
-      double i_term = z_gains_.at(i)[1] * pid_controllers_.at(Z).getErrI();
-      double d_term = z_gains_.at(i)[2] * pid_controllers_.at(Z).getErrD();
+      double p_term = control_gains_->z_gains.at(i)[0] * pid_controllers_.at(Z).getErrP();
+      double i_term = control_gains_->z_gains.at(i)[1] * pid_controllers_.at(Z).getErrI();
+      double d_term = control_gains_->z_gains.at(i)[2] * pid_controllers_.at(Z).getErrD();
       target_thrust_z_term(i) = p_term + i_term + d_term;
       pid_msg_.z.p_term.at(i) = p_term;
       pid_msg_.z.i_term.at(i) = i_term;
       pid_msg_.z.d_term.at(i) = d_term;
     }
   // feed-forward term for z
-  Eigen::MatrixXd q_mat_inv = getQInv();
-  double ff_acc_z = navigator_->getTargetAcc().z();
-  Eigen::VectorXd ff_term = q_mat_inv.col(0) * ff_acc_z;
+  double ff_acc_z = target_acc_.z();
+  Eigen::VectorXd ff_term = control_gains_->q_mat_inv.col(0) * ff_acc_z;
   target_thrust_z_term += ff_term;
 
   // constraint z (also  I term)
@@ -208,22 +240,81 @@ void UnderActuatedLQIController::controlCore()
   allocateYawTerm();
 }
 
-Eigen::MatrixXd UnderActuatedLQIController::getQInv()
+void UnderActuatedLQIController::addTelemetryChannels(telemetry::Recorder& recorder)
+{
+  PoseLinearController::addTelemetryChannels(recorder);
+
+  std::vector<std::string> gain_fields;
+  std::vector<std::string> allocation_fields{"model_revision", "target_roll", "target_pitch", "yaw_term"};
+  for(int i = 0; i < motor_num_; i++)
+    {
+      const std::string rotor = "rotor" + std::to_string(i + 1);
+      for(const auto field: {"p_gain", "i_gain", "d_gain"})
+        gain_fields.push_back(rotor + "/" + field);
+      allocation_fields.push_back(rotor + "/base_thrust");
+    }
+
+  const char* axes[] = {"roll", "pitch", "yaw", "z"};
+  for(int i = 0; i < lqi_gain_telemetry_channels_.size(); i++)
+    lqi_gain_telemetry_channels_.at(i) = recorder.addChannel(std::string("controller/lqi_gain/") + axes[i], gain_fields);
+  lqi_allocation_telemetry_channel_ = recorder.addChannel("controller/lqi_allocation", allocation_fields);
+}
+
+void UnderActuatedLQIController::recordTelemetry(telemetry::Recorder& recorder, double stamp)
+{
+  PoseLinearController::recordTelemetry(recorder, stamp);
+
+  if(!control_gains_) return; // no gain loaded in the control loop yet
+
+  std::array<double, telemetry::MAX_FIELDS> values; // no allocation in the control loop
+  const std::vector<Eigen::Vector3d>* gains[] = {&control_gains_->roll_gains, &control_gains_->pitch_gains,
+                                                 &control_gains_->yaw_gains, &control_gains_->z_gains};
+  for(int i = 0; i < lqi_gain_telemetry_channels_.size(); i++)
+    {
+      size_t n = 0;
+      for(const auto& gain: *gains[i])
+        {
+          if(n + 3 > values.size()) break;
+          for(int j = 0; j < 3; j++) values[n++] = gain[j];
+        }
+      recorder.record(lqi_gain_telemetry_channels_.at(i), stamp, values.data(), n);
+    }
+
+  size_t n = 0;
+  values[n++] = control_gains_->model_revision;
+  values[n++] = target_roll_;
+  values[n++] = target_pitch_;
+  values[n++] = candidate_yaw_term_;
+  for(const auto thrust: target_base_thrust_)
+    {
+      if(n == values.size()) break;
+      values[n++] = thrust;
+    }
+  recorder.record(lqi_allocation_telemetry_channel_, stamp, values.data(), n);
+}
+
+Eigen::MatrixXd UnderActuatedLQIController::calcQInv(const Eigen::MatrixXd& P, const Eigen::Matrix3d& inertia)
 {
-  // wrench allocation matrix
-  const std::vector<Eigen::Vector3d> rotors_origin = robot_model_->getRotorsOriginFromCog<Eigen::Vector3d>();
-  const std::vector<Eigen::Vector3d> rotors_normal = robot_model_->getRotorsNormalFromCog<Eigen::Vector3d>();
-  const auto& rotor_direction = robot_model_->getRotorDirection();
-  const double m_f_rate = robot_model_->getMFRate();
-  double uav_mass_inv = 1.0 / robot_model_->getMass();
-  Eigen::Matrix3d inertia_inv = robot_model_->getInertia<Eigen::Matrix3d>().inverse();
+  // wrench allocation matrix: z acc, roll/pitch/yaw angular acc
   Eigen::MatrixXd q_mat = Eigen::MatrixXd::Zero(4, motor_num_);
-  for (unsigned int i = 0; i < motor_num_; ++i) {
-    q_mat(0, i) = rotors_normal.at(i).z() * uav_mass_inv;
-    q_mat.block(1, i, 3, 1) = inertia_inv * (rotors_origin.at(i).cross(rotors_normal.at(i)) + m_f_rate * rotor_direction.at(i + 1) * rotors_normal.at(i));
-  }
-  Eigen::MatrixXd q_mat_inv = aerial_robot_model::pseudoinverse(q_mat);
-  return q_mat_inv;
+  q_mat.row(0) = P.row(2) / robot_model_->getMass();
+  q_mat.bottomRows(3) = inertia.inverse() * P.bottomRows(3);
+  return aerial_robot_model::pseudoinverse(q_mat);
+}
+
+void UnderActuatedLQIController::commitGain(const uint64_t model_revision)
+{
+  auto gains = std::make_shared<LQIGains>();
+  gains->model_revision = model_revision;
+  gains->roll_gains = roll_gains_;
+  gains->pitch_gains = pitch_gains_;
+  gains->yaw_gains = yaw_gains_;
+  gains->z_gains = z_gains_;
+  gains->q_mat_inv = q_mat_inv_;
+  std::atomic_store(&gains_, std::shared_ptr<const LQIGains>(gains));
+
+  gain_model_revision_ = model_revision;
+  gain_lqi_mode_ = lqi_mode_;
 }
 
 void UnderActuatedLQIController::allocateYawTerm()
@@ -231,9 +322,9 @@ void UnderActuatedLQIController::allocateYawTerm()
   Eigen::VectorXd target_thrust_yaw_term = Eigen::VectorXd::Zero(motor_num_);
   for(int i = 0; i < motor_num_; i++)
     {
-      double p_term = yaw_gains_.at(i)[0] * pid_controllers_.at(YAW).getErrP();
-      double i_term = yaw_gains_.at(i)[1] * pid_controllers_.at(YAW).getErrI();
-      double d_term = yaw_gains_.at(i)[2] * pid_controllers_.at(YAW).getErrD();
+      double p_term = control_gains_->yaw_gains.at(i)[0] * pid_controllers_.at(YAW).getErrP();
+      double i_term = control_gains_->yaw_gains.at(i)[1] * pid_controllers_.at(YAW).getErrI();
+      double d_term = control_gains_->yaw_gains.at(i)[2] * pid_controllers_.at(YAW).getErrD();
       target_thrust_yaw_term(i) = p_term + i_term + d_term;
       pid_msg_.yaw.p_term.at(i) = p_term;
       pid_msg_.yaw.i_term.at(i) = i_term;
@@ -241,9 +332,8 @@ void UnderActuatedLQIController::allocateYawTerm()
     }
 
   // feed-forward term for yaw
-  Eigen::MatrixXd q_mat_inv = getQInv();
-  double ff_ang_yaw = navigator_->getTargetAngAcc().z();
-  Eigen::VectorXd ff_term = q_mat_inv.col(3) * ff_ang_yaw;
+  double ff_ang_yaw = target_ang_acc_.z();
+  Eigen::VectorXd ff_term = control_gains_->q_mat_inv.col(3) * ff_ang_yaw;
   target_thrust_yaw_term += ff_term;
 
   // constraint yaw (also  I term)
@@ -262,9 +352,9 @@ void UnderActuatedLQIController::allocateYawTerm()
     {
       pid_msg_.yaw.total.at(i) =  target_thrust_yaw_term(i);
 
-      if(yaw_gains_[i][2] > max_yaw_scale)
+      if(control_gains_->yaw_gains[i][2] > max_yaw_scale)
         {
-          max_yaw_scale = yaw_gains_[i][2];
+          max_yaw_scale = control_gains_->yaw_gains[i][2];
           candidate_yaw_term_ = target_thrust_yaw_term(i);
         }
     }
@@ -278,7 +368,7 @@ bool UnderActuatedLQIController::optimalGain()
 
   Eigen::MatrixXd P = robot_model_->calcWrenchMatrixOnCoG();
   Eigen::MatrixXd P_dash = Eigen::MatrixXd::Zero(lqi_mode_, motor_num_);
-  Eigen::MatrixXd inertia = robot_model_->getInertia<Eigen::Matrix3d>();
+  Eigen::Matrix3d inertia = robot_model_->getInertia<Eigen::Matrix3d>();
   P_dash.row(0) = P.row(2) / robot_model_->getMass(); // z
   P_dash.bottomRows(lqi_mode_ - 1) = (inertia.inverse() * P.bottomRows(3)).topRows(lqi_mode_ - 1); // roll, pitch, yaw
 
@@ -342,6 +432,9 @@ bool UnderActuatedLQIController::optimalGain()
       else yaw_gains_.at(i).setZero();
     }
 
+  // allocation inverse from the same model state as the gains
+  q_mat_inv_ = calcQInv(P, inertia);
+
   return true;
 }
 
@@ -416,6 +509,7 @@ void UnderActuatedLQIController::rosParamInit()
   ros::NodeHandle lqi_nh(control_nh, "lqi");
   getParam<bool>(lqi_nh, "clamp_gain", clamp_gain_, true);
   getParam<bool>(lqi_nh, "realtime_update", realtime_update_, false);
+  getParam<double>(lqi_nh, "gain_generate_rate", gain_generate_rate_, 15.0);
   getParam<bool>(lqi_nh, "gyro_moment_compensation", gyro_moment_compensation_, false);
 
   /* propeller direction and lqi R */
@@ -487,6 +581,8 @@ void UnderActuatedLQIController::cfgLQICallback(aerial_robot_control::LQIConfig
   using Levels = aerial_robot_msgs::DynamicReconfigureLevels;
   if(config.lqi_flag)
     {
+      // the weights are read in optimalGain() of the gain generator
+      std::lock_guard<std::mutex> lock(gain_mutex_);
       switch(level)
         {
         case Levels::RECONFIGURE_LQI_ROLL_PITCH_P:
@@ -529,16 +625,11 @@ void UnderActuatedLQIController::cfgLQICallback(aerial_robot_control::LQIConfig
           break;
         }
 
+      lqi_weight_updated_ = true;
+
       if (!realtime_update_) {
         // instantly modify gain if no joint angles
-
-        if(optimalGain()) {
-          clampGain();
-          publishGain();
-        }
-        else {
-          ROS_ERROR_NAMED("LQI gain generator", "LQI gain generator: can not solve hamilton matrix");
-        }
+        updateGain();
       }
 
     }
@@ -58,6 +58,7 @@ void UnderActuatedTiltedLQIController::initialize(ros::NodeHandle nh,
 void UnderActuatedTiltedLQIController::controlCore()
 {
   PoseLinearController::controlCore();
+  loadGain();
 
   tf::Vector3 target_acc_w(pid_controllers_.at(X).result(),
                            pid_controllers_.at(Y).result(),
@@ -103,7 +104,7 @@ bool UnderActuatedTiltedLQIController::optimalGain()
 {
   /* calculate the P_orig pseudo inverse */
   Eigen::MatrixXd P = robot_model_->calcWrenchMatrixOnCoG();
-  Eigen::MatrixXd inertia = robot_model_->getInertia<Eigen::Matrix3d>();
+  Eigen::Matrix3d inertia = robot_model_->getInertia<Eigen::Matrix3d>();
   Eigen::MatrixXd P_dash  = inertia.inverse() * P.bottomRows(3); // roll, pitch, yaw
 
   Eigen::MatrixXd A = Eigen::MatrixXd::Zero(9, 9);
@@ -147,6 +148,9 @@ bool UnderActuatedTiltedLQIController::optimalGain()
       yaw_gains_.at(i) = Eigen::Vector3d(-K_(i,4), K_(i,8), -K_(i,5));
     }
 
+  // allocation inverse from the same model state as the gains
+  q_mat_inv_ = calcQInv(P, inertia);
+
   return true;
 }
 
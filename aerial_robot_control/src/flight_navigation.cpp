@@ -4,30 +4,26 @@ using namespace std;
 using namespace aerial_robot_navigation;
 
 BaseNavigator::BaseNavigator():
-  target_pos_(0, 0, 0),
-  target_vel_(0, 0, 0),
-  target_acc_(0, 0, 0),
-  target_rpy_(0, 0, 0),
-  target_omega_(0, 0, 0),
-  target_ang_acc_(0, 0, 0),
-  init_height_(0), land_height_(0),
-  force_att_control_flag_(false),
+  init_height_(0),
   trajectory_mode_(false),
+  trajectory_replanning_(false),
+  replan_busy_(false),
+  reference_preview_du_(0.1),
   trajectory_reset_time_(0),
   teleop_reset_time_(0),
-  low_voltage_flag_(false),
-  high_voltage_flag_(false),
-  prev_xy_control_mode_(ACC_CONTROL_MODE),
   xy_control_flag_(false),
   vel_based_waypoint_(false),
   gps_waypoint_(false),
   gps_waypoint_time_(0),
-  joy_stick_heart_beat_(false),
-  joy_stick_prev_time_(0),
-  teleop_flag_(true),
-  land_check_start_time_(0)
+  transformation_planning_(false),
+  transformation_start_time_(0)
 {
-  setNaviState(ARM_OFF_STATE);
+  state_machine_.setLogger([](NavigationStateMachine::LogLevel level, const std::string& msg)
+                           {
+                             if(level == NavigationStateMachine::ERROR) ROS_ERROR_STREAM(msg);
+                             else if(level == NavigationStateMachine::WARN) ROS_WARN_STREAM(msg);
+                             else ROS_INFO_STREAM(msg);
+                           });
 }
 
 void BaseNavigator::initialize(ros::NodeHandle nh, ros::NodeHandle nhp,
@@ -35,7 +31,7 @@ void BaseNavigator::initialize(ros::NodeHandle nh, ros::NodeHandle nhp,
                                boost::shared_ptr<aerial_robot_estimation::StateEstimator> estimator,
                                double loop_du)
 {
-  nh_ = nh;
+  nh_ = aerial_robot_model::CallbackScheduler::nodeHandle(nh, aerial_robot_model::callback_group::COMMAND);
   nhp_ = nhp;
 
   rosParamInit();
@@ -46,6 +42,7 @@ void BaseNavigator::initialize(ros::NodeHandle nh, ros::NodeHandle nhp,
 
   pose_sub_ = nh_.subscribe("target_pose", 1, &BaseNavigator::poseCallback, this, ros::TransportHints().tcpNoDelay());
   simple_move_base_goal_sub_ = nh_.subscribe("/move_base_simple/goal", 1, &BaseNavigator::simpleMoveBaseGoalCallback, this, ros::TransportHints().tcpNoDelay());
+  waypoints_sub_ = nh_.subscribe("target_waypoints", 1, &BaseNavigator::waypointsCallback, this, ros::TransportHints().tcpNoDelay());
   navi_sub_ = nh_.subscribe("uav/nav", 1, &BaseNavigator::naviCallback, this, ros::TransportHints().tcpNoDelay());
 
   battery_sub_ = nh_.subscribe("battery_voltage_status", 1, &BaseNavigator::batteryCheckCallback, this);
@@ -55,7 +52,6 @@ void BaseNavigator::initialize(ros::NodeHandle nh, ros::NodeHandle nhp,
   takeoff_sub_ = teleop_nh.subscribe("takeoff", 1, &BaseNavigator::takeoffCallback, this);
   halt_sub_ = teleop_nh.subscribe("halt", 1, &BaseNavigator::haltCallback, this);
   force_landing_sub_ = teleop_nh.subscribe("force_landing", 1, &BaseNavigator::forceLandingCallback, this);
-  force_landing_flag_ = false;
   land_sub_ = teleop_nh.subscribe("land", 1, &BaseNavigator::landCallback, this);
   start_sub_ = teleop_nh.subscribe("start", 1,&BaseNavigator::startCallback, this);
   ctrl_mode_sub_ = teleop_nh.subscribe("ctrl_mode", 1, &BaseNavigator::xyControlModeCallback, this);
@@ -75,7 +71,115 @@ void BaseNavigator::initialize(ros::NodeHandle nh, ros::NodeHandle nhp,
   path_pub_ = nh_.advertise<nav_msgs::Path>("trajectory", 1);
 
   estimate_mode_ = estimator_->getEstimateMode();
-  force_landing_start_time_ = ros::Time::now();
+
+  if(transformation_planning_) initTransformationPlanner();
+}
+
+void BaseNavigator::initTransformationPlanner()
+{
+  if(!boost::dynamic_pointer_cast<aerial_robot_model::transformable::RobotModel>(robot_model_))
+    {
+      ROS_WARN("[Nav] transformation planning is only for the transformable robot model");
+      return;
+    }
+
+  // the model of the navigator is updated by the joint states, the planner needs its own instance
+  std::string plugin_name;
+  if(!nh_.getParam("robot_model_plugin_name", plugin_name))
+    {
+      ROS_ERROR("[Nav] can not find plugin rosparameter for robot model, disable the transformation planning");
+      return;
+    }
+
+  boost::shared_ptr<aerial_robot_model::transformable::RobotModel> plan_model;
+  try
+    {
+      transformation_model_loader_ = std::make_shared<pluginlib::ClassLoader<aerial_robot_model::RobotModel> >("aerial_robot_model", "aerial_robot_model::RobotModel");
+      plan_model = boost::dynamic_pointer_cast<aerial_robot_model::transformable::RobotModel>(transformation_model_loader_->createInstance(plugin_name));
+    }
+  catch(pluginlib::PluginlibException& ex)
+    {
+      ROS_ERROR("The plugin failed to load for some reason. Error: %s", ex.what());
+      return;
+    }
+
+  transformation_planner_ = std::make_shared<aerial_robot_model::transformable::TransformationPlanner>(plan_model, transformation_params_);
+  transformation_target_sub_ = nh_.subscribe("target_joint_states", 1, &BaseNavigator::transformationTargetCallback, this);
+  transformation_joint_pub_ = nh_.advertise<sensor_msgs::JointState>("joints_ctrl", 1);
+}
+
+void BaseNavigator::transformationTargetCallback(const sensor_msgs::JointStateConstPtr& msg)
+{
+  if(transformation_future_.valid() && transformation_future_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      ROS_WARN("[Nav] transformation planning is in progress, ignore the new target");
+      return;
+    }
+
+  // start from the current joint state, the goal of the link joints not in the message are the current values
+  const KDL::JntArray start = robot_model_->getJointPositions();
+  const auto& link_joint_names = transformation_planner_->getLinkJointNames();
+  const auto& link_joint_indices = transformation_planner_->getRobotModel()->getLinkJointIndices();
+  Eigen::VectorXd goal(link_joint_names.size());
+  for(int i = 0; i < link_joint_names.size(); i++) goal(i) = start(link_joint_indices.at(i));
+
+  if(msg->name.empty())
+    {
+      if(msg->position.size() != link_joint_names.size())
+        {
+          ROS_ERROR("[Nav] the target joint size %zu is not equal to the link joint num %zu", msg->position.size(), link_joint_names.size());
+          return;
+        }
+      for(int i = 0; i < link_joint_names.size(); i++) goal(i) = msg->position.at(i);
+    }
+  else
+    {
+      for(int i = 0; i < msg->name.size() && i < msg->position.size(); i++)
+        {
+          auto itr = std::find(link_joint_names.begin(), link_joint_names.end(), msg->name.at(i));
+          if(itr == link_joint_names.end())
+            {
+              ROS_WARN_STREAM("[Nav] " << msg->name.at(i) << " is not a link joint, ignore in the transformation");
+              continue;
+            }
+          goal(itr - link_joint_names.begin()) = msg->position.at(i);
+        }
+    }
+
+  transformation_future_ = std::async(std::launch::async, [this, start, goal]()
+    {
+      if(!transformation_planner_->plan(start, goal))
+        {
+          const auto& stats = transformation_planner_->getStats();
+          ROS_ERROR("[Nav] no feasible transformation path, min margins along the path: fc_f %f, fc_t %f, thrust %f, joint torque %f",
+                    stats.min_fc_f_margin, stats.min_fc_t_margin, stats.min_thrust_margin, stats.min_joint_torque_margin);
+          return;
+        }
+
+      const auto& stats = transformation_planner_->getStats();
+      std::lock_guard<std::mutex> lock(transformation_mutex_);
+      transformation_trajectory_ = transformation_planner_->getTrajectory();
+      transformation_start_time_ = ros::Time::now().toSec();
+      transformation_joint_msg_.name = transformation_trajectory_.joint_names;
+      transformation_joint_msg_.position.resize(transformation_trajectory_.joint_names.size());
+      ROS_INFO("[Nav] start transformation: %zu waypoints, %f sec, planned in %d iterations, %f sec",
+               transformation_trajectory_.positions.size(), transformation_trajectory_.getDuration(), stats.iterations, stats.plan_time);
+    });
+}
+
+void BaseNavigator::updateTransformation()
+{
+  std::lock_guard<std::mutex> lock(transformation_mutex_);
+  if(transformation_trajectory_.empty()) return;
+
+  const ros::Time now = ros::Time::now();
+  const double t = now.toSec() - transformation_start_time_;
+  Eigen::Map<Eigen::VectorXd> positions(transformation_joint_msg_.position.data(), transformation_joint_msg_.position.size());
+  transformation_trajectory_.getPositions(t, positions);
+  transformation_joint_msg_.header.stamp = now;
+  transformation_joint_pub_.publish(transformation_joint_msg_);
+
+  if(t > transformation_trajectory_.getDuration()) transformation_trajectory_ = aerial_robot_model::transformable::TransformationTrajectory();
 }
 
 void BaseNavigator::batteryCheckCallback(const std_msgs::Float32ConstPtr &msg)
@@ -118,20 +222,17 @@ void BaseNavigator::batteryCheckCallback(const std_msgs::Float32ConstPtr &msg)
       return;
     }
 
+  int voltage_status = 0;
   if(percentage < low_voltage_thre_)
     {
-      low_voltage_flag_  = true;
+      voltage_status |= NavigationEvent::LOW_VOLTAGE;
       ROS_WARN_THROTTLE(1,"low voltage!");
     }
-  else
-    low_voltage_flag_  = false;
 
   if(input_cell - bat_cell_ > high_voltage_cell_thre_)
-    {
-      high_voltage_flag_ = true;
-    }
-  else
-    high_voltage_flag_ = false;
+    voltage_status |= NavigationEvent::HIGH_VOLTAGE;
+
+  handleEvent(NavigationEvent::BATTERY, voltage_status);
 
   if(power_info_pub_.getNumSubscribers() == 0) return;
 
@@ -145,25 +246,56 @@ void BaseNavigator::batteryCheckCallback(const std_msgs::Float32ConstPtr &msg)
 
 void BaseNavigator::poseCallback(const geometry_msgs::PoseStampedConstPtr & msg)
 {
-  if (traj_generator_ptr_.get() == nullptr)
-    {
-      ROS_DEBUG("traj_generator_ptr_ is null");
-    }
-
   generateNewTrajectory(*msg);
 }
 
 void BaseNavigator::simpleMoveBaseGoalCallback(const geometry_msgs::PoseStampedConstPtr & msg)
 {
-  if (traj_generator_ptr_.get() == nullptr)
-    {
-      ROS_DEBUG("traj_generator_ptr_ is null");
-    }
   geometry_msgs::PoseStamped target_pose = *msg;
   target_pose.pose.position.z = getTargetPos().z();
   generateNewTrajectory(target_pose);
 }
 
+void BaseNavigator::waypointsCallback(const nav_msgs::PathConstPtr & msg)
+{
+  if (!trajectory_replanning_)
+    {
+      ROS_WARN_THROTTLE(1.0, "[Nav] waypoints are only supported with the trajectory replanning");
+      return;
+    }
+
+  if (msg->poses.empty()) return;
+
+  std::vector<agi::QuadState> waypoints;
+  double yaw = getTargetRPY().z();
+  for (const auto& pose: msg->poses)
+    {
+      agi::QuadState waypoint;
+      waypoint.setZero();
+      Eigen::Vector3d p;
+      tf::pointMsgToEigen(pose.pose.position, p);
+      waypoint.p = p;
+      agi::Quaternion q;
+      tf::quaternionMsgToEigen(pose.pose.orientation, q);
+      if (std::fabs(1 - q.squaredNorm())  < 1e-6)
+        {
+          waypoint.q(q);
+          yaw = waypoint.getYaw();
+        }
+      else
+        {
+          waypoint.setYaw(yaw); // keep the last yaw
+        }
+      waypoints.push_back(waypoint);
+    }
+
+  auto target = target_.write();
+  if (!trajectory_mode_ || !receding_horizon_.active(ros::Time::now().toSec()))
+    receding_horizon_.reset(getTargetQuadState());
+  receding_horizon_.setWaypoints(waypoints);
+  trajectory_mode_ = true;
+}
+
 
 void BaseNavigator::naviCallback(const aerial_robot_msgs::FlightNavConstPtr & msg)
 {
@@ -171,7 +303,10 @@ void BaseNavigator::naviCallback(const aerial_robot_msgs::FlightNavConstPtr & ms
 
   gps_waypoint_ = false;
 
-  if(force_att_control_flag_) return;
+  if(state_machine_.getForceAttControlFlag()) return;
+
+  /* publish all the targets of this command at once */
+  auto target = target_.write();
 
   /* yaw */
   if(msg->yaw_nav_mode == aerial_robot_msgs::FlightNav::POS_MODE)
@@ -221,18 +356,18 @@ void BaseNavigator::naviCallback(const aerial_robot_msgs::FlightNavConstPtr & ms
       {
         tf::Vector3 target_cog_pos(msg->target_pos_x, msg->target_pos_y, 0);
 
-        tf::Vector3 target_delta = getTargetPos() - target_cog_pos;
+        tf::Vector3 target_delta = target->pos - target_cog_pos;
         target_delta.setZ(0);
 
         if(target_delta.length() > vel_nav_threshold_)
           {
             ROS_WARN("start vel nav control for waypoint");
             vel_based_waypoint_ = true;
-            xy_control_mode_ = VEL_CONTROL_MODE;
+            state_machine_.setXyControlMode(VEL_CONTROL_MODE);
           }
 
         if(!vel_based_waypoint_)
-          xy_control_mode_ = POS_CONTROL_MODE;
+          state_machine_.setXyControlMode(POS_CONTROL_MODE);
 
         setTargetPosX(target_cog_pos.x());
         setTargetPosY(target_cog_pos.y());
@@ -244,7 +379,7 @@ void BaseNavigator::naviCallback(const aerial_robot_msgs::FlightNavConstPtr & ms
     case aerial_robot_msgs::FlightNav::VEL_MODE:
       {
         /* do not switch to pure vel mode */
-        xy_control_mode_ = POS_CONTROL_MODE;
+        state_machine_.setXyControlMode(POS_CONTROL_MODE);
 
         teleop_reset_time_ = teleop_reset_duration_ + ros::Time::now().toSec();
 
@@ -273,7 +408,7 @@ void BaseNavigator::naviCallback(const aerial_robot_msgs::FlightNavConstPtr & ms
       }
     case aerial_robot_msgs::FlightNav::POS_VEL_MODE:
       {
-        xy_control_mode_ = POS_CONTROL_MODE;
+        state_machine_.setXyControlMode(POS_CONTROL_MODE);
         setTargetPosX(msg->target_pos_x);
         setTargetPosY(msg->target_pos_y);
         setTargetVelX(msg->target_vel_x);
@@ -287,8 +422,8 @@ void BaseNavigator::naviCallback(const aerial_robot_msgs::FlightNavConstPtr & ms
     case aerial_robot_msgs::FlightNav::ACC_MODE:
       {
         /* should be in COG frame */
-        xy_control_mode_ = ACC_CONTROL_MODE;
-        prev_xy_control_mode_ = ACC_CONTROL_MODE;
+        state_machine_.setXyControlMode(ACC_CONTROL_MODE);
+        state_machine_.setPrevXyControlMode(ACC_CONTROL_MODE);
 
         switch(msg->control_frame)
           {
@@ -366,6 +501,8 @@ const sensor_msgs::Joy BaseNavigator::ps4joyToPs3joyConvert(const sensor_msgs::J
 
 void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
 {
+  auto target = target_.write();
+
   sensor_msgs::Joy joy_cmd;
   if(joy_msg->axes.size() == PS3_AXES && joy_msg->buttons.size() == PS3_BUTTONS)
     {
@@ -382,53 +519,18 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
     }
 
   /* ps3 joy bottons assignment: http://wiki.ros.org/ps3joy */
-  if(!joy_stick_heart_beat_) joy_stick_heart_beat_ = true;
-  joy_stick_prev_time_ = ros::Time::now().toSec();
+  /* heartbeat and the force landing && halt process */
+  handleEvent(NavigationEvent::JOY, joy_cmd.buttons[PS3_BUTTON_SELECT] == 1);
 
   /* common command */
   /* start */
   if(joy_cmd.buttons[PS3_BUTTON_START] == 1 && getNaviState() == ARM_OFF_STATE)
     {
-      motorArming();
+      handleEvent(NavigationEvent::JOY_START, estimator_->getStateStatus(State::Z_BASE, estimate_mode_));
       return;
     }
 
-  /* force landing && halt */
-  if(joy_cmd.buttons[PS3_BUTTON_SELECT] == 1)
-    {
-      /* Force Landing in inflight mode: TAKEOFF_STATE/LAND_STATE/HOVER_STATE */
-      if(!force_landing_flag_ && (getNaviState() == TAKEOFF_STATE || getNaviState() == LAND_STATE || getNaviState() == HOVER_STATE))
-        {
-          ROS_WARN("Joy Control: force landing state");
-          spinal::FlightConfigCmd flight_config_cmd;
-          flight_config_cmd.cmd = spinal::FlightConfigCmd::FORCE_LANDING_CMD;
-          flight_config_pub_.publish(flight_config_cmd);
-          force_landing_flag_ = true;
-
-          /* update the force landing stamp for the halt process*/
-          force_landing_start_time_ = joy_cmd.header.stamp;
-        }
-
-      /* Halt mode */
-      if(joy_cmd.header.stamp.toSec() - force_landing_start_time_.toSec() > force_landing_to_halt_du_ && getNaviState() > START_STATE)
-        {
-          //if(!teleop_flag_) return; /* can not do the process if other processs are running */
-
-          ROS_ERROR("Joy Control: Halt!");
-
-          setNaviState(STOP_STATE);
-
-          /* update the target pos(maybe not necessary) */
-          setTargetXyFromCurrentState();
-          setTargetYawFromCurrentState();
-        }
-      return;
-    }
-  else
-    {
-      /* update the halt process */
-      force_landing_start_time_ = joy_cmd.header.stamp;
-    }
+  if(joy_cmd.buttons[PS3_BUTTON_SELECT] == 1) return;
 
   /* takeoff */
   if(joy_cmd.buttons[PS3_BUTTON_CROSS_LEFT] == 1 && joy_cmd.buttons[PS3_BUTTON_ACTION_CIRCLE] == 1)
@@ -440,15 +542,7 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
   /* landing */
   if(joy_cmd.buttons[PS3_BUTTON_CROSS_RIGHT] == 1 && joy_cmd.buttons[PS3_BUTTON_ACTION_SQUARE] == 1)
     {
-      if(force_att_control_flag_) return;
-
-      if(getNaviState() == LAND_STATE) return;
-      if(!teleop_flag_) return; /* can not do the process if other processs are running */
-
-      setNaviState(LAND_STATE);
-      //update
-      ROS_INFO("Joy Control: Land state");
-
+      handleEvent(NavigationEvent::LAND);
       return;
     }
 
@@ -490,44 +584,16 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
 
   /* mode selection */
   /* switch to acc model */
-  if(joy_cmd.buttons[PS3_BUTTON_CROSS_DOWN] == 1)
-    {
-      if (xy_control_mode_ != ACC_CONTROL_MODE)
-        {
-          ROS_WARN("Force siwtch to attitude control mode");
-          force_att_control_flag_ = true;
-          estimator_->setForceAttControlFlag(force_att_control_flag_);
-          xy_control_mode_ = ACC_CONTROL_MODE;
-        }
-    }
+  if(joy_cmd.buttons[PS3_BUTTON_CROSS_DOWN] == 1) handleEvent(NavigationEvent::JOY_ATT_MODE);
 
   /* switch to pure vel mode */
-  if(joy_cmd.buttons[PS3_BUTTON_ACTION_TRIANGLE] == 1)
-    {
-      if (xy_control_mode_ != VEL_CONTROL_MODE)
-        {
-          ROS_INFO("switch to pure vel control mode");
-          force_att_control_flag_ = false;
-          setTargetZeroVel();
-          setTargetZeroAcc();
-          xy_control_mode_ = VEL_CONTROL_MODE;
-        }
-    }
+  if(joy_cmd.buttons[PS3_BUTTON_ACTION_TRIANGLE] == 1) handleEvent(NavigationEvent::JOY_VEL_MODE);
 
   /* siwthc to pos mode */
-  if(joy_cmd.buttons[PS3_BUTTON_ACTION_CROSS] == 1)
-    {
-      if (xy_control_mode_ != POS_CONTROL_MODE)
-        {
-          ROS_INFO("change to pos control");
-          force_att_control_flag_ = false;
-          setTargetXyFromCurrentState();
-          xy_control_mode_ = POS_CONTROL_MODE;
-        }
-    }
+  if(joy_cmd.buttons[PS3_BUTTON_ACTION_CROSS] == 1) handleEvent(NavigationEvent::JOY_POS_MODE);
 
   /* finish if teleop flag is not true */
-  if(!teleop_flag_) return;
+  if(!state_machine_.getTeleopFlag()) return;
 
   /* mode oriented state */
   control_frame_ = WORLD_FRAME;
@@ -554,7 +620,7 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
     }
 
 
-  switch (xy_control_mode_)
+  switch (state_machine_.getXyControlMode())
     {
     case POS_CONTROL_MODE:
       {
@@ -567,7 +633,7 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
 
         if(control_frame_ == LOCAL_FRAME)
           {
-            tf::Vector3 target_vel = frameConversion(getTargetVel(), local_frame_rot);
+            tf::Vector3 target_vel = frameConversion(target->vel, local_frame_rot);
             setTargetVelX(target_vel.x());
             setTargetVelY(target_vel.y());
           }
@@ -581,7 +647,7 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
 
         if(control_frame_ == LOCAL_FRAME)
           {
-            tf::Vector3 target_vel = frameConversion(getTargetVel(), local_frame_rot);
+            tf::Vector3 target_vel = frameConversion(target->vel, local_frame_rot);
             setTargetVelX(target_vel.x());
             setTargetVelY(target_vel.y());
           }
@@ -597,7 +663,7 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
 
         if(control_frame_ == LOCAL_FRAME)
           {
-            tf::Vector3 target_acc = frameConversion(getTargetAcc(), local_frame_rot);
+            tf::Vector3 target_acc = frameConversion(target->acc, local_frame_rot);
             setTargetAccX(target_acc.x());
             setTargetAccY(target_acc.y());
           }
@@ -612,247 +678,106 @@ void BaseNavigator::joyStickControl(const sensor_msgs::JoyConstPtr & joy_msg)
 
 void BaseNavigator::update()
 {
-  if(force_att_control_flag_)
-    {
-      if(getNaviState() == LAND_STATE)
-        {
-          // reset to hover state and do manually landing
-          setTargetZFromCurrentState();
-          setNaviState(HOVER_STATE);
-        }
-    }
-  else
-    {
-      /* check the xy estimation status, if not ready, change to att_control_mode */
-      if(!estimator_->getStateStatus(State::X_BASE, estimate_mode_) || !estimator_->getStateStatus(State::Y_BASE, estimate_mode_))
-        {
-          if(xy_control_mode_ == VEL_CONTROL_MODE ||
-             xy_control_mode_ == POS_CONTROL_MODE)
-            {
-              ROS_WARN("No estimation for X, Y state, change to attitude control mode");
-              prev_xy_control_mode_ = xy_control_mode_;
-              xy_control_mode_ = ACC_CONTROL_MODE;
-            }
-        }
-      else
-        {
-          if(xy_control_mode_ == ACC_CONTROL_MODE &&
-             prev_xy_control_mode_ != ACC_CONTROL_MODE)
-            {
-              ROS_INFO("Estimation for X, Y state is established, siwtch back to the xy control mode");
-              xy_control_mode_ = prev_xy_control_mode_;
-            }
-
-          ROS_INFO_ONCE("\n \n ======================  \n Ready for takeoff !!! \n ====================== \n");
-        }
-    }
-
-  /* sensor health check */
-  if(estimator_->getUnhealthLevel() == Sensor::UNHEALTH_LEVEL3 && !force_landing_flag_)
-    {
-      if(getNaviState() == TAKEOFF_STATE || getNaviState() == HOVER_STATE  || getNaviState() == LAND_STATE)
-        ROS_WARN("Sensor Unhealth Level%d: force landing state", estimator_->getUnhealthLevel());
-      spinal::FlightConfigCmd flight_config_cmd;
-      flight_config_cmd.cmd = spinal::FlightConfigCmd::FORCE_LANDING_CMD;
-      flight_config_pub_.publish(flight_config_cmd);
-      force_landing_flag_ = true;
-    }
-
-  if(getNaviState() == TAKEOFF_STATE || getNaviState() == HOVER_STATE)
-    {
-      bool normal_land = false;
-
-      /* joystick heartbeat check */
-      if(check_joy_stick_heart_beat_ && joy_stick_heart_beat_ &&
-         ros::Time::now().toSec() - joy_stick_prev_time_ > joy_stick_heart_beat_du_)
-        {
-          normal_land = true;
-          ROS_ERROR("Normal Landing: att control mode, because no joy control");
-        }
-
-      /* low voltage flag */
-      if(low_voltage_flag_)
-        {
-          normal_land = true;
-          ROS_ERROR("Normal Landing: low battery");
-        }
-
-      if(normal_land && !force_att_control_flag_)
-        {
-          setNaviState(LAND_STATE);
-        }
-    }
-
-  /* update the target pos and velocity */
-  if (trajectory_mode_)
-    {
-      if (traj_generator_ptr_.get() == nullptr)
-        {
-          if (ros::Time::now().toSec() > trajectory_reset_time_)
-            {
-              setTargetZeroVel();
-              setTargetZeroAcc();
-
-              setTargetZeroOmega();
-              setTargetZeroAngAcc();
-
-              trajectory_mode_ = false;
-
-              ROS_INFO("[Flight nav] stop trajectory mode in POS-VEL mode");
-            }
-        }
-      else
-        {
-          // trajectory following mode
-          double t = ros::Time::now().toSec();
-          double end_t = traj_generator_ptr_->getEndSetpoint().state.t;
-          if (t > end_t)
-            {
-              ROS_INFO("[Nav] reach the end of trajectory");
-
-              setTargetZeroVel();
-              setTargetZeroAcc();
-
-              setTargetZeroOmega();
-              setTargetZeroAngAcc();
-
-              trajectory_mode_ = false;
-
-              traj_generator_ptr_.reset();
-            }
-          else
-            {
-              agi::QuadState target_state = traj_generator_ptr_->getState(t);
-              setTargetPos(tf::Vector3(target_state.p(0), target_state.p(1), target_state.p(2)));
-              setTargetVel(tf::Vector3(target_state.v(0), target_state.v(1), target_state.v(2)));
-              setTargetAcc(tf::Vector3(target_state.a(0), target_state.a(1), target_state.a(2)));
-
-              double target_yaw = target_state.getYaw();
-              double target_omega_z = target_state.w(2);
-              double target_ang_acc_z = target_state.tau(2);
-              setTargetYaw(target_yaw);
-              setTargetOmegaZ(target_omega_z);
-              setTargetAngAccZ(target_ang_acc_z);
-
-              tf::Vector3 curr_pos = estimator_->getPos(Frame::COG, estimate_mode_);
-              double yaw_angle = estimator_->getState(State::YAW_COG, estimate_mode_)[0];
-              ROS_INFO_THROTTLE(0.5, "[Nav] trajectory mode, target pos&yaw: [%f, %f, %f, %f], curr pos&yaw: [%f, %f, %f, %f]", target_state.p(0), target_state.p(1), target_state.p(2), target_yaw, curr_pos.x(), curr_pos.y(), curr_pos.z(), yaw_angle);
-            }
-        }
-    }
-  else
-    {
-      /* force reset velocity in idling mode */
-      if (ros::Time::now().toSec() > teleop_reset_time_)
-        {
-          setTargetZeroVel();
-          setTargetOmegaZ(0);
-        }
-
-      /* uniform linear motion */
-      addTargetPos(getTargetVel() * loop_du_);
-      addTargetYaw(getTargetOmega().z() * loop_du_);
-    }
-
-  tf::Vector3 curr_pos = estimator_->getPos(Frame::COG, estimate_mode_);
-  tf::Vector3 curr_vel = estimator_->getVel(Frame::COG, estimate_mode_);
-  tf::Vector3 delta = target_pos_ - curr_pos;
+  uint8_t published_state;
 
-  /* check the hard landing in force_landing model */
-  if(force_landing_flag_)
-    {
-      // TODO: check from altitude if possible (with sanity of estimator)
-    }
+  {
+    /* the state machine and the targets are updated in one transaction, the messages are published after it */
+    auto target = target_.write();
 
-  switch(getNaviState())
-    {
-    case START_STATE:
+    /* update the target pos and velocity */
+    if (trajectory_mode_)
       {
-        /* low voltage */
-        if(low_voltage_flag_)
-          {
-            setNaviState(ARM_OFF_STATE);
-            break;
-          }
-        if(high_voltage_flag_)
+        double t = ros::Time::now().toSec();
+        if (trajectory_replanning_ && receding_horizon_.active(t))
           {
-            setNaviState(ARM_OFF_STATE);
-            ROS_ERROR("high voltage!");
-            break;
-          }
+            // re-solve from the current reference if the goal or waypoints are updated
+            updateReplanning(t);
 
-        estimator_->setSensorFusionFlag(true);
-        force_landing_flag_ = false;
+            agi::QuadState target_state = receding_horizon_.getState(t);
+            setTargetFromTrajectory(target_state);
 
-        spinal::FlightConfigCmd flight_config_cmd;
-        flight_config_cmd.cmd = spinal::FlightConfigCmd::ARM_ON_CMD;
-        flight_config_pub_.publish(flight_config_cmd);
+            ROS_INFO_THROTTLE(0.5, "[Nav] trajectory replanning mode, target pos&yaw: [%f, %f, %f, %f], remaining waypoints: %zu", target_state.p(0), target_state.p(1), target_state.p(2), target_state.getYaw(), receding_horizon_.remainingWaypoints());
+          }
+        else if (traj_generator_ptr_.get() == nullptr)
+          {
+            if (ros::Time::now().toSec() > trajectory_reset_time_)
+              {
+                setTargetZeroVel();
+                setTargetZeroAcc();
 
-        break;
-      }
-    case TAKEOFF_STATE:
-      { //Takeoff Phase
+                setTargetZeroOmega();
+                setTargetZeroAngAcc();
 
-        /* set flying flag to true once */
-        if(!estimator_->getFlyingFlag())
-          estimator_->setFlyingFlag(true);
+                trajectory_mode_ = false;
+                std::atomic_store(&reference_preview_, std::shared_ptr<const std::vector<agi::QuadState> >());
 
-        if(xy_control_mode_ == POS_CONTROL_MODE)
-          {
-            if (fabs(delta.z()) > z_convergent_thresh_ || fabs(delta.x()) > xy_convergent_thresh_ || fabs(delta.y()) > xy_convergent_thresh_)
-              hover_convergent_start_time_ = ros::Time::now().toSec();
+                ROS_INFO("[Flight nav] stop trajectory mode in POS-VEL mode");
+              }
           }
         else
           {
-            if (fabs(delta.z()) > z_convergent_thresh_) hover_convergent_start_time_ = ros::Time::now().toSec();
-          }
-        if (ros::Time::now().toSec() - hover_convergent_start_time_ > hover_convergent_duration_)
-          {
-            hover_convergent_start_time_ = ros::Time::now().toSec();
-            setNaviState(HOVER_STATE);
-            ROS_INFO("\n \n ======================  \n Hover!!! \n ====================== \n");
-          }
-        break;
-      }
-    case LAND_STATE:
-      {
-        if (getNaviState() > START_STATE)
-          {
-            updateLandCommand();
-
-            if (ros::Time::now().toSec() - land_check_start_time_ > land_check_duration_)
+            // trajectory following mode
+            double end_t = traj_generator_ptr_->getEndSetpoint().state.t;
+            if (t > end_t)
               {
-                double delta = curr_pos.z() - land_height_;
-                double vel = curr_vel.z();
+                ROS_INFO("[Nav] reach the end of trajectory");
 
-                ROS_INFO("expected land height: %f (current height: %f), velocity: %f ", land_height_, curr_pos.z(), vel);
+                setTargetZeroVel();
+                setTargetZeroAcc();
 
-                if (fabs(delta) < land_pos_convergent_thresh_ &&
-                    vel > -land_vel_convergent_thresh_)
-                  {
-                    ROS_INFO("\n \n ======================  \n Land !!! \n ====================== \n");
-                    ROS_INFO("Start disarming motors");
-                    setNaviState(STOP_STATE);
-                  }
-                else
-                  {
-                    // not staedy, update the land height
-                    land_height_ = curr_pos.z();
-                  }
+                setTargetZeroOmega();
+                setTargetZeroAngAcc();
+
+                trajectory_mode_ = false;
+
+                traj_generator_ptr_.reset();
+              }
+            else
+              {
+                agi::QuadState target_state = traj_generator_ptr_->getState(t);
+                setTargetFromTrajectory(target_state);
+                double target_yaw = target_state.getYaw();
 
-                land_check_start_time_ = ros::Time::now().toSec();
+                tf::Vector3 curr_pos = estimator_->getPos(Frame::COG, estimate_mode_);
+                double yaw_angle = estimator_->getState(State::YAW_COG, estimate_mode_)[0];
+                ROS_INFO_THROTTLE(0.5, "[Nav] trajectory mode, target pos&yaw: [%f, %f, %f, %f], curr pos&yaw: [%f, %f, %f, %f]", target_state.p(0), target_state.p(1), target_state.p(2), target_yaw, curr_pos.x(), curr_pos.y(), curr_pos.z(), yaw_angle);
               }
           }
-        else
+      }
+    else
+      {
+        /* force reset velocity in idling mode */
+        if (ros::Time::now().toSec() > teleop_reset_time_)
           {
-            setNaviState(ARM_OFF_STATE);
+            setTargetZeroVel();
+            setTargetOmegaZ(0);
           }
-        break;
+
+        /* uniform linear motion */
+        addTargetPos(target->vel * loop_du_);
+        addTargetYaw(target->omega.z() * loop_du_);
       }
-    case HOVER_STATE:
-      {
-        if(force_att_control_flag_) break;
 
+    tf::Vector3 curr_pos = estimator_->getPos(Frame::COG, estimate_mode_);
+    tf::Vector3 curr_vel = estimator_->getVel(Frame::COG, estimate_mode_);
+    tf::Vector3 delta = target->pos - curr_pos;
+
+    NavigationInput input;
+    input.stamp = ros::Time::now().toSec();
+    input.xy_estimation = estimator_->getStateStatus(State::X_BASE, estimate_mode_) && estimator_->getStateStatus(State::Y_BASE, estimate_mode_);
+    input.unhealth = estimator_->getUnhealthLevel() == Sensor::UNHEALTH_LEVEL3;
+    input.delta[0] = delta.x();
+    input.delta[1] = delta.y();
+    input.delta[2] = delta.z();
+    input.z = curr_pos.z();
+    input.vz = curr_vel.z();
+
+    NavigationOutput output = state_machine_.update(input);
+    applyNavigationOutput(output);
+
+    /* waypoint navigation in hover state */
+    if(output.prev_state == HOVER_STATE && output.state == HOVER_STATE && !state_machine_.getForceAttControlFlag())
+      {
         if(gps_waypoint_)
           {
             if(ros::Time::now().toSec() - gps_waypoint_time_ > gps_waypoint_check_du_)
@@ -865,12 +790,12 @@ void BaseNavigator::update()
                 if(gps_waypoint_delta.length() < gps_waypoint_threshold_)
                   gps_waypoint_ = false;
 
-                xy_control_mode_ = POS_CONTROL_MODE;
+                state_machine_.setXyControlMode(POS_CONTROL_MODE);
 
                 if(gps_waypoint_delta.length() > vel_nav_threshold_)
                   {
                     vel_based_waypoint_ = true;
-                    xy_control_mode_ = VEL_CONTROL_MODE;
+                    state_machine_.setXyControlMode(VEL_CONTROL_MODE);
                   }
 
                 //ROS_INFO("gps_waypoint_delta: %f, %f", gps_waypoint_delta.x(), gps_waypoint_delta.y());
@@ -913,41 +838,146 @@ void BaseNavigator::update()
                     ROS_WARN("back to pos nav control for way point");
                   }
 
-                xy_control_mode_ = POS_CONTROL_MODE;
+                state_machine_.setXyControlMode(POS_CONTROL_MODE);
                 vel_based_waypoint_ = false;
                 setTargetZeroVel();
               }
           }
-        break;
       }
-    case STOP_STATE:
-      {
-        reset();
-
-        spinal::FlightConfigCmd flight_config_cmd;
-        flight_config_cmd.cmd = spinal::FlightConfigCmd::ARM_OFF_CMD;
-        flight_config_pub_.publish(flight_config_cmd);
-
-        if(force_landing_flag_)
-          {
-            halt();
-            force_landing_flag_ = false;
-          }
 
-        break;
-      }
-    default:
-      {
-        break;
-      }
-    }
+    published_state = state_machine_.getPublishedState();
+  }
 
   /* publish the state */
   std_msgs::UInt8 state_msg;
-  state_msg.data = getNaviState();
-  if(force_landing_flag_) state_msg.data = FORCE_LANDING_STATE;
-  else if(low_voltage_flag_) state_msg.data = LOW_BATTERY_STATE;
+  state_msg.data = published_state;
   flight_state_pub_.publish(state_msg);
+
+  if(transformation_planner_) updateTransformation();
+}
+
+void BaseNavigator::updateReplanning(double t)
+{
+  /* take the result of the worker, check if it is idle before to get the result stored before it finishes */
+  bool idle = !replan_busy_;
+  std::shared_ptr<ReplanSolution> solution = std::atomic_exchange(&replan_solution_, std::shared_ptr<ReplanSolution>());
+  if (solution && receding_horizon_.apply(*solution) && solution->preview)
+    std::atomic_store(&reference_preview_, solution->preview);
+
+  agi::RecedingHorizonReference::Problem problem;
+  if (!idle || !receding_horizon_.prepare(t, problem)) return;
+
+  /* the solution starts after the solve delay, the current trajectory is followed until then */
+  replan_busy_ = true;
+  const double preview_du = reference_preview_du_;
+  replan_future_ = std::async(std::launch::async, [this, problem, preview_du]()
+                              {
+                                auto solution = std::make_shared<ReplanSolution>();
+                                static_cast<agi::RecedingHorizonReference::Solution&>(*solution) = agi::RecedingHorizonReference::solve(problem);
+
+                                /* sample before the hand-over, the trajectory is not sampled concurrently with the control loop */
+                                std::vector<agi::QuadState> states;
+                                if (solution->trajectory)
+                                  {
+                                    std::vector<double> sample_times;
+                                    for (double sample_t = solution->trajectory->getStartTime(); sample_t <= solution->trajectory->getEndTime(); sample_t += 0.02)
+                                      sample_times.push_back(sample_t);
+                                    solution->trajectory->getStates(sample_times, states);
+
+                                    auto preview = std::make_shared<std::vector<agi::QuadState> >();
+                                    sample_times.clear();
+                                    for (double sample_t = solution->trajectory->getStartTime(); sample_t <= solution->trajectory->getEndTime(); sample_t += preview_du)
+                                      sample_times.push_back(sample_t);
+                                    solution->trajectory->getStates(sample_times, *preview);
+                                    solution->preview = preview;
+                                  }
+                                std::atomic_store(&replan_solution_, solution);
+
+                                if (!states.empty()) publishTrajectoryPath(states);
+
+                                /* last, the next solve replaces the future which waits for this task */
+                                replan_busy_ = false;
+                              });
+}
+
+NavigationOutput BaseNavigator::handleEvent(NavigationEvent::Type type, int value)
+{
+  auto target = target_.write();
+
+  NavigationEvent event;
+  event.type = type;
+  event.stamp = ros::Time::now().toSec();
+  event.value = value;
+
+  NavigationOutput output = state_machine_.handle(event);
+  applyNavigationOutput(output);
+  return output;
+}
+
+void BaseNavigator::applyNavigationOutput(const NavigationOutput& output)
+{
+  if(output.has(NavigationOutput::INIT_TAKEOFF_TARGET)) initTakeoffTarget();
+  if(output.has(NavigationOutput::HOLD_XY_TARGET)) setTargetXyFromCurrentState();
+  if(output.has(NavigationOutput::HOLD_Z_TARGET)) setTargetZFromCurrentState();
+  if(output.has(NavigationOutput::HOLD_YAW_TARGET)) setTargetYawFromCurrentState();
+  if(output.has(NavigationOutput::ZERO_VEL_ACC_TARGET))
+    {
+      setTargetZeroVel();
+      setTargetZeroAcc();
+    }
+
+  if(output.has(NavigationOutput::SET_FORCE_ATT_CONTROL)) estimator_->setForceAttControlFlag(true);
+  if(output.has(NavigationOutput::START_SENSOR_FUSION)) estimator_->setSensorFusionFlag(true);
+  /* set flying flag to true once */
+  if(output.has(NavigationOutput::SET_FLYING) && !estimator_->getFlyingFlag()) estimator_->setFlyingFlag(true);
+
+  if(output.has(NavigationOutput::UPDATE_LAND_COMMAND)) updateLandCommand();
+  if(output.has(NavigationOutput::RESET)) reset();
+
+  if(output.has(NavigationOutput::SEND_ARM_ON_CMD)) sendFlightConfigCmd(spinal::FlightConfigCmd::ARM_ON_CMD);
+  if(output.has(NavigationOutput::SEND_ARM_OFF_CMD)) sendFlightConfigCmd(spinal::FlightConfigCmd::ARM_OFF_CMD);
+  if(output.has(NavigationOutput::SEND_FORCE_LANDING_CMD)) sendFlightConfigCmd(spinal::FlightConfigCmd::FORCE_LANDING_CMD);
+
+  if(output.has(NavigationOutput::HALT)) halt();
+}
+
+void BaseNavigator::sendFlightConfigCmd(uint8_t cmd)
+{
+  spinal::FlightConfigCmd flight_config_cmd;
+  flight_config_cmd.cmd = cmd;
+  flight_config_pub_.publish(flight_config_cmd);
+}
+
+void BaseNavigator::initTakeoffTarget()
+{
+  for(const auto& handler: estimator_->getGpsHandlers())
+    {
+      if(handler->getStatus() == Status::ACTIVE)
+        {
+          ros::NodeHandle nh(nh_, "navigation");
+          NavigationConfig config = state_machine_.getConfig();
+          nh.param("outdoor_takeoff_height", takeoff_height_, 1.2);
+          nh.param("outdoor_hover_convergent_duration", config.hover_convergent_duration, 0.5);
+          nh.param("outdoor_xy_convergent_thresh", config.xy_convergent_thresh, 0.6);
+          nh.param("outdoor_z_convergent_thresh", config.z_convergent_thresh, 0.05);
+          state_machine_.setConfig(config);
+
+          ROS_WARN_STREAM("update the navigation parameters for outdoor flight, takeoff height: " << takeoff_height_ << "; outdoor_hover_convergent_duration: " << config.hover_convergent_duration << "; outdoor_xy_convergent_thresh: " << config.xy_convergent_thresh << "; outdoor_z_convergent_thresh: " << config.z_convergent_thresh);
+
+          break;
+        }
+    }
+
+  trajectory_mode_ = false;
+  std::atomic_store(&reference_preview_, std::shared_ptr<const std::vector<agi::QuadState> >());
+  setTargetXyFromCurrentState();
+  setTargetPosZ(takeoff_height_);
+  setTargetVelZ(0);
+  setTargetAccZ(0);
+  setInitHeight(estimator_->getPos(Frame::COG, estimate_mode_).z());
+  setTargetYawFromCurrentState();
+
+  ROS_INFO_STREAM("init height for takeoff: " << init_height_);
 }
 
 void BaseNavigator::updateLandCommand()
@@ -962,26 +992,8 @@ void BaseNavigator::updateLandCommand()
 
 void BaseNavigator::generateNewTrajectory(geometry_msgs::PoseStamped pose)
 {
-  if (traj_generator_ptr_.get() != nullptr)
-    {
-      ROS_WARN("[Nav] force to finish the last trajectory following");
-      traj_generator_ptr_.reset();
-    }
-
-  agi::QuadState start_state;
-  start_state.setZero();
-  tf::Vector3 last_target_pos = getTargetPos();
-  start_state.p = agi::Vector<3>(last_target_pos.x(), last_target_pos.y(), last_target_pos.z());
-  tf::Vector3 last_target_vel = getTargetVel();
-  start_state.v = agi::Vector<3>(last_target_vel.x(), last_target_vel.y(), last_target_vel.z());
-  tf::Vector3 last_target_acc = getTargetAcc();
-  start_state.a = agi::Vector<3>(last_target_acc.x(), last_target_acc.y(), last_target_acc.z());
-
-  double last_target_yaw_angle = getTargetRPY().z();
-  start_state.setYaw(last_target_yaw_angle);
-  double last_target_omega_z = getTargetOmega().z();
-  start_state.w(2) = last_target_omega_z;
-  start_state.t = ros::Time::now().toSec();
+  /* the trajectory is built and sampled outside the target transaction, only the hand over is locked */
+  agi::QuadState start_state = getTargetQuadState();
 
   agi::QuadState end_state;
   end_state.setZero();
@@ -1001,6 +1013,17 @@ void BaseNavigator::generateNewTrajectory(geometry_msgs::PoseStamped pose)
 
     }
 
+  if (trajectory_replanning_)
+    {
+      // continue from the current reference, the new goal is solved in the next update
+      auto target = target_.write();
+      if (traj_generator_ptr_.get() != nullptr) traj_generator_ptr_.reset();
+      if (!trajectory_mode_ || !receding_horizon_.active(start_state.t)) receding_horizon_.reset(getTargetQuadState());
+      receding_horizon_.setGoal(end_state);
+      trajectory_mode_ = true;
+      return;
+    }
+
   double du_tran = (end_state.p - start_state.p).norm() / trajectory_mean_vel_;
   double du_rot = fabs(end_state.getYaw() - start_state.getYaw()) / trajectory_mean_yaw_rate_;
   double du = std::max(du_tran, trajectory_min_du_);
@@ -1019,28 +1042,69 @@ void BaseNavigator::generateNewTrajectory(geometry_msgs::PoseStamped pose)
                   << " (omega z: " << start_state.w(2) << ")"
                   << " and target acc: " << start_state.a.transpose());
 
-  traj_generator_ptr_ = std::make_shared<agi::MinJerkTrajectory>(start_state, end_state);
+  std::shared_ptr<agi::MinJerkTrajectory> trajectory = std::make_shared<agi::MinJerkTrajectory>(start_state, end_state);
 
-  trajectory_mode_ = true;
+  std::vector<double> sample_times;
+  for (double t = 0; t <= du; t += 0.02) sample_times.push_back(start_state.t + t);
+
+  // evaluate all samples in one batch
+  std::vector<agi::QuadState> states;
+  trajectory->getStates(sample_times, states);
+
+  {
+    /* hand over from the current targets to the new trajectory in one transaction */
+    auto target = target_.write();
+    if (traj_generator_ptr_.get() != nullptr)
+      ROS_WARN("[Nav] force to finish the last trajectory following");
+    traj_generator_ptr_ = trajectory;
+    trajectory_mode_ = true;
+  }
 
-  double dt = 0.02;
+  publishTrajectoryPath(states);
+}
+
+agi::QuadState BaseNavigator::getTargetQuadState()
+{
+  TargetSetpoint target = target_.get();
+
+  agi::QuadState state;
+  state.setZero();
+  state.p = agi::Vector<3>(target.pos.x(), target.pos.y(), target.pos.z());
+  state.v = agi::Vector<3>(target.vel.x(), target.vel.y(), target.vel.z());
+  state.a = agi::Vector<3>(target.acc.x(), target.acc.y(), target.acc.z());
+  state.setYaw(target.rpy.z());
+  state.w(2) = target.omega.z();
+  state.t = ros::Time::now().toSec();
+  return state;
+}
+
+void BaseNavigator::setTargetFromTrajectory(const agi::QuadState& target_state)
+{
+  auto target = target_.write();
+  target->pos.setValue(target_state.p(0), target_state.p(1), target_state.p(2));
+  target->vel.setValue(target_state.v(0), target_state.v(1), target_state.v(2));
+  target->acc.setValue(target_state.a(0), target_state.a(1), target_state.a(2));
+  target->rpy.setZ(target_state.getYaw());
+  target->omega.setZ(target_state.w(2));
+  target->ang_acc.setZ(target_state.tau(2));
+}
+
+void BaseNavigator::publishTrajectoryPath(const std::vector<agi::QuadState>& states)
+{
   nav_msgs::Path msg;
-  msg.header.stamp.fromSec(start_state.t);
+  if (!states.empty()) msg.header.stamp.fromSec(states.front().t);
   msg.header.frame_id = "world";
 
-  for (double t = 0; t <= du; t += dt) {
-    geometry_msgs::PoseStamped pose_stamp;
-    pose_stamp.header.stamp = msg.header.stamp + ros::Duration(t);
+  msg.poses.resize(states.size());
+  for (int i = 0; i < states.size(); i++) {
+    geometry_msgs::PoseStamped& pose_stamp = msg.poses.at(i);
+    pose_stamp.header.stamp.fromSec(states.at(i).t);
     pose_stamp.header.frame_id = msg.header.frame_id;
 
-    agi::QuadState state = traj_generator_ptr_->getState(start_state.t + t);
-
-    tf::pointEigenToMsg(state.p, pose_stamp.pose.position);
-    tf::quaternionEigenToMsg(state.q(), pose_stamp.pose.orientation);
-    msg.poses.push_back(pose_stamp);
+    tf::pointEigenToMsg(states.at(i).p, pose_stamp.pose.position);
+    tf::quaternionEigenToMsg(states.at(i).q(), pose_stamp.pose.orientation);
   }
   path_pub_.publish(msg);
-
 }
 
 void BaseNavigator::rosParamInit()
@@ -1048,7 +1112,9 @@ void BaseNavigator::rosParamInit()
   getParam<bool>(nhp_, "param_verbose", param_verbose_, false);
 
   ros::NodeHandle nh(nh_, "navigation");
-  getParam<int>(nh, "xy_control_mode", xy_control_mode_, 0);
+  int xy_control_mode;
+  getParam<int>(nh, "xy_control_mode", xy_control_mode, 0);
+  state_machine_.setXyControlMode(xy_control_mode);
   getParam<double>(nh, "takeoff_height", takeoff_height_, 0.0);
 
   getParam<double>(nh, "land_descend_vel",land_descend_vel_, -0.3);
@@ -1057,19 +1123,20 @@ void BaseNavigator::rosParamInit()
     land_descend_vel_ == -0.3;
   }
 
-  getParam<double>(nh, "hover_convergent_duration", hover_convergent_duration_, 1.0);
-  getParam<double>(nh, "land_check_duration", land_check_duration_, 0.5);
-  if (land_check_duration_ < 0.5) {
-    ROS_WARN("land_check_duration_ (current value: %f) should be not smaller than 0.5", land_check_duration_);
-    land_check_duration_ = 0.5;
+  NavigationConfig config;
+  getParam<double>(nh, "hover_convergent_duration", config.hover_convergent_duration, 1.0);
+  getParam<double>(nh, "land_check_duration", config.land_check_duration, 0.5);
+  if (config.land_check_duration < 0.5) {
+    ROS_WARN("land_check_duration_ (current value: %f) should be not smaller than 0.5", config.land_check_duration);
+    config.land_check_duration = 0.5;
   }
 
   getParam<double>(nh, "trajectory_reset_duration", trajectory_reset_duration_, 0.5);
   getParam<double>(nh, "teleop_reset_duration", teleop_reset_duration_, 0.5);
-  getParam<double>(nh, "z_convergent_thresh", z_convergent_thresh_, 0.05);
-  getParam<double>(nh, "xy_convergent_thresh", xy_convergent_thresh_, 0.15);
-  getParam<double>(nh, "land_pos_convergent_thresh", land_pos_convergent_thresh_, 0.02);
-  getParam<double>(nh, "land_vel_convergent_thresh", land_vel_convergent_thresh_, 0.05);
+  getParam<double>(nh, "z_convergent_thresh", config.z_convergent_thresh, 0.05);
+  getParam<double>(nh, "xy_convergent_thresh", config.xy_convergent_thresh, 0.15);
+  getParam<double>(nh, "land_pos_convergent_thresh", config.land_pos_convergent_thresh, 0.02);
+  getParam<double>(nh, "land_vel_convergent_thresh", config.land_vel_convergent_thresh, 0.05);
 
   //*** trajectory
   getParam<double>(nh, "trajectory_mean_vel", trajectory_mean_vel_, 0.5);
@@ -1077,6 +1144,37 @@ void BaseNavigator::rosParamInit()
   getParam<double>(nh, "trajectory_min_du", trajectory_min_du_, 2.0);
   getParam<bool>(nh, "enable_latch_yaw_trajectory", enable_latch_yaw_trajectory_, false);
 
+  // continuous replanning from the current reference instead of one trajectory per goal
+  getParam<bool>(nh, "trajectory_replanning", trajectory_replanning_, false);
+  agi::RecedingHorizonParams replan_params;
+  getParam<double>(nh, "trajectory_replan_du", replan_params.replan_period, 0.1);
+  getParam<double>(nh, "trajectory_replan_delay", replan_params.solve_delay, 0.05); // longer than the solve time
+  getParam<double>(nh, "trajectory_preview_du", reference_preview_du_, 0.1);
+  if (reference_preview_du_ <= 0) reference_preview_du_ = 0.1;
+  getParam<double>(nh, "trajectory_max_vel", replan_params.limits.v_max, agi::INF);
+  getParam<double>(nh, "trajectory_max_acc", replan_params.limits.a_max, agi::INF);
+  getParam<double>(nh, "trajectory_max_jerk", replan_params.limits.j_max, agi::INF);
+  replan_params.mean_vel = trajectory_mean_vel_;
+  replan_params.mean_yaw_rate = enable_latch_yaw_trajectory_ ? agi::INF : trajectory_mean_yaw_rate_;
+  getParam<double>(nh, "trajectory_replan_min_du", replan_params.min_duration, 0.5);
+  receding_horizon_.setParams(replan_params);
+
+  //*** transformation
+  getParam<bool>(nh, "transformation_planning", transformation_planning_, false);
+  ros::NodeHandle transformation_nh(nh, "transformation");
+  getParam<int>(transformation_nh, "segment_num", transformation_params_.segment_num, 10);
+  getParam<int>(transformation_nh, "max_iteration", transformation_params_.max_iteration, 100);
+  getParam<double>(transformation_nh, "tolerance", transformation_params_.tolerance, 1e-3);
+  getParam<double>(transformation_nh, "constraint_tolerance", transformation_params_.constraint_tolerance, 1e-3);
+  getParam<double>(transformation_nh, "max_step", transformation_params_.max_step, 0.1);
+  getParam<double>(transformation_nh, "fc_f_margin", transformation_params_.fc_f_margin, 0.0);
+  getParam<double>(transformation_nh, "fc_t_margin", transformation_params_.fc_t_margin, 0.0);
+  getParam<double>(transformation_nh, "thrust_margin", transformation_params_.thrust_margin, 0.0);
+  getParam<double>(transformation_nh, "joint_torque_rate", transformation_params_.joint_torque_rate, 1.0);
+  getParam<double>(transformation_nh, "joint_vel_rate", transformation_params_.joint_vel_rate, 1.0);
+  getParam<double>(transformation_nh, "min_segment_du", transformation_params_.min_segment_du, 0.1);
+  getParam<double>(transformation_nh, "check_resolution", transformation_params_.check_resolution, 0.02);
+
   //*** auto vel nav
   getParam<double>(nh, "nav_vel_limit", nav_vel_limit_, 0.2);
   getParam<double>(nh, "vel_nav_threshold", vel_nav_threshold_, 0.4);
@@ -1092,12 +1190,13 @@ void BaseNavigator::rosParamInit()
   getParam<double>(nh, "max_teleop_yaw_vel", max_teleop_yaw_vel_, 0.5);
   getParam<double>(nh, "max_teleop_rp_angle", max_teleop_rp_angle_, 0.2);
   getParam<double>(nh, "joy_stick_deadzone", joy_stick_deadzone_, 0.2);
-  getParam<double>(nh, "joy_stick_heart_beat_du", joy_stick_heart_beat_du_, 2.0);
-  getParam<double>(nh, "force_landing_to_halt_du", force_landing_to_halt_du_, 1.0);
+  getParam<double>(nh, "joy_stick_heart_beat_du", config.joy_stick_heart_beat_du, 2.0);
+  getParam<double>(nh, "force_landing_to_halt_du", config.force_landing_to_halt_du, 1.0);
   getParam<bool>(nh, "force_landing_auto_stop_flag", force_landing_auto_stop_flag_, true);
   getParam<bool>(nh, "joy_udp", joy_udp_, true);
-  getParam<bool>(nh, "check_joy_stick_heart_beat", check_joy_stick_heart_beat_, false);
+  getParam<bool>(nh, "check_joy_stick_heart_beat", config.check_joy_stick_heart_beat, false);
   getParam<std::string>(nh, "teleop_local_frame", teleop_local_frame_, std::string("root"));
+  state_machine_.setConfig(config);
 
   ros::NodeHandle bat_nh(nh_, "bat_info");
   getParam<int>(bat_nh, "bat_cell", bat_cell_, 0); // Lipo battery cell
@@ -0,0 +1,450 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <aerial_robot_control/navigation_state_machine.h>
+#include <cmath>
+#include <cstdio>
+
+using namespace aerial_robot_navigation;
+
+NavigationStateMachine::NavigationStateMachine():
+  landing_preparation_(false),
+  state_(ARM_OFF_STATE),
+  xy_control_mode_(POS_CONTROL_MODE),
+  prev_xy_control_mode_(ACC_CONTROL_MODE),
+  force_att_control_(false),
+  force_landing_(false),
+  low_voltage_(false),
+  high_voltage_(false),
+  teleop_(true),
+  joy_stick_heart_beat_(false),
+  ready_(false),
+  preparing_landing_(false),
+  landing_prepared_(false),
+  joy_stick_prev_time_(0),
+  force_landing_start_time_(0),
+  hover_convergent_start_time_(0),
+  land_check_start_time_(0),
+  land_height_(0)
+{
+}
+
+NavigationOutput NavigationStateMachine::handle(const NavigationEvent& event)
+{
+  NavigationOutput output;
+  output.prev_state = state_;
+  output.state = state_;
+
+  switch(event.type)
+    {
+    case NavigationEvent::ARM:
+    case NavigationEvent::JOY_START:
+      {
+        if(event.type == NavigationEvent::JOY_START && state_ != ARM_OFF_STATE) break;
+
+        /* check whether there is the fusion for the altitude */
+        if(!event.value)
+          {
+            log(ERROR, "Flight Navigation: No correct sensor fusion for z(altitude), can not fly");
+            break;
+          }
+
+        transit(output, START_STATE);
+        xy_control_mode_ = POS_CONTROL_MODE;
+        preparing_landing_ = false;
+        landing_prepared_ = false;
+        output.actions |= NavigationOutput::INIT_TAKEOFF_TARGET;
+        log(INFO, "Start state");
+        break;
+      }
+    case NavigationEvent::TAKEOFF:
+      {
+        if(state_ == ARM_ON_STATE)
+          {
+            transit(output, TAKEOFF_STATE);
+            hover_convergent_start_time_ = event.stamp;
+            log(INFO, "Takeoff state");
+          }
+        break;
+      }
+    case NavigationEvent::LAND:
+      {
+        if(force_att_control_) break;
+        if(!teleop_) break; /* can not do the process if other processs are running */
+        if(state_ == LAND_STATE) break;
+
+        transit(output, LAND_STATE);
+        log(INFO, "Land state");
+        break;
+      }
+    case NavigationEvent::HALT:
+      {
+        if(!teleop_) break;
+
+        force_landing_ = true;
+        transit(output, STOP_STATE);
+        log(INFO, "Halt state");
+        break;
+      }
+    case NavigationEvent::FORCE_LANDING:
+      {
+        output.actions |= NavigationOutput::SEND_FORCE_LANDING_CMD;
+        force_landing_ = true;
+        log(INFO, "Force Landing state");
+        break;
+      }
+    case NavigationEvent::ARM_ON_ACK:
+      {
+        transit(output, ARM_ON_STATE);
+        log(INFO, "START RES From AERIAL ROBOT");
+        break;
+      }
+    case NavigationEvent::ARM_OFF_ACK:
+      {
+        transit(output, ARM_OFF_STATE);
+        log(INFO, "STOP RES From AERIAL ROBOT");
+        break;
+      }
+    case NavigationEvent::FORCE_LANDING_ACK:
+      {
+        /* get the first force landing message from spinal */
+        force_landing_ = true;
+        log(INFO, "FORCE LANDING MSG From AERIAL ROBOT");
+        break;
+      }
+    case NavigationEvent::XY_CONTROL_MODE:
+      {
+        if(state_ <= START_STATE) break;
+
+        if(event.value == POS_CONTROL_MODE)
+          {
+            output.actions |= NavigationOutput::HOLD_XY_TARGET | NavigationOutput::ZERO_VEL_ACC_TARGET;
+            xy_control_mode_ = POS_CONTROL_MODE;
+            log(INFO, "x/y position control mode");
+          }
+        if(event.value == VEL_CONTROL_MODE)
+          {
+            output.actions |= NavigationOutput::ZERO_VEL_ACC_TARGET;
+            xy_control_mode_ = VEL_CONTROL_MODE;
+            log(INFO, "x/y velocity control mode");
+          }
+        if(event.value == ACC_CONTROL_MODE)
+          {
+            xy_control_mode_ = ACC_CONTROL_MODE;
+            log(INFO, "x/y acceleration control mode");
+          }
+        break;
+      }
+    case NavigationEvent::TELEOP:
+      {
+        teleop_ = event.value;
+        log(WARN, teleop_ ? "start teleop control" : "stop teleop control");
+        break;
+      }
+    case NavigationEvent::BATTERY:
+      {
+        low_voltage_ = event.value & NavigationEvent::LOW_VOLTAGE;
+        high_voltage_ = event.value & NavigationEvent::HIGH_VOLTAGE;
+        break;
+      }
+    case NavigationEvent::JOY:
+      {
+        joy_stick_heart_beat_ = true;
+        joy_stick_prev_time_ = event.stamp;
+
+        if(!event.value)
+          {
+            /* update the halt process */
+            force_landing_start_time_ = event.stamp;
+            break;
+          }
+
+        /* force landing in inflight mode */
+        if(!force_landing_ && (state_ == TAKEOFF_STATE || state_ == LAND_STATE || state_ == HOVER_STATE))
+          {
+            log(WARN, "Joy Control: force landing state");
+            output.actions |= NavigationOutput::SEND_FORCE_LANDING_CMD;
+            force_landing_ = true;
+
+            /* update the force landing stamp for the halt process*/
+            force_landing_start_time_ = event.stamp;
+          }
+
+        /* halt if the button is held */
+        if(event.stamp - force_landing_start_time_ > config_.force_landing_to_halt_du && state_ > START_STATE)
+          {
+            log(ERROR, "Joy Control: Halt!");
+            transit(output, STOP_STATE);
+            output.actions |= NavigationOutput::HOLD_XY_TARGET | NavigationOutput::HOLD_YAW_TARGET;
+            xy_control_mode_ = POS_CONTROL_MODE;
+          }
+        break;
+      }
+    case NavigationEvent::JOY_ATT_MODE:
+      {
+        if(xy_control_mode_ == ACC_CONTROL_MODE) break;
+
+        log(WARN, "Force siwtch to attitude control mode");
+        force_att_control_ = true;
+        output.actions |= NavigationOutput::SET_FORCE_ATT_CONTROL;
+        xy_control_mode_ = ACC_CONTROL_MODE;
+        break;
+      }
+    case NavigationEvent::JOY_VEL_MODE:
+      {
+        if(xy_control_mode_ == VEL_CONTROL_MODE) break;
+
+        log(INFO, "switch to pure vel control mode");
+        force_att_control_ = false;
+        output.actions |= NavigationOutput::ZERO_VEL_ACC_TARGET;
+        xy_control_mode_ = VEL_CONTROL_MODE;
+        break;
+      }
+    case NavigationEvent::JOY_POS_MODE:
+      {
+        if(xy_control_mode_ == POS_CONTROL_MODE) break;
+
+        log(INFO, "change to pos control");
+        force_att_control_ = false;
+        output.actions |= NavigationOutput::HOLD_XY_TARGET;
+        xy_control_mode_ = POS_CONTROL_MODE;
+        break;
+      }
+    case NavigationEvent::LANDING_PREPARED:
+      {
+        if(!preparing_landing_ || state_ != HOVER_STATE) break;
+
+        log(WARN, "landing preparation is finished: back to land state");
+        preparing_landing_ = false;
+        landing_prepared_ = true;
+        teleop_ = true;
+        transit(output, LAND_STATE);
+        break;
+      }
+    default:
+      {
+        break;
+      }
+    }
+
+  return output;
+}
+
+NavigationOutput NavigationStateMachine::update(const NavigationInput& input)
+{
+  NavigationOutput output;
+  output.prev_state = state_;
+  output.state = state_;
+
+  if(force_att_control_)
+    {
+      if(state_ == LAND_STATE)
+        {
+          // reset to hover state and do manually landing
+          output.actions |= NavigationOutput::HOLD_Z_TARGET;
+          transit(output, HOVER_STATE);
+        }
+    }
+  else
+    {
+      /* check the xy estimation status, if not ready, change to att_control_mode */
+      if(!input.xy_estimation)
+        {
+          if(xy_control_mode_ == VEL_CONTROL_MODE || xy_control_mode_ == POS_CONTROL_MODE)
+            {
+              log(WARN, "No estimation for X, Y state, change to attitude control mode");
+              prev_xy_control_mode_ = xy_control_mode_;
+              xy_control_mode_ = ACC_CONTROL_MODE;
+            }
+        }
+      else
+        {
+          if(xy_control_mode_ == ACC_CONTROL_MODE && prev_xy_control_mode_ != ACC_CONTROL_MODE)
+            {
+              log(INFO, "Estimation for X, Y state is established, siwtch back to the xy control mode");
+              xy_control_mode_ = prev_xy_control_mode_;
+            }
+
+          if(!ready_) log(INFO, "\n \n ======================  \n Ready for takeoff !!! \n ====================== \n");
+          ready_ = true;
+        }
+    }
+
+  /* sensor health check */
+  if(input.unhealth && !force_landing_)
+    {
+      if(state_ == TAKEOFF_STATE || state_ == HOVER_STATE  || state_ == LAND_STATE)
+        log(WARN, "Sensor Unhealth Level3: force landing state");
+      output.actions |= NavigationOutput::SEND_FORCE_LANDING_CMD;
+      force_landing_ = true;
+    }
+
+  if(state_ == TAKEOFF_STATE || state_ == HOVER_STATE)
+    {
+      bool normal_land = false;
+
+      /* joystick heartbeat check */
+      if(config_.check_joy_stick_heart_beat && joy_stick_heart_beat_ &&
+         input.stamp - joy_stick_prev_time_ > config_.joy_stick_heart_beat_du)
+        {
+          normal_land = true;
+          log(ERROR, "Normal Landing: att control mode, because no joy control");
+        }
+
+      /* low voltage flag */
+      if(low_voltage_)
+        {
+          normal_land = true;
+          log(ERROR, "Normal Landing: low battery");
+        }
+
+      if(normal_land && !force_att_control_) transit(output, LAND_STATE);
+    }
+
+  switch(state_)
+    {
+    case START_STATE:
+      {
+        /* low voltage */
+        if(low_voltage_)
+          {
+            transit(output, ARM_OFF_STATE);
+            break;
+          }
+        if(high_voltage_)
+          {
+            transit(output, ARM_OFF_STATE);
+            log(ERROR, "high voltage!");
+            break;
+          }
+
+        output.actions |= NavigationOutput::START_SENSOR_FUSION | NavigationOutput::SEND_ARM_ON_CMD;
+        force_landing_ = false;
+        break;
+      }
+    case TAKEOFF_STATE:
+      {
+        output.actions |= NavigationOutput::SET_FLYING;
+
+        if(xy_control_mode_ == POS_CONTROL_MODE)
+          {
+            if(std::fabs(input.delta[2]) > config_.z_convergent_thresh ||
+               std::fabs(input.delta[0]) > config_.xy_convergent_thresh ||
+               std::fabs(input.delta[1]) > config_.xy_convergent_thresh)
+              hover_convergent_start_time_ = input.stamp;
+          }
+        else
+          {
+            if(std::fabs(input.delta[2]) > config_.z_convergent_thresh) hover_convergent_start_time_ = input.stamp;
+          }
+
+        if(input.stamp - hover_convergent_start_time_ > config_.hover_convergent_duration)
+          {
+            hover_convergent_start_time_ = input.stamp;
+            transit(output, HOVER_STATE);
+            log(INFO, "\n \n ======================  \n Hover!!! \n ====================== \n");
+          }
+        break;
+      }
+    case LAND_STATE:
+      {
+        if(landing_preparation_ && !preparing_landing_ && !landing_prepared_)
+          {
+            /* hover until the caller has prepared the landing */
+            preparing_landing_ = true;
+            teleop_ = false;
+            // reset the land height, since it is updated in the first land state
+            land_height_ = 0;
+            output.actions |= NavigationOutput::PREPARE_LANDING | NavigationOutput::HOLD_Z_TARGET;
+            transit(output, HOVER_STATE);
+            break;
+          }
+
+        output.actions |= NavigationOutput::UPDATE_LAND_COMMAND;
+
+        if(input.stamp - land_check_start_time_ > config_.land_check_duration)
+          {
+            double delta = input.z - land_height_;
+
+            char msg[128];
+            std::snprintf(msg, sizeof(msg), "expected land height: %f (current height: %f), velocity: %f ", land_height_, input.z, input.vz);
+            log(INFO, msg);
+
+            if(std::fabs(delta) < config_.land_pos_convergent_thresh &&
+               input.vz > -config_.land_vel_convergent_thresh)
+              {
+                log(INFO, "\n \n ======================  \n Land !!! \n ====================== \n");
+                log(INFO, "Start disarming motors");
+                transit(output, STOP_STATE);
+              }
+            else
+              {
+                // not staedy, update the land height
+                land_height_ = input.z;
+              }
+
+            land_check_start_time_ = input.stamp;
+          }
+        break;
+      }
+    case STOP_STATE:
+      {
+        output.actions |= NavigationOutput::RESET | NavigationOutput::SEND_ARM_OFF_CMD;
+        land_height_ = 0;
+        preparing_landing_ = false;
+        landing_prepared_ = false;
+
+        if(force_landing_)
+          {
+            output.actions |= NavigationOutput::HALT;
+            force_landing_ = false;
+          }
+        break;
+      }
+    default:
+      {
+        break;
+      }
+    }
+
+  return output;
+}
+
+uint8_t NavigationStateMachine::getPublishedState() const
+{
+  if(force_landing_) return FORCE_LANDING_STATE;
+  if(low_voltage_) return LOW_BATTERY_STATE;
+  return state_;
+}
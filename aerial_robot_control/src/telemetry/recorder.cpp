@@ -0,0 +1,325 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <aerial_robot_control/telemetry/recorder.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace aerial_robot_control
+{
+  namespace telemetry
+  {
+    namespace
+    {
+      std::atomic<uint64_t> recorder_count(0);
+
+      template<class T> void writeValue(FILE* file, const T& value)
+      {
+        fwrite(&value, sizeof(T), 1, file);
+      }
+
+      void writeString(FILE* file, const std::string& str)
+      {
+        writeValue<uint16_t>(file, str.size());
+        fwrite(str.data(), 1, str.size(), file);
+      }
+
+      template<class T> bool readValue(FILE* file, T& value)
+      {
+        return fread(&value, sizeof(T), 1, file) == 1;
+      }
+
+      uint64_t nowNsec()
+      {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      }
+    };
+
+    Recorder::Recorder(size_t buffer_size, double write_period):
+      id_(++recorder_count), buffer_size_(buffer_size), write_period_(write_period),
+      file_(nullptr), running_(false), written_(0)
+    {
+    }
+
+    Recorder::~Recorder()
+    {
+      close();
+    }
+
+    bool Recorder::open(const std::string& path)
+    {
+      close();
+
+      std::lock_guard<std::mutex> file_lock(file_mutex_);
+      file_ = fopen(path.c_str(), "wb");
+      if(!file_) return false;
+
+      fwrite(MAGIC, 1, sizeof(MAGIC), file_);
+      writeValue<uint16_t>(file_, VERSION);
+      writeValue<uint16_t>(file_, 0);
+
+      {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        for(const auto& channel: channels_) writeChannel(channel);
+      }
+
+      running_ = true;
+      writer_ = std::thread(&Recorder::writerFunc, this);
+      return true;
+    }
+
+    void Recorder::close()
+    {
+      if(!running_) return;
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+      }
+      wake_.notify_all();
+      writer_.join();
+
+      std::lock_guard<std::mutex> file_lock(file_mutex_);
+      drain();
+      fclose(file_);
+      file_ = nullptr;
+    }
+
+    int Recorder::addChannel(const std::string& name, const std::vector<std::string>& fields)
+    {
+      if(fields.size() > MAX_FIELDS) return -1;
+
+      std::lock_guard<std::mutex> file_lock(file_mutex_);
+      std::lock_guard<std::mutex> lock(channels_mutex_);
+      channels_.push_back(Channel{static_cast<uint16_t>(channels_.size()), name, fields});
+      // before any sample of this channel
+      if(file_) writeChannel(channels_.back());
+      return channels_.back().id;
+    }
+
+    bool Recorder::record(int channel, double stamp, const double* values, size_t size)
+    {
+      if(!running_ || channel < 0) return false;
+
+      const uint64_t start = nowNsec();
+      Producer* p = producer();
+      size = std::min(size, MAX_FIELDS);
+
+      bool result = p->buffer.push([&](Slot& slot)
+                                   {
+                                     slot.channel = channel;
+                                     slot.size = size;
+                                     slot.stamp = stamp;
+                                     std::copy(values, values + size, slot.values);
+                                   });
+      if(result) p->recorded.fetch_add(1, std::memory_order_relaxed);
+      else p->dropped.fetch_add(1, std::memory_order_relaxed);
+
+      const uint64_t duration = nowNsec() - start;
+      p->record_time_sum.fetch_add(duration, std::memory_order_relaxed);
+      if(duration > p->record_time_max.load(std::memory_order_relaxed))
+        p->record_time_max.store(duration, std::memory_order_relaxed); // only this thread writes
+      return result;
+    }
+
+    RecorderStats Recorder::getStats() const
+    {
+      RecorderStats stats;
+      uint64_t time_sum = 0, time_max = 0;
+      {
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        for(const auto& p: producers_)
+          {
+            stats.recorded += p->recorded.load(std::memory_order_relaxed);
+            stats.dropped += p->dropped.load(std::memory_order_relaxed);
+            time_sum += p->record_time_sum.load(std::memory_order_relaxed);
+            time_max = std::max(time_max, p->record_time_max.load(std::memory_order_relaxed));
+          }
+      }
+
+      stats.written = written_;
+      stats.max_record_time = time_max * 1e-9;
+      const uint64_t count = stats.recorded + stats.dropped;
+      if(count > 0) stats.mean_record_time = time_sum * 1e-9 / count;
+      return stats;
+    }
+
+    Recorder::Producer* Recorder::producer()
+    {
+      // one buffer per thread and recorder, created in the first call of the thread
+      thread_local std::vector<std::pair<uint64_t, Producer*> > producers;
+      for(const auto& p: producers)
+        if(p.first == id_) return p.second;
+
+      std::lock_guard<std::mutex> lock(producers_mutex_);
+      producers_.push_back(std::make_unique<Producer>(buffer_size_));
+      producers.emplace_back(id_, producers_.back().get());
+      return producers_.back().get();
+    }
+
+    void Recorder::writerFunc()
+    {
+      while(running_)
+        {
+          {
+            std::lock_guard<std::mutex> file_lock(file_mutex_);
+            drain();
+            fflush(file_);
+          }
+          std::unique_lock<std::mutex> lock(wake_mutex_);
+          wake_.wait_for(lock, std::chrono::duration<double>(write_period_), [this]() { return !running_; });
+        }
+    }
+
+    void Recorder::drain()
+    {
+      std::vector<Producer*> producers;
+      {
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        for(const auto& p: producers_) producers.push_back(p.get());
+      }
+
+      for(auto p: producers)
+        {
+          while(const Slot* slot = p->buffer.front())
+            {
+              writeValue<uint8_t>(file_, SAMPLE);
+              writeValue<uint16_t>(file_, slot->channel);
+              writeValue<uint16_t>(file_, slot->size);
+              writeValue<double>(file_, slot->stamp);
+              fwrite(slot->values, sizeof(double), slot->size, file_);
+              p->buffer.pop();
+              written_++;
+            }
+        }
+    }
+
+    void Recorder::writeChannel(const Channel& channel)
+    {
+      writeValue<uint8_t>(file_, CHANNEL);
+      writeValue<uint16_t>(file_, channel.id);
+      writeString(file_, channel.name);
+      writeValue<uint16_t>(file_, channel.fields.size());
+      for(const auto& field: channel.fields) writeString(file_, field);
+    }
+
+    bool Reader::open(const std::string& path)
+    {
+      close();
+      channels_.clear();
+
+      file_ = fopen(path.c_str(), "rb");
+      if(!file_)
+        {
+          error_ = "can not open " + path;
+          return false;
+        }
+
+      char magic[sizeof(MAGIC)];
+      uint16_t reserved;
+      if(fread(magic, 1, sizeof(magic), file_) != sizeof(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+         !readValue(file_, version_) || !readValue(file_, reserved))
+        {
+          error_ = path + " is not a telemetry log";
+          close();
+          return false;
+        }
+
+      if(version_ > VERSION)
+        {
+          error_ = "version " + std::to_string(version_) + " of " + path + " is newer than the reader (" + std::to_string(VERSION) + ")";
+          close();
+          return false;
+        }
+
+      return true;
+    }
+
+    void Reader::close()
+    {
+      if(file_) fclose(file_);
+      file_ = nullptr;
+    }
+
+    bool Reader::next(Sample& sample)
+    {
+      if(!file_) return false;
+
+      uint8_t type;
+      while(readValue(file_, type))
+        {
+          if(type == CHANNEL)
+            {
+              Channel channel;
+              uint16_t field_num;
+              if(!readValue(file_, channel.id) || !readString(channel.name) || !readValue(file_, field_num)) break;
+              channel.fields.resize(field_num);
+              bool valid = true;
+              for(auto& field: channel.fields) valid &= readString(field);
+              if(!valid) break;
+
+              if(channels_.size() <= channel.id) channels_.resize(channel.id + 1);
+              channels_.at(channel.id) = channel;
+            }
+          else if(type == SAMPLE)
+            {
+              uint16_t size;
+              if(!readValue(file_, sample.channel) || !readValue(file_, size) || !readValue(file_, sample.stamp)) break;
+              sample.values.resize(size);
+              if(fread(sample.values.data(), sizeof(double), size, file_) != size) break;
+              return true;
+            }
+          else
+            {
+              error_ = "unknown record type " + std::to_string(type);
+              return false;
+            }
+        }
+
+      // the end of the file, or a record truncated by a crash of the recorder
+      if(!feof(file_)) error_ = "read error";
+      return false;
+    }
+
+    bool Reader::readString(std::string& str)
+    {
+      uint16_t size;
+      if(!readValue(file_, size)) return false;
+      str.resize(size);
+      return fread(&str[0], 1, size, file_) == size;
+    }
+  };
+};
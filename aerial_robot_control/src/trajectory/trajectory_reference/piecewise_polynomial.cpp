@@ -0,0 +1,393 @@
+#include "aerial_robot_control/trajectory/trajectory_reference/piecewise_polynomial.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace agi {
+
+/* Highest derivative with a positive cost weight,
+/  the weights start from the velocity.
+*/
+int costDerivative(const Vector<>& weights) {
+  int r = 1;
+  for (int i = 0; i < weights.size(); ++i)
+    if (weights(i) > 0.0) r = i + 1;
+  return r;
+}
+
+PiecewisePolynomial::PiecewisePolynomial(const int order,
+                                         const Vector<>& weights,
+                                         const int continuity)
+  : r_(costDerivative(weights)),
+    order_(2 * costDerivative(weights) - 1),
+    continuity_(continuity),
+    alpha_(createAlpha(2 * costDerivative(weights) - 1)),
+    weights_(weights) {
+  if (order < order_)
+    std::cout << "Piecewise polynomial order is raised from " << order
+              << " to " << order_ << "!" << std::endl;
+
+  const int n = size();
+
+  // Map from the coefficients to the knot derivatives in segment time:
+  // [ d_start(0..r-1) ; d_end(0..r-1) ]
+  Matrix<> M = Matrix<>::Zero(n, n);
+  for (int k = 0; k < r_; ++k) {
+    M(k, k) = alpha_(k, k);
+    M.row(r_ + k) = alpha_.col(k).matrix().transpose();
+  }
+  M_inv_ = M.fullPivLu().inverse();
+
+  // Cost of the m-th derivative over one unit segment in terms of the
+  // scaled knot derivatives.
+  K_.resize(r_);
+  for (int m = 1; m <= r_; ++m) {
+    if (weights_(m - 1) <= 0.0) continue;
+
+    Matrix<> H = Matrix<>::Zero(n, n);
+    for (int a = m; a < n; ++a)
+      for (int b = m; b < n; ++b)
+        H(a, b) = alpha_(a, m) * alpha_(b, m) / (a + b - 2 * m + 1);
+
+    K_[m - 1] = weights_(m - 1) * M_inv_.transpose() * H * M_inv_;
+  }
+}
+
+bool PiecewisePolynomial::scale(const Scalar start_time,
+                                const Scalar duration) {
+  bool success = false;
+  if (std::isfinite(start_time)) {
+    t_offset_ = start_time;
+    success = true;
+  }
+
+  if (std::isfinite(duration)) {
+    if (duration > 0.0) {
+      t_scale_ = 1.0 / duration;
+    } else {
+      success = false;
+    }
+  }
+
+  return success;
+}
+
+int PiecewisePolynomial::addConstraint(const Scalar time,
+                                       const Vector<>& constraint) {
+  if (!std::isfinite(time)) return 0;
+
+  const int n_c = std::min((int)constraint.size(),
+                           continuity_ >= 0 ? continuity_ + 1 : r_);
+  Vector<> value = Vector<>::Constant(r_, NAN);
+  value.head(std::min(n_c, r_)) = constraint.head(std::min(n_c, r_));
+
+  const int n = value.array().isFinite().cast<int>().sum();
+  if (n < 1) return 0;
+
+  // Merge with the knot at the same time.
+  for (Knot& knot : knots_) {
+    if (std::abs(knot.t - time) < 1e-9) {
+      for (int i = 0; i < r_; ++i)
+        if (std::isfinite(value(i))) knot.value(i) = value(i);
+      return n;
+    }
+  }
+
+  knots_.push_back({time, value});
+  return n;
+}
+
+bool PiecewisePolynomial::solve() {
+  coeffs_.clear();
+  if (knots_.size() < 2) return false;  // Cant solve without constraints.
+
+  std::stable_sort(
+    knots_.begin(), knots_.end(),
+    [](const Knot& lhs, const Knot& rhs) -> bool { return lhs.t < rhs.t; });
+
+  const int N = knots_.size() - 1;
+  const int r = r_;
+
+  knots_tau_.resize(N + 1);
+  durations_.resize(N);
+  for (int k = 0; k <= N; ++k) knots_tau_[k] = tauFromTime(knots_[k].t);
+  for (int i = 0; i < N; ++i) {
+    durations_[i] = knots_[i + 1].t - knots_[i].t;
+    if (durations_[i] <= 0.0) return false;
+  }
+
+  // Fixed derivatives and the mask of the free ones per knot.
+  Matrix<> X = Matrix<>::Zero(r, N + 1);
+  Matrix<> free_mask = Matrix<>::Zero(r, N + 1);
+  for (int k = 0; k <= N; ++k) {
+    const Vector<>& value = knots_[k].value;
+    for (int i = 0; i < r; ++i) {
+      if (std::isfinite(value(i)))
+        X(i, k) = value(i);
+      else
+        free_mask(i, k) = 1.0;
+    }
+  }
+
+  // The factorization depends only on the durations and the free mask, the
+  // axes of one trajectory share it.
+  Factorization local;
+  Factorization& F = factorization_ ? *factorization_ : local;
+  if (F.durations != durations_ || F.free_mask.rows() != r ||
+      F.free_mask.cols() != N + 1 || F.free_mask != free_mask) {
+    if (!factorize(free_mask, &F)) {
+      F.durations.clear();
+      return false;
+    }
+  }
+
+  // Block-tridiagonal forward elimination of the right hand side.
+  std::vector<Vector<>> rhs(N + 1);
+  for (int k = 0; k <= N; ++k) {
+    Vector<> g = F.A[k] * X.col(k);
+    if (k > 0) g += F.Q[k - 1].bottomLeftCorner(r, r) * X.col(k - 1);
+    if (k < N) g += F.Q[k].topRightCorner(r, r) * X.col(k + 1);
+
+    rhs[k] = -F.P[k].transpose() * g;
+    if (k > 0 && F.Y[k - 1].size() > 0)
+      rhs[k] -= F.Y[k - 1].transpose() * rhs[k - 1];
+  }
+
+  const std::vector<Matrix<>>& P = F.P;
+  const std::vector<Matrix<>>& U = F.U;
+  const std::vector<Eigen::LDLT<Matrix<>>>& D = F.D;
+
+  // Back substitution.
+  d_ = X;
+  Vector<> f_next;
+  for (int k = N; k >= 0; --k) {
+    Vector<> f = rhs[k];
+    if (k < N && U[k].rows() > 0 && U[k].cols() > 0) f -= U[k] * f_next;
+    if (f.size() > 0) {
+      f = D[k].solve(f);
+      d_.col(k) += P[k] * f;
+    }
+    f_next = f;
+  }
+  if (!d_.allFinite()) return false;
+
+  // Coefficients of each derivative in segment time.
+  const int n = size();
+  coeffs_.resize(N);
+  for (int i = 0; i < N; ++i) {
+    const ArrayVector<> t_vec = ArrayVector<>::Constant(r, durations_[i])
+                                  .pow(ArrayVector<>::LinSpaced(r, 0, r - 1));
+    Vector<> e(n);
+    e << t_vec * d_.col(i).array(), t_vec * d_.col(i + 1).array();
+    const Vector<> c = M_inv_ * e;
+
+    Matrix<>& dc = coeffs_[i];
+    dc.setZero(n, n);
+    for (int k = 0; k < n; ++k)
+      dc.col(k).head(n - k) =
+        c.tail(n - k).cwiseProduct(alpha_.col(k).tail(n - k).matrix());
+  }
+
+  return true;
+}
+
+bool PiecewisePolynomial::factorize(const Matrix<>& free_mask,
+                                    Factorization* F) const {
+  const int N = durations_.size();
+  const int r = r_;
+
+  F->durations = durations_;
+  F->free_mask = free_mask;
+
+  F->P.resize(N + 1);
+  for (int k = 0; k <= N; ++k) {
+    const int n_free = free_mask.col(k).sum();
+    F->P[k] = Matrix<>::Zero(r, n_free);
+    for (int i = 0, j = 0; i < r; ++i)
+      if (free_mask(i, k) > 0.0) F->P[k](i, j++) = 1.0;
+  }
+
+  // Segment cost Hessians in terms of the knot derivatives, with the powers
+  // of the duration from a table instead of std::pow per element.
+  F->Q.assign(N, Matrix<>::Zero(2 * r, 2 * r));
+  std::vector<Scalar> T_pow(2 * r);
+  for (int i = 0; i < N; ++i) {
+    T_pow[0] = 1.0;
+    for (int p = 1; p < 2 * r; ++p) T_pow[p] = T_pow[p - 1] * durations_[i];
+    for (int m = 1; m <= r; ++m) {
+      if (K_[m - 1].size() == 0) continue;
+      const Scalar T_inv = 1.0 / T_pow[2 * m - 1];
+      for (int a = 0; a < 2 * r; ++a)
+        for (int b = 0; b < 2 * r; ++b)
+          F->Q[i](a, b) += K_[m - 1](a, b) * T_pow[a % r + b % r] * T_inv;
+    }
+  }
+
+  F->A.resize(N + 1);
+  F->D.resize(N + 1);
+  F->U.resize(N);
+  F->Y.resize(N);
+  for (int k = 0; k <= N; ++k) {
+    Matrix<>& A = F->A[k];
+    A = Matrix<>::Zero(r, r);
+    if (k > 0) A += F->Q[k - 1].bottomRightCorner(r, r);
+    if (k < N) {
+      A += F->Q[k].topLeftCorner(r, r);
+      F->U[k] = F->P[k].transpose() * F->Q[k].topRightCorner(r, r) * F->P[k + 1];
+    }
+
+    Matrix<> Dk = F->P[k].transpose() * A * F->P[k];
+    if (k > 0) {
+      if (F->U[k - 1].rows() > 0 && F->U[k - 1].cols() > 0) {
+        F->Y[k - 1] = F->D[k - 1].solve(F->U[k - 1]);
+        Dk -= F->U[k - 1].transpose() * F->Y[k - 1];
+      } else {
+        F->Y[k - 1].resize(0, 0);
+      }
+    }
+
+    if (Dk.rows() > 0) {
+      F->D[k].compute(Dk);
+      if (F->D[k].info() != Eigen::Success) return false;
+    }
+  }
+
+  return true;
+}
+
+bool PiecewisePolynomial::solved() const { return !coeffs_.empty(); }
+
+Scalar PiecewisePolynomial::tauFromTime(const Scalar t) const {
+  return t_scale_ * (t - t_offset_);
+}
+
+int PiecewisePolynomial::findSegment(const Scalar time) const {
+  const int N = segments();
+  if (N < 1) return -1;
+
+  const Scalar tau = tauFromTime(time);
+
+  // Queries are mostly monotonic, check the last and the next segment first.
+  int i = std::min(std::max(segment_hint_, 0), N - 1);
+  for (int step = 0; step < 2 && i < N; ++step, ++i) {
+    if ((i == 0 || tau >= knots_tau_[i]) &&
+        (i == N - 1 || tau < knots_tau_[i + 1])) {
+      segment_hint_ = i;
+      return i;
+    }
+  }
+
+  i = std::upper_bound(knots_tau_.begin() + 1, knots_tau_.end() - 1, tau) -
+      knots_tau_.begin() - 1;
+  segment_hint_ = i;
+  return i;
+}
+
+bool PiecewisePolynomial::eval(const Scalar time, Ref<Vector<>> state) const {
+  const int i = findSegment(time);
+  if (i < 0) return false;
+
+  const int n = state.rows();
+  const int N = size();
+  const Scalar h = knots_tau_[i + 1] - knots_tau_[i];
+  const Scalar sigma = (tauFromTime(time) - knots_tau_[i]) / h;
+  const Scalar segment_scale = t_scale_ / h;
+
+  Scalar time_scale = 1.0;
+  for (int k = 0; k < n; ++k) {
+    state(k) =
+      k < N ? time_scale * horner(coeffs_[i].col(k).data(), N, sigma) : 0.0;
+    time_scale *= segment_scale;
+  }
+
+  return true;
+}
+
+bool PiecewisePolynomial::eval(ConstRef<ArrayVector<>> times,
+                               Ref<Matrix<>> states) const {
+  if (states.cols() != times.size()) return false;
+
+  for (int j = 0; j < times.size(); ++j)
+    if (!eval(times(j), states.col(j))) return false;
+
+  return true;
+}
+
+Scalar PiecewisePolynomial::operator()(const Scalar time,
+                                       const int order) const {
+  const int i = findSegment(time);
+  if (i < 0) return NAN;
+  if (order >= size()) return 0.0;
+
+  const Scalar h = knots_tau_[i + 1] - knots_tau_[i];
+  const Scalar sigma = (tauFromTime(time) - knots_tau_[i]) / h;
+  return std::pow(t_scale_ / h, order) *
+         horner(coeffs_[i].col(order).data(), size(), sigma);
+}
+
+std::vector<Scalar> PiecewisePolynomial::segmentDurations() const {
+  std::vector<Scalar> durations(segments());
+  for (int i = 0; i < segments(); ++i)
+    durations[i] = (knots_tau_[i + 1] - knots_tau_[i]) / t_scale_;
+  return durations;
+}
+
+void PiecewisePolynomial::segmentCost(const int segment, Scalar* cost,
+                                      Scalar* gradient) const {
+  const int r = r_;
+  const Scalar T = durations_[segment];
+  Vector<> d(2 * r);
+  d << d_.col(segment), d_.col(segment + 1);
+
+  std::vector<Scalar> T_pow(2 * r);
+  T_pow[0] = 1.0;
+  for (int p = 1; p < 2 * r; ++p) T_pow[p] = T_pow[p - 1] * T;
+
+  *cost = 0.0;
+  *gradient = 0.0;
+  for (int m = 1; m <= r; ++m) {
+    if (K_[m - 1].size() == 0) continue;
+    const Scalar T_inv = 1.0 / T_pow[2 * m - 1];
+    for (int a = 0; a < 2 * r; ++a) {
+      for (int b = 0; b < 2 * r; ++b) {
+        const int p = 1 - 2 * m + a % r + b % r;
+        const Scalar x =
+          K_[m - 1](a, b) * d(a) * d(b) * T_pow[a % r + b % r] * T_inv;
+        *cost += x;
+        *gradient += x * p / T;
+      }
+    }
+  }
+}
+
+Scalar PiecewisePolynomial::cost() const {
+  Scalar total = 0.0;
+  for (int i = 0; i < segments(); ++i) {
+    Scalar cost, gradient;
+    segmentCost(i, &cost, &gradient);
+    total += cost;
+  }
+  return total;
+}
+
+Vector<> PiecewisePolynomial::costGradient() const {
+  // The free knot derivatives are optimal, so only the explicit dependency
+  // of each segment cost on its duration remains.
+  Vector<> gradient(segments());
+  for (int i = 0; i < segments(); ++i) {
+    Scalar cost;
+    segmentCost(i, &cost, &gradient(i));
+  }
+  return gradient;
+}
+
+void PiecewisePolynomial::reset() {
+  knots_.clear();
+  knots_tau_.clear();
+  durations_.clear();
+  coeffs_.clear();
+  d_.resize(0, 0);
+  segment_hint_ = 0;
+}
+
+}  // namespace agi
@@ -46,6 +46,7 @@ Polynomial<Solver>::Polynomial()
   : order_(11),
     continuity_(-1),
     c_(Vector<>::Constant(12, NAN)),
+    dc_(Matrix<>::Constant(12, 12, NAN)),
     exponents_(createExponents(11)),
     alpha_(createAlpha(11)),
     weights_(Vector<4>(0, 0, 0, 1)) {}
@@ -56,6 +57,7 @@ Polynomial<Solver>::Polynomial(const int order, const Vector<>& weights,
   : order_(order),
     continuity_(continuity),
     c_(Vector<>::Constant(order + 1, NAN)),
+    dc_(Matrix<>::Constant(order + 1, order + 1, NAN)),
     exponents_(createExponents(order)),
     alpha_(createAlpha(order)),
     weights_(weights) {}
@@ -65,6 +67,7 @@ Polynomial<void>::Polynomial()
   : order_(5),
     continuity_(3),
     c_(Vector<>::Constant(6, NAN)),
+    dc_(Matrix<>::Constant(6, 6, NAN)),
     exponents_(createExponents(5)),
     alpha_(createAlpha(5)),
     weights_(Vector<3>(0, 0, 1)),
@@ -244,6 +247,7 @@ bool Polynomial<Solver>::solve(const Matrix<>& H, const Matrix<>& A,
   Solver solver(S);
   const Vector<> x = solver.solve(s);
   c_ = x.head(n);
+  updateDerivativeCoeffs();
 
   return true;
 }
@@ -271,17 +275,60 @@ bool Polynomial<void>::solve() {
   const Matrix<3, 3> alpha_012 = alpha_.topLeftCorner(3, 3).transpose();
   const Vector<3> b_delta = c_.tail<3>() - alpha_012 * c_.head<3>();
   c_.tail<3>() = A_inv * b_delta;
+  updateDerivativeCoeffs();
 
   return true;
 }
 
 
+template<typename Solver>
+void Polynomial<Solver>::updateDerivativeCoeffs() {
+  // k-th derivative: sum_j c(j + k) * alpha(j + k, k) * tau^j
+  const int N = size();
+  dc_.setZero(N, N);
+  for (int k = 0; k < N; ++k)
+    dc_.col(k).head(N - k) =
+      c_.tail(N - k).cwiseProduct(alpha_.col(k).tail(N - k).matrix());
+}
+
 template<typename Solver>
 bool Polynomial<Solver>::eval(const Scalar time, Ref<Vector<>> state) const {
   const int n = state.rows();
-  const Vector<> time_scales = ArrayVector<>::Constant(n, t_scale_)
-                                 .pow(ArrayVector<>::LinSpaced(n, 0, n - 1));
-  state = time_scales.asDiagonal() * polyMatrixFromTime(time, n) * c_;
+  const int N = size();
+  const Scalar tau = tauFromTime(time);
+
+  Scalar time_scale = 1.0;
+  for (int k = 0; k < n; ++k) {
+    state(k) = k < N ? time_scale * horner(dc_.col(k).data(), N, tau) : 0.0;
+    time_scale *= t_scale_;
+  }
+
+  return true;
+}
+
+template<typename Solver>
+bool Polynomial<Solver>::eval(ConstRef<ArrayVector<>> times,
+                              Ref<Matrix<>> states) const {
+  if (states.cols() != times.size()) return false;
+
+  const int n = states.rows();
+  const int N = size();
+  const ArrayVector<> tau = t_scale_ * (times - t_offset_);
+
+  // Horner scheme over all time points at once, vectorized by Eigen.
+  ArrayVector<> r(times.size());
+  Scalar time_scale = 1.0;
+  for (int k = 0; k < n; ++k) {
+    if (k >= N) {
+      states.row(k).setZero();
+      continue;
+    }
+
+    r.setConstant(dc_(N - 1, k));
+    for (int i = N - 2; i >= 0; --i) r = r * tau + dc_(i, k);
+    states.row(k) = time_scale * r.matrix().transpose();
+    time_scale *= t_scale_;
+  }
 
   return true;
 }
@@ -289,8 +336,9 @@ bool Polynomial<Solver>::eval(const Scalar time, Ref<Vector<>> state) const {
 template<typename Solver>
 Scalar Polynomial<Solver>::operator()(const Scalar time,
                                       const int order) const {
-  return std::pow(t_scale_, order) * c_.transpose() *
-         (tauVectorFromTime(time, order).array() * alpha_.col(order)).matrix();
+  if (order >= size()) return 0.0;
+  return std::pow(t_scale_, order) *
+         horner(dc_.col(order).data(), size(), tauFromTime(time));
 }
 
 template class Polynomial<Eigen::HouseholderQR<Matrix<>>>;
@@ -1,5 +1,7 @@
 #include "aerial_robot_control/trajectory/trajectory_reference/polynomial_trajectory.hpp"
 
+#include <numeric>
+
 #include "aerial_robot_control/trajectory/math/gravity.hpp"
 
 
@@ -118,7 +120,7 @@ bool PolynomialTrajectory<PolyType>::addStateConstraint(const QuadState& state,
   // ToDo: Yaw relative to initial yaw.
   const Scalar yaw_angle = state.getYaw();
   if (std::isfinite(yaw_angle))
-    yaw_.addConstraint(state.t, Vector<3>(yaw_angle, state.w.z(), 0));
+    yaw_.addConstraint(state.t, Vector<3>(yaw_angle, state.w.z(), state.tau.z()));
 
   return true;
 }
@@ -145,12 +147,13 @@ QuadState PolynomialTrajectory<PolyType>::getState(const Scalar time) const {
 
   const Scalar t = std::clamp(time, start_state_.t, end_state_.t);
 
-  Matrix<> x = Matrix<>::Zero(5, 3);
-  Vector<> yaw = Vector<>::Zero(3);
+  Matrix<5, 3> x = Matrix<5, 3>::Zero();
+  Vector<3> yaw = Vector<3>::Zero();
 
   x_.eval(t, x.col(0));
   y_.eval(t, x.col(1));
   z_.eval(t, x.col(2));
+  if (!forward_heading_) yaw_.eval(t, yaw);
 
   state.setZero();
   state.t = t;
@@ -160,6 +163,50 @@ QuadState PolynomialTrajectory<PolyType>::getState(const Scalar time) const {
   state.j = x.row(3).transpose();
   state.s = x.row(4).transpose();
 
+  fillAttitude(state, yaw);
+  return state;
+}
+
+template<class PolyType>
+bool PolynomialTrajectory<PolyType>::getStates(
+  const std::vector<Scalar>& times, std::vector<QuadState>& states) const {
+  states.clear();
+  if (!valid()) return false;
+
+  const int n = times.size();
+  ArrayVector<> t(n);
+  for (int i = 0; i < n; ++i)
+    t(i) = std::clamp(times[i], start_state_.t, end_state_.t);
+
+  Matrix<> x(5, n), y(5, n), z(5, n);
+  Matrix<> yaw = Matrix<>::Zero(3, n);
+  x_.eval(t, x);
+  y_.eval(t, y);
+  z_.eval(t, z);
+  if (!forward_heading_) yaw_.eval(t, yaw);
+
+  // attitude depends on the previous sample, so fill in time order
+  states.resize(n);
+  for (int i = 0; i < n; ++i) {
+    QuadState& state = states[i];
+    state.setZero();
+    state.t = t(i);
+    state.p = Vector<3>(x(0, i), y(0, i), z(0, i));
+    state.v = Vector<3>(x(1, i), y(1, i), z(1, i));
+    state.a = Vector<3>(x(2, i), y(2, i), z(2, i));
+    state.j = Vector<3>(x(3, i), y(3, i), z(3, i));
+    state.s = Vector<3>(x(4, i), y(4, i), z(4, i));
+    fillAttitude(state, yaw.col(i));
+  }
+
+  return true;
+}
+
+template<class PolyType>
+void PolynomialTrajectory<PolyType>::fillAttitude(QuadState& state,
+                                                  const Vector<3>& yaw_in) const {
+  Vector<3> yaw = yaw_in;
+
   const Vector<3> thrust_vec = state.a - GVEC;
   const Scalar thrust = thrust_vec.norm();
   const Quaternion q_pitch_roll =
@@ -168,14 +215,13 @@ QuadState PolynomialTrajectory<PolyType>::getState(const Scalar time) const {
   q_pitch_roll_last_ = q_pitch_roll;
 
   if (forward_heading_) {
+    yaw.setZero();
     const Vector<3> v_body = q_pitch_roll.inverse() * state.v;
     if ((v_body.x() * v_body.x() + v_body.y() * v_body.y()) < 1e-6) {
       yaw(0) = std::atan2(v_body.y(), v_body.x());
     } else {
       yaw(0) = yaw_last_;
     }
-  } else {
-    yaw_.eval(t, yaw);
   }
 
   yaw_last_ = yaw(0);
@@ -192,7 +238,6 @@ QuadState PolynomialTrajectory<PolyType>::getState(const Scalar time) const {
 
   // compute angular acceleration
   state.tau = Vector<3>(0, 0, yaw(2));
-  return state;
 }
 
 template<class PolyType>
@@ -344,5 +389,162 @@ Scalar PolynomialTrajectory<PolyType>::findTime(
 
 template class PolynomialTrajectory<Polynomial<>>;
 template class PolynomialTrajectory<ClosedFormMinJerkAxis>;
+template class PolynomialTrajectory<PiecewisePolynomial>;
+
+TrajectoryLimits::TrajectoryLimits(const Quadrotor& quad, const Scalar v_max)
+  : v_max(v_max),
+    thrust_min(quad.collective_thrust_min()),
+    thrust_max(quad.collective_thrust_max()) {}
+
+std::vector<Scalar> PiecewiseMinSnapTrajectory::segmentDurations() const {
+  return x_.segmentDurations();
+}
+
+void PiecewiseMinSnapTrajectory::shareFactorization() {
+  const std::shared_ptr<PiecewisePolynomial::Factorization> factorization =
+    std::make_shared<PiecewisePolynomial::Factorization>();
+  x_.shareFactorization(factorization);
+  y_.shareFactorization(factorization);
+  z_.shareFactorization(factorization);
+}
+
+bool PiecewiseMinSnapTrajectory::setSegmentDurations(
+  const std::vector<Scalar>& durations) {
+  return solveSegmentDurations(durations, true);
+}
+
+bool PiecewiseMinSnapTrajectory::solveSegmentDurations(
+  const std::vector<Scalar>& durations, const bool solve_yaw) {
+  if (durations.size() + 1 != states_.size()) return false;
+  for (const Scalar duration : durations)
+    if (!std::isfinite(duration) || duration <= 0.0) return false;
+
+  for (size_t i = 0; i < durations.size(); i++)
+    states_.at(i + 1).t = states_.at(i).t + durations.at(i);
+
+  x_.reset();
+  y_.reset();
+  z_.reset();
+  yaw_.reset();
+  scale(states_.front().t, states_.back().t - states_.front().t);
+
+  addStateConstraint(states_.front());
+  addStateConstraint(states_.back());
+  for (size_t i = 1; i < states_.size() - 1; i++)
+    addStateConstraint(states_.at(i), 0);
+
+  if (!x_.solve() || !y_.solve() || !z_.solve()) return false;
+  if (!solve_yaw) return true;
+  if (!yaw_.solve()) return false;
+
+  start_state_ = getState(states_.front().t);
+  end_state_ = getState(states_.back().t);
+  return true;
+}
+
+Scalar PiecewiseMinSnapTrajectory::cost() const {
+  return x_.cost() + y_.cost() + z_.cost();
+}
+
+Scalar PiecewiseMinSnapTrajectory::limitRatio(const TrajectoryLimits& limits,
+                                              const int samples_per_segment) const {
+  if (!valid()) return NAN;
+
+  // Bound the acceleration such that any direction stays within the thrust
+  // limits, this is conservative but independent of the direction.
+  const Scalar a_max = std::min(
+    {limits.a_max, limits.thrust_max - G, G - limits.thrust_min});
+  if (a_max <= 0.0) return NAN;
+
+  const std::vector<Scalar> durations = segmentDurations();
+  const int n = durations.size() * samples_per_segment + 1;
+  ArrayVector<> times(n);
+  int idx = 0;
+  Scalar t_segment = getStartTime();
+  for (const Scalar duration : durations) {
+    for (int j = 0; j < samples_per_segment; ++j)
+      times(idx++) = t_segment + duration * j / samples_per_segment;
+    t_segment += duration;
+  }
+  times(idx) = getEndTime();
+
+  Matrix<> x(4, n), y(4, n), z(4, n);
+  x_.eval(times, x);
+  y_.eval(times, y);
+  z_.eval(times, z);
+
+  Scalar ratio = 0.0;
+  for (int i = 0; i < n; ++i) {
+    const Scalar v = Vector<3>(x(1, i), y(1, i), z(1, i)).norm();
+    const Scalar a = Vector<3>(x(2, i), y(2, i), z(2, i)).norm();
+    const Scalar j = Vector<3>(x(3, i), y(3, i), z(3, i)).norm();
+    ratio = std::max({ratio, v / limits.v_max, std::sqrt(a / a_max),
+                      std::cbrt(j / limits.j_max)});
+  }
+
+  return ratio;
+}
+
+Scalar PiecewiseMinSnapTrajectory::optimizeSegmentDurations(
+  const TrajectoryLimits& limits, const int iterations,
+  const Scalar tolerance) {
+  if (!valid()) return duration_;
+
+  std::vector<Scalar> durations = segmentDurations();
+  const int N = durations.size();
+  const Scalar total = std::accumulate(durations.begin(), durations.end(), 0.0);
+  const Scalar duration_min = 1e-2 * total / N;
+
+  // Relative time allocation with fixed total duration.
+  Scalar J = cost();
+  Scalar step = 0.1 * total / N;
+  for (int k = 0; N > 1 && k < iterations; ++k) {
+    const Vector<> gradient =
+      x_.costGradient() + y_.costGradient() + z_.costGradient();
+    const Vector<> projected =
+      gradient.array() - gradient.mean();
+    const Scalar g_max = projected.cwiseAbs().maxCoeff();
+    if (g_max * total < tolerance * J) break;
+
+    const Vector<> direction = -projected / g_max;
+    const Scalar slope = gradient.dot(direction);
+
+    bool accepted = false;
+    for (; step > 1e-6 * total; step *= 0.5) {
+      std::vector<Scalar> trial = durations;
+      bool feasible = true;
+      for (int i = 0; i < N; ++i) {
+        trial[i] += step * direction(i);
+        feasible &= trial[i] >= duration_min;
+      }
+      // The cost does not depend on yaw, it is solved once at the end.
+      if (!feasible || !solveSegmentDurations(trial, false)) continue;
+
+      const Scalar J_trial = cost();
+      if (J_trial <= J + 1e-4 * step * slope) {
+        durations = trial;
+        J = J_trial;
+        accepted = true;
+        break;
+      }
+    }
+
+    if (!accepted) break;
+    step = std::min(2.0 * step, 0.5 * total / N);
+  }
+  setSegmentDurations(durations);
+
+  // Stretch or shrink all segments until a limit is active.
+  for (int k = 0; k < iterations; ++k) {
+    const Scalar ratio = limitRatio(limits);
+    if (!std::isfinite(ratio) || ratio <= 0.0) break;
+    if (std::abs(ratio - 1.0) < tolerance) break;
+
+    for (Scalar& duration : durations) duration *= ratio;
+    if (!setSegmentDurations(durations)) break;
+  }
+
+  return duration_;
+}
 
 }  // namespace agi
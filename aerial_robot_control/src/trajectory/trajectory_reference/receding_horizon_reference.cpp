@@ -0,0 +1,223 @@
+#include "aerial_robot_control/trajectory/trajectory_reference/receding_horizon_reference.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace agi {
+
+namespace {
+constexpr Scalar kMinSegmentDuration = 0.05;
+constexpr int kLimitIterations = 10;
+
+QuadState createWaypoint(const QuadState& state) {
+  QuadState waypoint;
+  waypoint.setZero();
+  waypoint.t = NAN;  // Timed by the solution.
+  waypoint.p = state.p;
+  waypoint.setYaw(state.getYaw(0.0));
+  return waypoint;
+}
+
+bool sameWaypoint(const QuadState& lhs, const QuadState& rhs) {
+  return (lhs.p - rhs.p).norm() < 1e-6 &&
+         std::abs(std::remainder(lhs.getYaw(0.0) - rhs.getYaw(0.0), 2 * M_PI)) <
+           1e-6;
+}
+}  // namespace
+
+RecedingHorizonReference::RecedingHorizonReference(
+  const RecedingHorizonParams& params)
+  : params_(params) {
+  hold_state_.setZero();
+}
+
+void RecedingHorizonReference::reset(const QuadState& state) {
+  trajectory_.reset();
+  previous_.reset();
+  pending_ = false;
+  ++revision_;
+  hold_state_ = state;
+  waypoints_.clear();
+  changed_ = false;
+  last_replan_time_ = -INF;
+}
+
+void RecedingHorizonReference::setGoal(const QuadState& goal) {
+  setWaypoints({goal});
+}
+
+void RecedingHorizonReference::setWaypoints(
+  const std::vector<QuadState>& waypoints) {
+  // Streaming the same waypoints again does not need a new solution.
+  if (waypoints.size() == waypoints_.size() &&
+      std::equal(waypoints.begin(), waypoints.end(), waypoints_.begin(),
+                 sameWaypoint))
+    return;
+
+  waypoints_.clear();
+  for (const QuadState& waypoint : waypoints)
+    waypoints_.push_back(createWaypoint(waypoint));
+  changed_ = true;
+  ++revision_;
+}
+
+void RecedingHorizonReference::addWaypoint(const QuadState& waypoint) {
+  waypoints_.push_back(createWaypoint(waypoint));
+  changed_ = true;
+  ++revision_;
+}
+
+bool RecedingHorizonReference::update(const Scalar t) {
+  Problem problem;
+  if (!prepare(t, problem)) return false;
+  return apply(solve(problem));
+}
+
+bool RecedingHorizonReference::prepare(const Scalar t, Problem& problem) {
+  if (!changed_ || t - last_replan_time_ < params_.replan_period) return false;
+
+  last_replan_time_ = t;
+  changed_ = false;
+
+  // Drop the waypoints already passed by the current trajectory.
+  waypoints_.erase(std::remove_if(waypoints_.begin(), waypoints_.end(),
+                                  [t](const QuadState& waypoint) {
+                                    return std::isfinite(waypoint.t) &&
+                                           waypoint.t <= t;
+                                  }),
+                   waypoints_.end());
+  if (waypoints_.empty()) return false;
+
+  // Start from the current reference to keep it continuous.
+  const Scalar start_time = t + std::max(params_.solve_delay, 0.0);
+  problem.start = getState(start_time);
+  problem.start.t = start_time;
+  problem.waypoints = waypoints_;
+  problem.params = params_;
+  problem.revision = revision_;
+  pending_ = true;
+  return true;
+}
+
+RecedingHorizonReference::Solution RecedingHorizonReference::solve(
+  const Problem& problem) {
+  const RecedingHorizonParams& params = problem.params;
+  Solution solution;
+  solution.revision = problem.revision;
+
+  std::vector<QuadState> states{problem.start};
+  std::vector<Scalar> durations;
+  for (const QuadState& waypoint : problem.waypoints) {
+    const QuadState& last = states.back();
+    Scalar duration = (waypoint.p - last.p).norm() / params.mean_vel;
+    if (std::isfinite(params.mean_yaw_rate)) {
+      const Scalar yaw_diff =
+        std::remainder(waypoint.getYaw(0.0) - last.getYaw(0.0), 2 * M_PI);
+      duration = std::max(duration, std::abs(yaw_diff) / params.mean_yaw_rate);
+    }
+    durations.push_back(std::max(duration, kMinSegmentDuration));
+    states.push_back(waypoint);
+  }
+
+  const Scalar total = std::accumulate(durations.begin(), durations.end(), 0.0);
+  const Scalar stretch = std::max(params.min_duration / total, 1.0);
+  for (size_t i = 0; i < durations.size(); ++i)
+    states[i + 1].t = states[i].t + stretch * durations[i];
+
+  std::shared_ptr<PiecewiseMinSnapTrajectory> trajectory =
+    std::make_shared<PiecewiseMinSnapTrajectory>(states);
+  if (!trajectory->valid()) return solution;
+
+  if (durations.size() > 1 && params.allocation_iterations > 0)
+    trajectory->optimizeSegmentDurations(TrajectoryLimits(),
+                                         params.allocation_iterations);
+
+  // Only stretch, the nominal velocities are not exceeded for the limits.
+  for (int k = 0; k < kLimitIterations; ++k) {
+    const Scalar ratio = trajectory->limitRatio(params.limits);
+    if (!std::isfinite(ratio) || ratio <= 1.0 + 1e-3) break;
+
+    durations = trajectory->segmentDurations();
+    for (Scalar& duration : durations) duration *= ratio;
+    if (!trajectory->setSegmentDurations(durations)) return solution;
+  }
+
+  solution.trajectory = trajectory;
+  return solution;
+}
+
+bool RecedingHorizonReference::apply(const Solution& solution) {
+  // Changed waypoints are solved again in the next period.
+  pending_ = false;
+  if (solution.revision != revision_) return false;
+  if (!solution.trajectory) {
+    changed_ = true;  // Retry in the next period.
+    return false;
+  }
+
+  const std::vector<Scalar> durations =
+    solution.trajectory->segmentDurations();
+  if (durations.size() != waypoints_.size()) return false;
+
+  Scalar arrival = solution.trajectory->getStartTime();
+  for (size_t i = 0; i < waypoints_.size(); ++i) {
+    arrival += durations[i];
+    waypoints_[i].t = arrival;
+  }
+
+  previous_ = trajectory_;
+  trajectory_ = solution.trajectory;
+  ++replans_;
+  return true;
+}
+
+QuadState RecedingHorizonReference::getState(const Scalar t) const {
+  if (trajectory_ && t < trajectory_->getStartTime()) {
+    // Delayed solution, continue with the reference it starts from.
+    if (previous_) return previous_->getState(t);
+  } else if (trajectory_) {
+    return trajectory_->getState(t);
+  }
+
+  QuadState state = hold_state_;
+  state.t = t;
+  return state;
+}
+
+bool RecedingHorizonReference::getPreview(
+  const Scalar t, std::vector<QuadState>& states) const {
+  if (!(params_.preview_dt > 0.0)) return false;
+
+  const int n = std::floor(params_.horizon / params_.preview_dt) + 1;
+  std::vector<Scalar> times(n);
+  for (int i = 0; i < n; ++i) times[i] = t + i * params_.preview_dt;
+
+  if (trajectory_) return trajectory_->getStates(times, states);
+
+  states.assign(n, hold_state_);
+  for (int i = 0; i < n; ++i) states[i].t = times[i];
+  return true;
+}
+
+bool RecedingHorizonReference::getStates(
+  const Scalar dt, std::vector<QuadState>& states) const {
+  states.clear();
+  if (!trajectory_ || !(dt > 0.0)) return false;
+
+  std::vector<Scalar> times;
+  for (Scalar t = trajectory_->getStartTime(); t <= trajectory_->getEndTime();
+       t += dt)
+    times.push_back(t);
+  return trajectory_->getStates(times, states);
+}
+
+bool RecedingHorizonReference::active(const Scalar t) const {
+  return changed_ || pending_ ||
+         (trajectory_ && t <= trajectory_->getEndTime());
+}
+
+Scalar RecedingHorizonReference::getEndTime() const {
+  return trajectory_ ? trajectory_->getEndTime() : hold_state_.t;
+}
+
+}  // namespace agi
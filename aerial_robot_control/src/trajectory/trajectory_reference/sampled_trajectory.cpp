@@ -12,18 +12,16 @@ SampledTrajectory::SampledTrajectory(const SetpointVector& setpoints)
 Setpoint SampledTrajectory::getSetpoint(const QuadState& state,
                                         const Scalar t) {
   // find first point with timestamp larger than query:
-  SetpointVector::const_iterator upper_setpoint =
-    std::lower_bound(setpoints_.begin(), setpoints_.end(), t,
-                     [](const Setpoint& setpoint, const Scalar t) -> bool {
-                       return setpoint.state.t <= t;
-                     });
+  const size_t upper_index = findUpperIndex(t);
 
   // If query time is beyond trajectory, return last available state instead
-  if (upper_setpoint == setpoints_.end()) return setpoints_.back();
+  if (upper_index == setpoints_.size()) return setpoints_.back();
 
   // If query time is earlier than reference, return first point
-  if (upper_setpoint == setpoints_.begin()) return setpoints_.front();
+  if (upper_index == 0) return setpoints_.front();
 
+  SetpointVector::const_iterator upper_setpoint =
+    setpoints_.begin() + upper_index;
   SetpointVector::const_iterator lower_setpoint = std::prev(upper_setpoint);
 
   // interpolate between closest points in SetpointVector
@@ -33,6 +31,31 @@ Setpoint SampledTrajectory::getSetpoint(const QuadState& state,
   return interpolateSetpoints(*lower_setpoint, *upper_setpoint, x);
 }
 
+size_t SampledTrajectory::findUpperIndex(const Scalar t) const {
+  // Controllers query with increasing time, so the answer is usually the
+  // cached segment or one of the next few.
+  static constexpr size_t max_forward_steps = 4;
+  const size_t n = setpoints_.size();
+  size_t i = std::min(upper_index_, n);
+  if (i == 0 || setpoints_[i - 1].state.t <= t) {
+    for (size_t step = 0; step < max_forward_steps; ++step) {
+      if (i == n || setpoints_[i].state.t > t) {
+        upper_index_ = i;
+        return i;
+      }
+      ++i;
+    }
+  }
+
+  SetpointVector::const_iterator upper_setpoint =
+    std::lower_bound(setpoints_.begin(), setpoints_.end(), t,
+                     [](const Setpoint& setpoint, const Scalar t) -> bool {
+                       return setpoint.state.t <= t;
+                     });
+  upper_index_ = upper_setpoint - setpoints_.begin();
+  return upper_index_;
+}
+
 Setpoint SampledTrajectory::getStartSetpoint() { return setpoints_.front(); }
 
 Setpoint SampledTrajectory::getEndSetpoint() { return setpoints_.back(); }
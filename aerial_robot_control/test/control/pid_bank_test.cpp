@@ -0,0 +1,141 @@
+#include <aerial_robot_control/control/utils/pid_bank.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace aerial_robot_control;
+
+namespace
+{
+  /* axes with loose and tight limits, so that every clamp is active in some steps */
+  std::vector<PID> makePIDs()
+  {
+    return {PID("x", 2.0, 0.5, 1.0),
+        PID("y", 2.0, 0.5, 1.0, 3.0, 2.0, 0.5, 1.0, 1.0, 0.4, 0.8),
+        PID("z", 5.0, 2.0, 3.0, 10.0, 4.0, 1.0, 2.0, 0.5, 0.2, 0.3),
+        PID("yaw", 1.0, 0.0, 0.5, 0.5, 1e6, 1e6, 1e6, 1e6, 1e6, 1e6)};
+  }
+
+  void expectSame(PIDBank& bank, const std::vector<PID>& pids)
+  {
+    for(size_t i = 0; i < pids.size(); i++)
+      {
+        const PID& pid = pids.at(i);
+        auto axis = bank.at(i);
+        EXPECT_DOUBLE_EQ(axis.result(), pid.result()) << pid.getName();
+        EXPECT_DOUBLE_EQ(axis.getErrP(), pid.getErrP()) << pid.getName();
+        EXPECT_DOUBLE_EQ(axis.getErrI(), pid.getErrI()) << pid.getName();
+        EXPECT_DOUBLE_EQ(axis.getPrevErrI(), pid.getPrevErrI()) << pid.getName();
+        EXPECT_DOUBLE_EQ(axis.getErrD(), pid.getErrD()) << pid.getName();
+        EXPECT_DOUBLE_EQ(axis.getPTerm(), pid.getPTerm()) << pid.getName();
+        EXPECT_DOUBLE_EQ(axis.getITerm(), pid.getITerm()) << pid.getName();
+        EXPECT_DOUBLE_EQ(axis.getDTerm(), pid.getDTerm()) << pid.getName();
+      }
+  }
+}
+
+TEST(PIDBankTest, MatchesScalarPID)
+{
+  std::vector<PID> pids = makePIDs();
+  PIDBank bank;
+  for(const auto& pid: pids) bank.push_back(pid);
+  ASSERT_EQ(bank.size(), pids.size());
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> err(-3.0, 3.0);
+  const int n = pids.size();
+  const double du = 0.025;
+
+  for(int step = 0; step < 500; step++)
+    {
+      PIDBank::Array err_p(n), err_d(n), ff(n), dus = PIDBank::Array::Constant(n, du);
+      for(int i = 0; i < n; i++)
+        {
+          err_p(i) = err(gen);
+          err_d(i) = err(gen);
+          ff(i) = 0.2 * err(gen);
+          pids.at(i).update(err_p(i), du, err_d(i), ff(i));
+        }
+      bank.update(err_p, dus, err_d, ff);
+      expectSame(bank, pids);
+
+      // reset in the middle of the integration
+      if(step == 200)
+        {
+          pids.at(2).reset();
+          bank.at(2).reset();
+          expectSame(bank, pids);
+        }
+      if(step == 300)
+        {
+          for(auto& pid: pids) pid.reset();
+          bank.reset();
+          expectSame(bank, pids);
+        }
+    }
+}
+
+TEST(PIDBankTest, AxisUpdateMatchesScalarPID)
+{
+  std::vector<PID> pids = makePIDs();
+  PIDBank bank;
+  for(const auto& pid: pids) bank.push_back(pid);
+
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> err(-3.0, 3.0);
+  for(int step = 0; step < 200; step++)
+    {
+      for(size_t i = 0; i < pids.size(); i++)
+        {
+          const double err_p = err(gen), err_d = err(gen), du = 0.01 + 0.02 * (step % 3);
+          pids.at(i).update(err_p, du, err_d);
+          bank.at(i).update(err_p, du, err_d);
+        }
+      expectSame(bank, pids);
+    }
+}
+
+TEST(PIDBankTest, InactiveAxisKeepsState)
+{
+  std::vector<PID> pids = makePIDs();
+  PIDBank bank;
+  for(const auto& pid: pids) bank.push_back(pid);
+  const int n = pids.size();
+
+  PIDBank::Array err_p = PIDBank::Array::Constant(n, 1.0), du = PIDBank::Array::Constant(n, 0.025);
+  PIDBank::Array err_d = PIDBank::Array::Constant(n, 0.5), ff = PIDBank::Array::Zero(n);
+  bank.update(err_p, du, err_d, ff);
+  for(auto& pid: pids) pid.update(1.0, 0.025, 0.5);
+
+  bank.active()(1) = false;
+  bank.update(2 * err_p, du, 2 * err_d, ff);
+  for(int i = 0; i < n; i++)
+    if(i != 1) pids.at(i).update(2.0, 0.025, 1.0);
+  expectSame(bank, pids);
+}
+
+TEST(PIDBankTest, ConfigurationFromPID)
+{
+  const std::vector<PID> pids = makePIDs();
+  PIDBank bank;
+  for(const auto& pid: pids) bank.push_back(pid);
+
+  for(size_t i = 0; i < pids.size(); i++)
+    {
+      auto axis = bank.at(i);
+      EXPECT_EQ(axis.getName(), pids.at(i).getName());
+      EXPECT_EQ(axis.getPGain(), pids.at(i).getPGain());
+      EXPECT_EQ(axis.getLimitSum(), pids.at(i).getLimitSum());
+      EXPECT_EQ(axis.getLimitErrI(), pids.at(i).getLimitErrI());
+    }
+  EXPECT_THROW(bank.at(pids.size()), std::out_of_range);
+
+  for(size_t i = pids.size(); i < PIDBank::MAX_AXIS_NUM; i++) bank.push_back(PID());
+  EXPECT_THROW(bank.push_back(PID()), std::length_error);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,395 @@
+#include <aerial_robot_control/navigation_state_machine.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace aerial_robot_navigation;
+
+namespace
+{
+  const double loop_du = 0.025;
+
+  NavigationEvent event(NavigationEvent::Type type, double stamp, int value = 0)
+  {
+    NavigationEvent e;
+    e.type = type;
+    e.stamp = stamp;
+    e.value = value;
+    return e;
+  }
+
+  NavigationInput input(double stamp, double z = 1.0)
+  {
+    NavigationInput i;
+    i.stamp = stamp;
+    i.z = z;
+    return i;
+  }
+
+  /* tick until the state changes or the duration is over */
+  NavigationOutput spin(NavigationStateMachine& sm, double& t, double du, double z = 1.0)
+  {
+    NavigationOutput output;
+    for(double end = t + du; t < end; t += loop_du)
+      {
+        output = sm.update(input(t, z));
+        if(output.transition()) break;
+      }
+    return output;
+  }
+
+  void takeoff(NavigationStateMachine& sm, double& t)
+  {
+    sm.handle(event(NavigationEvent::ARM, t, 1));
+    sm.update(input(t));
+    sm.handle(event(NavigationEvent::ARM_ON_ACK, t));
+    sm.handle(event(NavigationEvent::TAKEOFF, t));
+    spin(sm, t, 2.0);
+    ASSERT_EQ(sm.getState(), HOVER_STATE);
+  }
+
+  /* one row of the transition table */
+  struct TransitionCase
+  {
+    const char* name;
+    bool flying; // start from hover
+    std::vector<NavigationEvent::Type> events;
+    int value; // value of the last event
+    uint8_t state; // expected state after the last event
+    uint32_t actions; // expected actions of the last event
+  };
+}
+
+TEST(NavigationStateMachineTest, EventTransitions)
+{
+  const std::vector<TransitionCase> cases =
+    {
+      {"arm", false, {NavigationEvent::ARM}, 1, START_STATE, NavigationOutput::INIT_TAKEOFF_TARGET},
+      {"arm without altitude", false, {NavigationEvent::ARM}, 0, ARM_OFF_STATE, 0},
+      {"joy start", false, {NavigationEvent::JOY_START}, 1, START_STATE, NavigationOutput::INIT_TAKEOFF_TARGET},
+      {"takeoff before arm", false, {NavigationEvent::TAKEOFF}, 0, ARM_OFF_STATE, 0},
+      {"takeoff after arm", false, {NavigationEvent::ARM_ON_ACK, NavigationEvent::TAKEOFF}, 0, TAKEOFF_STATE, 0},
+      {"land", true, {NavigationEvent::LAND}, 0, LAND_STATE, 0},
+      {"land without teleop", true, {NavigationEvent::TELEOP, NavigationEvent::LAND}, 0, HOVER_STATE, 0},
+      {"land in att control", true, {NavigationEvent::JOY_ATT_MODE, NavigationEvent::LAND}, 0, HOVER_STATE, 0},
+      {"halt", true, {NavigationEvent::HALT}, 0, STOP_STATE, 0},
+      {"force landing", true, {NavigationEvent::FORCE_LANDING}, 0, HOVER_STATE, NavigationOutput::SEND_FORCE_LANDING_CMD},
+      {"joy force landing", true, {NavigationEvent::JOY}, 1, HOVER_STATE, NavigationOutput::SEND_FORCE_LANDING_CMD},
+      {"arm off ack", true, {NavigationEvent::ARM_OFF_ACK}, 0, ARM_OFF_STATE, 0},
+      {"xy pos mode", true, {NavigationEvent::XY_CONTROL_MODE}, POS_CONTROL_MODE, HOVER_STATE,
+       NavigationOutput::HOLD_XY_TARGET | NavigationOutput::ZERO_VEL_ACC_TARGET},
+      {"xy vel mode", true, {NavigationEvent::XY_CONTROL_MODE}, VEL_CONTROL_MODE, HOVER_STATE, NavigationOutput::ZERO_VEL_ACC_TARGET},
+      {"xy mode before start", false, {NavigationEvent::XY_CONTROL_MODE}, VEL_CONTROL_MODE, ARM_OFF_STATE, 0},
+      {"joy att mode", true, {NavigationEvent::JOY_ATT_MODE}, 0, HOVER_STATE, NavigationOutput::SET_FORCE_ATT_CONTROL},
+      {"joy pos mode", true, {NavigationEvent::JOY_VEL_MODE, NavigationEvent::JOY_POS_MODE}, 0, HOVER_STATE, NavigationOutput::HOLD_XY_TARGET},
+    };
+
+  for(const auto& c: cases)
+    {
+      SCOPED_TRACE(c.name);
+      NavigationStateMachine sm;
+      double t = 0;
+      if(c.flying) takeoff(sm, t);
+
+      NavigationOutput output;
+      for(size_t i = 0; i < c.events.size(); i++)
+        output = sm.handle(event(c.events.at(i), t, i + 1 == c.events.size() ? c.value : 0));
+
+      EXPECT_EQ(sm.getState(), c.state);
+      EXPECT_EQ(output.actions, c.actions);
+    }
+}
+
+TEST(NavigationStateMachineTest, NominalFlight)
+{
+  NavigationStateMachine sm;
+  double t = 0;
+
+  sm.handle(event(NavigationEvent::ARM, t, 1));
+  NavigationOutput output = sm.update(input(t));
+  EXPECT_TRUE(output.has(NavigationOutput::START_SENSOR_FUSION));
+  EXPECT_TRUE(output.has(NavigationOutput::SEND_ARM_ON_CMD));
+
+  sm.handle(event(NavigationEvent::ARM_ON_ACK, t));
+  sm.handle(event(NavigationEvent::TAKEOFF, t));
+
+  /* not converged */
+  for(; t < 3.0; t += loop_du)
+    {
+      NavigationInput far = input(t);
+      far.delta[2] = 0.5;
+      EXPECT_EQ(sm.update(far).state, TAKEOFF_STATE);
+    }
+
+  /* hover after the convergent duration */
+  output = spin(sm, t, 2.0);
+  EXPECT_EQ(output.state, HOVER_STATE);
+  EXPECT_NEAR(t, 3.0 + sm.getConfig().hover_convergent_duration, 2 * loop_du);
+
+  /* descend and stop on the ground */
+  sm.handle(event(NavigationEvent::LAND, t));
+  double z = 1.0;
+  for(; t < 10.0 && sm.getState() == LAND_STATE; t += loop_du)
+    {
+      NavigationInput in = input(t, z);
+      in.vz = z > 0 ? -0.3 : 0;
+      output = sm.update(in);
+      if(output.has(NavigationOutput::UPDATE_LAND_COMMAND)) z = std::max(0.0, z - 0.3 * loop_du);
+    }
+  EXPECT_EQ(sm.getState(), STOP_STATE);
+  EXPECT_NEAR(z, 0.0, 1e-6);
+
+  output = sm.update(input(t, z));
+  EXPECT_TRUE(output.has(NavigationOutput::RESET));
+  EXPECT_TRUE(output.has(NavigationOutput::SEND_ARM_OFF_CMD));
+  EXPECT_FALSE(output.has(NavigationOutput::HALT));
+}
+
+TEST(NavigationStateMachineTest, SafetyTransitions)
+{
+  NavigationConfig config;
+  config.check_joy_stick_heart_beat = true;
+
+  {
+    SCOPED_TRACE("unhealth");
+    NavigationStateMachine sm;
+    double t = 0;
+    takeoff(sm, t);
+    NavigationInput in = input(t);
+    in.unhealth = true;
+    EXPECT_TRUE(sm.update(in).has(NavigationOutput::SEND_FORCE_LANDING_CMD));
+    EXPECT_TRUE(sm.getForceLandingFlag());
+    EXPECT_EQ(sm.getPublishedState(), NavigationStateMachine::FORCE_LANDING_STATE);
+    /* only once */
+    EXPECT_FALSE(sm.update(in).has(NavigationOutput::SEND_FORCE_LANDING_CMD));
+  }
+
+  {
+    SCOPED_TRACE("low voltage");
+    NavigationStateMachine sm;
+    double t = 0;
+    takeoff(sm, t);
+    sm.handle(event(NavigationEvent::BATTERY, t, NavigationEvent::LOW_VOLTAGE));
+    EXPECT_EQ(sm.update(input(t)).state, LAND_STATE);
+    EXPECT_EQ(sm.getPublishedState(), NavigationStateMachine::LOW_BATTERY_STATE);
+  }
+
+  {
+    SCOPED_TRACE("low voltage before takeoff");
+    NavigationStateMachine sm;
+    sm.handle(event(NavigationEvent::BATTERY, 0, NavigationEvent::LOW_VOLTAGE));
+    sm.handle(event(NavigationEvent::ARM, 0, 1));
+    NavigationOutput output = sm.update(input(0));
+    EXPECT_EQ(output.state, ARM_OFF_STATE);
+    EXPECT_FALSE(output.has(NavigationOutput::SEND_ARM_ON_CMD));
+  }
+
+  {
+    SCOPED_TRACE("lost joystick");
+    NavigationStateMachine sm;
+    sm.setConfig(config);
+    double t = 0;
+    takeoff(sm, t);
+    sm.handle(event(NavigationEvent::JOY, t));
+    EXPECT_EQ(spin(sm, t, config.joy_stick_heart_beat_du - 0.1).state, HOVER_STATE);
+    EXPECT_EQ(spin(sm, t, 0.2).state, LAND_STATE);
+  }
+
+  {
+    SCOPED_TRACE("halt after holding select");
+    NavigationStateMachine sm;
+    double t = 0;
+    takeoff(sm, t);
+    for(double end = t + 2.0; t < end && sm.getState() != STOP_STATE; t += 0.1)
+      sm.handle(event(NavigationEvent::JOY, t, 1));
+    EXPECT_EQ(sm.getState(), STOP_STATE);
+    EXPECT_NEAR(t - sm.getForceLandingStartTime(), sm.getConfig().force_landing_to_halt_du, 0.2);
+    NavigationOutput output = sm.update(input(t));
+    EXPECT_TRUE(output.has(NavigationOutput::HALT));
+    EXPECT_FALSE(sm.getForceLandingFlag());
+  }
+
+  {
+    SCOPED_TRACE("xy estimation fallback");
+    NavigationStateMachine sm;
+    double t = 0;
+    takeoff(sm, t);
+    NavigationInput in = input(t);
+    in.xy_estimation = false;
+    sm.update(in);
+    EXPECT_EQ(sm.getXyControlMode(), ACC_CONTROL_MODE);
+    in.xy_estimation = true;
+    sm.update(in);
+    EXPECT_EQ(sm.getXyControlMode(), POS_CONTROL_MODE);
+  }
+}
+
+TEST(NavigationStateMachineTest, LandingPreparation)
+{
+  NavigationStateMachine sm;
+  sm.setLandingPreparation(true);
+  double t = 0;
+  takeoff(sm, t);
+
+  sm.handle(event(NavigationEvent::LAND, t));
+  NavigationOutput output = sm.update(input(t));
+  EXPECT_EQ(output.state, HOVER_STATE);
+  EXPECT_TRUE(output.has(NavigationOutput::PREPARE_LANDING));
+  EXPECT_TRUE(output.has(NavigationOutput::HOLD_Z_TARGET));
+  EXPECT_TRUE(sm.preparingLanding());
+  EXPECT_FALSE(sm.getTeleopFlag());
+
+  /* hover until prepared */
+  EXPECT_EQ(spin(sm, t, 1.0).state, HOVER_STATE);
+  sm.handle(event(NavigationEvent::LANDING_PREPARED, t));
+  EXPECT_EQ(sm.getState(), LAND_STATE);
+  EXPECT_TRUE(sm.getTeleopFlag());
+  EXPECT_TRUE(sm.update(input(t)).has(NavigationOutput::UPDATE_LAND_COMMAND));
+
+  /* prepared again for the next flight */
+  spin(sm, t, 2.0, 0.0);
+  EXPECT_EQ(sm.getState(), STOP_STATE);
+  sm.update(input(t, 0.0));
+  EXPECT_FALSE(sm.landingPrepared());
+}
+
+/*
+  random event sequences: the state machine has to be deterministic and keep the
+  safety rules in any order of the events
+*/
+TEST(NavigationStateMachineTest, RandomSequences)
+{
+  const int sequences = 5000;
+  const int steps = 200;
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> event_type(0, NavigationEvent::TYPE_NUM - 1);
+
+  for(int s = 0; s < sequences; s++)
+    {
+      NavigationConfig config;
+      config.check_joy_stick_heart_beat = s % 2;
+      config.hover_convergent_duration = 0.2;
+      bool landing_preparation = s % 3 == 0;
+
+      NavigationStateMachine sm;
+      sm.setConfig(config);
+      sm.setLandingPreparation(landing_preparation);
+
+      std::vector<NavigationEvent> events;
+      std::vector<NavigationInput> inputs;
+      std::vector<NavigationOutput> outputs;
+
+      double t = 0;
+      double joy_stamp = -1;
+      for(int i = 0; i < steps; i++)
+        {
+          t += 0.01 + 0.3 * uniform(rng);
+          SCOPED_TRACE(::testing::Message() << "sequence " << s << ", step " << i);
+
+          uint8_t prev_state = sm.getState();
+          NavigationOutput output;
+
+          if(uniform(rng) < 0.3)
+            {
+              NavigationEvent e = event(static_cast<NavigationEvent::Type>(event_type(rng)), t);
+              switch(e.type)
+                {
+                case NavigationEvent::ARM:
+                case NavigationEvent::JOY_START:
+                  e.value = uniform(rng) < 0.9; break;
+                case NavigationEvent::XY_CONTROL_MODE:
+                  e.value = static_cast<int>(3 * uniform(rng)); break;
+                case NavigationEvent::TELEOP:
+                  e.value = uniform(rng) < 0.7; break;
+                case NavigationEvent::BATTERY:
+                  e.value = uniform(rng) < 0.8 ? 0 : static_cast<int>(1 + 3 * uniform(rng)); break;
+                case NavigationEvent::JOY:
+                  e.value = uniform(rng) < 0.1; joy_stamp = t; break;
+                default:
+                  break;
+                }
+
+              output = sm.handle(e);
+              events.push_back(e);
+
+              if(output.state == TAKEOFF_STATE && prev_state != TAKEOFF_STATE)
+                {
+                  EXPECT_EQ(prev_state, ARM_ON_STATE);
+                }
+            }
+          else
+            {
+              NavigationInput in = input(t, 2.0 * uniform(rng));
+              in.xy_estimation = uniform(rng) < 0.9;
+              in.unhealth = uniform(rng) < 0.02;
+              in.vz = uniform(rng) - 0.5;
+              for(auto& d: in.delta) d = 0.2 * (uniform(rng) - 0.5);
+
+              bool force_landing = sm.getForceLandingFlag();
+              bool force_att = sm.getForceAttControlFlag();
+              bool low_voltage = sm.getLowVoltageFlag();
+
+              output = sm.update(in);
+              inputs.push_back(in);
+
+              /* sensor unhealth level3: always force landing */
+              if(in.unhealth && !force_landing)
+                {
+                  EXPECT_TRUE(output.has(NavigationOutput::SEND_FORCE_LANDING_CMD));
+                }
+
+              /* low battery or lost joystick: never keep flying normally */
+              bool lost_joy = config.check_joy_stick_heart_beat && joy_stamp >= 0 &&
+                t - joy_stamp > config.joy_stick_heart_beat_du;
+              if((low_voltage || lost_joy) && !force_att &&
+                 (prev_state == TAKEOFF_STATE || prev_state == HOVER_STATE))
+                {
+                  EXPECT_NE(output.state, TAKEOFF_STATE);
+                  if(output.state == HOVER_STATE)
+                    {
+                      EXPECT_TRUE(sm.preparingLanding());
+                    }
+                }
+
+              if(output.has(NavigationOutput::SEND_ARM_ON_CMD))
+                {
+                  EXPECT_EQ(prev_state, START_STATE);
+                }
+            }
+
+          EXPECT_EQ(output.prev_state, prev_state);
+          EXPECT_EQ(output.state, sm.getState());
+          EXPECT_LE(sm.getState(), STOP_STATE);
+          EXPECT_GE(sm.getXyControlMode(), POS_CONTROL_MODE);
+          EXPECT_LE(sm.getXyControlMode(), ACC_CONTROL_MODE);
+
+          outputs.push_back(output);
+          if(::testing::Test::HasFailure()) return;
+        }
+
+      /* replay in the same order: same outputs */
+      if(s % 10 == 0)
+        {
+          NavigationStateMachine replay;
+          replay.setConfig(config);
+          replay.setLandingPreparation(landing_preparation);
+
+          size_t e = 0, i = 0;
+          for(const auto& expected: outputs)
+            {
+              bool is_event = e < events.size() && (i >= inputs.size() || events.at(e).stamp <= inputs.at(i).stamp);
+              NavigationOutput output = is_event ? replay.handle(events.at(e++)) : replay.update(inputs.at(i++));
+              ASSERT_EQ(output.actions, expected.actions);
+              ASSERT_EQ(output.state, expected.state);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
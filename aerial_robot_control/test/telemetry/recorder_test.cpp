@@ -0,0 +1,211 @@
+#include <aerial_robot_control/telemetry/recorder.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace aerial_robot_control;
+
+namespace
+{
+  std::string tempPath(const std::string& name)
+  {
+    return "/tmp/" + name + "_" + std::to_string(getpid()) + ".artl";
+  }
+
+  std::vector<telemetry::Sample> readAll(const std::string& path, telemetry::Reader& reader)
+  {
+    std::vector<telemetry::Sample> samples;
+    EXPECT_TRUE(reader.open(path)) << reader.getError();
+    telemetry::Sample sample;
+    while(reader.next(sample)) samples.push_back(sample);
+    EXPECT_TRUE(reader.getError().empty()) << reader.getError();
+    return samples;
+  }
+}
+
+TEST(RingBufferTest, FifoAndFull)
+{
+  RingBuffer<int> buffer(3);
+  EXPECT_EQ(buffer.capacity(), 3);
+  EXPECT_EQ(buffer.front(), nullptr);
+
+  for(int i = 0; i < 3; i++) EXPECT_TRUE(buffer.push([i](int& slot) { slot = i; }));
+  EXPECT_FALSE(buffer.push([](int& slot) { slot = 3; }));
+  EXPECT_EQ(buffer.size(), 3);
+
+  for(int i = 0; i < 3; i++)
+    {
+      ASSERT_NE(buffer.front(), nullptr);
+      EXPECT_EQ(*buffer.front(), i);
+      buffer.pop();
+    }
+  EXPECT_EQ(buffer.front(), nullptr);
+  EXPECT_EQ(buffer.size(), 0);
+}
+
+TEST(RingBufferTest, ProducerConsumer)
+{
+  const int n = 200000;
+  RingBuffer<int> buffer(64);
+
+  std::thread producer([&]()
+                       {
+                         for(int i = 0; i < n; i++)
+                           while(!buffer.push([i](int& slot) { slot = i; })) std::this_thread::yield();
+                       });
+
+  int expected = 0;
+  while(expected < n)
+    {
+      const int* value = buffer.front();
+      if(!value)
+        {
+          std::this_thread::yield();
+          continue;
+        }
+      ASSERT_EQ(*value, expected);
+      buffer.pop();
+      expected++;
+    }
+  producer.join();
+}
+
+TEST(RecorderTest, RoundTrip)
+{
+  const std::string path = tempPath("recorder_round_trip");
+  telemetry::Recorder recorder;
+  int state = recorder.addChannel("state", {"x", "y", "z"});
+  EXPECT_FALSE(recorder.record(state, 0.0, {1, 2, 3})); // not open
+
+  ASSERT_TRUE(recorder.open(path));
+  int target = recorder.addChannel("target", {"z"}); // after open
+  for(int i = 0; i < 100; i++)
+    {
+      EXPECT_TRUE(recorder.record(state, i * 0.01, {i * 1.0, i * 2.0, i * 3.0}));
+      if(i % 10 == 0)
+        {
+          EXPECT_TRUE(recorder.record(target, i * 0.01, {-i * 1.0}));
+        }
+    }
+  recorder.close();
+
+  telemetry::RecorderStats stats = recorder.getStats();
+  EXPECT_EQ(stats.recorded, 110);
+  EXPECT_EQ(stats.dropped, 0);
+  EXPECT_EQ(stats.written, 110);
+  EXPECT_GT(stats.max_record_time, 0);
+  EXPECT_LE(stats.mean_record_time, stats.max_record_time);
+
+  telemetry::Reader reader;
+  auto samples = readAll(path, reader);
+  EXPECT_EQ(reader.getVersion(), telemetry::VERSION);
+  ASSERT_EQ(reader.getChannels().size(), 2);
+  EXPECT_EQ(reader.getChannels().at(state).name, "state");
+  EXPECT_EQ(reader.getChannels().at(state).fields, std::vector<std::string>({"x", "y", "z"}));
+  EXPECT_EQ(reader.getChannels().at(target).name, "target");
+  ASSERT_EQ(samples.size(), 110);
+
+  int state_count = 0;
+  for(const auto& sample: samples)
+    {
+      if(sample.channel != state) continue;
+      EXPECT_DOUBLE_EQ(sample.stamp, state_count * 0.01);
+      EXPECT_EQ(sample.values, std::vector<double>({state_count * 1.0, state_count * 2.0, state_count * 3.0}));
+      state_count++;
+    }
+  EXPECT_EQ(state_count, 100);
+  remove(path.c_str());
+}
+
+TEST(RecorderTest, MultipleThreads)
+{
+  const std::string path = tempPath("recorder_threads");
+  const int thread_num = 4;
+  const int n = 20000;
+  telemetry::Recorder recorder(n, 0.001);
+  ASSERT_TRUE(recorder.open(path));
+
+  std::vector<std::thread> threads;
+  for(int t = 0; t < thread_num; t++)
+    {
+      int channel = recorder.addChannel("thread" + std::to_string(t), {"index"});
+      threads.emplace_back([&recorder, channel]()
+                           {
+                             for(int i = 0; i < n; i++) recorder.record(channel, i, {static_cast<double>(i)});
+                           });
+    }
+  for(auto& thread: threads) thread.join();
+  recorder.close();
+  EXPECT_EQ(recorder.getStats().dropped, 0);
+
+  // the samples of each thread keep their order
+  telemetry::Reader reader;
+  std::vector<int> next(thread_num, 0);
+  for(const auto& sample: readAll(path, reader))
+    {
+      ASSERT_LT(sample.channel, thread_num);
+      ASSERT_EQ(sample.values.at(0), next.at(sample.channel));
+      next.at(sample.channel)++;
+    }
+  for(int t = 0; t < thread_num; t++) EXPECT_EQ(next.at(t), n);
+  remove(path.c_str());
+}
+
+TEST(RecorderTest, DropWhenFull)
+{
+  const std::string path = tempPath("recorder_drop");
+  telemetry::Recorder recorder(16, 10.0); // the writer sleeps
+  int channel = recorder.addChannel("value", {"v"});
+  ASSERT_TRUE(recorder.open(path));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10)); // first cycle of the writer
+
+  int accepted = 0;
+  for(int i = 0; i < 100; i++) accepted += recorder.record(channel, i, {1.0});
+  EXPECT_EQ(accepted, 16);
+
+  telemetry::RecorderStats stats = recorder.getStats();
+  EXPECT_EQ(stats.recorded, 16);
+  EXPECT_EQ(stats.dropped, 84);
+  recorder.close();
+  EXPECT_EQ(recorder.getStats().written, 16);
+  remove(path.c_str());
+}
+
+TEST(RecorderTest, Fields)
+{
+  telemetry::Recorder recorder;
+  EXPECT_EQ(recorder.addChannel("too_many", std::vector<std::string>(telemetry::MAX_FIELDS + 1, "f")), -1);
+  EXPECT_EQ(recorder.addChannel("max", std::vector<std::string>(telemetry::MAX_FIELDS, "f")), 0);
+}
+
+TEST(ReaderTest, InvalidFile)
+{
+  const std::string path = tempPath("reader_invalid");
+  telemetry::Reader reader;
+  EXPECT_FALSE(reader.open(path));
+
+  FILE* file = fopen(path.c_str(), "wb");
+  fwrite("ABCD\x01\x00\x00\x00", 1, 8, file);
+  fclose(file);
+  EXPECT_FALSE(reader.open(path));
+
+  // newer schema
+  file = fopen(path.c_str(), "wb");
+  uint16_t version = telemetry::VERSION + 1, reserved = 0;
+  fwrite(telemetry::MAGIC, 1, 4, file);
+  fwrite(&version, sizeof(version), 1, file);
+  fwrite(&reserved, sizeof(reserved), 1, file);
+  fclose(file);
+  EXPECT_FALSE(reader.open(path));
+  EXPECT_NE(reader.getError().find("newer"), std::string::npos);
+  remove(path.c_str());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,122 @@
+#include <aerial_robot_control/trajectory/trajectory_reference/polynomial_trajectory.hpp>
+#include <aerial_robot_control/trajectory/utils/timer.hpp>
+#include <cstdio>
+
+/*
+  Construction and sampling cost of the agi trajectories versus the waypoint
+  count and the polynomial order. Run it before and after touching the
+  trajectory generation, the numbers are only comparable on the same machine.
+ */
+
+using namespace agi;
+
+namespace
+{
+  const int repeat = 20;
+  const Scalar sample_dt = 0.02;
+
+  std::vector<QuadState> createWaypoints(const int n)
+  {
+    std::srand(0);
+    std::vector<QuadState> states;
+    for (int i = 0; i < n; i++)
+      {
+        QuadState state;
+        state.setZero();
+        state.t = i;
+        state.p = 2.0 * Vector<3>::Random();
+        states.push_back(state);
+      }
+    return states;
+  }
+
+  template<class Trajectory, class Factory>
+  void benchmark(const std::string& name, const int waypoints, const int order, Factory factory)
+  {
+    Timer construct("construct"), sample("getState"), batch("getStates");
+
+    std::shared_ptr<Trajectory> traj;
+    for (int i = 0; i < repeat; i++)
+      {
+        construct.tic();
+        traj = factory();
+        construct.toc();
+      }
+
+    std::vector<Scalar> times;
+    for (Scalar t = traj->getStartTime(); t <= traj->getEndTime(); t += sample_dt)
+      times.push_back(t);
+
+    std::vector<QuadState> states;
+    for (int i = 0; i < repeat; i++)
+      {
+        sample.tic();
+        for (const Scalar t : times) traj->getState(t);
+        sample.toc();
+
+        batch.tic();
+        traj->getStates(times, states);
+        batch.toc();
+      }
+
+    const Scalar n = times.size();
+    std::printf("%-24s %9d %5d %14.3f %14.3f %14.3f %5s\n", name.c_str(), waypoints, order,
+                1e6 * construct.mean(), 1e9 * sample.mean() / n, 1e9 * batch.mean() / n,
+                traj->valid() ? "ok" : "fail");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::printf("%-24s %9s %5s %14s %14s %14s %5s\n", "trajectory", "waypoints", "order",
+              "construct[us]", "sample[ns]", "batch[ns]", "valid");
+
+  for (const int order : {5, 7, 11, 15})
+    {
+      const std::vector<QuadState> states = createWaypoints(2);
+      benchmark<MinJerkTrajectory>("MinJerk", 2, order, [&]() {
+          return std::make_shared<MinJerkTrajectory>(states.front(), states.back(), order); });
+      benchmark<MinSnapTrajectory>("MinSnap", 2, order, [&]() {
+          return std::make_shared<MinSnapTrajectory>(states.front(), states.back(), order); });
+    }
+
+  {
+    const std::vector<QuadState> states = createWaypoints(2);
+    benchmark<ClosedFormMinJerkTrajectory>("ClosedFormMinJerk", 2, 5, [&]() {
+        return std::make_shared<ClosedFormMinJerkTrajectory>(states.front(), states.back()); });
+  }
+
+  // single polynomial through all waypoints, limited by its order
+  for (const int n : {3, 4, 5, 6})
+    {
+      const std::vector<QuadState> states = createWaypoints(n);
+      benchmark<MinSnapTrajectory>("MinSnap", n, 11, [&]() {
+          return std::make_shared<MinSnapTrajectory>(states); });
+    }
+
+  for (const int n : {2, 5, 10, 20, 50, 100, 200})
+    {
+      const std::vector<QuadState> states = createWaypoints(n);
+      benchmark<PiecewiseMinSnapTrajectory>("PiecewiseMinSnap", n, 7, [&]() {
+          return std::make_shared<PiecewiseMinSnapTrajectory>(states); });
+    }
+
+  for (const int n : {5, 10, 20, 50})
+    {
+      const std::vector<QuadState> states = createWaypoints(n);
+      Timer timer("optimizeSegmentDurations");
+      TrajectoryLimits limits;
+      limits.v_max = 2.0;
+      limits.thrust_max = 20.0;
+      for (int i = 0; i < 5; i++)
+        {
+          PiecewiseMinSnapTrajectory traj(states);
+          timer.tic();
+          traj.optimizeSegmentDurations(limits);
+          timer.toc();
+        }
+      std::printf("%-24s %9d %5d %14.3f\n", "TimeAllocation", n, 7, 1e6 * timer.mean());
+    }
+
+  return 0;
+}
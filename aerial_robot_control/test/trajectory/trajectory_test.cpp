@@ -0,0 +1,329 @@
+#include <aerial_robot_control/trajectory/math/gravity.hpp>
+#include <aerial_robot_control/trajectory/trajectory_reference/polynomial_trajectory.hpp>
+#include <aerial_robot_control/trajectory/trajectory_reference/receding_horizon_reference.hpp>
+#include <aerial_robot_control/trajectory/trajectory_reference/sampled_trajectory.hpp>
+#include <gtest/gtest.h>
+
+using namespace agi;
+
+namespace
+{
+  const Scalar tolerance = 1e-6;
+
+  QuadState createState(const Scalar t, const Vector<3>& p)
+  {
+    QuadState state;
+    state.setZero();
+    state.t = t;
+    state.p = p;
+    return state;
+  }
+
+  std::vector<QuadState> createWaypoints(const int n, const Scalar du = 1.0)
+  {
+    std::srand(0);
+    std::vector<QuadState> states;
+    for (int i = 0; i < n; i++)
+      states.push_back(createState(i * du, 2.0 * Vector<3>::Random()));
+
+    states.front().v = Vector<3>(-1, 0.5, 0);
+    states.front().a = Vector<3>(0.2, 0, -0.1);
+    states.front().setYaw(0.3);
+    states.back().setYaw(1.0);
+    return states;
+  }
+
+  void expectBoundary(const QuadState& expected, const QuadState& actual, const int order)
+  {
+    EXPECT_NEAR((expected.p - actual.p).norm(), 0.0, tolerance);
+    if (order > 0) EXPECT_NEAR((expected.v - actual.v).norm(), 0.0, tolerance);
+    if (order > 1) EXPECT_NEAR((expected.a - actual.a).norm(), 0.0, tolerance);
+    if (order > 2) EXPECT_NEAR((expected.j - actual.j).norm(), 0.0, tolerance);
+  }
+}
+
+TEST(PolynomialTrajectoryTest, MinJerkBoundary)
+{
+  const std::vector<QuadState> states = createWaypoints(2, 2.0);
+  MinJerkTrajectory traj(states.front(), states.back());
+  ASSERT_TRUE(traj.valid());
+
+  expectBoundary(states.front(), traj.getState(states.front().t), 2);
+  expectBoundary(states.back(), traj.getState(states.back().t), 2);
+  EXPECT_NEAR(traj.getState(states.back().t).getYaw(), 1.0, tolerance);
+}
+
+TEST(PolynomialTrajectoryTest, ClosedFormMatchesMinJerk)
+{
+  const std::vector<QuadState> states = createWaypoints(2, 2.0);
+  MinJerkTrajectory traj(states.front(), states.back(), 5);
+  ClosedFormMinJerkTrajectory closed_form(states.front(), states.back());
+  ASSERT_TRUE(closed_form.valid());
+
+  for (Scalar t = 0.0; t <= 2.0; t += 0.05)
+    {
+      const QuadState a = traj.getState(t);
+      const QuadState b = closed_form.getState(t);
+      EXPECT_NEAR((a.p - b.p).norm(), 0.0, tolerance);
+      EXPECT_NEAR((a.a - b.a).norm(), 0.0, tolerance);
+    }
+}
+
+TEST(PolynomialTrajectoryTest, MinSnapWaypoints)
+{
+  const std::vector<QuadState> states = createWaypoints(4);
+  MinSnapTrajectory traj(states);
+  ASSERT_TRUE(traj.valid());
+
+  expectBoundary(states.front(), traj.getState(states.front().t), 3);
+  expectBoundary(states.back(), traj.getState(states.back().t), 3);
+  for (size_t i = 1; i < states.size() - 1; i++)
+    expectBoundary(states.at(i), traj.getState(states.at(i).t), 0);
+}
+
+TEST(PolynomialTrajectoryTest, BatchMatchesSingleEvaluation)
+{
+  const std::vector<QuadState> states = createWaypoints(4);
+  MinSnapTrajectory traj(states);
+
+  std::vector<Scalar> times;
+  for (Scalar t = -0.5; t <= 3.5; t += 0.01) times.push_back(t);
+
+  std::vector<QuadState> batch;
+  ASSERT_TRUE(traj.getStates(times, batch));
+  ASSERT_EQ(batch.size(), times.size());
+
+  MinSnapTrajectory reference(states);
+  for (size_t i = 0; i < times.size(); i++)
+    {
+      const QuadState state = reference.getState(times.at(i));
+      EXPECT_NEAR(state.t, batch.at(i).t, 1e-12);
+      EXPECT_NEAR((state.p - batch.at(i).p).norm(), 0.0, 1e-12);
+      EXPECT_NEAR((state.s - batch.at(i).s).norm(), 0.0, 1e-12);
+      EXPECT_NEAR((state.w - batch.at(i).w).norm(), 0.0, 1e-12);
+    }
+}
+
+TEST(PiecewiseTrajectoryTest, SingleSegmentMatchesMinSnap)
+{
+  std::vector<QuadState> states = createWaypoints(2, 2.0);
+  states.front().j = Vector<3>(0.1, 0, 0.3);
+  MinSnapTrajectory dense(states.front(), states.back());
+  PiecewiseMinSnapTrajectory piecewise(states);
+  ASSERT_TRUE(piecewise.valid());
+
+  for (Scalar t = 0.0; t <= 2.0; t += 0.05)
+    {
+      const QuadState a = dense.getState(t);
+      const QuadState b = piecewise.getState(t);
+      EXPECT_NEAR((a.p - b.p).norm(), 0.0, tolerance);
+      EXPECT_NEAR((a.v - b.v).norm(), 0.0, tolerance);
+      EXPECT_NEAR((a.a - b.a).norm(), 0.0, tolerance);
+      EXPECT_NEAR((a.s - b.s).norm(), 0.0, tolerance);
+      EXPECT_NEAR((a.w - b.w).norm(), 0.0, tolerance);
+    }
+}
+
+TEST(PiecewiseTrajectoryTest, WaypointsAndContinuity)
+{
+  const std::vector<QuadState> states = createWaypoints(20);
+  PiecewiseMinSnapTrajectory traj(states);
+  ASSERT_TRUE(traj.valid());
+  ASSERT_EQ(traj.segmentDurations().size(), states.size() - 1);
+
+  expectBoundary(states.front(), traj.getState(states.front().t), 3);
+  expectBoundary(states.back(), traj.getState(states.back().t), 3);
+
+  // derivatives up to jerk are continuous across the segments
+  const Scalar eps = 1e-7;
+  for (size_t i = 1; i < states.size() - 1; i++)
+    {
+      const Scalar t = states.at(i).t;
+      expectBoundary(states.at(i), traj.getState(t), 0);
+
+      const QuadState before = traj.getState(t - eps);
+      const QuadState after = traj.getState(t + eps);
+      EXPECT_NEAR((before.p - after.p).norm(), 0.0, 1e-5);
+      EXPECT_NEAR((before.v - after.v).norm(), 0.0, 1e-5);
+      EXPECT_NEAR((before.a - after.a).norm(), 0.0, 1e-4);
+      EXPECT_NEAR((before.j - after.j).norm(), 0.0, 1e-3);
+    }
+}
+
+TEST(PiecewiseTrajectoryTest, SegmentTimeAllocation)
+{
+  std::vector<QuadState> states = createWaypoints(10);
+  states.front().v.setZero();
+  states.front().a.setZero();
+  PiecewiseMinSnapTrajectory traj(states);
+  const Scalar cost = traj.cost();
+
+  // relative allocation only, the total duration is kept
+  const Scalar duration = traj.optimizeSegmentDurations(TrajectoryLimits());
+  EXPECT_NEAR(duration, states.back().t - states.front().t, 1e-9);
+  EXPECT_LT(traj.cost(), cost);
+
+  TrajectoryLimits limits;
+  limits.v_max = 1.0;
+  limits.thrust_min = 5.0;
+  limits.thrust_max = 15.0;
+  traj.optimizeSegmentDurations(limits);
+  ASSERT_TRUE(traj.valid());
+  EXPECT_NEAR(traj.limitRatio(limits), 1.0, 1e-3);
+
+  for (size_t i = 1; i < states.size() - 1; i++)
+    {
+      Scalar t = traj.getStartTime();
+      for (size_t j = 0; j < i; j++) t += traj.segmentDurations().at(j);
+      expectBoundary(states.at(i), traj.getState(t), 0);
+    }
+}
+
+TEST(SampledTrajectoryTest, InterpolationAccuracy)
+{
+  // quadratic reference: the linear interpolation error is bounded by h^2 / 8 * |p''|
+  const Vector<3> p0(1, -2, 0.5), v0(0.5, 0.2, -1), a0(0.3, -0.4, 0.1);
+  const Scalar h = 0.1;
+
+  SetpointVector setpoints;
+  for (int i = 0; i <= 50; i++)
+    {
+      const Scalar t = i * h;
+      QuadState state;
+      state.setZero();
+      state.t = t;
+      state.p = p0 + v0 * t + 0.5 * a0 * t * t;
+      state.v = v0 + a0 * t;
+      state.a = a0;
+      setpoints.push_back(Setpoint(state, Command(t, G, Vector<3>::Zero())));
+    }
+
+  SampledTrajectory traj(setpoints);
+  const Scalar bound = h * h / 8 * a0.norm() + 1e-12;
+
+  QuadState query;
+  query.setZero();
+  for (Scalar t = 0.0; t < 5.0; t += 0.013)
+    {
+      const Setpoint setpoint = traj.getSetpoint(query, t);
+      EXPECT_NEAR(setpoint.state.t, t, 1e-9);
+      EXPECT_LE((setpoint.state.p - (p0 + v0 * t + 0.5 * a0 * t * t)).norm(), bound);
+      EXPECT_NEAR((setpoint.state.v - (v0 + a0 * t)).norm(), 0.0, 1e-9);
+    }
+
+  // out of order queries and clamping at both ends
+  for (const Scalar t : {3.33, 0.51, 4.97, 0.0, 2.05})
+    {
+      const Setpoint setpoint = traj.getSetpoint(query, t);
+      EXPECT_LE((setpoint.state.p - (p0 + v0 * t + 0.5 * a0 * t * t)).norm(), bound);
+    }
+  EXPECT_NEAR(traj.getSetpoint(query, -1.0).state.t, 0.0, 1e-12);
+  EXPECT_NEAR(traj.getSetpoint(query, 10.0).state.t, 5.0, 1e-12);
+}
+
+TEST(RecedingHorizonTest, ContinuousReplanning)
+{
+  RecedingHorizonParams params;
+  params.replan_period = 0.1;
+  params.mean_vel = 1.0;
+  params.limits.v_max = 1.0;
+  params.limits.a_max = 2.0;
+  params.limits.j_max = 5.0;
+  RecedingHorizonReference reference(params);
+  reference.reset(createState(0.0, Vector<3>::Zero()));
+
+  // goal streamed every control cycle and moving every 0.3 s
+  const Scalar dt = 0.01;
+  QuadState last = reference.getState(0.0);
+  for (int i = 0; i < 300; i++)
+    {
+      const Scalar t = i * dt;
+      reference.setGoal(createState(NAN, Vector<3>(1.0 + std::floor(t / 0.3) * 0.2, 0.5, 1.0)));
+      const bool replanned = reference.update(t);
+      const QuadState state = reference.getState(t);
+
+      // no jump at the replanning
+      if (replanned)
+        {
+          const QuadState before = last;
+          EXPECT_NEAR((before.p + before.v * dt - state.p).norm(), 0.0, 1e-3);
+          EXPECT_NEAR((before.v + before.a * dt - state.v).norm(), 0.0, 1e-2);
+          EXPECT_NEAR((before.a + before.j * dt - state.a).norm(), 0.0, 1e-1);
+        }
+      EXPECT_LE(state.v.norm(), params.limits.v_max + 1e-2);
+      EXPECT_LE(state.a.norm(), params.limits.a_max + 1e-2);
+      last = state;
+    }
+
+  // identical goals are coalesced, at most one solve per period
+  EXPECT_LE(reference.replans(), 10);
+
+  std::vector<QuadState> preview;
+  ASSERT_TRUE(reference.getPreview(3.0, preview));
+  EXPECT_EQ(preview.size(), 11);
+  EXPECT_NEAR(preview.back().t, 4.0, 1e-9);
+
+  // reach the final goal at rest
+  while (reference.active(reference.getEndTime()) && reference.update(reference.getEndTime()));
+  const QuadState end = reference.getState(reference.getEndTime());
+  EXPECT_NEAR((end.p - Vector<3>(2.8, 0.5, 1.0)).norm(), 0.0, tolerance);
+  EXPECT_NEAR(end.v.norm(), 0.0, tolerance);
+}
+
+TEST(RecedingHorizonTest, WaypointsArePassed)
+{
+  RecedingHorizonReference reference;
+  reference.reset(createState(0.0, Vector<3>::Zero()));
+  reference.setWaypoints({createState(NAN, Vector<3>(1, 0, 0)),
+                          createState(NAN, Vector<3>(1, 1, 0)),
+                          createState(NAN, Vector<3>(0, 1, 0))});
+  ASSERT_TRUE(reference.update(0.0));
+  EXPECT_EQ(reference.remainingWaypoints(), 3);
+
+  // replanning after the first waypoint only keeps the rest
+  const Scalar t = 0.5 * reference.getEndTime();
+  reference.addWaypoint(createState(NAN, Vector<3>(0, 0, 0)));
+  ASSERT_TRUE(reference.update(t));
+  EXPECT_LE(reference.remainingWaypoints(), 3);
+  EXPECT_NEAR(reference.getState(reference.getEndTime()).p.norm(), 0.0, tolerance);
+}
+
+TEST(RecedingHorizonTest, DelayedSolution)
+{
+  RecedingHorizonParams params;
+  params.solve_delay = 0.05;
+  RecedingHorizonReference reference(params);
+  reference.reset(createState(0.0, Vector<3>::Zero()));
+  reference.setGoal(createState(NAN, Vector<3>(1, 0, 0)));
+  ASSERT_TRUE(reference.update(0.0));
+
+  // solved while the current trajectory is followed
+  RecedingHorizonReference::Problem problem;
+  reference.setGoal(createState(NAN, Vector<3>(1, 1, 0)));
+  ASSERT_TRUE(reference.prepare(0.5, problem));
+  EXPECT_NEAR(problem.start.t, 0.55, 1e-9);
+  const QuadState before = reference.getState(0.52);
+  EXPECT_TRUE(reference.active(0.52));
+  ASSERT_TRUE(reference.apply(RecedingHorizonReference::solve(problem)));
+
+  // the current trajectory is kept until the start of the new one
+  EXPECT_NEAR((reference.getState(0.52).p - before.p).norm(), 0.0, 1e-12);
+  const QuadState start = reference.getState(0.55);
+  EXPECT_NEAR((start.p - problem.start.p).norm(), 0.0, 1e-9);
+  EXPECT_NEAR((start.v - problem.start.v).norm(), 0.0, 1e-9);
+  EXPECT_NEAR((reference.getState(reference.getEndTime()).p - Vector<3>(1, 1, 0)).norm(), 0.0, tolerance);
+
+  // a solution of outdated waypoints is dropped and solved again
+  reference.setGoal(createState(NAN, Vector<3>(0, 1, 0)));
+  ASSERT_TRUE(reference.prepare(1.0, problem));
+  reference.setGoal(createState(NAN, Vector<3>(0, 0, 0)));
+  EXPECT_FALSE(reference.apply(RecedingHorizonReference::solve(problem)));
+  ASSERT_TRUE(reference.update(1.2));
+  EXPECT_NEAR(reference.getState(reference.getEndTime()).p.norm(), 0.0, tolerance);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
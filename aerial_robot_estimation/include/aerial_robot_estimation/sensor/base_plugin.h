@@ -36,6 +36,7 @@
 #pragma once
 
 #include <aerial_robot_estimation/state_estimation.h>
+#include <aerial_robot_model/utils/callback_scheduler.h>
 #include <aerial_robot_msgs/States.h>
 #include <Eigen/Core>
 #include <Eigen/Dense>
@@ -75,7 +76,7 @@ namespace sensor_plugin
       estimator_ = estimator;
       robot_model_ = robot_model;
 
-      nh_ = nh;
+      nh_ = aerial_robot_model::CallbackScheduler::nodeHandle(nh, aerial_robot_model::callback_group::SENSOR);
       nhp_ = ros::NodeHandle(nh_, sensor_name);
       indexed_nhp_ = ros::NodeHandle(nh_, sensor_name + std::to_string(index));
 
@@ -447,6 +447,7 @@ namespace aerial_robot_estimation
     /* ros param */
     bool param_verbose_;
     int estimate_mode_; /* main estimte mode */
+    bool intra_process_; /* publish shared pointers to the nodelets in the same process without serialization */
 
     /* robot model (kinematics)  */
     boost::shared_ptr<aerial_robot_model::RobotModel> robot_model_;
@@ -477,7 +478,22 @@ namespace aerial_robot_estimation
     /* latitude & longitude point */
     geographic_msgs::GeoPoint curr_wgs84_poiont_;
 
+    /* preallocated messages, updated in place and published as shared pointers */
+    aerial_robot_msgs::States::Ptr full_state_msg_;
+    nav_msgs::Odometry::Ptr baselink_odom_msg_, cog_odom_msg_;
+
     void statePublish(const ros::TimerEvent & e);
+    /* the preallocated message to be updated, copied only if a subscriber in the same process still holds the last one */
+    template<class T> T& writable(boost::shared_ptr<T>& msg)
+    {
+      if(msg.use_count() > 1) msg = boost::make_shared<T>(*msg);
+      return *msg;
+    }
+    template<class T> void publish(ros::Publisher& pub, const boost::shared_ptr<T>& msg)
+    {
+      if(intra_process_) pub.publish(msg);
+      else pub.publish(*msg);
+    }
     void rosParamInit();
   };
 };
@@ -45,6 +45,7 @@ StateEstimator::StateEstimator()
     flying_flag_(false),
     un_descend_flag_(false),
     force_att_control_flag_(false),
+    intra_process_(false),
     imu_handlers_(0), alt_handlers_(0), vo_handlers_(0), gps_handlers_(0), plane_detection_handlers_(0)
 {
   fuser_[0].resize(0);
@@ -76,6 +77,23 @@ void StateEstimator::initialize(ros::NodeHandle nh, ros::NodeHandle nh_private,
   full_state_pub_ = nh_.advertise<aerial_robot_msgs::States>("uav/full_state", 1);
 
   nhp_.param("tf_prefix", tf_prefix_, std::string(""));
+  nhp_.param("intra_process", intra_process_, false);
+
+  /* message templates, the ids in the order of State */
+  const std::array<std::string, State::TOTAL_NUM> state_ids = {"x_cog", "y_cog", "z_cog", "x_b", "y_b", "z_b",
+                                                               "roll_cog", "pitch_cog", "yaw_cog", "roll_b", "pitch_b", "yaw_b"};
+  full_state_msg_ = boost::make_shared<aerial_robot_msgs::States>();
+  full_state_msg_->states.resize(State::TOTAL_NUM);
+  for(int axis = 0; axis < State::TOTAL_NUM; axis++)
+    {
+      full_state_msg_->states[axis].id = state_ids[axis];
+      full_state_msg_->states[axis].state.resize(3);
+    }
+  baselink_odom_msg_ = boost::make_shared<nav_msgs::Odometry>();
+  baselink_odom_msg_->header.frame_id = std::string("/world");
+  cog_odom_msg_ = boost::make_shared<nav_msgs::Odometry>();
+  cog_odom_msg_->header.frame_id = std::string("/world");
+  cog_odom_msg_->child_frame_id = tf::resolve(tf_prefix_, std::string("cog"));
 
   double rate;
   nhp_.param("state_pub_rate", rate, 100.0);
@@ -85,78 +103,30 @@ void StateEstimator::initialize(ros::NodeHandle nh, ros::NodeHandle nh_private,
 void StateEstimator::statePublish(const ros::TimerEvent & e)
 {
   ros::Time imu_stamp = boost::dynamic_pointer_cast<sensor_plugin::Imu>(imu_handlers_.at(0))->getStamp();
-  aerial_robot_msgs::States full_state;
+  aerial_robot_msgs::States& full_state = writable(full_state_msg_);
   full_state.header.stamp = imu_stamp;
 
   for(int axis = 0; axis < State::TOTAL_NUM; axis++)
     {
-      aerial_robot_msgs::State r_state;
       AxisState state = getState(axis);
-
-      switch(axis)
-        {
-        case State::X_COG:
-          r_state.id = "x_cog";
-          break;
-        case State::Y_COG:
-          r_state.id = "y_cog";
-          break;
-        case State::Z_COG:
-          r_state.id = "z_cog";
-          break;
-        case State::X_BASE:
-          r_state.id = "x_b";
-          break;
-        case State::Y_BASE:
-          r_state.id = "y_b";
-          break;
-        case State::Z_BASE:
-          r_state.id = "z_b";
-          break;
-        case State::ROLL_COG:
-          r_state.id = "roll_cog";
-          break;
-        case State::PITCH_COG:
-          r_state.id = "pitch_cog";
-          break;
-        case State::YAW_COG:
-          r_state.id = "yaw_cog";
-          break;
-        case State::ROLL_BASE:
-          r_state.id = "roll_b";
-          break;
-        case State::PITCH_BASE:
-          r_state.id = "pitch_b";
-          break;
-        case State::YAW_BASE:
-          r_state.id = "yaw_b";
-          break;
-        default:
-          break;
-        }
-      r_state.state.resize(3);
       for(int mode = 0; mode < 3; mode++)
-        tf::vector3TFToMsg(state[mode].second, r_state.state[mode]);
-
-      full_state.states.push_back(r_state);
+        tf::vector3TFToMsg(state[mode].second, full_state.states[axis].state[mode]);
     }
-  full_state_pub_.publish(full_state);
-
-  nav_msgs::Odometry odom_state;
-  odom_state.header.stamp = imu_stamp;
-  odom_state.header.frame_id = std::string("/world");
+  publish(full_state_pub_, full_state_msg_);
 
   /* Baselink */
+  nav_msgs::Odometry& baselink_odom = writable(baselink_odom_msg_);
+  baselink_odom.header.stamp = imu_stamp;
   /* Rotation */
   tf::Quaternion q; getOrientation(Frame::BASELINK, estimate_mode_).getRotation(q);
-  tf::quaternionTFToMsg(q, odom_state.pose.pose.orientation);
-  tf::vector3TFToMsg(getAngularVel(Frame::BASELINK, estimate_mode_), odom_state.twist.twist.angular);
+  tf::quaternionTFToMsg(q, baselink_odom.pose.pose.orientation);
+  tf::vector3TFToMsg(getAngularVel(Frame::BASELINK, estimate_mode_), baselink_odom.twist.twist.angular);
 
   /* Translation */
-  odom_state.child_frame_id = tf::resolve(tf_prefix_, robot_model_->getBaselinkName());
-  tf::pointTFToMsg(getPos(Frame::BASELINK, estimate_mode_), odom_state.pose.pose.position);
-  tf::vector3TFToMsg(getVel(Frame::BASELINK, estimate_mode_), odom_state.twist.twist.linear);
-  baselink_odom_pub_.publish(odom_state);
+  baselink_odom.child_frame_id = tf::resolve(tf_prefix_, robot_model_->getBaselinkName()); // the baselink can be changed
+  tf::pointTFToMsg(getPos(Frame::BASELINK, estimate_mode_), baselink_odom.pose.pose.position);
+  tf::vector3TFToMsg(getVel(Frame::BASELINK, estimate_mode_), baselink_odom.twist.twist.linear);
+  publish(baselink_odom_pub_, baselink_odom_msg_);
 
   /* TF broadcast from world frame */
   tf::Transform root2baselink_tf;
@@ -167,7 +137,7 @@ void StateEstimator::statePublish(const ros::TimerEvent & e)
     root2baselink_tf.setIdentity(); // not initialized
 
   tf::Transform world2baselink_tf;
-  tf::poseMsgToTF(odom_state.pose.pose, world2baselink_tf);
+  tf::poseMsgToTF(baselink_odom.pose.pose, world2baselink_tf);
   geometry_msgs::TransformStamped transformStamped;
   tf::transformStampedTFToMsg(tf::StampedTransform(world2baselink_tf * root2baselink_tf.inverse(),
                                                    imu_stamp, "world",
@@ -176,15 +146,16 @@ void StateEstimator::statePublish(const ros::TimerEvent & e)
   br_.sendTransform(transformStamped);
 
   /* COG */
+  nav_msgs::Odometry& cog_odom = writable(cog_odom_msg_);
+  cog_odom.header.stamp = imu_stamp;
   /* Rotation */
   getOrientation(Frame::COG, estimate_mode_).getRotation(q);
-  tf::quaternionTFToMsg(q, odom_state.pose.pose.orientation);
-  tf::vector3TFToMsg(getAngularVel(Frame::COG, estimate_mode_), odom_state.twist.twist.angular);
+  tf::quaternionTFToMsg(q, cog_odom.pose.pose.orientation);
+  tf::vector3TFToMsg(getAngularVel(Frame::COG, estimate_mode_), cog_odom.twist.twist.angular);
   /* Translation */
-  odom_state.child_frame_id = tf::resolve(tf_prefix_, std::string("cog"));
-  tf::pointTFToMsg(getPos(Frame::COG, estimate_mode_), odom_state.pose.pose.position);
-  tf::vector3TFToMsg(getVel(Frame::COG, estimate_mode_), odom_state.twist.twist.linear);
-  cog_odom_pub_.publish(odom_state);
+  tf::pointTFToMsg(getPos(Frame::COG, estimate_mode_), cog_odom.pose.pose.position);
+  tf::vector3TFToMsg(getVel(Frame::COG, estimate_mode_), cog_odom.twist.twist.linear);
+  publish(cog_odom_pub_, cog_odom_msg_);
 
 }
 
@@ -49,6 +49,7 @@
 #include <kdl/tree.hpp>
 #include <kdl/treefksolverpos_recursive.hpp>
 #include <kdl/treejnttojacsolver.hpp>
+#include <atomic>
 #include <mutex>
 #include <sensor_msgs/JointState.h>
 #include <stdexcept>
@@ -71,7 +72,9 @@ namespace aerial_robot_model {
     // kinematics
     const bool initialized() const { return initialized_; }
     const bool isModelFixed() const {return fixed_model_; }
+    const uint64_t getRevision() const { return revision_; } // incremented in every updateRobotModel
     const std::string getBaselinkName() const { return baselink_; }
+    const std::string& getThrustLinkName() const { return thrust_link_; }
     const std::map<std::string, KDL::RigidBodyInertia>& getInertiaMap() const { return inertia_map_; }
     const double getMass() const { return mass_; }
     const int getRotorNum() const { return rotor_num_; }
@@ -171,6 +174,7 @@ namespace aerial_robot_model {
     // kinematics
     bool initialized_;
     bool fixed_model_;
+    std::atomic<uint64_t> revision_;
     double mass_;
     urdf::Model model_;
     std::string baselink_;
@@ -271,13 +275,16 @@ namespace aerial_robot_model {
       std::lock_guard<std::mutex> lock(mutex_rotor_origin_);
       rotors_origin_from_cog_ = rotors_origin_from_cog;
     }
+    /* without copy and lock, only for updateRobotModelImpl() of the derived models, which is the writer of these caches */
+    const std::vector<KDL::Vector>& getRotorsOriginFromCogCache() const { return rotors_origin_from_cog_; }
+    const std::vector<KDL::Vector>& getRotorsNormalFromCogCache() const { return rotors_normal_from_cog_; }
     void setSegmentsTf(const std::map<std::string, KDL::Frame> seg_tf_map)
     {
       std::lock_guard<std::mutex> lock(mutex_seg_tf_);
       seg_tf_map_ = seg_tf_map;
     }
 
-    void setStaticThrust(const Eigen::VectorXd static_thrust) {static_thrust_ = static_thrust;}
+    void setStaticThrust(const Eigen::VectorXd& static_thrust) {static_thrust_ = static_thrust;}
     void setThrustWrenchMatrix(const Eigen::MatrixXd q_mat) {q_mat_ = q_mat;}
 
   };
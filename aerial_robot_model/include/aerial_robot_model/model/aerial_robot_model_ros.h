@@ -37,26 +37,76 @@
 
 #include <aerial_robot_model/model/aerial_robot_model.h>
 #include <aerial_robot_model/AddExtraModule.h>
+#include <aerial_robot_model/utils/callback_scheduler.h>
+#include <atomic>
+#include <condition_variable>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <memory>
+#include <mutex>
 #include <pluginlib/class_loader.h>
 #include <spinal/DesireCoord.h>
 #include <tf/tf.h>
 #include <tf2_ros/transform_broadcaster.h>
 #include <tf2_ros/static_transform_broadcaster.h>
+#include <thread>
 
 
 namespace aerial_robot_model {
 
+  /* policy of the model update by the joint states, "model_update/mode":
+     - immediate: update in every joint state callback
+     - coalesce: merge the joint states and update once per requestUpdate() from the control loop (or the own timer of "model_update/rate"),
+                 the update runs in the model update thread, not in the caller
+     In both modes, the update is skipped if all joints moved less than "model_update/joint_tolerance" from the last update,
+     and the cog tf for the visualization is limited to "model_update/tf_rate" and broadcast outside the control loop.
+  */
+  namespace model_update
+  {
+    enum {IMMEDIATE = 0, COALESCE = 1};
+  };
+
+  struct ModelUpdateStats
+  {
+    uint64_t received = 0;
+    uint64_t updates = 0;
+    uint64_t coalesced = 0; // joint states merged with the later ones into one update
+    uint64_t skipped = 0; // all joints moved less than the tolerance
+    uint64_t tf_published = 0;
+    double max_update_time = 0; // [sec]
+    double total_update_time = 0; // [sec]
+  };
+
+  /* state of the model after an update, published by the updating thread and read without lock by the others (e.g. telemetry) */
+  struct ModelSnapshot
+  {
+    uint64_t revision = 0;
+    ros::Time stamp; // of the joint state
+    double mass = 0;
+    KDL::Frame cog;
+    KDL::JntArray joint_positions;
+  };
+
   //Transformable Aerial Robot Model with ROS functions
   class RobotModelRos {
   public:
     RobotModelRos(ros::NodeHandle nh, ros::NodeHandle nhp);
-    virtual ~RobotModelRos() = default;
+    virtual ~RobotModelRos();
 
     //public functions
-    sensor_msgs::JointState getJointState() const { return joint_state_; }
+    sensor_msgs::JointState getJointState() const { return joint_state_ ? *joint_state_ : sensor_msgs::JointState(); }
 
     const boost::shared_ptr<aerial_robot_model::RobotModel> getRobotModel() const { return robot_model_; }
 
+    /* apply the pending joint state to the model, return false if there is no update (e.g. in the immediate mode) */
+    bool update();
+    /* coalesce mode: wake up the model update thread to apply the pending joint state, without blocking the caller */
+    void requestUpdate();
+    int getUpdateMode() const { return update_mode_; }
+    /* null before the first update */
+    std::shared_ptr<const ModelSnapshot> getSnapshot() const { return std::atomic_load(&snapshot_); }
+    /* reset_max: restart the measurement of the max update time */
+    ModelUpdateStats getUpdateStats(bool reset_max = false);
+
   private:
     //private attributes
     ros::ServiceServer add_extra_module_service_;
@@ -64,15 +114,45 @@ namespace aerial_robot_model {
     ros::Subscriber joint_state_sub_;
     tf2_ros::TransformBroadcaster br_;
     tf2_ros::StaticTransformBroadcaster static_br_;
-    sensor_msgs::JointState joint_state_;
+    sensor_msgs::JointStateConstPtr joint_state_; // shared with the publisher in the same process, no copy
     ros::NodeHandle nh_;
     ros::NodeHandle nhp_;
     pluginlib::ClassLoader<aerial_robot_model::RobotModel> robot_model_loader_;
     boost::shared_ptr<aerial_robot_model::RobotModel> robot_model_;
     std::string tf_prefix_;
 
+    // update policy
+    int update_mode_;
+    double joint_tolerance_;
+    double tf_period_;
+    std::mutex update_mutex_; // pending and applied joint positions, stats
+    std::mutex model_update_mutex_; // serialize the model update from the callback, control loop and timer
+    KDL::JntArray pending_positions_; // merged joint states, the servo groups may publish partial states
+    ros::Time pending_stamp_;
+    bool pending_;
+    KDL::JntArray applied_positions_;
+    ros::Time applied_stamp_;
+    bool applied_;
+    uint64_t tf_revision_; // model revision of the last cog tf
+    ros::Time tf_stamp_; // time of the last cog tf
+    ModelUpdateStats update_stats_;
+    ros::Timer update_timer_;
+    std::thread update_thread_; // coalesce mode
+    std::mutex request_mutex_;
+    std::condition_variable request_cv_;
+    std::atomic<bool> update_requested_;
+    std::atomic<bool> update_thread_running_;
+    std::shared_ptr<const ModelSnapshot> snapshot_; // exchanged atomically
+    ros::Timer tf_timer_;
+    ros::WallTimer stats_timer_;
+    ros::Publisher diagnostics_pub_;
+
     //private functions
     void jointStateCallback(const sensor_msgs::JointStateConstPtr& state);
+    void updateThreadFunc();
+    void publishSnapshot(const KDL::JntArray& joint_positions, const ros::Time& stamp);
+    void broadcastCog(bool throttle);
+    void statsCallback(const ros::WallTimerEvent& e);
     bool addExtraModuleCallback(aerial_robot_model::AddExtraModule::Request& req, aerial_robot_model::AddExtraModule::Response& res);
     void desireCoordinateCallback(const spinal::DesireCoordConstPtr& msg);
   };
@@ -0,0 +1,138 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <aerial_robot_model/model/transformable_aerial_robot_model.h>
+
+namespace aerial_robot_model {
+  namespace transformable {
+
+    struct TransformationPlannerParams
+    {
+      int segment_num = 10; // the path is optimized on segment_num + 1 waypoints including both ends
+      int max_iteration = 100;
+      double tolerance = 1e-3; // [rad] convergence of the waypoint update
+      double constraint_tolerance = 1e-3; // acceptable violation at the convergence, covered by the margins
+      double max_step = 0.1; // [rad] max update of a joint angle per iteration
+      double damping = 1e-3;
+      double constraint_weight = 100; // initial weight of the violation w.r.t. the smoothness, increased while the violation remains
+      double max_constraint_weight = 1e4;
+      double fc_f_margin = 0; // margins added to the thresholds of the model for the waypoints,
+      double fc_t_margin = 0; // to keep the interpolated path between them inside the limits
+      double thrust_margin = 0; // [N]
+      double joint_torque_rate = 1.0; // usable rate of the effort limit in urdf
+      double joint_vel_rate = 1.0; // usable rate of the velocity limit in urdf
+      double min_segment_du = 0.1; // [sec]
+      double check_resolution = 0.02; // [rad] interval of the final check along the path
+    };
+
+    struct TransformationPlannerStats
+    {
+      int iterations = 0;
+      bool feasible = false; // whole path passes the check
+      double smoothness = 0; // sum of the squared second differences of the waypoints
+      double violation = 0; // squared constraint violation on the waypoints
+      double constraint_weight = 0;
+      double min_fc_f_margin = 0; // min margin along the path w.r.t. the thresholds of the model
+      double min_fc_t_margin = 0;
+      double min_thrust_margin = 0;
+      double min_joint_torque_margin = 0;
+      double plan_time = 0; // sec
+    };
+
+    /* link joint angles along the time, linearly interpolated between the waypoints */
+    struct TransformationTrajectory
+    {
+      std::vector<std::string> joint_names; // link joints
+      std::vector<double> times; // from the start, times.front() = 0
+      std::vector<Eigen::VectorXd> positions;
+
+      bool empty() const { return times.empty(); }
+      double getDuration() const { return times.empty() ? 0 : times.back(); }
+      Eigen::VectorXd getPositions(double t) const;
+      void getPositions(double t, Eigen::Ref<Eigen::VectorXd> positions) const; // without allocation, e.g. into a preallocated message
+    };
+
+    /*
+       Joint space path between two configurations of a transformable robot:
+         min sum_k |q_{k-1} - 2 q_k + q_{k+1}|^2 + w sum_k |min(0, c(q_k))|^2
+       over the inner waypoints q_k of the link joints, where c >= 0 stacks
+         - approx feasible control force / torque distances - thresholds of the model
+         - thrust_max - static thrust, static thrust - thrust_min
+         - effort limit -/+ joint torque
+       with their jacobians from RobotModel::updateJacobians(). The least squares are solved by Gauss-Newton
+       within the joint limits, and the weight w is increased while the violation at the convergence exceeds the tolerance.
+       The path is then checked with the exact values (RobotModel::stabilityCheck, including the robot specific conditions
+       such as the roll/pitch margin of hydrus and the rotor overlap of dragon) at the check resolution,
+       and is time parameterized by the velocity limits in urdf.
+       The other joints (e.g. gimbals) keep the values of the start configuration, or are processed by the model itself.
+    */
+    class TransformationPlanner
+    {
+    public:
+      /* robot_model: dedicated instance for planning, modified in plan() */
+      TransformationPlanner(boost::shared_ptr<RobotModel> robot_model, const TransformationPlannerParams& params = TransformationPlannerParams());
+
+      /* goal: link joint angles in the order of getLinkJointNames(). return false if the path does not pass the check */
+      bool plan(const KDL::JntArray& start, const Eigen::VectorXd& goal);
+
+      const TransformationTrajectory& getTrajectory() const { return trajectory_; }
+      const TransformationPlannerStats& getStats() const { return stats_; }
+      const TransformationPlannerParams& getParams() const { return params_; }
+      void setParams(const TransformationPlannerParams& params) { params_ = params; }
+
+      const std::vector<std::string>& getLinkJointNames() const { return robot_model_->getLinkJointNames(); }
+      boost::shared_ptr<RobotModel> getRobotModel() const { return robot_model_; }
+
+      /* the joint positions of the model with the given link joint angles */
+      KDL::JntArray getJointPositions(const KDL::JntArray& base, const Eigen::VectorXd& link_joint_angles) const;
+
+    private:
+      boost::shared_ptr<RobotModel> robot_model_;
+      TransformationPlannerParams params_;
+      TransformationPlannerStats stats_;
+      TransformationTrajectory trajectory_;
+
+      std::vector<int> link_joint_cols_; // index in getJointNames() of each link joint
+      Eigen::VectorXd lower_limits_, upper_limits_, effort_limits_, vel_limits_;
+
+      void calcConstraints(const KDL::JntArray& joint_positions, Eigen::VectorXd& c, Eigen::MatrixXd& c_jacobian);
+      Eigen::MatrixXd linkJointColumns(const Eigen::MatrixXd& jacobian) const;
+      bool checkPath(const KDL::JntArray& start, const std::vector<Eigen::VectorXd>& waypoints);
+      void timeParameterize(const std::vector<Eigen::VectorXd>& waypoints);
+    };
+  } // namespace transformable
+} //namespace aerial_robot_model
@@ -59,7 +59,9 @@
 
 /* util */
 #include <string>
+#include <unordered_map>
 #include <boost/algorithm/clamp.hpp>
+#include <boost/make_shared.hpp>
 
 using namespace std;
 
@@ -209,6 +211,19 @@ protected:
   map<string, vector<ros::Publisher> > servo_ctrl_sim_pubs_; // TODO: should be actionlib, trajectory controller
 
   map<string, ServoGroupHandler> servos_handler_;
+
+  /* index tables built at configuration time */
+  map<string, unordered_map<int, int> > servo_id_indices_; // servo id -> index in the group
+  map<string, unordered_map<string, int> > servo_name_indices_; // joint name -> index in the group
+  unordered_map<int, SingleServoHandlePtr> common_servo_handles_; // servo id -> handle updated by the common state topic
+  ServoGroupHandler all_servos_; // order of the joint states
+
+  /* preallocated messages, updated in place and published as shared pointers */
+  map<string, spinal::ServoControlCmd::Ptr> servo_ctrl_msgs_;
+  map<string, sensor_msgs::JointState::Ptr> mujoco_ctrl_msgs_;
+  sensor_msgs::JointState::Ptr servo_states_msg_;
+  bool intra_process_; // publish shared pointers to the nodelets in the same process without serialization
+
   double moving_check_rate_;
   double moving_angle_thresh_;
   bool send_init_joint_pose_;
@@ -219,11 +234,25 @@ protected:
   void servoStatesCallback(const spinal::ServoStatesConstPtr& state_msg, const std::string& servo_group_name);
   void servoCtrlCallback(const sensor_msgs::JointStateConstPtr& joints_ctrl_msg, const std::string& servo_group_name);
   bool servoTorqueCtrlCallback(std_srvs::SetBool::Request &req, std_srvs::SetBool::Response &res, const std::string& servo_group_name);
+  void buildIndexTables();
+
+  /* the preallocated message to be updated, copied only if a subscriber in the same process still holds the last one */
+  template<class T> T& writable(boost::shared_ptr<T>& msg)
+  {
+    if(msg.use_count() > 1) msg = boost::make_shared<T>(*msg);
+    return *msg;
+  }
+
+  template<class T> void publish(ros::Publisher& pub, const boost::shared_ptr<T>& msg)
+  {
+    if(intra_process_) pub.publish(msg);
+    else pub.publish(*msg);
+  }
 
 public:
   ServoBridge(ros::NodeHandle nh, ros::NodeHandle nhp);
   ~ServoBridge()  {}
-  void servoStatePublish();
+  void servoStatePublish(const ros::Time& stamp);
 
 };
 
@@ -0,0 +1,140 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+namespace aerial_robot_model {
+
+  namespace callback_group
+  {
+    enum {SENSOR = 0, MODEL = 1, COMMAND = 2, DIAGNOSTICS = 3, TOTAL_NUM = 4};
+  };
+
+  struct CallbackGroupStats
+  {
+    uint64_t enqueued = 0;
+    uint64_t called = 0;
+    uint64_t dropped = 0;  // messages overwritten in the subscriber queue before their callback was called
+    uint64_t depth = 0;    // callbacks waiting in the queue
+    uint64_t max_depth = 0;
+    double max_latency = 0; // [sec] from the enqueue to the start of the callback
+  };
+
+  /* callback queue with its own threads, priority and cpu affinity */
+  class CallbackGroup : public ros::CallbackQueue
+  {
+  public:
+    CallbackGroup(const std::string& name, int threads, int priority, const std::vector<int>& affinity);
+    ~CallbackGroup();
+
+    void addCallback(const ros::CallbackInterfacePtr& callback, uint64_t owner_id = 0) override;
+
+    void start();
+    void stop();
+
+    const std::string& getName() const { return name_; }
+    int getThreadNum() const { return thread_num_; }
+    int getPriority() const { return priority_; }
+    /* reset_max: restart the measurement of the max depth and latency */
+    CallbackGroupStats getStats(bool reset_max = false);
+
+  private:
+    class MeasuredCallback;
+
+    std::string name_;
+    int thread_num_;
+    int priority_;
+    std::vector<int> affinity_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_;
+
+    std::mutex stats_mutex_;
+    CallbackGroupStats stats_;
+
+    void threadFunc();
+    void callbackDone(const ros::WallTime& enqueue_stamp, const ros::WallTime& start_stamp, bool dropped);
+    void callbackRemoved();
+  };
+
+  /* Dedicated callback queues and threads per class of callbacks, configured by "callback_groups/<group>/{threads, priority, affinity}":
+     - sensor: high-rate sensors (imu, mocap, gps, ...)
+     - model: joint states and robot model
+     - command: navigation commands, joystick, flight config, gains and dynamic reconfigure
+     - diagnostics: statistics and monitoring
+     The plugins get the node handle of their group with nodeHandle(), and the queue depth, latency and drop counts of each group are published in "diagnostics".
+     Each scheduler serves the node handles sharing the callback queue of its own node handle, so several nodelets in one manager keep separate groups.
+  */
+  class CallbackScheduler
+  {
+  public:
+    CallbackScheduler(ros::NodeHandle nh, ros::NodeHandle nhp);
+    ~CallbackScheduler();
+
+    /* stop the threads, the queues are kept until the destruction for the subscribers still referring to them */
+    void stop();
+
+    /* node handle whose subscribers, services and timers are called in the given group of the scheduler owning the queue of nh,
+       or nh itself if there is no such scheduler (e.g. callback groups disabled or unit test) */
+    static ros::NodeHandle nodeHandle(const ros::NodeHandle& nh, int group);
+
+    CallbackGroup* getGroup(int group) const { return groups_.at(group).get(); }
+
+  private:
+    /* running schedulers by the callback queue of their node handle, e.g. the one of each nodelet */
+    static std::mutex instances_mutex_;
+    static std::map<ros::CallbackQueueInterface*, CallbackScheduler*> instances_;
+    ros::CallbackQueueInterface* owner_queue_;
+
+    ros::NodeHandle nh_;
+    ros::NodeHandle nhp_;
+    ros::Publisher diagnostics_pub_;
+    ros::WallTimer stats_timer_;
+    std::vector<std::unique_ptr<CallbackGroup> > groups_;
+    std::vector<uint64_t> prev_dropped_;
+
+    void statsCallback(const ros::WallTimerEvent& e);
+  };
+} //namespace aerial_robot_model
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <Eigen/Dense>
@@ -40,9 +42,10 @@ namespace aerial_robot_model {
     return skew_mat;
   }
 
+  // log(1 + exp(x * epsilon)) / epsilon, shifted by max(x, 0) to avoid overflow with a large epsilon
   inline double reluApprox(double x, double epsilon = 10)
   {
-    return std::log(1 + std::exp(x * epsilon)) / epsilon;
+    return std::max(x, 0.0) + std::log1p(std::exp(- std::abs(x) * epsilon)) / epsilon;
   }
 
   // differential of reluApprox
@@ -51,17 +54,26 @@ namespace aerial_robot_model {
     return 1 / (1 + std::exp(- x * epsilon));
   }
 
+  // log(exp(- x * epsilon) + exp(x * epsilon)) / epsilon, shifted by |x| to avoid overflow with a large epsilon
   inline double absApprox(double x, double epsilon = 10)
   {
-    return std::log(std::exp(- x * epsilon) + std::exp(x * epsilon)) / epsilon;
+    return std::abs(x) + std::log1p(std::exp(- 2 * std::abs(x) * epsilon)) / epsilon;
   }
 
   // differential of absApprox
   inline double tanh(double x, double epsilon = 10)
   {
-    double a = std::exp(-x * epsilon);
-    double b = std::exp(x * epsilon);
-    return (b - a) / (b + a);
+    return std::tanh(x * epsilon);
+  }
+
+  // smooth approximation of min(x) by log-sum-exp, the differential w.r.t. x is stored in grad
+  inline double softmin(const Eigen::VectorXd& x, Eigen::VectorXd& grad, double epsilon = 10)
+  {
+    const double x_min = x.minCoeff();
+    grad = (- epsilon * (x.array() - x_min)).exp().matrix(); // shift by the minimum to avoid overflow
+    const double sum = grad.sum();
+    grad /= sum;
+    return x_min - std::log(sum) / epsilon;
   }
 
 
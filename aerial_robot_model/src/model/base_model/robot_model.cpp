@@ -15,7 +15,8 @@ namespace aerial_robot_model {
     thrust_max_(0),
     thrust_min_(0),
     mass_(0),
-    initialized_(false)
+    initialized_(false),
+    revision_(0)
   {
     if (init_with_rosparam)
       getParamFromRos();
@@ -318,11 +319,13 @@ namespace aerial_robot_model {
     KDL::JntArray dummy_joint_positions(tree_.getNrOfJoints());
     KDL::SetToZero(dummy_joint_positions);
     updateRobotModelImpl(dummy_joint_positions);
+    revision_++;
   }
 
   void RobotModel::updateRobotModel(const KDL::JntArray& joint_positions)
   {
     updateRobotModelImpl(joint_positions);
+    revision_++;
   }
 
   void RobotModel::updateRobotModel(const sensor_msgs::JointState& state)
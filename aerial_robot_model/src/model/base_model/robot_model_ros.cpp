@@ -2,9 +2,17 @@
 
 namespace aerial_robot_model {
   RobotModelRos::RobotModelRos(ros::NodeHandle nh, ros::NodeHandle nhp):
-    nh_(nh),
+    nh_(CallbackScheduler::nodeHandle(nh, callback_group::MODEL)),
     nhp_(nhp),
-    robot_model_loader_("aerial_robot_model", "aerial_robot_model::RobotModel")
+    robot_model_loader_("aerial_robot_model", "aerial_robot_model::RobotModel"),
+    update_mode_(model_update::IMMEDIATE),
+    joint_tolerance_(0),
+    tf_period_(0),
+    pending_(false),
+    applied_(false),
+    tf_revision_(0),
+    update_requested_(false),
+    update_thread_running_(false)
   {
     // rosparam
     nhp_.param("tf_prefix", tf_prefix_, std::string(""));
@@ -36,27 +44,205 @@ namespace aerial_robot_model {
       tf.header.frame_id = tf::resolve(tf_prefix_, robot_model_->getRootFrameName());
       tf.child_frame_id = tf::resolve(tf_prefix_, std::string("cog"));
       static_br_.sendTransform(tf);
+
+      publishSnapshot(robot_model_->getJointPositions(), tf.header.stamp);
     }
     else {
+      ros::NodeHandle update_nh(nhp_, "model_update");
+      update_nh.param("mode", update_mode_, (int)model_update::IMMEDIATE);
+      update_nh.param("joint_tolerance", joint_tolerance_, 0.0);
+      // 0: broadcast in every update, only in the immediate mode to keep the tf out of the control loop
+      double tf_rate, update_rate, stats_rate;
+      update_nh.param("tf_rate", tf_rate, update_mode_ == model_update::COALESCE ? 20.0 : 0.0);
+      update_nh.param("rate", update_rate, 0.0);
+      update_nh.param("stats_rate", stats_rate, 1.0);
+      if(update_mode_ == model_update::COALESCE && tf_rate <= 0)
+        {
+          ROS_WARN("[model update] tf_rate should be positive in the coalesce mode, use 20 Hz");
+          tf_rate = 20.0;
+        }
+      tf_period_ = tf_rate > 0 ? 1.0 / tf_rate : 0;
+
+      pending_positions_ = KDL::JntArray(robot_model_->getTree().getNrOfJoints());
       joint_state_sub_ = nh_.subscribe("joint_states", 1, &RobotModelRos::jointStateCallback, this);
+
+      if(update_mode_ == model_update::COALESCE)
+        {
+          // without the control loop calling update() (e.g. standalone nodelet)
+          if(update_rate > 0)
+            update_timer_ = nh_.createTimer(ros::Duration(1.0 / update_rate), [this](const ros::TimerEvent& e) { update(); });
+          tf_timer_ = nh_.createTimer(ros::Duration(tf_period_), [this](const ros::TimerEvent& e) { broadcastCog(false); });
+
+          update_thread_running_ = true;
+          update_thread_ = std::thread(&RobotModelRos::updateThreadFunc, this);
+        }
+
+      diagnostics_pub_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", 1);
+      if(stats_rate > 0)
+        stats_timer_ = CallbackScheduler::nodeHandle(nhp_, callback_group::DIAGNOSTICS).createWallTimer(ros::WallDuration(1.0 / stats_rate), &RobotModelRos::statsCallback, this);
     }
 
     desire_coordinate_sub_ = nh_.subscribe("desire_coordinate", 1, &RobotModelRos::desireCoordinateCallback, this);
     add_extra_module_service_ = nh_.advertiseService("add_extra_module", &RobotModelRos::addExtraModuleCallback, this);
  }
 
+  RobotModelRos::~RobotModelRos()
+  {
+    if(!update_thread_.joinable()) return;
+    update_thread_running_ = false;
+    request_cv_.notify_one();
+    update_thread_.join();
+  }
+
   void RobotModelRos::jointStateCallback(const sensor_msgs::JointStateConstPtr& state)
   {
-    joint_state_ = *state;
-    robot_model_->updateRobotModel(*state);
+    {
+      std::lock_guard<std::mutex> lock(update_mutex_);
+      joint_state_ = state;
+      update_stats_.received++;
+      if(pending_) update_stats_.coalesced++;
+
+      const auto& joint_index_map = robot_model_->getJointIndexMap();
+      for(unsigned int i = 0; i < state->name.size() && i < state->position.size(); ++i)
+        {
+          auto itr = joint_index_map.find(state->name[i]);
+          if(itr != joint_index_map.end()) pending_positions_(itr->second) = state->position[i];
+        }
+      pending_stamp_ = state->header.stamp;
+      pending_ = true;
+    }
+
+    if(update_mode_ == model_update::IMMEDIATE && update()) broadcastCog(true);
+  }
+
+  bool RobotModelRos::update()
+  {
+    std::lock_guard<std::mutex> model_lock(model_update_mutex_);
+
+    KDL::JntArray joint_positions;
+    ros::Time stamp;
+    {
+      std::lock_guard<std::mutex> lock(update_mutex_);
+      if(!pending_) return false;
+      pending_ = false;
+
+      if(applied_ && joint_tolerance_ > 0 &&
+         (pending_positions_.data - applied_positions_.data).cwiseAbs().maxCoeff() < joint_tolerance_)
+        {
+          update_stats_.skipped++;
+          return false;
+        }
+
+      joint_positions = pending_positions_;
+      stamp = pending_stamp_;
+    }
+
+    const ros::WallTime start = ros::WallTime::now();
+    robot_model_->updateRobotModel(joint_positions);
+    const double update_time = (ros::WallTime::now() - start).toSec();
+
+    publishSnapshot(joint_positions, stamp);
+
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    applied_positions_ = joint_positions;
+    applied_stamp_ = stamp;
+    applied_ = true;
+    update_stats_.updates++;
+    update_stats_.total_update_time += update_time;
+    update_stats_.max_update_time = std::max(update_stats_.max_update_time, update_time);
+    return true;
+  }
+
+  void RobotModelRos::requestUpdate()
+  {
+    // no lock in the caller, a wake-up lost between the check and the wait of the update thread is covered by its timeout
+    update_requested_ = true;
+    request_cv_.notify_one();
+  }
+
+  void RobotModelRos::updateThreadFunc()
+  {
+    while(update_thread_running_)
+      {
+        {
+          std::unique_lock<std::mutex> lock(request_mutex_);
+          request_cv_.wait_for(lock, std::chrono::milliseconds(10), [this] { return update_requested_ || !update_thread_running_; });
+        }
+        if(update_requested_.exchange(false)) update();
+      }
+  }
+
+  void RobotModelRos::publishSnapshot(const KDL::JntArray& joint_positions, const ros::Time& stamp)
+  {
+    auto snapshot = std::make_shared<ModelSnapshot>();
+    snapshot->revision = robot_model_->getRevision();
+    snapshot->stamp = stamp;
+    snapshot->mass = robot_model_->getMass();
+    snapshot->cog = robot_model_->getCog<KDL::Frame>();
+    snapshot->joint_positions = joint_positions;
+    std::atomic_store(&snapshot_, std::shared_ptr<const ModelSnapshot>(snapshot));
+  }
+
+  void RobotModelRos::broadcastCog(bool throttle)
+  {
+    ros::Time stamp;
+    {
+      std::lock_guard<std::mutex> lock(update_mutex_);
+      if(!applied_ || robot_model_->getRevision() == tf_revision_) return;
+      const ros::Time now = ros::Time::now();
+      if(throttle && tf_period_ > 0 && (now - tf_stamp_).toSec() < tf_period_) return;
+      tf_revision_ = robot_model_->getRevision();
+      tf_stamp_ = now;
+      stamp = applied_stamp_;
+      update_stats_.tf_published++;
+    }
 
     geometry_msgs::TransformStamped tf = robot_model_->getCog<geometry_msgs::TransformStamped>();
-    tf.header = state->header;
+    tf.header.stamp = stamp;
     tf.header.frame_id = tf::resolve(tf_prefix_, robot_model_->getRootFrameName());
     tf.child_frame_id = tf::resolve(tf_prefix_, std::string("cog"));
     br_.sendTransform(tf);
   }
 
+  ModelUpdateStats RobotModelRos::getUpdateStats(bool reset_max)
+  {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    ModelUpdateStats stats = update_stats_;
+    if(reset_max) update_stats_.max_update_time = 0;
+    return stats;
+  }
+
+  void RobotModelRos::statsCallback(const ros::WallTimerEvent& e)
+  {
+    ModelUpdateStats stats = getUpdateStats(true);
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "robot_model: update";
+    status.hardware_id = nh_.getNamespace();
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = update_mode_ == model_update::COALESCE ? "coalesce" : "immediate";
+
+    auto add_value = [&status](const std::string& key, const std::string& value)
+      {
+        diagnostic_msgs::KeyValue kv;
+        kv.key = key;
+        kv.value = value;
+        status.values.push_back(kv);
+      };
+    add_value("received", std::to_string(stats.received));
+    add_value("updates", std::to_string(stats.updates));
+    add_value("coalesced", std::to_string(stats.coalesced));
+    add_value("skipped", std::to_string(stats.skipped));
+    add_value("tf_published", std::to_string(stats.tf_published));
+    add_value("max_update_time_ms", std::to_string(stats.max_update_time * 1000));
+    add_value("mean_update_time_ms", std::to_string(stats.updates > 0 ? stats.total_update_time / stats.updates * 1000 : 0));
+
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    msg.status.push_back(status);
+    diagnostics_pub_.publish(msg);
+  }
+
   bool RobotModelRos::addExtraModuleCallback(aerial_robot_model::AddExtraModule::Request &req, aerial_robot_model::AddExtraModule::Response &res)
   {
     switch(req.action)
@@ -0,0 +1,287 @@
+#include <aerial_robot_model/model/transformation_planner.h>
+#include <algorithm>
+
+using namespace aerial_robot_model::transformable;
+
+Eigen::VectorXd TransformationTrajectory::getPositions(double t) const
+{
+  if(t <= times.front()) return positions.front();
+  if(t >= times.back()) return positions.back();
+
+  const int k = std::upper_bound(times.begin(), times.end(), t) - times.begin() - 1;
+  const double s = (t - times.at(k)) / (times.at(k + 1) - times.at(k));
+  return (1 - s) * positions.at(k) + s * positions.at(k + 1);
+}
+
+void TransformationTrajectory::getPositions(double t, Eigen::Ref<Eigen::VectorXd> positions) const
+{
+  if(t <= times.front()) { positions = this->positions.front(); return; }
+  if(t >= times.back()) { positions = this->positions.back(); return; }
+
+  const int k = std::upper_bound(times.begin(), times.end(), t) - times.begin() - 1;
+  const double s = (t - times.at(k)) / (times.at(k + 1) - times.at(k));
+  positions.noalias() = (1 - s) * this->positions.at(k) + s * this->positions.at(k + 1);
+}
+
+TransformationPlanner::TransformationPlanner(boost::shared_ptr<RobotModel> robot_model, const TransformationPlannerParams& params):
+  robot_model_(robot_model), params_(params)
+{
+  const auto& link_joint_names = robot_model_->getLinkJointNames();
+  const auto& joint_names = robot_model_->getJointNames();
+  const int link_joint_num = link_joint_names.size();
+
+  lower_limits_.resize(link_joint_num);
+  upper_limits_.resize(link_joint_num);
+  effort_limits_.resize(link_joint_num);
+  vel_limits_.resize(link_joint_num);
+  for(int i = 0; i < link_joint_num; i++)
+    {
+      const std::string& name = link_joint_names.at(i);
+      link_joint_cols_.push_back(std::find(joint_names.begin(), joint_names.end(), name) - joint_names.begin());
+
+      lower_limits_(i) = robot_model_->getLinkJointLowerLimits().at(i);
+      upper_limits_(i) = robot_model_->getLinkJointUpperLimits().at(i);
+
+      // no check for the limit without the value in urdf
+      const auto limits = robot_model_->getUrdfModel().getJoint(name)->limits;
+      effort_limits_(i) = (limits && limits->effort > 0) ? limits->effort : 0;
+      vel_limits_(i) = (limits && limits->velocity > 0) ? limits->velocity : 0;
+      if(vel_limits_(i) == 0)
+        ROS_WARN_STREAM("[transformation planner] no velocity limit of " << name << " in urdf, the time is given by min_segment_du");
+    }
+  trajectory_.joint_names = link_joint_names;
+}
+
+KDL::JntArray TransformationPlanner::getJointPositions(const KDL::JntArray& base, const Eigen::VectorXd& link_joint_angles) const
+{
+  KDL::JntArray joint_positions = base;
+  const auto& link_joint_indices = robot_model_->getLinkJointIndices();
+  for(int i = 0; i < link_joint_indices.size(); i++)
+    joint_positions(link_joint_indices.at(i)) = link_joint_angles(i);
+  return joint_positions;
+}
+
+Eigen::MatrixXd TransformationPlanner::linkJointColumns(const Eigen::MatrixXd& jacobian) const
+{
+  // the columns are the root 6dof and all joints, or the root 6dof and only the link joints (e.g. dragon with the gimbals processed)
+  const int link_joint_num = link_joint_cols_.size();
+  if(jacobian.cols() != 6 + robot_model_->getJointNum()) return jacobian.rightCols(link_joint_num);
+
+  Eigen::MatrixXd link_jacobian(jacobian.rows(), link_joint_num);
+  for(int i = 0; i < link_joint_num; i++)
+    link_jacobian.col(i) = jacobian.col(6 + link_joint_cols_.at(i));
+  return link_jacobian;
+}
+
+void TransformationPlanner::calcConstraints(const KDL::JntArray& joint_positions, Eigen::VectorXd& c, Eigen::MatrixXd& c_jacobian)
+{
+  robot_model_->updateJacobians(joint_positions);
+
+  const Eigen::VectorXd& fc_f_dists = robot_model_->getApproxFeasibleControlFDists();
+  const Eigen::VectorXd& fc_t_dists = robot_model_->getApproxFeasibleControlTDists();
+  const Eigen::VectorXd& lambda = robot_model_->getStaticThrust();
+  const Eigen::VectorXd& joint_torque = robot_model_->getJointTorque();
+  const Eigen::MatrixXd lambda_jacobian = linkJointColumns(robot_model_->getLambdaJacobian());
+  const Eigen::MatrixXd joint_torque_jacobian = linkJointColumns(robot_model_->getJointTorqueJacobian());
+  const int link_joint_num = link_joint_cols_.size();
+  const int rotor_num = lambda.size();
+
+  c.resize(fc_f_dists.size() + fc_t_dists.size() + 2 * rotor_num + 2 * link_joint_num);
+  c_jacobian.resize(c.size(), link_joint_num);
+
+  int row = 0;
+  c.segment(row, fc_f_dists.size()) = fc_f_dists.array() - robot_model_->getFeasibleControlFMinThre() - params_.fc_f_margin;
+  c_jacobian.middleRows(row, fc_f_dists.size()) = linkJointColumns(robot_model_->getFeasibleControlFDistsJacobian());
+  row += fc_f_dists.size();
+
+  c.segment(row, fc_t_dists.size()) = fc_t_dists.array() - robot_model_->getFeasibleControlTMinThre() - params_.fc_t_margin;
+  c_jacobian.middleRows(row, fc_t_dists.size()) = linkJointColumns(robot_model_->getFeasibleControlTDistsJacobian());
+  row += fc_t_dists.size();
+
+  c.segment(row, rotor_num) = (robot_model_->getThrustUpperLimit() - params_.thrust_margin) - lambda.array();
+  c_jacobian.middleRows(row, rotor_num) = -lambda_jacobian;
+  row += rotor_num;
+  c.segment(row, rotor_num) = lambda.array() - (robot_model_->getThrustLowerLimit() + params_.thrust_margin);
+  c_jacobian.middleRows(row, rotor_num) = lambda_jacobian;
+  row += rotor_num;
+
+  for(int i = 0; i < link_joint_num; i++, row += 2)
+    {
+      if(effort_limits_(i) == 0)
+        {
+          // always satisfied without the effort limit
+          c.segment(row, 2).setOnes();
+          c_jacobian.middleRows(row, 2).setZero();
+          continue;
+        }
+
+      const double limit = params_.joint_torque_rate * effort_limits_(i);
+      const double tau = joint_torque(link_joint_cols_.at(i));
+      c(row) = limit - tau;
+      c(row + 1) = limit + tau;
+      c_jacobian.row(row) = -joint_torque_jacobian.row(link_joint_cols_.at(i));
+      c_jacobian.row(row + 1) = joint_torque_jacobian.row(link_joint_cols_.at(i));
+    }
+}
+
+bool TransformationPlanner::plan(const KDL::JntArray& start, const Eigen::VectorXd& goal)
+{
+  const ros::WallTime start_stamp = ros::WallTime::now();
+  stats_ = TransformationPlannerStats();
+  trajectory_.times.clear();
+  trajectory_.positions.clear();
+
+  const int n = link_joint_cols_.size();
+  const int segment_num = std::max(params_.segment_num, 1);
+  const int inner_num = segment_num - 1;
+  if(goal.size() != n)
+    {
+      ROS_ERROR("[transformation planner] the size of the goal %ld is not equal to the link joint num %d", goal.size(), n);
+      return false;
+    }
+  if((goal.array() < lower_limits_.array()).any() || (goal.array() > upper_limits_.array()).any())
+    {
+      ROS_ERROR("[transformation planner] the goal is out of the joint limits");
+      return false;
+    }
+
+  const auto& link_joint_indices = robot_model_->getLinkJointIndices();
+  Eigen::VectorXd q_start(n);
+  for(int i = 0; i < n; i++) q_start(i) = start(link_joint_indices.at(i));
+
+  // initial path: linear interpolation
+  std::vector<Eigen::VectorXd> waypoints(segment_num + 1);
+  for(int k = 0; k <= segment_num; k++)
+    waypoints.at(k) = q_start + (goal - q_start) * k / (double)segment_num;
+
+  // smoothness: the second differences of the inner waypoints, with the fixed ends
+  const int dim = n * inner_num;
+  Eigen::MatrixXd h_smooth = Eigen::MatrixXd::Zero(dim, dim);
+  for(int k = 0; k < segment_num - 1; k++)
+    {
+      // second difference at the waypoint k + 1: x_{k} - 2 x_{k+1} + x_{k+2}, the inner waypoint k + 1 is x(k)
+      const double coeff[3] = {1, -2, 1};
+      for(int a = 0; a < 3; a++)
+        for(int b = 0; b < 3; b++)
+          {
+            const int ia = k + a - 1, ib = k + b - 1;
+            if(ia < 0 || ia >= inner_num || ib < 0 || ib >= inner_num) continue;
+            h_smooth.block(ia * n, ib * n, n, n).diagonal().array() += coeff[a] * coeff[b];
+          }
+    }
+
+  double weight = params_.constraint_weight;
+  Eigen::VectorXd c;
+  Eigen::MatrixXd c_jacobian;
+  for(stats_.iterations = 0; stats_.iterations < params_.max_iteration && inner_num > 0; stats_.iterations++)
+    {
+      Eigen::VectorXd g = Eigen::VectorXd::Zero(dim);
+      stats_.smoothness = 0;
+      for(int k = 1; k < segment_num; k++)
+        {
+          const Eigen::VectorXd r = waypoints.at(k - 1) - 2 * waypoints.at(k) + waypoints.at(k + 1);
+          stats_.smoothness += r.squaredNorm();
+          if(k > 1) g.segment((k - 2) * n, n) += r;
+          g.segment((k - 1) * n, n) -= 2 * r;
+          if(k < inner_num) g.segment(k * n, n) += r;
+        }
+
+      Eigen::MatrixXd h = h_smooth;
+      h.diagonal().array() += params_.damping;
+      stats_.violation = 0;
+      double max_violation = 0;
+      for(int k = 0; k < inner_num; k++)
+        {
+          calcConstraints(getJointPositions(start, waypoints.at(k + 1)), c, c_jacobian);
+          for(int i = 0; i < c.size(); i++)
+            {
+              if(c(i) >= 0) continue;
+              stats_.violation += c(i) * c(i);
+              max_violation = std::max(max_violation, -c(i));
+              h.block(k * n, k * n, n, n).noalias() += weight * c_jacobian.row(i).transpose() * c_jacobian.row(i);
+              g.segment(k * n, n) += weight * c(i) * c_jacobian.row(i).transpose();
+            }
+        }
+
+      Eigen::VectorXd dx = -h.ldlt().solve(g);
+      if(dx.cwiseAbs().maxCoeff() > params_.max_step) dx *= params_.max_step / dx.cwiseAbs().maxCoeff();
+
+      double max_dx = 0; // the actual update within the joint limits
+      for(int k = 0; k < inner_num; k++)
+        {
+          const Eigen::VectorXd w = (waypoints.at(k + 1) + dx.segment(k * n, n)).cwiseMax(lower_limits_).cwiseMin(upper_limits_);
+          max_dx = std::max(max_dx, (w - waypoints.at(k + 1)).cwiseAbs().maxCoeff());
+          waypoints.at(k + 1) = w;
+        }
+
+      if(max_dx < params_.tolerance)
+        {
+          if(max_violation <= params_.constraint_tolerance) break;
+          // converged to the balance with the smoothness, emphasize the violation
+          if(weight >= params_.max_constraint_weight) break;
+          weight = std::min(weight * 10, params_.max_constraint_weight);
+        }
+    }
+  stats_.constraint_weight = weight;
+
+  stats_.feasible = checkPath(start, waypoints);
+  if(stats_.feasible) timeParameterize(waypoints);
+  stats_.plan_time = (ros::WallTime::now() - start_stamp).toSec();
+
+  return stats_.feasible;
+}
+
+bool TransformationPlanner::checkPath(const KDL::JntArray& start, const std::vector<Eigen::VectorXd>& waypoints)
+{
+  stats_.min_fc_f_margin = stats_.min_fc_t_margin = stats_.min_thrust_margin = stats_.min_joint_torque_margin = 1e6;
+
+  bool feasible = true;
+  for(int k = 0; k + 1 < waypoints.size(); k++)
+    {
+      const Eigen::VectorXd delta = waypoints.at(k + 1) - waypoints.at(k);
+      const int sample_num = std::max(1, (int)std::ceil(delta.cwiseAbs().maxCoeff() / params_.check_resolution));
+      for(int s = (k == 0 ? 0 : 1); s <= sample_num; s++)
+        {
+          robot_model_->updateRobotModel(getJointPositions(start, waypoints.at(k) + delta * s / (double)sample_num));
+          if(!robot_model_->stabilityCheck(false)) feasible = false;
+
+          const Eigen::VectorXd& lambda = robot_model_->getStaticThrust();
+          stats_.min_fc_f_margin = std::min(stats_.min_fc_f_margin, robot_model_->getFeasibleControlFMin() - robot_model_->getFeasibleControlFMinThre());
+          stats_.min_fc_t_margin = std::min(stats_.min_fc_t_margin, robot_model_->getFeasibleControlTMin() - robot_model_->getFeasibleControlTMinThre());
+          stats_.min_thrust_margin = std::min({stats_.min_thrust_margin,
+                robot_model_->getThrustUpperLimit() - lambda.maxCoeff(), lambda.minCoeff() - robot_model_->getThrustLowerLimit()});
+
+          if(effort_limits_.maxCoeff() == 0) continue;
+          robot_model_->calcJointTorque(true);
+          const Eigen::VectorXd& joint_torque = robot_model_->getJointTorque();
+          for(int i = 0; i < link_joint_cols_.size(); i++)
+            {
+              if(effort_limits_(i) == 0) continue;
+              const double margin = params_.joint_torque_rate * effort_limits_(i) - std::abs(joint_torque(link_joint_cols_.at(i)));
+              stats_.min_joint_torque_margin = std::min(stats_.min_joint_torque_margin, margin);
+              if(margin < 0) feasible = false;
+            }
+        }
+    }
+
+  return feasible;
+}
+
+void TransformationPlanner::timeParameterize(const std::vector<Eigen::VectorXd>& waypoints)
+{
+  trajectory_.times.assign(1, 0);
+  trajectory_.positions.assign(1, waypoints.front());
+
+  for(int k = 0; k + 1 < waypoints.size(); k++)
+    {
+      const Eigen::VectorXd delta = (waypoints.at(k + 1) - waypoints.at(k)).cwiseAbs();
+      if(delta.maxCoeff() == 0) continue;
+
+      double du = params_.min_segment_du;
+      for(int i = 0; i < delta.size(); i++)
+        if(vel_limits_(i) > 0) du = std::max(du, delta(i) / (params_.joint_vel_rate * vel_limits_(i)));
+
+      trajectory_.times.push_back(trajectory_.times.back() + du);
+      trajectory_.positions.push_back(waypoints.at(k + 1));
+    }
+}
@@ -40,6 +40,7 @@ ServoBridge::ServoBridge(ros::NodeHandle nh, ros::NodeHandle nhp): nh_(nh),nhp_(
 {
   nh_.param("/use_sim_time", simulation_mode_, false);
   nhp_.param("use_mujoco", use_mujoco_, false);
+  nhp_.param("intra_process", intra_process_, false);
   if(use_mujoco_)
     {
       ROS_WARN("use mujoco simulator");
@@ -70,7 +71,7 @@ ServoBridge::ServoBridge(ros::NodeHandle nh, ros::NodeHandle nhp): nh_(nh),nhp_(
   servo_states_subs_.insert(make_pair("common", nh_.subscribe<spinal::ServoStates>(state_sub_topic, 10, boost::bind(&ServoBridge::servoStatesCallback, this, _1, "common"))));
   /* common publisher: target servo state to real machine (spinal_ros_bridge) */
   servo_ctrl_pubs_.insert(make_pair("common", nh_.advertise<spinal::ServoControlCmd>(ctrl_pub_topic, 1)));
-  mujoco_control_input_pub_ = nh_.advertise<sensor_msgs::JointState>("mujoco/ctrl_input", 1);
+  if(use_mujoco_) mujoco_control_input_pub_ = nh_.advertise<sensor_msgs::JointState>("mujoco/ctrl_input", 1);
   /* common publisher: torque on/off command */
   servo_torque_ctrl_pubs_.insert(make_pair("common", nh_.advertise<spinal::ServoTorqueCmd>(torque_pub_topic, 1)));
 
@@ -213,27 +214,76 @@ ServoBridge::ServoBridge(ros::NodeHandle nh, ros::NodeHandle nhp): nh_(nh),nhp_(
       servos_handler_.insert(make_pair(servo_group_params.first, servo_group_handler));
     }
 
+  buildIndexTables();
+
   if(!simulation_mode_) servo_states_pub_ = nh_.advertise<sensor_msgs::JointState>("joint_states", 1);
 }
 
+void ServoBridge::buildIndexTables()
+{
+  for(const auto& servo_group: servos_handler_)
+    {
+      const string& group_name = servo_group.first;
+      const ServoGroupHandler& servo_group_handler = servo_group.second;
+
+      auto& id_indices = servo_id_indices_[group_name];
+      auto& name_indices = servo_name_indices_[group_name];
+      for(int i = 0; i < servo_group_handler.size(); i++)
+        {
+          if(!id_indices.emplace(servo_group_handler.at(i)->getId(), i).second)
+            ROS_WARN("[servo bridge]: duplicated servo index %d in group %s", servo_group_handler.at(i)->getId(), group_name.c_str());
+          name_indices.emplace(servo_group_handler.at(i)->getName(), i);
+        }
+
+      /* servos updated by the common state topic, the first group has priority for the same index */
+      if(!no_real_state_flags_.at(group_name) && servo_states_subs_.find(group_name) == servo_states_subs_.end())
+        {
+          for(const auto& servo_handler: servo_group_handler)
+            common_servo_handles_.emplace(servo_handler->getId(), servo_handler);
+        }
+
+      /* command templates in the predefined order */
+      servo_ctrl_msgs_[group_name] = boost::make_shared<spinal::ServoControlCmd>();
+      mujoco_ctrl_msgs_[group_name] = boost::make_shared<sensor_msgs::JointState>();
+      spinal::ServoControlCmd& target_angle_msg = *servo_ctrl_msgs_[group_name];
+      sensor_msgs::JointState& mujoco_control_input_msg = *mujoco_ctrl_msgs_[group_name];
+      for(const auto& servo_handler: servo_group_handler)
+        {
+          target_angle_msg.index.push_back(servo_handler->getId());
+          target_angle_msg.angles.push_back(0);
+          mujoco_control_input_msg.name.push_back(servo_handler->getName());
+          mujoco_control_input_msg.position.push_back(0);
+          all_servos_.push_back(servo_handler);
+        }
+    }
+
+  /* joint state template of all groups */
+  servo_states_msg_ = boost::make_shared<sensor_msgs::JointState>();
+  for(const auto& servo_handler: all_servos_)
+    servo_states_msg_->name.push_back(servo_handler->getName());
+  servo_states_msg_->position.resize(all_servos_.size());
+  servo_states_msg_->effort.resize(all_servos_.size());
+}
+
 void ServoBridge::servoStatesCallback(const spinal::ServoStatesConstPtr& state_msg, const string& servo_group_name)
 {
   /* independent group servo process without state publish */
   if(servo_group_name != std::string("common"))
     {
-      for(auto it: state_msg->servos)
+      const ServoGroupHandler& servo_group_handler = servos_handler_.at(servo_group_name);
+      const auto& id_indices = servo_id_indices_.at(servo_group_name);
+      for(const auto& it: state_msg->servos)
         {
-          auto servo_handler = find_if(servos_handler_[servo_group_name].begin(),
-                                       servos_handler_[servo_group_name].end(),
-                                       [&](SingleServoHandlePtr s) {return it.index == s->getId();} );
-
-          if(servo_handler == servos_handler_[servo_group_name].end())
+          auto id_index = id_indices.find(it.index);
+          if(id_index == id_indices.end())
             {
               ROS_ERROR("[servo bridge, servo state callback]: no matching joint handler for servo index %d", it.index);
               return;
             }
-          (*servo_handler)->setCurrAngleVal((double)it.angle, ValueType::BIT); // angle (position)
-          (*servo_handler)->setCurrTorqueVal((double)it.load); // torque (effort)
+
+          const SingleServoHandlePtr& servo_handler = servo_group_handler.at(id_index->second);
+          servo_handler->setCurrAngleVal((double)it.angle, ValueType::BIT); // angle (position)
+          servo_handler->setCurrTorqueVal((double)it.load); // torque (effort)
         }
 
       // finish process
@@ -241,121 +291,104 @@ void ServoBridge::servoStatesCallback(const spinal::ServoStatesConstPtr& state_m
     }
 
 
-  /* group of "common", search in all group */
-  for(auto it: state_msg->servos)
+  /* group of "common": groups without real state or with independent servo state process are not in the table */
+  for(const auto& it: state_msg->servos)
     {
-      for(auto servo_group: servos_handler_)
-        {
-          // no real state from real machine, skip
-          if(no_real_state_flags_.at(servo_group.first))
-            {
-              ROS_DEBUG_STREAM(servo_group.first << ", no real state, skip");
-              continue;
-            }
-
-          // has independent servo state process
-          if(servo_states_subs_.find(servo_group.first) != servo_states_subs_.end())
-            {
-              ROS_DEBUG_STREAM(servo_group.first << ", do not process in common group, skip");
-              continue;
-            }
-
-          auto servo_handler = find_if(servos_handler_[servo_group.first].begin(),
-                                       servos_handler_[servo_group.first].end(),
-                                       [&](SingleServoHandlePtr s) {return it.index == s->getId();});
+      auto servo_handler = common_servo_handles_.find(it.index);
+      if(servo_handler == common_servo_handles_.end()) continue;
 
-          if(servo_handler == servos_handler_[servo_group.first].end())
-            {
-              // search in next servo group
-              continue;
-            }
-
-          (*servo_handler)->setCurrAngleVal((double)it.angle, ValueType::BIT); // angle (position)
-          (*servo_handler)->setCurrTorqueVal((double)it.load); // torque (effort)
-
-          ROS_DEBUG("servo index: %d, find in group %s", it.index, servo_group.first.c_str());
-
-          break; // search next servo state from real machine
-        }
+      servo_handler->second->setCurrAngleVal((double)it.angle, ValueType::BIT); // angle (position)
+      servo_handler->second->setCurrTorqueVal((double)it.load); // torque (effort)
     }
 
+  servoStatePublish(state_msg->stamp);
+}
 
-  sensor_msgs::JointState servo_states_msg;
-  servo_states_msg.header.stamp = state_msg->stamp;
-
-  for(auto servo_group : servos_handler_)
+void ServoBridge::servoStatePublish(const ros::Time& stamp)
+{
+  sensor_msgs::JointState& servo_states_msg = writable(servo_states_msg_);
+  servo_states_msg.header.stamp = stamp;
+  for(int i = 0; i < all_servos_.size(); i++)
     {
-      for(auto servo_handler: servo_group.second)
-        {
-          servo_states_msg.name.push_back(servo_handler->getName());
-          servo_states_msg.position.push_back(servo_handler->getCurrAngleVal(ValueType::RADIAN));
-          servo_states_msg.effort.push_back(servo_handler->getCurrTorqueVal());
-        }
+      servo_states_msg.position[i] = all_servos_[i]->getCurrAngleVal(ValueType::RADIAN);
+      servo_states_msg.effort[i] = all_servos_[i]->getCurrTorqueVal();
     }
-  servo_states_pub_.publish(servo_states_msg);
+  publish(servo_states_pub_, servo_states_msg_);
 }
 
 void ServoBridge::servoCtrlCallback(const sensor_msgs::JointStateConstPtr& servo_ctrl_msg, const string& servo_group_name)
 {
-  spinal::ServoControlCmd target_angle_msg;
-  sensor_msgs::JointState mujoco_control_input_msg;
+  const ServoGroupHandler& servo_group_handler = servos_handler_.at(servo_group_name);
+  spinal::ServoControlCmd& target_angle_msg = writable(servo_ctrl_msgs_.at(servo_group_name));
+  sensor_msgs::JointState& mujoco_control_input_msg = writable(mujoco_ctrl_msgs_.at(servo_group_name));
 
   if(servo_ctrl_msg->name.size() > 0)
-    {
-      for(int i = 0; i < servo_ctrl_msg->name.size(); i++)
-        {/* servo name is assigned */
-          if(servo_ctrl_msg->position.size() !=  servo_ctrl_msg->name.size())
-            {
-              ROS_ERROR("[servo bridge, servo control control]: the servo position num and name num are different in ros msgs [%d vs %d]",
-                        (int)servo_ctrl_msg->position.size(), (int)servo_ctrl_msg->name.size());
-              return;
-            }
+    {/* servo name is assigned */
+      if(servo_ctrl_msg->position.size() !=  servo_ctrl_msg->name.size())
+        {
+          ROS_ERROR("[servo bridge, servo control control]: the servo position num and name num are different in ros msgs [%d vs %d]",
+                    (int)servo_ctrl_msg->position.size(), (int)servo_ctrl_msg->name.size());
+          return;
+        }
 
-          mujoco_control_input_msg.name.push_back(servo_ctrl_msg->name.at(i));
-          mujoco_control_input_msg.position.push_back(servo_ctrl_msg->position.at(i));
+      /* keep the capacity of the templates, no allocation if the joint num does not increase */
+      target_angle_msg.index.resize(servo_ctrl_msg->name.size());
+      target_angle_msg.angles.resize(servo_ctrl_msg->name.size());
+      mujoco_control_input_msg.name.resize(servo_ctrl_msg->name.size());
+      mujoco_control_input_msg.position.resize(servo_ctrl_msg->name.size());
 
+      const auto& name_indices = servo_name_indices_.at(servo_group_name);
+      for(int i = 0; i < servo_ctrl_msg->name.size(); i++)
+        {
           // use servo_name to search the servo_handler
-          auto servo_handler = find_if(servos_handler_[servo_group_name].begin(), servos_handler_[servo_group_name].end(),
-                                       [&](SingleServoHandlePtr s) {return servo_ctrl_msg->name.at(i)  == s->getName();});
-
-          if(servo_handler == servos_handler_[servo_group_name].end())
+          auto name_index = name_indices.find(servo_ctrl_msg->name.at(i));
+          if(name_index == name_indices.end())
           {
             ROS_ERROR("[servo bridge, servo control callback]: no matching servo handler for %s", servo_ctrl_msg->name.at(i).c_str());
             return;
           }
 
-          (*servo_handler)->setTargetAngleVal(servo_ctrl_msg->position[i], ValueType::RADIAN);
-          target_angle_msg.index.push_back((*servo_handler)->getId());
-          target_angle_msg.angles.push_back((*servo_handler)->getTargetAngleVal(ValueType::BIT));
+          const SingleServoHandlePtr& servo_handler = servo_group_handler.at(name_index->second);
+          servo_handler->setTargetAngleVal(servo_ctrl_msg->position[i], ValueType::RADIAN);
+          target_angle_msg.index[i] = servo_handler->getId();
+          target_angle_msg.angles[i] = servo_handler->getTargetAngleVal(ValueType::BIT);
+
+          mujoco_control_input_msg.name[i] = servo_ctrl_msg->name[i];
+          mujoco_control_input_msg.position[i] = servo_ctrl_msg->position[i];
 
           if(simulation_mode_)
             {
               std_msgs::Float64 msg;
               msg.data = servo_ctrl_msg->position[i];
-              servo_ctrl_sim_pubs_[servo_group_name].at(distance(servos_handler_[servo_group_name].begin(), servo_handler)).publish(msg);
+              servo_ctrl_sim_pubs_[servo_group_name].at(name_index->second).publish(msg);
             }
         }
     }
   else
     { /* for fast tranmission: no searching process, in the predefine order */
 
-      if(servo_ctrl_msg->position.size() != servos_handler_[servo_group_name].size())
+      if(servo_ctrl_msg->position.size() != servo_group_handler.size())
         {
           ROS_ERROR("[servo bridge, servo control control]: the joint num from rosparam %d is not equal with ros msgs %d",
-                    (int)servos_handler_[servo_group_name].size(), (int)servo_ctrl_msg->position.size());
+                    (int)servo_group_handler.size(), (int)servo_ctrl_msg->position.size());
           return;
         }
 
+      target_angle_msg.index.resize(servo_group_handler.size());
+      target_angle_msg.angles.resize(servo_group_handler.size());
+      mujoco_control_input_msg.name.resize(servo_group_handler.size());
+      mujoco_control_input_msg.position.resize(servo_group_handler.size());
+
       for(int i = 0; i < servo_ctrl_msg->position.size(); i++)
         {
           /*  use the kinematics order (e.g. joint1 ~ joint N, gimbal_roll -> gimbal_pitch) */
-          SingleServoHandlePtr servo_handler = servos_handler_[servo_group_name].at(i);
+          const SingleServoHandlePtr& servo_handler = servo_group_handler[i];
           servo_handler->setTargetAngleVal(servo_ctrl_msg->position[i], ValueType::RADIAN);
-          target_angle_msg.index.push_back(servo_handler->getId());
-          target_angle_msg.angles.push_back(servo_handler->getTargetAngleVal(ValueType::BIT));
+          target_angle_msg.index[i] = servo_handler->getId();
+          target_angle_msg.angles[i] = servo_handler->getTargetAngleVal(ValueType::BIT);
 
-          mujoco_control_input_msg.name.push_back(servo_handler->getName());
-          mujoco_control_input_msg.position.push_back(servo_ctrl_msg->position.at(i));
+          mujoco_control_input_msg.name[i] = servo_handler->getName();
+          mujoco_control_input_msg.position[i] = servo_ctrl_msg->position[i];
 
           if(simulation_mode_)
             {
@@ -366,12 +399,13 @@ void ServoBridge::servoCtrlCallback(const sensor_msgs::JointStateConstPtr& servo
         }
     }
 
-  mujoco_control_input_pub_.publish(mujoco_control_input_msg);
+  if(use_mujoco_) publish(mujoco_control_input_pub_, mujoco_ctrl_msgs_.at(servo_group_name));
 
-  if (servo_ctrl_pubs_.find(servo_group_name) != servo_ctrl_pubs_.end())
-    servo_ctrl_pubs_[servo_group_name].publish(target_angle_msg);
+  auto servo_ctrl_pub = servo_ctrl_pubs_.find(servo_group_name);
+  if (servo_ctrl_pub != servo_ctrl_pubs_.end())
+    publish(servo_ctrl_pub->second, servo_ctrl_msgs_.at(servo_group_name));
   else
-    servo_ctrl_pubs_["common"].publish(target_angle_msg);
+    publish(servo_ctrl_pubs_.at("common"), servo_ctrl_msgs_.at(servo_group_name));
 }
 
 bool ServoBridge::servoTorqueCtrlCallback(std_srvs::SetBool::Request &req, std_srvs::SetBool::Response &res, const std::string& servo_group_name)
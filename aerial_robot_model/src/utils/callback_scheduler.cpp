@@ -0,0 +1,286 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <aerial_robot_model/utils/callback_scheduler.h>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+namespace aerial_robot_model {
+
+  /* wrapper to measure the latency and the drop of the original callback */
+  class CallbackGroup::MeasuredCallback : public ros::CallbackInterface
+  {
+  public:
+    MeasuredCallback(const ros::CallbackInterfacePtr& callback, CallbackGroup* group):
+      callback_(callback), group_(group), enqueue_stamp_(ros::WallTime::now()) {}
+
+    // called or removed by the owner
+    ~MeasuredCallback() { group_->callbackRemoved(); }
+
+    CallResult call() override
+    {
+      ros::WallTime start_stamp = ros::WallTime::now();
+      CallResult result = callback_->call();
+      // try again: the callback is pushed back to the queue without addCallback
+      if(result != TryAgain) group_->callbackDone(enqueue_stamp_, start_stamp, result == Invalid);
+      return result;
+    }
+
+    bool ready() override { return callback_->ready(); }
+
+  private:
+    ros::CallbackInterfacePtr callback_;
+    CallbackGroup* group_;
+    ros::WallTime enqueue_stamp_;
+  };
+
+  CallbackGroup::CallbackGroup(const std::string& name, int threads, int priority, const std::vector<int>& affinity):
+    name_(name), thread_num_(std::max(threads, 1)), priority_(priority), affinity_(affinity), running_(false)
+  {
+  }
+
+  CallbackGroup::~CallbackGroup()
+  {
+    stop();
+    clear(); // remove the remaining callbacks while the statistics are alive
+  }
+
+  void CallbackGroup::addCallback(const ros::CallbackInterfacePtr& callback, uint64_t owner_id)
+  {
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.enqueued++;
+      stats_.depth++;
+      stats_.max_depth = std::max(stats_.max_depth, stats_.depth);
+    }
+
+    ros::CallbackQueue::addCallback(boost::make_shared<MeasuredCallback>(callback, this), owner_id);
+  }
+
+  void CallbackGroup::callbackDone(const ros::WallTime& enqueue_stamp, const ros::WallTime& start_stamp, bool dropped)
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.called++;
+    if(dropped) stats_.dropped++;
+    stats_.max_latency = std::max(stats_.max_latency, (start_stamp - enqueue_stamp).toSec());
+  }
+
+  void CallbackGroup::callbackRemoved()
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if(stats_.depth > 0) stats_.depth--;
+  }
+
+  CallbackGroupStats CallbackGroup::getStats(bool reset_max)
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    CallbackGroupStats stats = stats_;
+    if(reset_max)
+      {
+        stats_.max_depth = stats_.depth;
+        stats_.max_latency = 0;
+      }
+    return stats;
+  }
+
+  void CallbackGroup::start()
+  {
+    if(running_) return;
+    running_ = true;
+
+    for(int i = 0; i < thread_num_; i++)
+      {
+        threads_.emplace_back(&CallbackGroup::threadFunc, this);
+        pthread_t handle = threads_.back().native_handle();
+
+        if(priority_ > 0)
+          {
+            sched_param param;
+            param.sched_priority = priority_;
+            if(pthread_setschedparam(handle, SCHED_FIFO, &param) != 0)
+              ROS_WARN("[callback group] %s: can not set the real-time priority %d, check the rtprio limit", name_.c_str(), priority_);
+          }
+
+        if(!affinity_.empty())
+          {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            for(const auto cpu: affinity_) CPU_SET(cpu, &cpu_set);
+            if(pthread_setaffinity_np(handle, sizeof(cpu_set_t), &cpu_set) != 0)
+              ROS_WARN("[callback group] %s: can not set the cpu affinity", name_.c_str());
+          }
+      }
+  }
+
+  void CallbackGroup::stop()
+  {
+    if(!running_) return;
+    running_ = false;
+
+    for(auto& thread: threads_) thread.join();
+    threads_.clear();
+  }
+
+  void CallbackGroup::threadFunc()
+  {
+    while(running_ && !ros::isShuttingDown())
+      callAvailable(ros::WallDuration(0.01));
+  }
+
+  std::mutex CallbackScheduler::instances_mutex_;
+  std::map<ros::CallbackQueueInterface*, CallbackScheduler*> CallbackScheduler::instances_;
+
+  CallbackScheduler::CallbackScheduler(ros::NodeHandle nh, ros::NodeHandle nhp):
+    nh_(nh), nhp_(nhp), owner_queue_(nh.getCallbackQueue())
+  {
+    const std::vector<std::string> names = {"sensor", "model", "command", "diagnostics"};
+    const std::vector<int> default_threads = {2, 1, 1, 1};
+
+    ros::NodeHandle groups_nh(nhp_, "callback_groups");
+    for(int i = 0; i < callback_group::TOTAL_NUM; i++)
+      {
+        ros::NodeHandle group_nh(groups_nh, names.at(i));
+        int threads, priority;
+        std::vector<int> affinity;
+        group_nh.param("threads", threads, default_threads.at(i));
+        group_nh.param("priority", priority, 0);
+        group_nh.getParam("affinity", affinity);
+
+        groups_.push_back(std::make_unique<CallbackGroup>(names.at(i), threads, priority, affinity));
+        groups_.back()->start();
+        ROS_DEBUG("[callback group] %s: %d threads, priority %d", names.at(i).c_str(), threads, priority);
+      }
+
+    {
+      std::lock_guard<std::mutex> lock(instances_mutex_);
+      CallbackScheduler*& instance = instances_[owner_queue_];
+      if(instance) ROS_WARN("[callback group] another scheduler is running for the same node, replace it");
+      instance = this;
+    }
+
+    double stats_rate;
+    groups_nh.param("stats_rate", stats_rate, 1.0);
+    diagnostics_pub_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", 1);
+    if(stats_rate > 0)
+      stats_timer_ = nodeHandle(nhp_, callback_group::DIAGNOSTICS).createWallTimer(ros::WallDuration(1.0 / stats_rate), &CallbackScheduler::statsCallback, this);
+  }
+
+  CallbackScheduler::~CallbackScheduler()
+  {
+    stop();
+  }
+
+  void CallbackScheduler::stop()
+  {
+    stats_timer_.stop();
+
+    {
+      std::lock_guard<std::mutex> lock(instances_mutex_);
+      auto instance = instances_.find(owner_queue_);
+      if(instance != instances_.end() && instance->second == this) instances_.erase(instance);
+    }
+
+    for(auto& group: groups_) group->stop();
+  }
+
+  ros::NodeHandle CallbackScheduler::nodeHandle(const ros::NodeHandle& nh, int group)
+  {
+    std::lock_guard<std::mutex> lock(instances_mutex_);
+    ros::CallbackQueueInterface* queue = nh.getCallbackQueue();
+
+    // the node handle of the owner, or one already assigned to a group of the same scheduler
+    CallbackScheduler* scheduler = nullptr;
+    auto instance = instances_.find(queue);
+    if(instance != instances_.end()) scheduler = instance->second;
+    for(auto it = instances_.begin(); !scheduler && it != instances_.end(); it++)
+      {
+        for(const auto& g: it->second->groups_)
+          if(g.get() == queue) scheduler = it->second;
+      }
+    if(!scheduler) return nh;
+
+    ros::NodeHandle group_nh(nh);
+    group_nh.setCallbackQueue(scheduler->getGroup(group));
+    return group_nh;
+  }
+
+  void CallbackScheduler::statsCallback(const ros::WallTimerEvent& e)
+  {
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+
+    if(prev_dropped_.size() != groups_.size()) prev_dropped_.assign(groups_.size(), 0);
+
+    for(int i = 0; i < groups_.size(); i++)
+      {
+        CallbackGroupStats stats = groups_.at(i)->getStats(true);
+
+        diagnostic_msgs::DiagnosticStatus status;
+        status.name = "callback_groups: " + groups_.at(i)->getName();
+        status.hardware_id = nh_.getNamespace();
+        if(stats.dropped > prev_dropped_.at(i))
+          {
+            status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+            status.message = std::to_string(stats.dropped - prev_dropped_.at(i)) + " messages dropped";
+          }
+        else
+          {
+            status.level = diagnostic_msgs::DiagnosticStatus::OK;
+            status.message = "OK";
+          }
+        prev_dropped_.at(i) = stats.dropped;
+
+        auto add_value = [&status](const std::string& key, const std::string& value)
+          {
+            diagnostic_msgs::KeyValue kv;
+            kv.key = key;
+            kv.value = value;
+            status.values.push_back(kv);
+          };
+        add_value("threads", std::to_string(groups_.at(i)->getThreadNum()));
+        add_value("priority", std::to_string(groups_.at(i)->getPriority()));
+        add_value("enqueued", std::to_string(stats.enqueued));
+        add_value("called", std::to_string(stats.called));
+        add_value("dropped", std::to_string(stats.dropped));
+        add_value("depth", std::to_string(stats.depth));
+        add_value("max_depth", std::to_string(stats.max_depth));
+        add_value("max_latency_ms", std::to_string(stats.max_latency * 1000));
+        msg.status.push_back(status);
+      }
+
+    diagnostics_pub_.publish(msg);
+  }
+} //namespace aerial_robot_model
@@ -0,0 +1,90 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <spinal/serial_bridge/protocol.h>
+#include <spinal/serial_bridge/serial_port.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace spinal
+{
+  namespace serial_bridge
+  {
+    /*
+      emulated spinal on the slave of a pseudo terminal, to test the bridge without hardware:
+      - answers the topic request of the host with the given endpoints, and requests the time
+      - the messages to the subscriber endpoints are passed to the handler, which can publish to the publisher endpoints
+    */
+    class LoopbackClient
+    {
+    public:
+      struct Endpoint
+      {
+        uint16_t type; // protocol::ID_PUBLISHER, protocol::ID_SUBSCRIBER, or with protocol::ID_SERVICE_SERVER
+        TopicInfo info;
+      };
+      using MessageHandler = std::function<void(LoopbackClient& client, uint16_t topic_id, const uint8_t* payload, uint16_t length)>;
+
+      LoopbackClient(const std::vector<Endpoint>& endpoints, MessageHandler handler);
+      ~LoopbackClient() { stop(); }
+
+      bool start(const std::string& port);
+      void stop();
+
+      bool publish(uint16_t topic_id, const uint8_t* payload, uint16_t length);
+
+      bool synchronized() const { return synchronized_; } // got the time from the host
+      uint64_t getNegotiations() const { return negotiations_; }
+      uint64_t getReceived() const { return received_; }
+
+    private:
+      std::vector<Endpoint> endpoints_;
+      MessageHandler handler_;
+      SerialPort port_;
+      std::mutex write_mutex_;
+      std::thread thread_;
+      std::atomic<bool> running_;
+      std::atomic<bool> synchronized_;
+      std::atomic<uint64_t> negotiations_;
+      std::atomic<uint64_t> received_;
+
+      void threadFunc();
+      void onFrame(uint16_t topic_id, const uint8_t* payload, uint16_t length);
+    };
+  };
+};
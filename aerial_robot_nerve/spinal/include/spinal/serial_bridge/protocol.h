@@ -0,0 +1,204 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace spinal
+{
+  namespace serial_bridge
+  {
+    /*
+      wire protocol of rosserial (protocol version 2), also used by STM32Hardware in spinal:
+      - frame: 0xff, 0xfe, uint16 payload length, length checksum, uint16 topic id, payload, checksum
+      - length checksum: 255 - (sum of the length bytes) % 256
+      - checksum: 255 - (sum of the topic id and payload bytes) % 256
+      - the payload is the ros serialization of the message (little endian)
+    */
+    namespace protocol
+    {
+      constexpr uint8_t SYNC_FLAG = 0xff;
+      constexpr uint8_t PROTOCOL_VER = 0xfe;
+      constexpr size_t HEADER_SIZE = 7;
+      constexpr size_t FRAME_OVERHEAD = HEADER_SIZE + 1;
+      constexpr size_t MAX_PAYLOAD = 65535;
+
+      /* reserved topic ids, the endpoints of the client start from 100 */
+      enum : uint16_t
+        {
+          ID_PUBLISHER = 0, // also the request of the topics (empty payload)
+          ID_SUBSCRIBER = 1,
+          ID_SERVICE_SERVER = 2,
+          ID_SERVICE_CLIENT = 4,
+          ID_PARAMETER_REQUEST = 6,
+          ID_LOG = 7,
+          ID_TIME = 10,
+          ID_TX_STOP = 11,
+          ID_CLIENT_START = 100,
+        };
+
+      /* level of rosserial_msgs/Log */
+      enum : uint8_t {ROSDEBUG, INFO, WARN, ERROR, FATAL};
+    };
+
+    /* rosserial_msgs/TopicInfo */
+    struct TopicInfo
+    {
+      uint16_t topic_id = 0;
+      std::string topic_name;
+      std::string message_type;
+      std::string md5sum;
+      int32_t buffer_size = 0;
+    };
+
+    /* rosserial_msgs/RequestParamResponse */
+    struct ParamResponse
+    {
+      std::vector<int32_t> ints;
+      std::vector<float> floats;
+      std::vector<std::string> strings;
+    };
+
+    /*
+      frame writer for batched writes: append frames to one buffer, which is sent by one write.
+      the payload can be serialized in place between beginFrame() and endFrame().
+    */
+    class FrameBuffer
+    {
+    public:
+      /* reserve the header and the payload, return the payload pointer */
+      uint8_t* beginFrame(uint16_t topic_id, uint16_t length);
+      /* fill the length and checksums of the last frame */
+      void endFrame();
+      void append(uint16_t topic_id, const uint8_t* payload, uint16_t length);
+
+      const uint8_t* data() const { return buffer_.data(); }
+      size_t size() const { return buffer_.size(); }
+      size_t frames() const { return frames_; }
+      bool empty() const { return buffer_.empty(); }
+      void clear() { buffer_.clear(); frames_ = 0; }
+      void swap(FrameBuffer& other) { buffer_.swap(other.buffer_); std::swap(frames_, other.frames_); std::swap(frame_begin_, other.frame_begin_); }
+
+    private:
+      std::vector<uint8_t> buffer_;
+      size_t frame_begin_ = 0;
+      size_t frames_ = 0;
+    };
+
+    struct DecoderStats
+    {
+      uint64_t frames = 0;
+      uint64_t skipped_bytes = 0; // garbage before the sync flag
+      uint64_t length_errors = 0;
+      uint64_t checksum_errors = 0;
+    };
+
+    /*
+      stream decoder: the handler gets the payload of each valid frame.
+      the payload points into the given data if the frame is not split between two feeds (no copy),
+      otherwise into the internal buffer, and is only valid during the call.
+    */
+    class FrameDecoder
+    {
+    public:
+      using FrameHandler = std::function<void(uint16_t topic_id, const uint8_t* payload, uint16_t length)>;
+      using ErrorHandler = std::function<void(uint16_t topic_id)>; // checksum error of the frame with the topic id
+
+      FrameDecoder(FrameHandler frame_handler, ErrorHandler error_handler = ErrorHandler(), size_t max_payload = protocol::MAX_PAYLOAD);
+
+      void feed(const uint8_t* data, size_t size);
+      void reset() { pending_.clear(); }
+      const DecoderStats& getStats() const { return stats_; }
+
+    private:
+      FrameHandler frame_handler_;
+      ErrorHandler error_handler_;
+      size_t max_payload_;
+      std::vector<uint8_t> pending_; // incomplete frame of the previous feed
+      DecoderStats stats_;
+
+      size_t parse(const uint8_t* data, size_t size);
+    };
+
+    /* serialization of the rosserial control messages, the same format as ros serialization */
+    class PayloadReader
+    {
+    public:
+      PayloadReader(const uint8_t* data, size_t size): data_(data), size_(size), pos_(0), ok_(true) {}
+
+      template<class T> T read()
+      {
+        T value = T();
+        if(pos_ + sizeof(T) > size_) { ok_ = false; return value; }
+        for(size_t i = 0; i < sizeof(T); i++)
+          reinterpret_cast<uint8_t*>(&value)[i] = data_[pos_ + i];
+        pos_ += sizeof(T);
+        return value;
+      }
+      std::string readString();
+      bool ok() const { return ok_; }
+
+    private:
+      const uint8_t* data_;
+      size_t size_;
+      size_t pos_;
+      bool ok_;
+    };
+
+    class PayloadWriter
+    {
+    public:
+      template<class T> void write(T value)
+      {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        data_.insert(data_.end(), p, p + sizeof(T));
+      }
+      void writeString(const std::string& str);
+      const std::vector<uint8_t>& data() const { return data_; }
+
+    private:
+      std::vector<uint8_t> data_;
+    };
+
+    bool decodeTopicInfo(const uint8_t* payload, uint16_t length, TopicInfo& info);
+    std::vector<uint8_t> encodeTopicInfo(const TopicInfo& info);
+    std::vector<uint8_t> encodeParamResponse(const ParamResponse& response);
+    std::vector<uint8_t> encodeTime(uint32_t sec, uint32_t nsec);
+  };
+};
@@ -0,0 +1,337 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <spinal/serial_bridge/loopback_client.h>
+#include <spinal/serial_bridge/protocol.h>
+#include <spinal/serial_bridge/serial_port.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <topic_tools/shape_shifter.h>
+
+namespace spinal
+{
+  namespace serial_bridge
+  {
+    /* counters of one endpoint, updated by the rx or tx thread and read by the diagnostics */
+    struct EndpointStats
+    {
+      std::atomic<uint64_t> messages{0};
+      std::atomic<uint64_t> dropped{0};  // tx buffer full or write error (host to spinal)
+      std::atomic<uint64_t> errors{0};   // checksum or deserialization error (spinal to host)
+      std::atomic<uint64_t> latency_sum{0}; // [nsec]
+      std::atomic<uint64_t> latency_max{0};
+
+      void addLatency(uint64_t latency)
+      {
+        latency_sum += latency;
+        uint64_t max = latency_max;
+        while(latency > max && !latency_max.compare_exchange_weak(max, latency));
+      }
+    };
+
+    class SerialBridge;
+
+    /* topic published by spinal */
+    class Inbound
+    {
+    public:
+      Inbound(const TopicInfo& info): info_(info) {}
+      virtual ~Inbound() {}
+      /* deserialize directly from the frame and publish */
+      virtual bool decode(const uint8_t* payload, uint16_t length) = 0;
+
+      const TopicInfo& getInfo() const { return info_; }
+      EndpointStats stats;
+
+    protected:
+      TopicInfo info_;
+    };
+
+    /* topic subscribed by spinal, the callbacks serialize the messages into the batch of the tx thread */
+    class Outbound
+    {
+    public:
+      Outbound(SerialBridge& bridge, const TopicInfo& info): bridge_(bridge), info_(info) {}
+      virtual ~Outbound() { sub_.shutdown(); } // wait for the running callback
+
+      const TopicInfo& getInfo() const { return info_; }
+      EndpointStats stats;
+
+    protected:
+      SerialBridge& bridge_;
+      TopicInfo info_;
+      ros::Subscriber sub_;
+    };
+
+    /* service server of spinal: the request is sent to the subscriber endpoint, the response comes from the publisher endpoint */
+    class ServiceBridge
+    {
+    public:
+      ServiceBridge(SerialBridge& bridge, const std::string& name): bridge_(bridge), name_(name), request_id_(0), response_id_(0) {}
+      virtual ~ServiceBridge() { server_.shutdown(); }
+
+      virtual void advertise(ros::NodeHandle nh) = 0;
+      void onResponse(const uint8_t* payload, uint16_t length);
+
+      const std::string& getName() const { return name_; }
+      uint16_t request_id_, response_id_;
+      EndpointStats stats;
+
+    protected:
+      SerialBridge& bridge_;
+      std::string name_;
+      ros::ServiceServer server_;
+
+      std::mutex call_mutex_; // one call at a time
+      std::mutex response_mutex_;
+      std::condition_variable response_cv_;
+      std::vector<uint8_t> response_;
+      bool response_ready_ = false;
+
+      /* send the request, and wait for the response */
+      bool call(uint32_t length, const std::function<void(uint8_t*)>& serialize, std::vector<uint8_t>& response);
+    };
+
+    /*
+      native host side of the spinal link, replacing the generic rosserial server:
+      - the wire protocol is the same as rosserial (STM32Hardware), including the topic negotiation, time sync, parameters and logs
+      - known message and service types have precompiled handlers, which deserialize the frame directly into the published message,
+        and serialize the subscribed message directly into the tx buffer. other types fall back to topic_tools::ShapeShifter.
+      - the messages to spinal are batched: the tx thread serializes all messages arrived in one control tick and writes them at once
+      - per topic counters of messages, drops, errors and latency are published as diagnostics
+      - loopback: emulate spinal on a pseudo terminal, which echoes the messages to its subscribers on "loopback/<topic>"
+    */
+    class SerialBridge
+    {
+    public:
+      SerialBridge(ros::NodeHandle nh, ros::NodeHandle nhp);
+      ~SerialBridge();
+
+      /* serialize a message for spinal into the current batch, return false if dropped */
+      bool send(uint16_t topic_id, uint32_t length, const std::function<void(uint8_t*)>& serialize, EndpointStats* stats);
+      /* write the batch */
+      void flush();
+
+      ros::CallbackQueue* getTxQueue() { return &tx_queue_; }
+      double getServiceTimeout() const { return service_timeout_; }
+
+      /* precompiled handlers */
+      template<class T> void registerMessage();
+      template<class Srv> void registerService();
+
+    private:
+      ros::NodeHandle nh_;
+      ros::NodeHandle nhp_;
+
+      SerialPort port_;
+      std::unique_ptr<LoopbackClient> loopback_;
+      std::string port_name_;
+      int baud_;
+      double negotiation_timeout_;
+      double link_timeout_;
+      double service_timeout_;
+      size_t max_tx_buffer_;
+
+      std::atomic<bool> running_;
+      std::thread rx_thread_;
+      std::thread tx_thread_;
+      ros::CallbackQueue tx_queue_;
+
+      // batch of the messages to spinal
+      std::mutex write_mutex_; // keep the order of the batches
+      std::mutex tx_mutex_;
+      FrameBuffer tx_buffer_, tx_writing_;
+      std::vector<std::pair<EndpointStats*, uint64_t> > tx_pending_, tx_pending_writing_; // receive time of each message [nsec]
+      std::atomic<uint64_t> tx_bytes_, tx_writes_;
+
+      // endpoints, modified only in the rx thread
+      std::mutex endpoints_mutex_;
+      std::map<uint16_t, std::unique_ptr<Inbound> > inbounds_;
+      std::map<uint16_t, std::unique_ptr<Outbound> > outbounds_;
+      std::map<std::string, std::unique_ptr<ServiceBridge> > services_;
+      std::map<uint16_t, ServiceBridge*> service_responses_;
+
+      struct MessageHandler
+      {
+        std::string md5sum;
+        std::function<Inbound*(const TopicInfo&)> inbound;
+        std::function<Outbound*(const TopicInfo&)> outbound;
+      };
+      std::map<std::string, MessageHandler> message_handlers_;
+      std::map<std::string, std::function<ServiceBridge*(const std::string&)> > service_handlers_;
+
+      // link state, in the rx thread
+      std::atomic<bool> negotiated_;
+      ros::WallTime last_topic_request_;
+      ros::WallTime last_frame_;
+      uint64_t rx_stamp_; // arrival of the current chunk [nsec]
+      std::atomic<uint64_t> rx_bytes_;
+      DecoderStats decoder_stats_;
+      std::mutex decoder_stats_mutex_;
+
+      ros::Publisher diagnostics_pub_;
+      ros::WallTimer stats_timer_;
+      std::map<std::string, uint64_t> prev_failures_;
+
+      void registerHandlers();
+      bool startLoopback();
+
+      void rxThread();
+      void txThread();
+      void requestTopics();
+      void onFrame(uint16_t topic_id, const uint8_t* payload, uint16_t length);
+      void onChecksumError(uint16_t topic_id);
+      void onTopicInfo(uint16_t type, const uint8_t* payload, uint16_t length);
+      void onParameterRequest(const uint8_t* payload, uint16_t length);
+      void onLog(const uint8_t* payload, uint16_t length);
+      void sendControl(uint16_t topic_id, const std::vector<uint8_t>& payload);
+
+      void statsCallback(const ros::WallTimerEvent& e);
+    };
+
+    uint64_t wallNow();
+
+    template<class T> class MessageInbound : public Inbound
+    {
+    public:
+      MessageInbound(ros::NodeHandle nh, const TopicInfo& info): Inbound(info)
+      {
+        pub_ = nh.advertise<T>(info.topic_name, 10);
+      }
+
+      bool decode(const uint8_t* payload, uint16_t length) override
+      {
+        // a new message for each publish, passed to the nodelets in the same process without copy
+        boost::shared_ptr<T> msg = boost::make_shared<T>();
+        try
+          {
+            ros::serialization::IStream stream(const_cast<uint8_t*>(payload), length);
+            ros::serialization::deserialize(stream, *msg);
+          }
+        catch(ros::serialization::StreamOverrunException& e)
+          {
+            return false;
+          }
+        pub_.publish(msg);
+        return true;
+      }
+
+    private:
+      ros::Publisher pub_;
+    };
+
+    template<class T> class MessageOutbound : public Outbound
+    {
+    public:
+      MessageOutbound(SerialBridge& bridge, ros::NodeHandle nh, const TopicInfo& info): Outbound(bridge, info)
+      {
+        ros::SubscribeOptions ops;
+        ops.template init<T>(info.topic_name, 10, boost::bind(&MessageOutbound::callback, this, _1));
+        ops.callback_queue = bridge.getTxQueue();
+        ops.transport_hints = ros::TransportHints().tcpNoDelay();
+        sub_ = nh.subscribe(ops);
+      }
+
+    private:
+      void callback(const boost::shared_ptr<const T>& msg)
+      {
+        uint32_t length = ros::serialization::serializationLength(*msg);
+        bridge_.send(info_.topic_id, length, [&msg, length](uint8_t* p)
+                     {
+                       ros::serialization::OStream stream(p, length);
+                       ros::serialization::serialize(stream, *msg);
+                     }, &stats);
+      }
+    };
+
+    template<class Srv> class TypedServiceBridge : public ServiceBridge
+    {
+    public:
+      TypedServiceBridge(SerialBridge& bridge, const std::string& name): ServiceBridge(bridge, name) {}
+
+      void advertise(ros::NodeHandle nh) override
+      {
+        server_ = nh.advertiseService(name_, &TypedServiceBridge::callback, this);
+      }
+
+    private:
+      bool callback(typename Srv::Request& req, typename Srv::Response& res)
+      {
+        uint32_t length = ros::serialization::serializationLength(req);
+        std::vector<uint8_t> response;
+        if(!call(length, [&req, length](uint8_t* p)
+                 {
+                   ros::serialization::OStream stream(p, length);
+                   ros::serialization::serialize(stream, req);
+                 }, response)) return false;
+
+        try
+          {
+            ros::serialization::IStream stream(response.data(), response.size());
+            ros::serialization::deserialize(stream, res);
+          }
+        catch(ros::serialization::StreamOverrunException& e)
+          {
+            stats.errors++;
+            return false;
+          }
+        return true;
+      }
+    };
+
+    template<class T> void SerialBridge::registerMessage()
+    {
+      MessageHandler handler;
+      handler.md5sum = ros::message_traits::md5sum<T>();
+      handler.inbound = [this](const TopicInfo& info) { return new MessageInbound<T>(nh_, info); };
+      handler.outbound = [this](const TopicInfo& info) { return new MessageOutbound<T>(*this, nh_, info); };
+      message_handlers_[ros::message_traits::datatype<T>()] = handler;
+    }
+
+    template<class Srv> void SerialBridge::registerService()
+    {
+      service_handlers_[ros::service_traits::datatype<Srv>()] = [this](const std::string& name) { return new TypedServiceBridge<Srv>(*this, name); };
+    }
+  };
+};
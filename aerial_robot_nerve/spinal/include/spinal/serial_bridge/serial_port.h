@@ -0,0 +1,75 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace spinal
+{
+  namespace serial_bridge
+  {
+    /* raw serial port or the master of a pseudo terminal */
+    class SerialPort
+    {
+    public:
+      SerialPort(): fd_(-1) {}
+      ~SerialPort() { close(); }
+      SerialPort(const SerialPort&) = delete;
+      SerialPort& operator=(const SerialPort&) = delete;
+
+      bool open(const std::string& port, int baud);
+      /* open a pseudo terminal pair, this is the master and slave_name is the path of the slave */
+      bool openPty(std::string& slave_name);
+      void close();
+      bool isOpen() const { return fd_ >= 0; }
+
+      /* wait up to timeout_ms for the data, return the read size, 0 for timeout, -1 for error */
+      int read(uint8_t* data, size_t size, int timeout_ms);
+      /* write all data */
+      bool write(const uint8_t* data, size_t size);
+
+      const std::string& getError() const { return error_; }
+
+    private:
+      int fd_;
+      std::string error_;
+
+      bool setRaw(int baud);
+    };
+  };
+};
@@ -0,0 +1,122 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <spinal/serial_bridge/loopback_client.h>
+
+using namespace spinal::serial_bridge;
+
+LoopbackClient::LoopbackClient(const std::vector<Endpoint>& endpoints, MessageHandler handler):
+  endpoints_(endpoints), handler_(handler),
+  running_(false), synchronized_(false), negotiations_(0), received_(0)
+{
+}
+
+bool LoopbackClient::start(const std::string& port)
+{
+  stop();
+  if(!port_.open(port, 0)) return false;
+
+  running_ = true;
+  thread_ = std::thread(&LoopbackClient::threadFunc, this);
+  return true;
+}
+
+void LoopbackClient::stop()
+{
+  running_ = false;
+  if(thread_.joinable()) thread_.join();
+  port_.close();
+}
+
+bool LoopbackClient::publish(uint16_t topic_id, const uint8_t* payload, uint16_t length)
+{
+  FrameBuffer frame;
+  frame.append(topic_id, payload, length);
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  return port_.write(frame.data(), frame.size());
+}
+
+void LoopbackClient::threadFunc()
+{
+  FrameDecoder decoder([this](uint16_t topic_id, const uint8_t* payload, uint16_t length)
+                       {
+                         onFrame(topic_id, payload, length);
+                       });
+
+  uint8_t buf[1024];
+  while(running_)
+    {
+      int n = port_.read(buf, sizeof(buf), 10);
+      if(n < 0) break;
+      if(n > 0) decoder.feed(buf, n);
+    }
+}
+
+void LoopbackClient::onFrame(uint16_t topic_id, const uint8_t* payload, uint16_t length)
+{
+  switch(topic_id)
+    {
+    case protocol::ID_PUBLISHER:
+      {
+        // topic request: all endpoints in one write, then the time
+        if(length != 0) return;
+        FrameBuffer frames;
+        for(const auto& endpoint: endpoints_)
+          {
+            std::vector<uint8_t> info = encodeTopicInfo(endpoint.info);
+            frames.append(endpoint.type, info.data(), info.size());
+          }
+        std::vector<uint8_t> time = encodeTime(0, 0);
+        frames.append(protocol::ID_TIME, time.data(), time.size());
+
+        // count before the write, the host can observe the reply before this thread continues
+        negotiations_++;
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        port_.write(frames.data(), frames.size());
+        return;
+      }
+    case protocol::ID_TIME:
+      synchronized_ = true;
+      return;
+    case protocol::ID_TX_STOP:
+      synchronized_ = false;
+      return;
+    default:
+      if(topic_id < protocol::ID_CLIENT_START) return;
+      received_++;
+      if(handler_) handler_(*this, topic_id, payload, length);
+      return;
+    }
+}
@@ -0,0 +1,206 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <spinal/serial_bridge/protocol.h>
+#include <algorithm>
+
+using namespace spinal::serial_bridge;
+
+namespace
+{
+  uint8_t checksum(const uint8_t* data, size_t size)
+  {
+    uint32_t sum = 0;
+    for(size_t i = 0; i < size; i++) sum += data[i];
+    return 255 - sum % 256;
+  }
+};
+
+uint8_t* FrameBuffer::beginFrame(uint16_t topic_id, uint16_t length)
+{
+  frame_begin_ = buffer_.size();
+  buffer_.resize(frame_begin_ + protocol::FRAME_OVERHEAD + length);
+  uint8_t* frame = &buffer_[frame_begin_];
+  frame[0] = protocol::SYNC_FLAG;
+  frame[1] = protocol::PROTOCOL_VER;
+  frame[2] = length & 0xff;
+  frame[3] = length >> 8;
+  frame[4] = checksum(frame + 2, 2);
+  frame[5] = topic_id & 0xff;
+  frame[6] = topic_id >> 8;
+  return frame + protocol::HEADER_SIZE;
+}
+
+void FrameBuffer::endFrame()
+{
+  uint8_t* frame = &buffer_[frame_begin_];
+  uint16_t length = frame[2] | (frame[3] << 8);
+  frame[protocol::HEADER_SIZE + length] = checksum(frame + 5, length + 2);
+  frames_++;
+}
+
+void FrameBuffer::append(uint16_t topic_id, const uint8_t* payload, uint16_t length)
+{
+  uint8_t* p = beginFrame(topic_id, length);
+  if(length > 0) std::copy(payload, payload + length, p);
+  endFrame();
+}
+
+FrameDecoder::FrameDecoder(FrameHandler frame_handler, ErrorHandler error_handler, size_t max_payload):
+  frame_handler_(frame_handler), error_handler_(error_handler), max_payload_(max_payload)
+{
+}
+
+void FrameDecoder::feed(const uint8_t* data, size_t size)
+{
+  if(pending_.empty())
+    {
+      // decode in place, keep only the incomplete frame
+      size_t used = parse(data, size);
+      pending_.assign(data + used, data + size);
+    }
+  else
+    {
+      pending_.insert(pending_.end(), data, data + size);
+      size_t used = parse(pending_.data(), pending_.size());
+      pending_.erase(pending_.begin(), pending_.begin() + used);
+    }
+}
+
+size_t FrameDecoder::parse(const uint8_t* data, size_t size)
+{
+  size_t i = 0;
+  while(true)
+    {
+      while(i < size && data[i] != protocol::SYNC_FLAG)
+        {
+          i++;
+          stats_.skipped_bytes++;
+        }
+
+      if(size - i < 2) return i;
+      if(data[i + 1] != protocol::PROTOCOL_VER)
+        {
+          i++;
+          stats_.skipped_bytes++;
+          continue;
+        }
+
+      if(size - i < 5) return i;
+      uint16_t length = data[i + 2] | (data[i + 3] << 8);
+      if(checksum(data + i + 2, 2) != data[i + 4] || length > max_payload_)
+        {
+          // not a frame header, search the next sync flag
+          i++;
+          stats_.length_errors++;
+          continue;
+        }
+
+      if(size - i < protocol::FRAME_OVERHEAD + length) return i;
+      uint16_t topic_id = data[i + 5] | (data[i + 6] << 8);
+      if(checksum(data + i + 5, length + 2) != data[i + protocol::HEADER_SIZE + length])
+        {
+          i++;
+          stats_.checksum_errors++;
+          if(error_handler_) error_handler_(topic_id);
+          continue;
+        }
+
+      stats_.frames++;
+      frame_handler_(topic_id, data + i + protocol::HEADER_SIZE, length);
+      i += protocol::FRAME_OVERHEAD + length;
+    }
+}
+
+std::string PayloadReader::readString()
+{
+  uint32_t length = read<uint32_t>();
+  if(!ok_ || pos_ + length > size_)
+    {
+      ok_ = false;
+      return std::string();
+    }
+  std::string str(reinterpret_cast<const char*>(data_ + pos_), length);
+  pos_ += length;
+  return str;
+}
+
+void PayloadWriter::writeString(const std::string& str)
+{
+  write<uint32_t>(str.size());
+  data_.insert(data_.end(), str.begin(), str.end());
+}
+
+bool spinal::serial_bridge::decodeTopicInfo(const uint8_t* payload, uint16_t length, TopicInfo& info)
+{
+  PayloadReader reader(payload, length);
+  info.topic_id = reader.read<uint16_t>();
+  info.topic_name = reader.readString();
+  info.message_type = reader.readString();
+  info.md5sum = reader.readString();
+  info.buffer_size = reader.read<int32_t>();
+  return reader.ok();
+}
+
+std::vector<uint8_t> spinal::serial_bridge::encodeTopicInfo(const TopicInfo& info)
+{
+  PayloadWriter writer;
+  writer.write<uint16_t>(info.topic_id);
+  writer.writeString(info.topic_name);
+  writer.writeString(info.message_type);
+  writer.writeString(info.md5sum);
+  writer.write<int32_t>(info.buffer_size);
+  return writer.data();
+}
+
+std::vector<uint8_t> spinal::serial_bridge::encodeParamResponse(const ParamResponse& response)
+{
+  PayloadWriter writer;
+  writer.write<uint32_t>(response.ints.size());
+  for(const auto v: response.ints) writer.write<int32_t>(v);
+  writer.write<uint32_t>(response.floats.size());
+  for(const auto v: response.floats) writer.write<float>(v);
+  writer.write<uint32_t>(response.strings.size());
+  for(const auto& v: response.strings) writer.writeString(v);
+  return writer.data();
+}
+
+std::vector<uint8_t> spinal::serial_bridge::encodeTime(uint32_t sec, uint32_t nsec)
+{
+  PayloadWriter writer;
+  writer.write<uint32_t>(sec);
+  writer.write<uint32_t>(nsec);
+  return writer.data();
+}
@@ -0,0 +1,692 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <spinal/serial_bridge/serial_bridge.h>
+#include <spinal/Barometer.h>
+#include <spinal/BoardInfo.h>
+#include <spinal/DesireCoord.h>
+#include <spinal/FlightConfigCmd.h>
+#include <spinal/FourAxisCommand.h>
+#include <spinal/GetBoardInfo.h>
+#include <spinal/Gps.h>
+#include <spinal/GpsFull.h>
+#include <spinal/Gyro.h>
+#include <spinal/Imu.h>
+#include <spinal/ImuCalib.h>
+#include <spinal/MagDeclination.h>
+#include <spinal/PMatrixPseudoInverseWithInertia.h>
+#include <spinal/PwmInfo.h>
+#include <spinal/PwmTest.h>
+#include <spinal/Pwms.h>
+#include <spinal/RollPitchYawTerms.h>
+#include <spinal/ServoControlCmd.h>
+#include <spinal/ServoStates.h>
+#include <spinal/ServoTorqueCmd.h>
+#include <spinal/ServoTorqueStates.h>
+#include <spinal/SetAttitudeGains.h>
+#include <spinal/SetBoardConfig.h>
+#include <spinal/SimpleImu.h>
+#include <spinal/TorqueAllocationMatrixInv.h>
+#include <spinal/UavInfo.h>
+#include <std_msgs/Float32.h>
+#include <std_msgs/Float32MultiArray.h>
+#include <std_msgs/UInt8.h>
+#include <std_msgs/UInt16.h>
+#include <std_srvs/SetBool.h>
+
+using namespace spinal::serial_bridge;
+
+namespace
+{
+  /* fallback for the types without precompiled handler */
+  class GenericInbound : public Inbound
+  {
+  public:
+    GenericInbound(ros::NodeHandle nh, const TopicInfo& info): Inbound(info), nh_(nh) {}
+
+    bool decode(const uint8_t* payload, uint16_t length) override
+    {
+      boost::shared_ptr<topic_tools::ShapeShifter> msg = boost::make_shared<topic_tools::ShapeShifter>();
+      msg->morph(info_.md5sum, info_.message_type, "", "false");
+      ros::serialization::IStream stream(const_cast<uint8_t*>(payload), length);
+      msg->read(stream);
+      if(!pub_) pub_ = msg->advertise(nh_, info_.topic_name, 10);
+      pub_.publish(msg);
+      return true;
+    }
+
+  private:
+    ros::NodeHandle nh_;
+    ros::Publisher pub_;
+  };
+
+  class GenericOutbound : public Outbound
+  {
+  public:
+    GenericOutbound(SerialBridge& bridge, ros::NodeHandle nh, const TopicInfo& info): Outbound(bridge, info)
+    {
+      ros::SubscribeOptions ops;
+      ops.init<topic_tools::ShapeShifter>(info.topic_name, 10, boost::bind(&GenericOutbound::callback, this, _1));
+      ops.callback_queue = bridge.getTxQueue();
+      ops.transport_hints = ros::TransportHints().tcpNoDelay();
+      sub_ = nh.subscribe(ops);
+    }
+
+  private:
+    void callback(const topic_tools::ShapeShifter::ConstPtr& msg)
+    {
+      if(msg->getMD5Sum() != info_.md5sum)
+        {
+          stats.dropped++;
+          ROS_WARN_THROTTLE(1.0, "[spinal bridge] %s: md5sum of %s does not match", info_.topic_name.c_str(), msg->getDataType().c_str());
+          return;
+        }
+
+      uint32_t length = msg->size();
+      bridge_.send(info_.topic_id, length, [&msg, length](uint8_t* p)
+                   {
+                     ros::serialization::OStream stream(p, length);
+                     msg->write(stream);
+                   }, &stats);
+    }
+  };
+};
+
+uint64_t spinal::serial_bridge::wallNow()
+{
+  return ros::WallTime::now().toNSec();
+}
+
+void ServiceBridge::onResponse(const uint8_t* payload, uint16_t length)
+{
+  std::lock_guard<std::mutex> lock(response_mutex_);
+  response_.assign(payload, payload + length);
+  response_ready_ = true;
+  response_cv_.notify_all();
+}
+
+bool ServiceBridge::call(uint32_t length, const std::function<void(uint8_t*)>& serialize, std::vector<uint8_t>& response)
+{
+  std::lock_guard<std::mutex> call_lock(call_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(response_mutex_);
+    response_ready_ = false;
+  }
+
+  uint64_t start = wallNow();
+  if(!bridge_.send(request_id_, length, serialize, nullptr))
+    {
+      stats.dropped++;
+      return false;
+    }
+  bridge_.flush();
+
+  std::unique_lock<std::mutex> lock(response_mutex_);
+  if(!response_cv_.wait_for(lock, std::chrono::duration<double>(bridge_.getServiceTimeout()), [this] { return response_ready_; }))
+    {
+      stats.dropped++;
+      ROS_WARN("[spinal bridge] no response of the service %s from spinal", name_.c_str());
+      return false;
+    }
+
+  response.swap(response_);
+  stats.messages++;
+  stats.addLatency(wallNow() - start);
+  return true;
+}
+
+SerialBridge::SerialBridge(ros::NodeHandle nh, ros::NodeHandle nhp):
+  nh_(nh), nhp_(nhp), running_(false), tx_bytes_(0), tx_writes_(0),
+  negotiated_(false), rx_stamp_(0), rx_bytes_(0)
+{
+  nhp_.param("port", port_name_, std::string("/dev/ttyUSB0"));
+  nhp_.param("baud", baud_, 921600);
+  nhp_.param("negotiation_timeout", negotiation_timeout_, 1.0);
+  nhp_.param("link_timeout", link_timeout_, 5.0);
+  nhp_.param("service_timeout", service_timeout_, 1.0);
+  int max_tx_buffer;
+  nhp_.param("max_tx_buffer", max_tx_buffer, 4096); // [byte] of one batch
+  max_tx_buffer_ = max_tx_buffer;
+
+  registerHandlers();
+
+  bool loopback;
+  nhp_.param("loopback", loopback, false);
+  if(loopback)
+    {
+      if(!startLoopback()) return;
+    }
+  else if(!port_.open(port_name_, baud_))
+    {
+      ROS_ERROR_STREAM("[spinal bridge] " << port_.getError());
+      return;
+    }
+
+  double stats_rate;
+  nhp_.param("stats_rate", stats_rate, 1.0);
+  diagnostics_pub_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", 1);
+  if(stats_rate > 0)
+    stats_timer_ = nhp_.createWallTimer(ros::WallDuration(1.0 / stats_rate), &SerialBridge::statsCallback, this);
+
+  running_ = true;
+  rx_thread_ = std::thread(&SerialBridge::rxThread, this);
+  tx_thread_ = std::thread(&SerialBridge::txThread, this);
+}
+
+SerialBridge::~SerialBridge()
+{
+  running_ = false;
+  stats_timer_.stop();
+  if(rx_thread_.joinable()) rx_thread_.join();
+  if(tx_thread_.joinable()) tx_thread_.join();
+  if(loopback_) loopback_->stop();
+
+  // stop the outbound callbacks before the queue
+  services_.clear();
+  outbounds_.clear();
+  inbounds_.clear();
+}
+
+void SerialBridge::registerHandlers()
+{
+  // to spinal
+  registerMessage<spinal::FourAxisCommand>();
+  registerMessage<spinal::RollPitchYawTerms>();
+  registerMessage<spinal::PwmInfo>();
+  registerMessage<spinal::UavInfo>();
+  registerMessage<spinal::PMatrixPseudoInverseWithInertia>();
+  registerMessage<spinal::TorqueAllocationMatrixInv>();
+  registerMessage<spinal::ServoControlCmd>();
+  registerMessage<spinal::ServoTorqueCmd>();
+  registerMessage<spinal::PwmTest>();
+  registerMessage<spinal::FlightConfigCmd>();
+  registerMessage<spinal::DesireCoord>();
+  registerMessage<std_msgs::UInt8>();
+  registerMessage<std_msgs::Float32>();
+
+  // from spinal
+  registerMessage<spinal::Imu>();
+  registerMessage<spinal::SimpleImu>();
+  registerMessage<spinal::Gyro>();
+  registerMessage<spinal::Barometer>();
+  registerMessage<spinal::Gps>();
+  registerMessage<spinal::GpsFull>();
+  registerMessage<spinal::Pwms>();
+  registerMessage<spinal::ServoStates>();
+  registerMessage<spinal::ServoTorqueStates>();
+  registerMessage<spinal::BoardInfo>();
+  registerMessage<std_msgs::UInt16>();
+  registerMessage<std_msgs::Float32MultiArray>();
+
+  registerService<spinal::GetBoardInfo>();
+  registerService<spinal::SetBoardConfig>();
+  registerService<spinal::ImuCalib>();
+  registerService<spinal::MagDeclination>();
+  registerService<spinal::SetAttitudeGains>();
+  registerService<std_srvs::SetBool>();
+}
+
+bool SerialBridge::startLoopback()
+{
+  std::string slave;
+  if(!port_.openPty(slave))
+    {
+      ROS_ERROR_STREAM("[spinal bridge] " << port_.getError());
+      return false;
+    }
+
+  // emulated subscribers of spinal, and the publishers echoing them
+  std::map<std::string, std::string> topics;
+  if(!nhp_.getParam("loopback/topics", topics))
+    topics = {{"four_axes/command", "spinal/FourAxisCommand"},
+              {"rpy/gain", "spinal/RollPitchYawTerms"},
+              {"uav_info", "spinal/UavInfo"},
+              {"servo/target_states", "spinal/ServoControlCmd"}};
+
+  std::vector<LoopbackClient::Endpoint> endpoints;
+  std::map<uint16_t, uint16_t> echo_ids;
+  uint16_t id = protocol::ID_CLIENT_START;
+  for(const auto& topic: topics)
+    {
+      auto handler = message_handlers_.find(topic.second);
+      if(handler == message_handlers_.end())
+        {
+          ROS_ERROR_STREAM("[spinal bridge] loopback: no precompiled handler for " << topic.second);
+          continue;
+        }
+
+      LoopbackClient::Endpoint sub, pub;
+      sub.type = protocol::ID_SUBSCRIBER;
+      sub.info.topic_id = id++;
+      sub.info.topic_name = topic.first;
+      sub.info.message_type = topic.second;
+      sub.info.md5sum = handler->second.md5sum;
+      pub.type = protocol::ID_PUBLISHER;
+      pub.info = sub.info;
+      pub.info.topic_id = id++;
+      pub.info.topic_name = "loopback/" + topic.first;
+      echo_ids[sub.info.topic_id] = pub.info.topic_id;
+      endpoints.push_back(sub);
+      endpoints.push_back(pub);
+    }
+
+  loopback_.reset(new LoopbackClient(endpoints, [echo_ids](LoopbackClient& client, uint16_t topic_id, const uint8_t* payload, uint16_t length)
+                                     {
+                                       auto it = echo_ids.find(topic_id);
+                                       if(it != echo_ids.end()) client.publish(it->second, payload, length);
+                                     }));
+  if(!loopback_->start(slave))
+    {
+      ROS_ERROR_STREAM("[spinal bridge] loopback: can not open " << slave);
+      return false;
+    }
+
+  ROS_INFO_STREAM("[spinal bridge] loopback on " << slave);
+  return true;
+}
+
+bool SerialBridge::send(uint16_t topic_id, uint32_t length, const std::function<void(uint8_t*)>& serialize, EndpointStats* stats)
+{
+  uint64_t stamp = wallNow();
+  std::lock_guard<std::mutex> lock(tx_mutex_);
+  if(length > protocol::MAX_PAYLOAD || tx_buffer_.size() + length + protocol::FRAME_OVERHEAD > max_tx_buffer_)
+    {
+      if(stats) stats->dropped++;
+      return false;
+    }
+
+  serialize(tx_buffer_.beginFrame(topic_id, length));
+  tx_buffer_.endFrame();
+  if(stats) tx_pending_.push_back(std::make_pair(stats, stamp));
+  return true;
+}
+
+void SerialBridge::flush()
+{
+  std::lock_guard<std::mutex> write_lock(write_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(tx_mutex_);
+    if(tx_buffer_.empty()) return;
+    tx_writing_.swap(tx_buffer_);
+    tx_pending_writing_.swap(tx_pending_);
+  }
+
+  bool ok = port_.write(tx_writing_.data(), tx_writing_.size());
+  uint64_t now = wallNow();
+  for(const auto& pending: tx_pending_writing_)
+    {
+      if(ok)
+        {
+          pending.first->messages++;
+          pending.first->addLatency(now - pending.second);
+        }
+      else pending.first->dropped++;
+    }
+  if(ok)
+    {
+      tx_bytes_ += tx_writing_.size();
+      tx_writes_++;
+    }
+  else ROS_ERROR_STREAM_THROTTLE(1.0, "[spinal bridge] " << port_.getError());
+
+  tx_writing_.clear();
+  tx_pending_writing_.clear();
+}
+
+void SerialBridge::txThread()
+{
+  while(running_ && ros::ok())
+    {
+      // the messages of one control tick are written at once
+      tx_queue_.callAvailable(ros::WallDuration(0.01));
+      flush();
+    }
+}
+
+void SerialBridge::sendControl(uint16_t topic_id, const std::vector<uint8_t>& payload)
+{
+  send(topic_id, payload.size(), [&payload](uint8_t* p) { std::copy(payload.begin(), payload.end(), p); }, nullptr);
+  flush();
+}
+
+void SerialBridge::requestTopics()
+{
+  sendControl(protocol::ID_PUBLISHER, std::vector<uint8_t>());
+  last_topic_request_ = ros::WallTime::now();
+}
+
+void SerialBridge::rxThread()
+{
+  FrameDecoder decoder([this](uint16_t topic_id, const uint8_t* payload, uint16_t length) { onFrame(topic_id, payload, length); },
+                       [this](uint16_t topic_id) { onChecksumError(topic_id); });
+
+  last_frame_ = ros::WallTime::now();
+  requestTopics();
+
+  std::vector<uint8_t> buf(4096);
+  while(running_ && ros::ok())
+    {
+      int n = port_.read(buf.data(), buf.size(), 10);
+      if(n < 0)
+        {
+          ROS_ERROR_STREAM_THROTTLE(1.0, "[spinal bridge] " << port_.getError());
+          ros::WallDuration(0.1).sleep();
+          continue;
+        }
+
+      if(n > 0)
+        {
+          rx_stamp_ = wallNow();
+          rx_bytes_ += n;
+          decoder.feed(buf.data(), n);
+          std::lock_guard<std::mutex> lock(decoder_stats_mutex_);
+          decoder_stats_ = decoder.getStats();
+        }
+
+      ros::WallTime now = ros::WallTime::now();
+      if(negotiated_ && (now - last_frame_).toSec() > link_timeout_)
+        {
+          ROS_WARN("[spinal bridge] no data from spinal for %f sec, request the topics again", link_timeout_);
+          negotiated_ = false;
+        }
+      if(!negotiated_ && (now - last_topic_request_).toSec() > negotiation_timeout_)
+        {
+          decoder.reset();
+          requestTopics();
+        }
+    }
+}
+
+void SerialBridge::onFrame(uint16_t topic_id, const uint8_t* payload, uint16_t length)
+{
+  last_frame_ = ros::WallTime::now();
+
+  if(topic_id >= protocol::ID_CLIENT_START)
+    {
+      auto inbound = inbounds_.find(topic_id);
+      if(inbound != inbounds_.end())
+        {
+          EndpointStats& stats = inbound->second->stats;
+          if(inbound->second->decode(payload, length))
+            {
+              stats.messages++;
+              stats.addLatency(wallNow() - rx_stamp_);
+            }
+          else stats.errors++;
+          return;
+        }
+
+      auto service = service_responses_.find(topic_id);
+      if(service != service_responses_.end()) service->second->onResponse(payload, length);
+      return;
+    }
+
+  switch(topic_id)
+    {
+    case protocol::ID_PUBLISHER:
+    case protocol::ID_SUBSCRIBER:
+    case protocol::ID_SERVICE_SERVER + protocol::ID_PUBLISHER:
+    case protocol::ID_SERVICE_SERVER + protocol::ID_SUBSCRIBER:
+      onTopicInfo(topic_id, payload, length);
+      break;
+    case protocol::ID_SERVICE_CLIENT + protocol::ID_PUBLISHER:
+    case protocol::ID_SERVICE_CLIENT + protocol::ID_SUBSCRIBER:
+      ROS_WARN_ONCE("[spinal bridge] service clients on spinal are not supported");
+      break;
+    case protocol::ID_PARAMETER_REQUEST:
+      onParameterRequest(payload, length);
+      break;
+    case protocol::ID_LOG:
+      onLog(payload, length);
+      break;
+    case protocol::ID_TIME:
+      {
+        ros::Time now = ros::Time::now();
+        sendControl(protocol::ID_TIME, encodeTime(now.sec, now.nsec));
+        break;
+      }
+    case protocol::ID_TX_STOP:
+      ROS_WARN("[spinal bridge] spinal stopped the link, request the topics again");
+      negotiated_ = false;
+      break;
+    default:
+      break;
+    }
+}
+
+void SerialBridge::onChecksumError(uint16_t topic_id)
+{
+  auto inbound = inbounds_.find(topic_id);
+  if(inbound != inbounds_.end()) inbound->second->stats.errors++;
+}
+
+void SerialBridge::onTopicInfo(uint16_t type, const uint8_t* payload, uint16_t length)
+{
+  TopicInfo info;
+  if(!decodeTopicInfo(payload, length, info))
+    {
+      ROS_ERROR("[spinal bridge] invalid topic info");
+      return;
+    }
+  negotiated_ = true;
+
+  if(type == protocol::ID_SERVICE_SERVER + protocol::ID_PUBLISHER || type == protocol::ID_SERVICE_SERVER + protocol::ID_SUBSCRIBER)
+    {
+      auto service = services_.find(info.topic_name);
+      if(service == services_.end())
+        {
+          auto factory = service_handlers_.find(info.message_type);
+          if(factory == service_handlers_.end())
+            {
+              ROS_ERROR("[spinal bridge] no precompiled handler for the service %s [%s]", info.topic_name.c_str(), info.message_type.c_str());
+              return;
+            }
+          std::lock_guard<std::mutex> lock(endpoints_mutex_);
+          service = services_.emplace(info.topic_name, std::unique_ptr<ServiceBridge>(factory->second(info.topic_name))).first;
+        }
+
+      ServiceBridge* bridge = service->second.get();
+      bool advertise = bridge->request_id_ == 0 || bridge->response_id_ == 0;
+      if(type == protocol::ID_SERVICE_SERVER + protocol::ID_PUBLISHER)
+        {
+          bridge->response_id_ = info.topic_id;
+          service_responses_[info.topic_id] = bridge;
+        }
+      else bridge->request_id_ = info.topic_id;
+
+      if(advertise && bridge->request_id_ != 0 && bridge->response_id_ != 0)
+        {
+          bridge->advertise(nh_);
+          ROS_INFO("[spinal bridge] setup service server %s [%s]", info.topic_name.c_str(), info.message_type.c_str());
+        }
+      return;
+    }
+
+  // the same endpoint is sent again after the re-negotiation
+  if(type == protocol::ID_PUBLISHER)
+    {
+      auto inbound = inbounds_.find(info.topic_id);
+      if(inbound != inbounds_.end() && inbound->second->getInfo().topic_name == info.topic_name) return;
+    }
+  else
+    {
+      auto outbound = outbounds_.find(info.topic_id);
+      if(outbound != outbounds_.end() && outbound->second->getInfo().topic_name == info.topic_name) return;
+    }
+
+  Inbound* inbound = nullptr;
+  Outbound* outbound = nullptr;
+  auto handler = message_handlers_.find(info.message_type);
+  bool precompiled = handler != message_handlers_.end() && handler->second.md5sum == info.md5sum;
+  if(handler != message_handlers_.end() && !precompiled)
+    ROS_WARN("[spinal bridge] md5sum of %s [%s] does not match, use the generic handler", info.topic_name.c_str(), info.message_type.c_str());
+
+  if(type == protocol::ID_PUBLISHER)
+    inbound = precompiled ? handler->second.inbound(info) : new GenericInbound(nh_, info);
+  else
+    outbound = precompiled ? handler->second.outbound(info) : new GenericOutbound(*this, nh_, info);
+
+  std::lock_guard<std::mutex> lock(endpoints_mutex_);
+  if(inbound) inbounds_[info.topic_id].reset(inbound);
+  if(outbound) outbounds_[info.topic_id].reset(outbound);
+
+  ROS_INFO("[spinal bridge] setup %s %s [%s]%s", type == protocol::ID_PUBLISHER ? "publisher" : "subscriber",
+           info.topic_name.c_str(), info.message_type.c_str(), precompiled ? "" : " with the generic handler");
+}
+
+void SerialBridge::onParameterRequest(const uint8_t* payload, uint16_t length)
+{
+  PayloadReader reader(payload, length);
+  std::string name = reader.readString();
+
+  ParamResponse response;
+  XmlRpc::XmlRpcValue value;
+  if(reader.ok() && nh_.getParam(name, value))
+    {
+      auto add = [&response](XmlRpc::XmlRpcValue& v)
+        {
+          switch(v.getType())
+            {
+            case XmlRpc::XmlRpcValue::TypeBoolean: response.ints.push_back((bool)v); break;
+            case XmlRpc::XmlRpcValue::TypeInt: response.ints.push_back((int)v); break;
+            case XmlRpc::XmlRpcValue::TypeDouble: response.floats.push_back((double)v); break;
+            case XmlRpc::XmlRpcValue::TypeString: response.strings.push_back((std::string)v); break;
+            default: break;
+            }
+        };
+      if(value.getType() == XmlRpc::XmlRpcValue::TypeArray)
+        for(int i = 0; i < value.size(); i++) add(value[i]);
+      else add(value);
+    }
+  else
+    ROS_WARN_STREAM("[spinal bridge] spinal requests an unknown parameter " << name);
+
+  sendControl(protocol::ID_PARAMETER_REQUEST, encodeParamResponse(response));
+}
+
+void SerialBridge::onLog(const uint8_t* payload, uint16_t length)
+{
+  PayloadReader reader(payload, length);
+  uint8_t level = reader.read<uint8_t>();
+  std::string msg = reader.readString();
+  if(!reader.ok()) return;
+
+  switch(level)
+    {
+    case protocol::ROSDEBUG: ROS_DEBUG_STREAM("[spinal] " << msg); break;
+    case protocol::INFO: ROS_INFO_STREAM("[spinal] " << msg); break;
+    case protocol::WARN: ROS_WARN_STREAM("[spinal] " << msg); break;
+    case protocol::ERROR: ROS_ERROR_STREAM("[spinal] " << msg); break;
+    case protocol::FATAL: ROS_FATAL_STREAM("[spinal] " << msg); break;
+    default: break;
+    }
+}
+
+void SerialBridge::statsCallback(const ros::WallTimerEvent& e)
+{
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+
+  auto add_status = [this, &msg](const std::string& name, const std::string& direction, const EndpointStats& stats)
+    {
+      diagnostic_msgs::DiagnosticStatus status;
+      status.name = "spinal_bridge: " + name;
+      status.hardware_id = port_name_;
+
+      uint64_t messages = stats.messages, failures = stats.dropped + stats.errors;
+      uint64_t& prev = prev_failures_[name];
+      if(failures > prev)
+        {
+          status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+          status.message = std::to_string(failures - prev) + " messages lost";
+        }
+      else
+        {
+          status.level = diagnostic_msgs::DiagnosticStatus::OK;
+          status.message = "OK";
+        }
+      prev = failures;
+
+      auto add_value = [&status](const std::string& key, const std::string& value)
+        {
+          diagnostic_msgs::KeyValue kv;
+          kv.key = key;
+          kv.value = value;
+          status.values.push_back(kv);
+        };
+      add_value("direction", direction);
+      add_value("messages", std::to_string(messages));
+      add_value("dropped", std::to_string(stats.dropped));
+      add_value("errors", std::to_string(stats.errors));
+      add_value("mean_latency_ms", std::to_string(messages > 0 ? stats.latency_sum * 1e-6 / messages : 0.0));
+      add_value("max_latency_ms", std::to_string(stats.latency_max * 1e-6));
+      msg.status.push_back(status);
+    };
+
+  {
+    std::lock_guard<std::mutex> lock(endpoints_mutex_);
+    for(const auto& inbound: inbounds_) add_status(inbound.second->getInfo().topic_name, "from spinal", inbound.second->stats);
+    for(const auto& outbound: outbounds_) add_status(outbound.second->getInfo().topic_name, "to spinal", outbound.second->stats);
+    for(const auto& service: services_) add_status(service.first, "service", service.second->stats);
+  }
+
+  DecoderStats decoder_stats;
+  {
+    std::lock_guard<std::mutex> lock(decoder_stats_mutex_);
+    decoder_stats = decoder_stats_;
+  }
+  diagnostic_msgs::DiagnosticStatus link;
+  link.name = "spinal_bridge: link";
+  link.hardware_id = port_name_;
+  link.level = negotiated_ ? diagnostic_msgs::DiagnosticStatus::OK : diagnostic_msgs::DiagnosticStatus::WARN;
+  link.message = negotiated_ ? "OK" : "not connected";
+  auto add_value = [&link](const std::string& key, uint64_t value)
+    {
+      diagnostic_msgs::KeyValue kv;
+      kv.key = key;
+      kv.value = std::to_string(value);
+      link.values.push_back(kv);
+    };
+  add_value("rx_bytes", rx_bytes_);
+  add_value("rx_frames", decoder_stats.frames);
+  add_value("skipped_bytes", decoder_stats.skipped_bytes);
+  add_value("length_errors", decoder_stats.length_errors);
+  add_value("checksum_errors", decoder_stats.checksum_errors);
+  add_value("tx_bytes", tx_bytes_);
+  add_value("tx_writes", tx_writes_);
+  msg.status.push_back(link);
+
+  diagnostics_pub_.publish(msg);
+}
@@ -0,0 +1,216 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <spinal/serial_bridge/serial_port.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace spinal::serial_bridge;
+
+namespace
+{
+  speed_t baudToSpeed(int baud)
+  {
+    switch(baud)
+      {
+      case 9600: return B9600;
+      case 19200: return B19200;
+      case 38400: return B38400;
+      case 57600: return B57600;
+      case 115200: return B115200;
+      case 230400: return B230400;
+      case 460800: return B460800;
+      case 921600: return B921600;
+      case 1000000: return B1000000;
+      case 2000000: return B2000000;
+      default: return 0;
+      }
+  }
+};
+
+bool SerialPort::open(const std::string& port, int baud)
+{
+  close();
+  fd_ = ::open(port.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if(fd_ < 0)
+    {
+      error_ = "can not open " + port + ": " + std::strerror(errno);
+      return false;
+    }
+
+  if(!setRaw(baud))
+    {
+      close();
+      return false;
+    }
+  return true;
+}
+
+bool SerialPort::openPty(std::string& slave_name)
+{
+  close();
+  fd_ = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if(fd_ < 0 || grantpt(fd_) != 0 || unlockpt(fd_) != 0)
+    {
+      error_ = std::string("can not open a pseudo terminal: ") + std::strerror(errno);
+      close();
+      return false;
+    }
+
+  char name[128];
+  if(ptsname_r(fd_, name, sizeof(name)) != 0)
+    {
+      error_ = std::string("can not get the slave name: ") + std::strerror(errno);
+      close();
+      return false;
+    }
+  slave_name = name;
+
+  // no echo and no line discipline on the slave side
+  int slave = ::open(name, O_RDWR | O_NOCTTY);
+  if(slave >= 0)
+    {
+      struct termios tio;
+      if(tcgetattr(slave, &tio) == 0)
+        {
+          cfmakeraw(&tio);
+          tcsetattr(slave, TCSANOW, &tio);
+        }
+      ::close(slave);
+    }
+
+  return setRaw(0);
+}
+
+bool SerialPort::setRaw(int baud)
+{
+  struct termios tio;
+  if(tcgetattr(fd_, &tio) != 0)
+    {
+      error_ = std::string("tcgetattr: ") + std::strerror(errno);
+      return false;
+    }
+
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  if(baud > 0)
+    {
+      speed_t speed = baudToSpeed(baud);
+      if(speed == 0)
+        {
+          error_ = "unsupported baud rate " + std::to_string(baud);
+          return false;
+        }
+      cfsetispeed(&tio, speed);
+      cfsetospeed(&tio, speed);
+    }
+
+  if(tcsetattr(fd_, TCSANOW, &tio) != 0)
+    {
+      error_ = std::string("tcsetattr: ") + std::strerror(errno);
+      return false;
+    }
+  tcflush(fd_, TCIOFLUSH);
+  return true;
+}
+
+void SerialPort::close()
+{
+  if(fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
+
+int SerialPort::read(uint8_t* data, size_t size, int timeout_ms)
+{
+  struct pollfd pfd = {fd_, POLLIN, 0};
+  int ret = poll(&pfd, 1, timeout_ms);
+  if(ret < 0)
+    {
+      if(errno == EINTR) return 0;
+      error_ = std::string("poll: ") + std::strerror(errno);
+      return -1;
+    }
+  if(ret == 0) return 0;
+  if(pfd.revents & (POLLERR | POLLNVAL))
+    {
+      error_ = "serial port error";
+      return -1;
+    }
+  if(!(pfd.revents & POLLIN))
+    {
+      // POLLHUP of a pseudo terminal until the slave is opened
+      usleep(timeout_ms * 1000);
+      return 0;
+    }
+
+  ssize_t n = ::read(fd_, data, size);
+  if(n < 0)
+    {
+      if(errno == EAGAIN || errno == EINTR) return 0;
+      error_ = std::string("read: ") + std::strerror(errno);
+      return -1;
+    }
+  return n;
+}
+
+bool SerialPort::write(const uint8_t* data, size_t size)
+{
+  size_t written = 0;
+  while(written < size)
+    {
+      ssize_t n = ::write(fd_, data + written, size - written);
+      if(n < 0)
+        {
+          if(errno == EINTR) continue;
+          if(errno == EAGAIN)
+            {
+              // the driver buffer is full
+              struct pollfd pfd = {fd_, POLLOUT, 0};
+              if(poll(&pfd, 1, 100) > 0) continue;
+            }
+          error_ = std::string("write: ") + std::strerror(errno);
+          return false;
+        }
+      written += n;
+    }
+  return true;
+}
@@ -0,0 +1,259 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <spinal/serial_bridge/loopback_client.h>
+#include <spinal/serial_bridge/protocol.h>
+#include <spinal/serial_bridge/serial_port.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+using namespace spinal::serial_bridge;
+
+namespace
+{
+  struct Frame
+  {
+    uint16_t topic_id;
+    std::vector<uint8_t> payload;
+  };
+
+  std::vector<uint8_t> createPayload(size_t size, uint8_t seed)
+  {
+    std::vector<uint8_t> payload(size);
+    for(size_t i = 0; i < size; i++) payload[i] = seed + i * 7;
+    return payload;
+  }
+
+  FrameDecoder createDecoder(std::vector<Frame>& frames, std::vector<uint16_t>& errors)
+  {
+    return FrameDecoder([&frames](uint16_t topic_id, const uint8_t* payload, uint16_t length)
+                        {
+                          frames.push_back(Frame{topic_id, std::vector<uint8_t>(payload, payload + length)});
+                        },
+                        [&errors](uint16_t topic_id) { errors.push_back(topic_id); });
+  }
+
+  /* rosserial frame of the topic request, generated by rosserial_server */
+  const std::vector<uint8_t> topic_request = {0xff, 0xfe, 0x00, 0x00, 0xff, 0x00, 0x00, 0xff};
+};
+
+TEST(SerialBridgeTest, frameFormat)
+{
+  FrameBuffer buffer;
+  buffer.append(protocol::ID_PUBLISHER, nullptr, 0);
+  ASSERT_EQ(buffer.size(), topic_request.size());
+  EXPECT_TRUE(std::equal(topic_request.begin(), topic_request.end(), buffer.data()));
+
+  // serialization in place
+  buffer.clear();
+  std::vector<uint8_t> payload = createPayload(300, 1);
+  uint8_t* p = buffer.beginFrame(125, payload.size());
+  std::copy(payload.begin(), payload.end(), p);
+  buffer.endFrame();
+  ASSERT_EQ(buffer.size(), payload.size() + protocol::FRAME_OVERHEAD);
+  EXPECT_EQ(buffer.data()[2], 300 & 0xff);
+  EXPECT_EQ(buffer.data()[3], 300 >> 8);
+  EXPECT_EQ(buffer.data()[4], 255 - ((300 & 0xff) + (300 >> 8)) % 256);
+  EXPECT_EQ(buffer.data()[5], 125);
+  EXPECT_EQ(buffer.data()[6], 0);
+}
+
+TEST(SerialBridgeTest, batchRoundTrip)
+{
+  FrameBuffer buffer;
+  std::vector<Frame> sent;
+  for(int i = 0; i < 20; i++)
+    {
+      sent.push_back(Frame{uint16_t(100 + i), createPayload(i * 13, i)});
+      buffer.append(sent.back().topic_id, sent.back().payload.data(), sent.back().payload.size());
+    }
+  EXPECT_EQ(buffer.frames(), sent.size());
+
+  // one feed, byte by byte and random chunks
+  for(size_t chunk: {buffer.size(), size_t(1), size_t(5), size_t(64)})
+    {
+      std::vector<Frame> frames;
+      std::vector<uint16_t> errors;
+      FrameDecoder decoder = createDecoder(frames, errors);
+      for(size_t i = 0; i < buffer.size(); i += chunk)
+        decoder.feed(buffer.data() + i, std::min(chunk, buffer.size() - i));
+
+      ASSERT_EQ(frames.size(), sent.size());
+      for(size_t i = 0; i < sent.size(); i++)
+        {
+          EXPECT_EQ(frames.at(i).topic_id, sent.at(i).topic_id);
+          EXPECT_EQ(frames.at(i).payload, sent.at(i).payload);
+        }
+      EXPECT_TRUE(errors.empty());
+      EXPECT_EQ(decoder.getStats().frames, sent.size());
+    }
+}
+
+TEST(SerialBridgeTest, resync)
+{
+  std::vector<uint8_t> payload = createPayload(40, 3);
+  FrameBuffer good;
+  good.append(101, payload.data(), payload.size());
+
+  // garbage with sync flags, a frame with a broken checksum, and an invalid length checksum
+  std::vector<uint8_t> stream = {0x12, 0xff, 0x34, 0xff, 0xff};
+  FrameBuffer broken;
+  broken.append(102, payload.data(), payload.size());
+  std::vector<uint8_t> corrupted(broken.data(), broken.data() + broken.size());
+  corrupted[protocol::HEADER_SIZE + 3] ^= 0x01;
+  stream.insert(stream.end(), corrupted.begin(), corrupted.end());
+  std::vector<uint8_t> bad_length = {0xff, 0xfe, 0x10, 0x00, 0x00};
+  stream.insert(stream.end(), bad_length.begin(), bad_length.end());
+  stream.insert(stream.end(), good.data(), good.data() + good.size());
+
+  for(size_t chunk: {stream.size(), size_t(1), size_t(7)})
+    {
+      std::vector<Frame> frames;
+      std::vector<uint16_t> errors;
+      FrameDecoder decoder = createDecoder(frames, errors);
+      for(size_t i = 0; i < stream.size(); i += chunk)
+        decoder.feed(stream.data() + i, std::min(chunk, stream.size() - i));
+
+      ASSERT_EQ(frames.size(), 1);
+      EXPECT_EQ(frames.front().topic_id, 101);
+      EXPECT_EQ(frames.front().payload, payload);
+      ASSERT_EQ(errors.size(), 1);
+      EXPECT_EQ(errors.front(), 102);
+      EXPECT_EQ(decoder.getStats().checksum_errors, 1);
+      EXPECT_EQ(decoder.getStats().length_errors, 1);
+      EXPECT_GT(decoder.getStats().skipped_bytes, 0);
+    }
+}
+
+TEST(SerialBridgeTest, topicInfo)
+{
+  TopicInfo info;
+  info.topic_id = 123;
+  info.topic_name = "four_axes/command";
+  info.message_type = "spinal/FourAxisCommand";
+  info.md5sum = "0123456789abcdef0123456789abcdef";
+  info.buffer_size = 512;
+
+  std::vector<uint8_t> payload = encodeTopicInfo(info);
+  TopicInfo decoded;
+  ASSERT_TRUE(decodeTopicInfo(payload.data(), payload.size(), decoded));
+  EXPECT_EQ(decoded.topic_id, info.topic_id);
+  EXPECT_EQ(decoded.topic_name, info.topic_name);
+  EXPECT_EQ(decoded.message_type, info.message_type);
+  EXPECT_EQ(decoded.md5sum, info.md5sum);
+  EXPECT_EQ(decoded.buffer_size, info.buffer_size);
+
+  EXPECT_FALSE(decodeTopicInfo(payload.data(), payload.size() - 1, decoded));
+}
+
+TEST(SerialBridgeTest, ptyLoopback)
+{
+  SerialPort host;
+  std::string slave;
+  ASSERT_TRUE(host.openPty(slave)) << host.getError();
+
+  TopicInfo sub_info, pub_info;
+  sub_info.topic_id = 100;
+  sub_info.topic_name = "four_axes/command";
+  sub_info.message_type = "spinal/FourAxisCommand";
+  pub_info = sub_info;
+  pub_info.topic_id = 101;
+  pub_info.topic_name = "loopback/four_axes/command";
+  std::vector<LoopbackClient::Endpoint> endpoints = {{protocol::ID_SUBSCRIBER, sub_info}, {protocol::ID_PUBLISHER, pub_info}};
+  LoopbackClient client(endpoints, [](LoopbackClient& client, uint16_t topic_id, const uint8_t* payload, uint16_t length)
+                        {
+                          client.publish(topic_id + 1, payload, length);
+                        });
+  ASSERT_TRUE(client.start(slave));
+
+  std::vector<Frame> frames;
+  std::vector<uint16_t> errors;
+  FrameDecoder decoder = createDecoder(frames, errors);
+  auto receive = [&](size_t n)
+    {
+      uint8_t buf[1024];
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+      while(frames.size() < n && std::chrono::steady_clock::now() < deadline)
+        {
+          int size = host.read(buf, sizeof(buf), 10);
+          ASSERT_GE(size, 0) << host.getError();
+          decoder.feed(buf, size);
+        }
+    };
+
+  // negotiation
+  ASSERT_TRUE(host.write(topic_request.data(), topic_request.size()));
+  receive(3);
+  ASSERT_EQ(frames.size(), 3);
+  EXPECT_EQ(frames.at(0).topic_id, protocol::ID_SUBSCRIBER);
+  EXPECT_EQ(frames.at(1).topic_id, protocol::ID_PUBLISHER);
+  EXPECT_EQ(frames.at(2).topic_id, protocol::ID_TIME);
+  TopicInfo info;
+  ASSERT_TRUE(decodeTopicInfo(frames.at(1).payload.data(), frames.at(1).payload.size(), info));
+  EXPECT_EQ(info.topic_name, pub_info.topic_name);
+  EXPECT_EQ(client.getNegotiations(), 1);
+
+  // time sync and a batch of messages, echoed by the client
+  FrameBuffer batch;
+  std::vector<uint8_t> time = encodeTime(1, 2);
+  batch.append(protocol::ID_TIME, time.data(), time.size());
+  std::vector<std::vector<uint8_t> > payloads;
+  for(int i = 0; i < 10; i++)
+    {
+      payloads.push_back(createPayload(17, i));
+      batch.append(sub_info.topic_id, payloads.back().data(), payloads.back().size());
+    }
+  ASSERT_TRUE(host.write(batch.data(), batch.size()));
+  receive(3 + payloads.size());
+
+  ASSERT_EQ(frames.size(), 3 + payloads.size());
+  for(size_t i = 0; i < payloads.size(); i++)
+    {
+      EXPECT_EQ(frames.at(3 + i).topic_id, pub_info.topic_id);
+      EXPECT_EQ(frames.at(3 + i).payload, payloads.at(i));
+    }
+  EXPECT_TRUE(client.synchronized());
+  EXPECT_EQ(client.getReceived(), payloads.size());
+  EXPECT_TRUE(errors.empty());
+
+  client.stop();
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
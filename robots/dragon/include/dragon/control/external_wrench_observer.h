@@ -0,0 +1,111 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <Eigen/Dense>
+
+namespace aerial_robot_control
+{
+  typedef Eigen::Matrix<double, 6, 1> Vector6d;
+
+  struct ExternalWrenchObserverParams
+  {
+    enum Type
+      {
+        FIRST_ORDER = 0, // momentum observer: w = K (p - p0 - int(J u - N + w))
+        SECOND_ORDER = 1, // generalized momentum with the disturbance dynamics (w: random walk), characteristic s^2 + 2 zeta omega s + omega^2
+        KALMAN = 2, // the same model as SECOND_ORDER with the gains from the kalman filter
+      };
+
+    int type = FIRST_ORDER;
+    Vector6d gain = Vector6d::Constant(10.0); // first order [1/s]
+    Vector6d bandwidth = Vector6d::Constant(20.0); // second order [rad/s]
+    double damping = 0.7; // second order
+    Vector6d momentum_noise = Vector6d::Constant(0.05); // kalman: measurement noise of the momentum (std)
+    Vector6d momentum_process_noise = Vector6d::Constant(0.5); // kalman: model error of the momentum dynamics (std per sqrt(s))
+    Vector6d wrench_process_noise = Vector6d::Constant(20.0); // kalman: random walk of the external wrench (std per sqrt(s))
+    double max_dt = 0.1; // restart the observer after a gap in the sample stream
+  };
+
+  /* one sample of the rigid body, synchronized with the imu */
+  struct ExternalWrenchObserverInput
+  {
+    double stamp = 0; // sec
+    double mass = 0;
+    Eigen::Matrix3d inertia = Eigen::Matrix3d::Identity();
+    Eigen::Matrix3d rot = Eigen::Matrix3d::Identity(); // orientation of the CoG frame
+    Eigen::Vector3d vel = Eigen::Vector3d::Zero(); // velocity of CoG w.r.t. world frame
+    Eigen::Vector3d omega = Eigen::Vector3d::Zero(); // angular velocity w.r.t. CoG frame
+    Eigen::Vector3d gravity = Eigen::Vector3d(0, 0, 9.80665);
+    Vector6d wrench = Vector6d::Zero(); // commanded force and torque w.r.t. CoG frame
+  };
+
+  /*
+     External wrench estimation from the momentum p = (m v, I omega):
+       dp/dt = J u - N + w,  J = diag(R, I), N = (m g, omega x I omega)
+     The force is expressed in the world frame and the torque in the CoG frame.
+     The observer is discretized with the exact interval between the sample stamps.
+  */
+  class ExternalWrenchObserver
+  {
+  public:
+    ExternalWrenchObserver(const ExternalWrenchObserverParams& params = ExternalWrenchObserverParams()): params_(params) { reset(); }
+
+    void reset();
+    /* return false if the sample is only used for the (re)initialization */
+    bool update(const ExternalWrenchObserverInput& input);
+
+    const Vector6d& getWrench() const { return wrench_; }
+    const ExternalWrenchObserverParams& getParams() const { return params_; }
+    void setParams(const ExternalWrenchObserverParams& params) { params_ = params; reset(); }
+
+  private:
+    ExternalWrenchObserverParams params_;
+
+    bool initialized_;
+    double prev_stamp_;
+    Vector6d wrench_;
+    Vector6d prev_input_; // J u - N of the last sample, zero-order hold until the current sample
+
+    // first order
+    Vector6d init_momentum_;
+    Vector6d integrate_term_;
+
+    // second order and kalman: [p, w] per axis
+    Vector6d momentum_;
+    Vector6d cov_pp_, cov_pw_, cov_ww_;
+  };
+};
@@ -36,7 +36,10 @@
 #pragma once
 
 #include <aerial_robot_control/control/base/pose_linear_controller.h>
+#include <dragon/control/external_wrench_observer.h>
+#include <dragon/control/wrench_allocation_qp.h>
 #include <dragon/model/full_vectoring_robot_model.h>
+#include <dragon/model/rotor_interference.h>
 #include <geometry_msgs/WrenchStamped.h>
 #include <spinal/FourAxisCommand.h>
 #include <spinal/RollPitchYawTerm.h>
@@ -54,6 +57,7 @@ namespace aerial_robot_control
     DragonFullVectoringController();
     ~DragonFullVectoringController()
     {
+      if(dragon_imu_) dragon_imu_->setUpdateCallback(nullptr);
       wrench_estimate_thread_.interrupt();
       wrench_estimate_thread_.join();
     }
@@ -64,6 +68,9 @@ namespace aerial_robot_control
                     boost::shared_ptr<aerial_robot_navigation::BaseNavigator> navigator,
                     double ctrl_loop_rate) override;
 
+    void addTelemetryChannels(telemetry::Recorder& recorder) override;
+    void recordTelemetry(telemetry::Recorder& recorder, double stamp) override;
+
   private:
 
     ros::Publisher flight_cmd_pub_; //for spinal
@@ -82,16 +89,22 @@ namespace aerial_robot_control
     bool gimbal_vectoring_check_flag_;
     double allocation_refine_threshold_;
     int allocation_refine_max_iteration_;
+    bool wrench_allocation_qp_; // constrained QP instead of the iterative pseudoinverse
+    WrenchAllocationQP allocation_qp_;
     Eigen::VectorXd target_wrench_acc_cog_;
+    int vectoring_telemetry_channel_;
+    int wrench_telemetry_channel_;
 
     /* external wrench */
     std::mutex wrench_mutex_;
     boost::thread wrench_estimate_thread_;
-    Eigen::VectorXd init_sum_momentum_;
+    double wrench_estimate_update_rate_;
+    double wrench_estimate_timestamp_; // last estimation in the control loop (replay)
+    bool wrench_observer_imu_sync_; // update the observer in the imu callback
+    boost::shared_ptr<sensor_plugin::DragonImu> dragon_imu_;
+    ExternalWrenchObserver wrench_observer_;
+    std::mutex est_wrench_mutex_;
     Eigen::VectorXd est_external_wrench_;
-    Eigen::MatrixXd momentum_observer_matrix_;
-    Eigen::VectorXd integrate_term_;
-    double prev_est_wrench_timestamp_;
 
     bool rotor_interfere_compensate_;
     double fz_bias_;
@@ -104,18 +117,18 @@ namespace aerial_robot_control
     double rotor_interfere_force_dev_weight_;
     Eigen::VectorXd rotor_interfere_force_;
     Eigen::VectorXd rotor_interfere_comp_wrench_;
-    std::vector<Eigen::VectorXd> overlap_positions_;
-    std::vector<double> overlap_weights_;
-    std::vector<std::string> overlap_segments_;
-    std::vector<std::string> overlap_rotors_;
-    double overlap_dist_rotor_thresh_;
-    double overlap_dist_rotor_relax_thresh_;
-    double overlap_dist_link_thresh_;
-    double overlap_dist_link_relax_thresh_;
-    double overlap_dist_inter_joint_thresh_;
+    Dragon::RotorInterference rotor_interference_;
+    std::vector<Dragon::RotorOverlap> overlaps_;
+    std::vector<Eigen::Vector3d> interfere_segment_positions_;
+    std::vector<Eigen::Vector3d> interfere_link_axes_;
 
 
-    void externalWrenchEstimate();
+    void externalWrenchEstimate(double stamp);
+    const Eigen::VectorXd getEstExternalWrench()
+    {
+      std::lock_guard<std::mutex> lock(est_wrench_mutex_);
+      return est_external_wrench_;
+    }
     const Eigen::VectorXd getTargetWrenchAccCog()
     {
       std::lock_guard<std::mutex> lock(wrench_mutex_);
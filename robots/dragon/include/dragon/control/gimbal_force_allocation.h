@@ -0,0 +1,130 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <kdl/frames.hpp>
+#include <memory>
+#include <vector>
+
+namespace aerial_robot_control
+{
+  /*
+     Horizontal force allocation of the gimbal vectoring:
+     f_xy = P# * [roll, pitch, yaw, x, y], P = [I^-1 * P_att; P_xy / m] (5 x 2n).
+     Since P has full row rank when the controllability check passes, P# = P^T (P P^T)^-1,
+     and a single LDLT factorization of the 5x5 gram matrix gives both the determinant and the solve.
+     When the determinant is low (no roll and pitch control), the [yaw, x, y] rows are used, whose gram matrix is the sub-block of the same one.
+  */
+  class GimbalForceAllocatorBase
+  {
+  public:
+    virtual ~GimbalForceAllocatorBase() = default;
+
+    /* update P from the rotor origins, and return det(P P^T) */
+    virtual double update(const std::vector<KDL::Vector>& rotors_origin_from_cog, const Eigen::Matrix3d& inertia, double mass) = 0;
+
+    /* f_xy = P# * [roll, pitch, yaw, x, y] */
+    virtual void allocate(const Eigen::Matrix<double, 5, 1>& target_acc, Eigen::VectorXd& f_xy) const = 0;
+    /* f_xy = P_yaw_xy# * [yaw, x, y] */
+    virtual void allocateYawXy(const Eigen::Vector3d& target_acc, Eigen::VectorXd& f_xy) const = 0;
+
+    virtual Eigen::MatrixXd getP() const = 0; // for debug
+  };
+
+  template <int N> class GimbalForceAllocator : public GimbalForceAllocatorBase
+  {
+  public:
+    static constexpr int Cols = N == Eigen::Dynamic ? Eigen::Dynamic : 2 * N;
+    using PMatrix = Eigen::Matrix<double, 5, Cols>;
+    using FVector = Eigen::Matrix<double, Cols, 1>;
+
+    GimbalForceAllocator(int rotor_num): rotor_num_(rotor_num), P_(PMatrix::Zero(5, 2 * rotor_num)), f_xy_(FVector::Zero(2 * rotor_num)) {}
+
+    double update(const std::vector<KDL::Vector>& rotors_origin_from_cog, const Eigen::Matrix3d& inertia, double mass) override
+    {
+      const Eigen::Matrix3d inertia_inv = inertia.inverse(); // closed form for 3x3
+      for(int i = 0; i < rotor_num_; i++)
+        {
+          const KDL::Vector& p = rotors_origin_from_cog.at(i);
+          /* columns of P_att: x force -> (0, p_z, -p_y), y force -> (-p_z, 0, p_x) */
+          P_.template block<3, 1>(0, 2 * i) = inertia_inv * Eigen::Vector3d(0, p.z(), -p.y());
+          P_.template block<3, 1>(0, 2 * i + 1) = inertia_inv * Eigen::Vector3d(-p.z(), 0, p.x());
+          P_.template block<2, 2>(3, 2 * i) = Eigen::Matrix2d::Identity() / mass;
+        }
+
+      gram_ = P_ * P_.transpose();
+      ldlt_.compute(gram_);
+      return ldlt_.vectorD().prod(); // the symmetric permutation does not change the determinant
+    }
+
+    void allocate(const Eigen::Matrix<double, 5, 1>& target_acc, Eigen::VectorXd& f_xy) const override
+    {
+      f_xy_.noalias() = P_.transpose() * ldlt_.solve(target_acc);
+      f_xy = f_xy_;
+    }
+
+    void allocateYawXy(const Eigen::Vector3d& target_acc, Eigen::VectorXd& f_xy) const override
+    {
+      const Eigen::Matrix3d gram = gram_.template bottomRightCorner<3, 3>();
+      f_xy_.noalias() = P_.template bottomRows<3>().transpose() * gram.ldlt().solve(target_acc);
+      f_xy = f_xy_;
+    }
+
+    Eigen::MatrixXd getP() const override { return P_; }
+
+  private:
+    int rotor_num_;
+    PMatrix P_;
+    Eigen::Matrix<double, 5, 5> gram_;
+    Eigen::LDLT<Eigen::Matrix<double, 5, 5> > ldlt_;
+    mutable FVector f_xy_;
+  };
+
+  /* fixed-size kernels for the common rotor numbers */
+  inline std::unique_ptr<GimbalForceAllocatorBase> createGimbalForceAllocator(int rotor_num)
+  {
+    switch(rotor_num)
+      {
+      case 3: return std::make_unique<GimbalForceAllocator<3> >(rotor_num);
+      case 4: return std::make_unique<GimbalForceAllocator<4> >(rotor_num);
+      case 6: return std::make_unique<GimbalForceAllocator<6> >(rotor_num);
+      case 8: return std::make_unique<GimbalForceAllocator<8> >(rotor_num);
+      default: return std::make_unique<GimbalForceAllocator<Eigen::Dynamic> >(rotor_num);
+      }
+  }
+};
@@ -36,6 +36,7 @@
 #pragma once
 
 #include <hydrus/hydrus_lqi_controller.h>
+#include <dragon/control/gimbal_force_allocation.h>
 #include <dragon/model/hydrus_like_robot_model.h>
 #include <dragon/dragon_navigation.h>
 #include <gazebo_msgs/ApplyBodyWrench.h>
@@ -43,6 +44,7 @@
 #include <ros/ros.h>
 #include <std_msgs/Float32MultiArray.h>
 #include <spinal/RollPitchYawTerm.h>
+#include <mutex>
 
 namespace aerial_robot_control
 {
@@ -64,6 +66,9 @@ namespace aerial_robot_control
       HydrusLQIController::reset();
     }
 
+    void addTelemetryChannels(telemetry::Recorder& recorder) override;
+    void recordTelemetry(telemetry::Recorder& recorder, double stamp) override;
+
   private:
     ros::Publisher gimbal_control_pub_;
     ros::Publisher gimbal_target_force_pub_;
@@ -80,7 +85,8 @@ namespace aerial_robot_control
     void extraVectoringForceCallback(const std_msgs::Float32MultiArrayConstPtr& msg);
 
     boost::shared_ptr<Dragon::HydrusLikeRobotModel> dragon_robot_model_;
-    Eigen::MatrixXd P_xy_;
+    std::unique_ptr<GimbalForceAllocatorBase> force_allocator_;
+    Eigen::VectorXd f_xy_;
 
     bool gimbal_vectoring_check_flag_;
     bool add_lqi_result_;
@@ -89,12 +95,16 @@ namespace aerial_robot_control
 
     double gimbal_roll_pitch_control_rate_thresh_;
     double gimbal_roll_pitch_control_p_det_thresh_;
+    int gimbal_telemetry_channel_;
 
 
     /* external wrench */
     ros::ServiceServer add_external_wrench_service_, clear_external_wrench_service_;
     bool addExternalWrenchCallback(gazebo_msgs::ApplyBodyWrench::Request& req, gazebo_msgs::ApplyBodyWrench::Response& res);
     bool clearExternalWrenchCallback(gazebo_msgs::BodyRequest::Request& req, gazebo_msgs::BodyRequest::Response& res);
+    std::mutex external_wrench_mutex_;
+    std::map<std::string, Dragon::ExternalWrench> external_wrench_map_; // copy of the robot model one, in the level CoG frame; only re-copied when the set changes
+    bool external_wrench_changed_;
 
     /* extra vectoring force (i.e., for grasping) */
     Eigen::VectorXd extra_vectoring_force_;
@@ -0,0 +1,105 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <Eigen/Dense>
+#include <vector>
+
+namespace aerial_robot_control
+{
+  struct WrenchAllocationQPParams
+  {
+    int max_iteration = 50;
+    int projection_iteration = 5; // Dykstra passes for the intersection of the rotor constraints
+    double tolerance = 1e-4; // absolute tolerance of the primal and dual residuals (per element)
+    double relative_tolerance = 1e-3;
+    double rho = 0.1; // initial penalty, adapted by the residual balancing
+    double relaxation = 1.6;
+    double effort_weight = 1e-4; // thrust effort w.r.t. the wrench error
+    Eigen::Matrix<double, 6, 1> wrench_weight = Eigen::Matrix<double, 6, 1>::Ones();
+    double thrust_min = 0;
+    double thrust_max = 1e6;
+    double gimbal_max_angle = M_PI / 2; // tilt from the gimbal neutral axis
+    double gimbal_max_rate = 1e6; // rad/s, change of the thrust direction
+  };
+
+  struct WrenchAllocationQPStats
+  {
+    int iterations = 0;
+    bool converged = false;
+    bool warm_started = false;
+    double solve_time = 0; // sec
+    double primal_residual = 0;
+    double dual_residual = 0;
+    double wrench_error = 0; // |Q f - b|
+    int saturated_rotors = 0; // rotors on the boundary of their constraints
+  };
+
+  /*
+     Constrained wrench allocation solved by ADMM:
+       min 1/2 |W (Q f - b)|^2 + 1/2 effort_weight |f|^2  s.t. f_i in C_i
+     The vectoring force of each rotor is 3D (free gimbal, in the link frame) or 2D (roll locked gimbal, (x, z) in the gimbal roll frame).
+     C_i is the intersection of the thrust bounds |f_i| <= thrust_max and c_i.f_i >= thrust_min,
+     the gimbal angle limit as a circular cone around the neutral axis (z), and the gimbal rate limit as a circular cone around the previous direction c_i.
+     The previous solution and dual variables are reused as the warm start, as long as the rotor dimensions do not change.
+  */
+  class WrenchAllocationQP
+  {
+  public:
+    WrenchAllocationQP(const WrenchAllocationQPParams& params = WrenchAllocationQPParams()): params_(params) {}
+
+    /* dt: time from the last solve, for the gimbal rate limit. return false if not converged within the iteration budget (f is still feasible) */
+    bool solve(const Eigen::MatrixXd& q_mat, const Eigen::VectorXd& target_wrench, const std::vector<int>& rotor_dims, double dt, Eigen::VectorXd& f);
+    void reset() { rotor_dims_.clear(); }
+
+    const WrenchAllocationQPStats& getStats() const { return stats_; }
+    const WrenchAllocationQPParams& getParams() const { return params_; }
+    void setParams(const WrenchAllocationQPParams& params) { params_ = params; }
+
+  private:
+    WrenchAllocationQPParams params_;
+    WrenchAllocationQPStats stats_;
+
+    std::vector<int> rotor_dims_; // of the last solution
+    Eigen::VectorXd x_, z_, u_, z_prev_, prev_f_;
+    Eigen::MatrixXd h_mat_;
+    Eigen::VectorXd q_vec_;
+    Eigen::LLT<Eigen::MatrixXd> llt_;
+
+    template <int D> bool projectRotor(Eigen::Ref<Eigen::VectorXd> f, const Eigen::Ref<const Eigen::VectorXd>& prev_f, double max_delta_angle) const;
+  };
+};
@@ -54,7 +54,7 @@ namespace aerial_robot_navigation
 
     void update() override;
 
-    inline const bool getLandingFlag() const { return landing_flag_; }
+    inline const bool getLandingFlag() const { return state_machine_.preparingLanding() || state_machine_.landingPrepared(); }
 
   private:
     ros::Publisher curr_target_baselink_rot_pub_;
@@ -81,7 +81,6 @@ namespace aerial_robot_navigation
 
     /* landing process */
     bool level_flag_;
-    bool landing_flag_;
     bool servo_torque_;
 
     /* rosparam */
@@ -35,6 +35,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <dragon/model/gimbal_lock_objective.h>
 #include <dragon/model/hydrus_like_robot_model.h>
 #include <nlopt.hpp>
 #include <numeric>
@@ -55,7 +57,7 @@ namespace Dragon
     virtual ~FullVectoringRobotModel() = default;
 
 
-    inline boost::shared_ptr<aerial_robot_model::transformable::RobotModel> getRobotModelForPlan() { return robot_model_for_plan_;}
+    inline const std::vector<Eigen::Vector3d>& getRotorsOriginFromCogForPlan() const { return rotors_origin_from_cog_for_plan_; } // only for gimbal lock planning
     inline const Eigen::VectorXd& getHoverVectoringF() const {return hover_vectoring_f_;}
 
     const std::vector<int> getRollLockedGimbal()
@@ -70,7 +72,7 @@ namespace Dragon
     const std::vector<int>& getRollLockedGimbalForPlan() const { return roll_locked_gimbal_for_plan_; } // only for gimbal lock planning
     void setRollLockedGimbalForPlan(const std::vector<int> roll_locked_gimbal_for_plan) { roll_locked_gimbal_for_plan_ = roll_locked_gimbal_for_plan; } // only for gimbal lock planning
 
-    void setRollLockedGimbal(const std::vector<int> roll_locked_gimbal)
+    void setRollLockedGimbal(const std::vector<int>& roll_locked_gimbal)
     {
       std::lock_guard<std::mutex> lock(roll_locked_gimbal_mutex_);
       roll_locked_gimbal_ = roll_locked_gimbal;
@@ -83,12 +85,44 @@ namespace Dragon
     // rewrite
     Eigen::VectorXd calcFeasibleControlFxyDists(const std::vector<int>& gimbal_roll_lock, const std::vector<double>& locked_roll_angles, int rotor_num, const std::vector<Eigen::Matrix3d>& link_rot);
     Eigen::VectorXd calcFeasibleControlTDists(const std::vector<int>& gimbal_roll_lock, const std::vector<double>& locked_roll_angles, int rotor_num, const std::vector<Eigen::Vector3d>& rotor_pos, const std::vector<Eigen::Matrix3d>& link_rot);
+    double calcSmoothMinControlWrench(const std::vector<double>& locked_roll_angles, std::vector<double>& grad); // only for gimbal lock planning
 
     bool stabilityCheck(bool verbose) override;
 
   private:
 
-    boost::shared_ptr<aerial_robot_model::transformable::RobotModel> robot_model_for_plan_;
+    /* flattened tree for the forward kinematics of all segments in one pass, built in the first update */
+    struct FkSegment
+    {
+      const KDL::Segment* segment;
+      int parent; // index in fk_segments_, -1 for the children of the root
+      unsigned int q_nr;
+    };
+    std::vector<FkSegment> fk_segments_;
+    std::vector<KDL::Frame> fk_frames_; // frames of the last calcSegmentFrames()
+    int baselink_slot_;
+    std::vector<int> link_slots_;
+    std::vector<int> thrust_slots_;
+    std::vector<int> gimbal_roll_module_slots_;
+    std::vector<int> edf_slots_; // left and right of each rotor
+    std::vector<std::pair<int, KDL::RigidBodyInertia> > inertia_slots_;
+    std::vector<int> gimbal_roll_joint_indices_;
+    std::vector<int> gimbal_pitch_joint_indices_;
+
+    /* kinematics of the model for plan, i.e., the model with the gimbal processed joints (without extra modules) */
+    KDL::Frame cog_for_plan_;
+    double mass_for_plan_;
+    std::vector<Eigen::Vector3d> rotors_origin_from_cog_for_plan_, prev_rotors_origin_from_cog_for_plan_;
+
+    /* buffers of the update, to avoid allocation */
+    KDL::JntArray gimbal_processed_joint_curr_;
+    std::vector<double> gimbal_nominal_angles_level_; // with level gimbals
+    std::vector<double> gimbal_nominal_angles_curr_;
+    std::vector<KDL::Rotation> links_rotation_from_cog_curr_;
+    std::vector<int> roll_locked_gimbal_curr_;
+    std::vector<KDL::Vector> edfs_origin_from_cog_curr_;
+    Eigen::MatrixXd full_q_mat_;
+    Eigen::VectorXd static_thrust_curr_;
 
     Eigen::VectorXd hover_vectoring_f_;
 
@@ -107,6 +141,11 @@ namespace Dragon
     double min_torque_weight_;
     double min_force_normalized_weight_;
     double min_torque_normalized_weight_;
+    bool gimbal_roll_lock_gradient_solver_ = true;
+    double gimbal_roll_lock_smooth_epsilon_ = 50.0;
+    int gimbal_roll_lock_max_eval_ = 100;
+    std::vector<Eigen::Vector3d> lock_plan_rotor_pos_; // rotor origins of the last calcBestLockGimbalRoll()
+    std::vector<Eigen::Matrix3d> lock_plan_link_rot_;
     std::vector<KDL::Rotation> prev_links_rotation_from_cog_;
     int robot_model_refine_max_iteration_;
     double robot_model_refine_threshold_;
@@ -118,6 +157,10 @@ namespace Dragon
 
     //private functions
     void getParamFromRos();
+    void initKinematics();
+    void calcSegmentFrames(const KDL::JntArray& joint_positions);
+    void updateKinematicsForPlan(const KDL::JntArray& joint_positions, const KDL::Rotation& cog_desire_orientation);
+    void setGimbalProcessedAngles(const std::vector<double>& gimbal_angles);
     void updateRobotModelImpl(const KDL::JntArray& joint_positions) override;
 
     /* gimbal roll angle optimization problem */
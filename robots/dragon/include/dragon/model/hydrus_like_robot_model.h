@@ -35,6 +35,7 @@
 
 #pragma once
 
+#include <dragon/model/rotor_interference.h>
 #include <hydrus/hydrus_robot_model.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <kdl_conversions/kdl_msg.h>
@@ -82,6 +83,7 @@ namespace Dragon
     const double getEdfRadius() const {return edf_radius_;}
     const double getEdfMaxTilt() const {return edf_max_tilt_;}
     const std::vector<std::string>& getEdfNames() const { return edf_names_; }
+    Eigen::MatrixXd getEdfPositionJacobian(int edf_index);
     template <class T> std::vector<T> getEdfsOriginFromCog();
     const Eigen::VectorXd& getExWrenchCompensateVectoringThrust() const {return wrench_comp_thrust_;}
     const std::map<std::string, ExternalWrench>& getExternalWrenchMap() const {return external_wrench_map_;}
@@ -100,27 +102,27 @@ namespace Dragon
       return vectoring_q_mat_;
     }
 
-    void setGimbalNominalAngles(const std::vector<double> gimbal_nominal_angles)
+    void setGimbalNominalAngles(const std::vector<double>& gimbal_nominal_angles)
     {
       std::lock_guard<std::mutex> lock(gimbal_nominal_angles_mutex_);
       gimbal_nominal_angles_ = gimbal_nominal_angles;
     }
-    void setGimbalProcessedJoint(const KDL::JntArray gimbal_processed_joint)
+    void setGimbalProcessedJoint(const KDL::JntArray& gimbal_processed_joint)
     {
       std::lock_guard<std::mutex> lock(gimbal_processed_joint_mutex_);
       gimbal_processed_joint_ = gimbal_processed_joint;
     }
-    void setLinksRotationFromCog(const std::vector<KDL::Rotation> links_rotation_from_cog)
+    void setLinksRotationFromCog(const std::vector<KDL::Rotation>& links_rotation_from_cog)
     {
       std::lock_guard<std::mutex> lock(links_rotation_mutex_);
       links_rotation_from_cog_ = links_rotation_from_cog;
     }
-    void setEdfsOriginFromCog(const std::vector<KDL::Vector> edfs_origin_from_cog)
+    void setEdfsOriginFromCog(const std::vector<KDL::Vector>& edfs_origin_from_cog)
     {
       std::lock_guard<std::mutex> lock(edgs_origin_mutex_);
       edfs_origin_from_cog_ = edfs_origin_from_cog;
     }
-    void setVectoringForceWrenchMatrix(const Eigen::MatrixXd vectoring_q_mat)
+    void setVectoringForceWrenchMatrix(const Eigen::MatrixXd& vectoring_q_mat)
     {
       std::lock_guard<std::mutex> lock(vectoring_q_mat_mutex_);
       vectoring_q_mat_ = vectoring_q_mat;
@@ -143,6 +145,8 @@ namespace Dragon
     std::vector<KDL::Rotation> links_rotation_from_cog_;
 
     Eigen::MatrixXd gimbal_jacobian_;
+    std::vector<int> link_joint_cols_; // column of each link joint in the full-body jacobian
+    std::vector<std::pair<int, int> > gimbal_cols_; // column of each gimbal (roll, pitch) in the full-body jacobian
     Eigen::MatrixXd rotor_overlap_jacobian_;
 
     // overlap
@@ -155,6 +159,7 @@ namespace Dragon
     Eigen::VectorXd wrench_comp_thrust_;
     Eigen::VectorXd vectoring_thrust_;
     Eigen::MatrixXd vectoring_q_mat_;
+    Eigen::MatrixXd q_pseudo_inv_;
     Eigen::MatrixXd comp_thrust_jacobian_;
 
     std::mutex gimbal_nominal_angles_mutex_;
@@ -167,6 +172,7 @@ namespace Dragon
     void addCompThrustToLambdaJacobian();
     void addCompThrustToJointTorqueJacobian();
     void getParamFromRos();
+    bool hasCompThrust() const { return !external_wrench_map_.empty() || !wrench_comp_thrust_.isZero(0); }
 
   protected:
 
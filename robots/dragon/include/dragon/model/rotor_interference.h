@@ -0,0 +1,140 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Dense>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Dragon
+{
+  /* segment of the link module interfered by the rotor downwash (bit flags) */
+  enum InterferenceSegment
+    {
+      INTERFERE_INTER_JOINT = 1,
+      INTERFERE_ROTOR_LEFT = 2,
+      INTERFERE_ROTOR_RIGHT = 4,
+      INTERFERE_LINK = 8,
+    };
+
+  struct RotorOverlap
+  {
+    int rotor; // edf index: 2 * rotor_id + (0: left, 1: right)
+    int link; // index of the interfered link
+    int segment; // InterferenceSegment flags
+    Eigen::Vector3d position;
+    double weight;
+  };
+
+  struct RotorInterferenceParams
+  {
+    double rotor_thresh = 0.08;
+    double rotor_relax_thresh = 0.08;
+    double link_thresh = 0.08;
+    double link_relax_thresh = 0.08;
+    double inter_joint_thresh = 0.08;
+    double downwash_cone_angle = 0; // half angle of the downwash cone, the thresholds spread with the depth from the rotor
+    bool prune = true; // bounding sphere test of each (edf, link) pair, the results do not depend on it
+  };
+
+  /*
+     Geometric interference between the rotor downwash and the link modules.
+     The downwash of each edf is a cone along -u_rotor, and each link module is a capsule (link axis from link_i to the inter joint) with the two edfs on it.
+     The segment frames are resolved once to a fixed index table (getSegmentNames()),
+     and the pairs of (edf, link) are pruned by the bounding sphere of the link module before the detailed tests.
+  */
+  class RotorInterference
+  {
+  public:
+    RotorInterference(int rotor_num = 0, const RotorInterferenceParams& params = RotorInterferenceParams());
+
+    void initialize(int rotor_num);
+
+    /* order: link1...linkN, inter_joint1...inter_jointN-1, edf1_left, edf1_right, ... edfN_right */
+    const std::vector<std::string>& getSegmentNames() const { return segment_names_; }
+    int linkIndex(int i) const { return i; }
+    int interJointIndex(int i) const { return rotor_num_ + i; }
+    int edfIndex(int i, int side) const { return 2 * rotor_num_ - 1 + 2 * i + side; }
+
+    /*
+       segment_positions: the origins of getSegmentNames() w.r.t. cog frame
+       link_axes: x axis of each link frame w.r.t. cog frame
+       rotor_normals: thrust direction of each rotor w.r.t. cog frame
+    */
+    const std::vector<RotorOverlap>& update(const std::vector<Eigen::Vector3d>& segment_positions,
+                                            const std::vector<Eigen::Vector3d>& link_axes,
+                                            const std::vector<Eigen::Vector3d>& rotor_normals);
+
+    const std::vector<RotorOverlap>& getOverlaps() const { return overlaps_; }
+    int getPrunedPairNum() const { return pruned_pair_num_; }
+
+    const RotorInterferenceParams& getParams() const { return params_; }
+    void setParams(const RotorInterferenceParams& params);
+
+    std::string getOverlapName(const RotorOverlap& overlap) const;
+
+    /* rotor-rotor overlap: edf_j is inside the cone (radius + depth * tan(max_tilt)) of edf_i. edfs on the same link are skipped */
+    static bool rotorPairOverlap(const Eigen::Vector3d& p_i, const Eigen::Vector3d& p_j, double edf_radius, double edf_max_tilt);
+    /* return the first overlapped pair of edfs, or (-1, -1) */
+    static std::pair<int, int> findRotorPairOverlap(const std::vector<Eigen::Vector3d>& edf_positions, double edf_radius, double edf_max_tilt);
+
+  private:
+    int rotor_num_;
+    RotorInterferenceParams params_;
+    double tan_cone_;
+    double max_thresh_;
+
+    std::vector<std::string> segment_names_;
+    std::vector<RotorOverlap> overlaps_;
+    int pruned_pair_num_;
+
+    // per update
+    std::vector<Eigen::Vector3d> p_inters_;
+    std::vector<Eigen::Vector3d> bound_centers_;
+    std::vector<double> bound_radiuses_;
+
+    double spread(const Eigen::Vector3d& p_rotor, const Eigen::Vector3d& u_rotor, const Eigen::Vector3d& p) const
+    {
+      return std::max(0.0, (p_rotor - p).dot(u_rotor)) * tan_cone_;
+    }
+
+    void rotorInterfere(int edf, const Eigen::Vector3d& p_rotor, const Eigen::Vector3d& u_rotor, double link_length,
+                        const std::vector<Eigen::Vector3d>& segment_positions, const std::vector<Eigen::Vector3d>& link_axes);
+  };
+};
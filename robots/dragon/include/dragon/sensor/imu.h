@@ -36,6 +36,7 @@
 #pragma once
 
 #include <aerial_robot_estimation/sensor/imu.h>
+#include <functional>
 #include <geometry_msgs/Vector3Stamped.h>
 
 using namespace Eigen;
@@ -76,6 +77,13 @@ namespace sensor_plugin
       return filtered_vel_cog_;
     }
 
+    /* called with the imu stamp after the filtered states are updated, e.g., for the external wrench observer */
+    void setUpdateCallback(const std::function<void(double)>& callback)
+    {
+      boost::lock_guard<boost::mutex> lock(callback_mutex_);
+      update_callback_ = callback;
+    }
+
   protected:
 
     void ImuCallback(const spinal::ImuConstPtr& imu_msg) override;
@@ -83,6 +91,8 @@ namespace sensor_plugin
     // work around to obtain filter states
     boost::mutex omega_mutex_;
     boost::mutex vel_mutex_;
+    boost::mutex callback_mutex_;
+    std::function<void(double)> update_callback_;
     tf::Vector3 filtered_vel_cog_;
     tf::Vector3 filtered_omega_cog_;
     IirFilter lpf_omega_; // for gyro
@@ -0,0 +1,129 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <dragon/control/external_wrench_observer.h>
+
+using namespace aerial_robot_control;
+
+void ExternalWrenchObserver::reset()
+{
+  initialized_ = false;
+  prev_stamp_ = 0;
+  wrench_.setZero();
+  prev_input_.setZero();
+  init_momentum_.setZero();
+  integrate_term_.setZero();
+  momentum_.setZero();
+  cov_pp_.setZero();
+  cov_pw_.setZero();
+  cov_ww_.setZero();
+}
+
+bool ExternalWrenchObserver::update(const ExternalWrenchObserverInput& input)
+{
+  Vector6d momentum;
+  momentum.head<3>() = input.mass * input.vel;
+  momentum.tail<3>() = input.inertia * input.omega;
+
+  Vector6d model_input; // J u - N
+  model_input.head<3>() = input.rot * input.wrench.head<3>() - input.mass * input.gravity;
+  model_input.tail<3>() = input.wrench.tail<3>() - input.omega.cross(input.inertia * input.omega);
+
+  const double dt = input.stamp - prev_stamp_;
+  if(!initialized_ || dt > params_.max_dt)
+    {
+      /* the external wrench is assumed to be zero at the beginning */
+      initialized_ = true;
+      wrench_.setZero();
+      init_momentum_ = momentum;
+      integrate_term_.setZero();
+      momentum_ = momentum;
+      cov_pp_ = params_.momentum_noise.cwiseAbs2();
+      cov_pw_.setZero();
+      cov_ww_.setZero();
+      prev_input_ = model_input;
+      prev_stamp_ = input.stamp;
+      return false;
+    }
+  if(dt <= 0) return false; // same or older sample
+
+  switch(params_.type)
+    {
+    case ExternalWrenchObserverParams::SECOND_ORDER:
+      {
+        const Vector6d k1 = 2 * params_.damping * params_.bandwidth * dt;
+        const Vector6d k2 = params_.bandwidth.cwiseAbs2() * dt;
+
+        /* predict with the disturbance, then correct with the momentum residual */
+        momentum_ += (prev_input_ + wrench_) * dt;
+        const Vector6d residual = momentum - momentum_;
+        momentum_ += k1.cwiseMin(1.0).cwiseProduct(residual);
+        wrench_ += k2.cwiseProduct(residual);
+        break;
+      }
+    case ExternalWrenchObserverParams::KALMAN:
+      {
+        /* predict: F = [1 dt; 0 1] */
+        momentum_ += (prev_input_ + wrench_) * dt;
+        cov_pp_ += 2 * dt * cov_pw_ + dt * dt * cov_ww_ + params_.momentum_process_noise.cwiseAbs2() * dt;
+        cov_pw_ += dt * cov_ww_;
+        cov_ww_ += params_.wrench_process_noise.cwiseAbs2() * dt;
+
+        /* correct: H = [1 0] */
+        const Vector6d s = cov_pp_ + params_.momentum_noise.cwiseAbs2();
+        const Vector6d k_p = cov_pp_.cwiseQuotient(s);
+        const Vector6d k_w = cov_pw_.cwiseQuotient(s);
+        const Vector6d residual = momentum - momentum_;
+        momentum_ += k_p.cwiseProduct(residual);
+        wrench_ += k_w.cwiseProduct(residual);
+
+        const Vector6d cov_pp = cov_pp_, cov_pw = cov_pw_;
+        cov_pp_ -= k_p.cwiseProduct(cov_pp);
+        cov_pw_ -= k_p.cwiseProduct(cov_pw);
+        cov_ww_ -= k_w.cwiseProduct(cov_pw);
+        break;
+      }
+    default:
+      {
+        integrate_term_ += (prev_input_ + wrench_) * dt;
+        wrench_ = params_.gain.cwiseProduct(momentum - init_momentum_ - integrate_term_);
+        break;
+      }
+    }
+
+  prev_input_ = model_input;
+  prev_stamp_ = input.stamp;
+  return true;
+}
@@ -4,7 +4,9 @@ using namespace aerial_robot_model;
 using namespace aerial_robot_control;
 
 DragonFullVectoringController::DragonFullVectoringController():
-  PoseLinearController()
+  PoseLinearController(),
+  vectoring_telemetry_channel_(-1),
+  wrench_telemetry_channel_(-1)
 {
 }
 
@@ -33,22 +35,34 @@ void DragonFullVectoringController::initialize(ros::NodeHandle nh, ros::NodeHand
 
   rotor_interfere_comp_wrench_ = Eigen::VectorXd::Zero(6); // reset
   est_external_wrench_ = Eigen::VectorXd::Zero(6);
-  init_sum_momentum_ = Eigen::VectorXd::Zero(6);
-  integrate_term_ = Eigen::VectorXd::Zero(6);
-  prev_est_wrench_timestamp_ = 0;
   fz_bias_ = 0;
   tx_bias_ = 0;
   ty_bias_ = 0;
+  wrench_estimate_timestamp_ = 0;
+
+  ros::NodeHandle control_nh(nh_, "controller");
+  control_nh.param ("wrench_estimate_update_rate", wrench_estimate_update_rate_, 100.0);
+  dragon_imu_ = boost::dynamic_pointer_cast<sensor_plugin::DragonImu>(estimator_->getImuHandler(0));
+  if(!dragon_imu_)
+    {
+      ROS_ERROR("[control] full vectoring control requires sensor_plugin::DragonImu for the external wrench estimation");
+      return;
+    }
+  if(replay_) return; // estimate in the control loop with the simulated time
+
+  if(wrench_observer_imu_sync_)
+    {
+      /* exact sample timestamps from the imu stream */
+      dragon_imu_->setUpdateCallback([this](double stamp) { externalWrenchEstimate(stamp); });
+      return;
+    }
+
   wrench_estimate_thread_ = boost::thread([this]()
                                           {
-                                            ros::NodeHandle control_nh(nh_, "controller");
-                                            double update_rate;
-                                            control_nh.param ("wrench_estimate_update_rate", update_rate, 100.0);
-
-                                            ros::Rate loop_rate(update_rate);
+                                            ros::Rate loop_rate(wrench_estimate_update_rate_);
                                             while(ros::ok())
                                               {
-                                                externalWrenchEstimate();
+                                                externalWrenchEstimate(estimator_->getImuLatestTimeStamp());
                                                 loop_rate.sleep();
                                               }
                                           });
@@ -57,10 +71,7 @@ void DragonFullVectoringController::initialize(ros::NodeHandle nh, ros::NodeHand
 void DragonFullVectoringController::rotorInterfereCompensation()
 {
   //rotor interference compensation based on previous robot model
-  overlap_positions_.clear();
-  overlap_weights_.clear();
-  overlap_segments_.clear();
-  overlap_rotors_.clear();
+  overlaps_.clear();
 
   if(navigator_->getForceLandingFlag())
     {
@@ -72,241 +83,31 @@ void DragonFullVectoringController::rotorInterfereCompensation()
 
   if(seg_tf_map.size() == 0) return;
 
-  const auto u = robot_model_for_control_->getRotorsNormalFromCog<Eigen::Vector3d>();
-  double link_length = (seg_tf_map.at(std::string("inter_joint1")).p - seg_tf_map.at(std::string("link1")).p).Norm();
-  KDL::Frame cog_inv = robot_model_for_control_->getCog<KDL::Frame>().Inverse();
-
-  auto rotorInterfere = [this, &seg_tf_map, &cog_inv](int i, Eigen::Vector3d p_rotor, Eigen::Vector3d u_rotor, double link_length, std::string rotor_name)
-    {
-      for(int j = 0; j < motor_num_; ++j)
-        {
-          bool overlap_inter = false;
-          std::string s = std::to_string(j + 1);
-
-          KDL::Frame f_link  = cog_inv * seg_tf_map.at(std::string("link") + s);
-          Eigen::Vector3d u_link = aerial_robot_model::kdlToEigen(f_link.M * KDL::Vector(1, 0, 0));
-          Eigen::Vector3d p_link = aerial_robot_model::kdlToEigen(f_link.p);
-          Eigen::Vector3d p_inter;
-          double dist_inter = overlap_dist_inter_joint_thresh_;
-          if(j == motor_num_ - 1)
-            p_inter = p_link + u_link * link_length;
-          else
-            p_inter = aerial_robot_model::kdlToEigen(((cog_inv * seg_tf_map.at(std::string("inter_joint") + s)).p + (cog_inv * seg_tf_map.at(std::string("link") + std::to_string(j + 2))).p)/2);
-
-          if(p_inter.z() > p_rotor.z() && p_link.z() > p_rotor.z()) continue; // never overlap
-
-          // case1: inter joint
-          if(p_inter.z() <= p_rotor.z())
-            {
-              dist_inter = (p_rotor + (p_inter - p_rotor).dot(u_rotor) * u_rotor - p_inter).norm();
-              if(dist_inter < overlap_dist_inter_joint_thresh_)
-                {
-                  overlap_inter = true;
-                  /// ROS_INFO_STREAM("rotor" << i + 1 << "_" << rotor_name << " " << p_rotor.transpose() <<  ", interfere with inter_joint" << j+1 << ": " << p_inter.transpose());
-                }
-            }
-
-          if(j == i) // self overlap never
-            {
-              if(overlap_inter)
-                {
-                  overlap_positions_.push_back(p_inter);
-                  overlap_weights_.push_back(1);
-                  overlap_segments_.push_back(std::string("inter_joint") + s);
-                  overlap_rotors_.push_back(std::string("rotor") + std::to_string(i + 1) + std::string("_") + rotor_name);
-                }
-              continue;
-            }
-
-          // case2: rotor
-          Eigen::Vector3d p_rotor_l = aerial_robot_model::kdlToEigen((cog_inv * seg_tf_map.at(std::string("edf") + s + std::string("_left"))).p);
-          Eigen::Vector3d p_rotor_r = aerial_robot_model::kdlToEigen((cog_inv * seg_tf_map.at(std::string("edf") + s + std::string("_right"))).p);
-          bool overlap_rotor = false;
-          double linear_rotor_weight = 0;
-
-          if(p_rotor.z() > p_rotor_l.z() && p_rotor.z() > p_rotor_r.z())
-            {
-              Eigen::Vector3d p_projected_rotor_l = p_rotor + (p_rotor_l.z() - p_rotor.z()) / u_rotor.z() * u_rotor;
-              Eigen::Vector3d p_projected_rotor_r = p_rotor + (p_rotor_r.z() - p_rotor.z()) / u_rotor.z() * u_rotor;
-              double dist_rotor_l = (p_projected_rotor_l - p_rotor_l).norm();
-              double dist_rotor_r = (p_projected_rotor_r - p_rotor_r).norm();
-
-              if(dist_rotor_l < overlap_dist_rotor_relax_thresh_ || dist_rotor_r < overlap_dist_rotor_relax_thresh_)
-                {
-                  // ROS_INFO_STREAM("p_projected_rotor_l: " << p_projected_rotor_l.transpose() << "; p_projected_rotor_r: " << p_projected_rotor_r.transpose());
-                  // ROS_INFO_STREAM("p_rotor_l: " << p_rotor_l.transpose() << "; p_rotor_r: " << p_rotor_r.transpose());
-                  // ROS_INFO_STREAM("dist_rotor_l: " << dist_rotor_l << "; dist_rotor_r: " << dist_rotor_r);
-                  double rotor_l_weight = 1;
-                  double rotor_r_weight = 1;
-
-
-                  double relax_range = overlap_dist_rotor_relax_thresh_ - overlap_dist_rotor_thresh_;
-                  if(dist_rotor_l > overlap_dist_rotor_thresh_)
-                    {
-                      if(dist_rotor_l > overlap_dist_rotor_relax_thresh_) rotor_l_weight = 0;
-                      else
-                        {
-                          if(overlap_dist_rotor_relax_thresh_ > overlap_dist_rotor_thresh_)
-                            {
-                              double diff = (overlap_dist_rotor_relax_thresh_ - dist_rotor_l) / relax_range;
-                              rotor_l_weight = diff * diff ;
-                            }
-                        }
-                    }
-                  if(dist_rotor_r > overlap_dist_rotor_thresh_)
-                    {
-                      if(dist_rotor_r > overlap_dist_rotor_relax_thresh_) rotor_r_weight = 0;
-                      else
-                        {
-                          if(overlap_dist_rotor_relax_thresh_ > overlap_dist_rotor_thresh_)
-                            {
-                              double diff = (overlap_dist_rotor_relax_thresh_ - dist_rotor_r) / relax_range;
-                              rotor_r_weight = diff * diff ;
-                            }
-                        }
-                    }
-
-                  if(dist_rotor_l > overlap_dist_rotor_relax_thresh_)
-                    {
-                      linear_rotor_weight = (overlap_dist_rotor_relax_thresh_ - dist_rotor_r) / overlap_dist_rotor_relax_thresh_;
-                      overlap_positions_.push_back(p_rotor_r);
-                      overlap_weights_.push_back(rotor_r_weight);
-                      overlap_segments_.push_back(std::string("rotor") + s + std::string("_right"));
-                      overlap_rotors_.push_back(std::string("rotor") + std::to_string(i + 1) + std::string("_") + rotor_name);
-
-
-                      /// ROS_INFO_STREAM("rotor" << i + 1 << "_" << rotor_name << " " << p_rotor.transpose() << ", interfere with rotor" << j+1 << "right: " << overlap_positions_.back().transpose());
-                    }
-                  else if(dist_rotor_r > overlap_dist_rotor_relax_thresh_)
-                    {
-                      linear_rotor_weight = (overlap_dist_rotor_relax_thresh_ - dist_rotor_l) / overlap_dist_rotor_relax_thresh_;
-                      overlap_positions_.push_back(p_rotor_l);
-                      overlap_weights_.push_back(rotor_l_weight);
-
-                      overlap_segments_.push_back(std::string("rotor") + s + std::string("_left"));
-                      overlap_rotors_.push_back(std::string("rotor") + std::to_string(i + 1) + std::string("_") + rotor_name);
-
-                      /// ROS_INFO_STREAM("rotor" << i + 1 << "_" << rotor_name << " " << p_rotor.transpose() << ", interfere with rotor" << j+1 << "left: " << overlap_positions_.back().transpose());
-                    }
-                  else
-                    {
-                      linear_rotor_weight = (overlap_dist_rotor_relax_thresh_ - (dist_rotor_l + dist_rotor_r) / 2) / overlap_dist_rotor_relax_thresh_;
-                      overlap_positions_.push_back((rotor_l_weight * p_rotor_l + rotor_r_weight * p_rotor_r) / (rotor_l_weight + rotor_r_weight));
-                      overlap_weights_.push_back((rotor_l_weight + rotor_r_weight) / 2);
-
-                      overlap_segments_.push_back(std::string("rotor") + s + std::string("_left&right"));
-                      overlap_rotors_.push_back(std::string("rotor") + std::to_string(i + 1) + std::string("_") + rotor_name);
-
-                      /// ROS_INFO_STREAM("rotor" << i + 1 << "_" << rotor_name << " " << p_rotor.transpose() << ", interfere with rotor" << j+1 << "left&right: " << overlap_positions_.back().transpose());
-                    }
-
-                  overlap_rotor = true;
-                }
-            }
-
-          // case3: link
-          Eigen::Matrix2d A; A << u_link.dot(u_link), -u_link.dot(u_rotor), u_link.dot(u_rotor), - u_rotor.dot(u_rotor);
-          Eigen::Vector2d diff(-u_link.dot(p_link - p_rotor), -u_rotor.dot(p_link - p_rotor));
-          Eigen::Vector2d t = A.inverse() * diff;
-          double dist_link = 1e6;
-          bool overlap_link = false;
-
-          Eigen::Vector3d p_link_overlap = p_link + u_link * t(0);
-          dist_link = (p_link_overlap - (p_rotor + u_rotor * t(1))).norm();
-
-          if(t(1) < 0)
-            {
-
-              if(dist_link < overlap_dist_link_relax_thresh_)
-                {
-                  overlap_link = true;
-
-                  if(t(0) < 0)
-                    {
-                      if(j == 0 && t(0) > overlap_dist_link_relax_thresh_) overlap_link = true; // relax for the end of the link
-                      else overlap_link = false;
-                    }
-                  if(t(0) > link_length)
-                    {
-                      if(j == motor_num_ - 1 && t(0) < link_length + overlap_dist_link_relax_thresh_) overlap_link = true; // relax for the end of the link
-                      else overlap_link = false;
-                    }
-                }
-
-              if(overlap_link)
-                {
-                  double linear_link_weight = (overlap_dist_link_relax_thresh_ - dist_link) / overlap_dist_link_relax_thresh_;
-
-                  double weight = 1;
-                  if(dist_link > overlap_dist_link_thresh_)
-                    {
-                      double diff = (overlap_dist_link_relax_thresh_ - dist_link) / (overlap_dist_link_relax_thresh_ - overlap_dist_link_thresh_);
-                      weight = diff * diff ;
-                    }
-
-                  if(overlap_rotor)
-                    {
-                      Eigen::Vector3d p_rotor_overlap = overlap_positions_.back();
-                      double weight_rotor_overlap = overlap_weights_.back();
-                      overlap_positions_.back() = (linear_rotor_weight * p_rotor_overlap + linear_link_weight * p_link_overlap) / (linear_rotor_weight + linear_link_weight);
-                      overlap_weights_.back() = (weight_rotor_overlap + weight) / 2;
-
-                      overlap_segments_.back() = overlap_segments_.back() + std::string("&link");
-
-                      /// ROS_INFO_STREAM("  rotor" << i + 1 << "_" << rotor_name << " " << p_rotor.transpose() << ", interfere with link" << j+1 << "&rotor : " << overlap_positions_.back().transpose());
-                    }
-                  else
-                    {
-
-                      if(overlap_inter)
-                        {
-                          double linear_inter_weight = (overlap_dist_inter_joint_thresh_ - dist_inter) / overlap_dist_inter_joint_thresh_;
-                          overlap_positions_.push_back((linear_inter_weight * p_inter + linear_link_weight * p_link_overlap) / (linear_inter_weight + linear_link_weight));
-                          overlap_weights_.push_back(weight);
-
-                          overlap_segments_.push_back(std::string("link&inter_joint") + s);
-                          overlap_rotors_.push_back(std::string("rotor") + std::to_string(i + 1) + std::string("_") + rotor_name);
-
-                          /// ROS_INFO_STREAM(" rotor" << i + 1 << "_" << rotor_name << " " << p_rotor.transpose() << ", interfere with link & inter_joint" << j+1 << ": " << overlap_positions_.back().transpose());
-                        }
-                      else
-                        {
-                          overlap_positions_.push_back(p_link_overlap);
-                          overlap_weights_.push_back(weight);
-
-                          overlap_segments_.push_back(std::string("link") + s);
-                          overlap_rotors_.push_back(std::string("rotor") + std::to_string(i + 1) + std::string("_") + rotor_name);
-
-                          /// ROS_INFO_STREAM("rotor" << i + 1 << "_" << rotor_name << " " << p_rotor.transpose() << ", interfere with link" << j+1 << ": " << overlap_positions_.back().transpose());
-                        }
-                    }
-                }
-
-            }
-        }
-    };
-
-  for(int i = 0; i < motor_num_; ++i)
+  /* the segment frames are resolved by the fixed index table of the interference model */
+  const auto& segment_names = rotor_interference_.getSegmentNames();
+  const KDL::Frame cog_inv = robot_model_for_control_->getCog<KDL::Frame>().Inverse();
+  for(int k = 0; k < segment_names.size(); k++)
     {
-      std::string s = std::to_string(i + 1);
-      KDL::Frame f_rotor  = cog_inv * seg_tf_map.at(std::string("edf") + s + std::string("_left"));
-      rotorInterfere(i, aerial_robot_model::kdlToEigen(f_rotor.p), u.at(i), link_length, std::string("left"));
-      f_rotor  = cog_inv * seg_tf_map.at(std::string("edf") + s + std::string("_right"));
-      rotorInterfere(i, aerial_robot_model::kdlToEigen(f_rotor.p), u.at(i), link_length, std::string("right"));
+      const KDL::Frame f = cog_inv * seg_tf_map.at(segment_names.at(k));
+      interfere_segment_positions_.at(k) = aerial_robot_model::kdlToEigen(f.p);
+      if(k < motor_num_) interfere_link_axes_.at(k) = aerial_robot_model::kdlToEigen(f.M * KDL::Vector(1, 0, 0));
     }
 
+  overlaps_ = rotor_interference_.update(interfere_segment_positions_, interfere_link_axes_,
+                                         robot_model_for_control_->getRotorsNormalFromCog<Eigen::Vector3d>());
 
-  if(overlap_positions_.size() == 0)
+  const Eigen::VectorXd est_external_wrench = getEstExternalWrench();
+  if(overlaps_.size() == 0)
     {
-      fz_bias_ = (1 - wrench_lpf_rate_) * fz_bias_ + wrench_lpf_rate_ * est_external_wrench_(2);
-      tx_bias_ = (1 - wrench_lpf_rate_) * tx_bias_ + wrench_lpf_rate_ * est_external_wrench_(3);
-      ty_bias_ = (1 - wrench_lpf_rate_) * ty_bias_ + wrench_lpf_rate_ * est_external_wrench_(4);
+      fz_bias_ = (1 - wrench_lpf_rate_) * fz_bias_ + wrench_lpf_rate_ * est_external_wrench(2);
+      tx_bias_ = (1 - wrench_lpf_rate_) * tx_bias_ + wrench_lpf_rate_ * est_external_wrench(3);
+      ty_bias_ = (1 - wrench_lpf_rate_) * ty_bias_ + wrench_lpf_rate_ * est_external_wrench(4);
 
       rotor_interfere_comp_wrench_.segment(2, 3) = (1 - comp_wrench_lpf_rate_) * rotor_interfere_comp_wrench_.segment(2, 3) +  comp_wrench_lpf_rate_ * Eigen::VectorXd::Zero(3);
     }
   else
     {
-      Eigen::Vector3d external_wrench(est_external_wrench_(2), est_external_wrench_(3) - tx_bias_, est_external_wrench_(4) - ty_bias_); //fz, mx,my
+      Eigen::Vector3d external_wrench(est_external_wrench(2), est_external_wrench(3) - tx_bias_, est_external_wrench(4) - ty_bias_); //fz, mx,my
       if(fz_bias_thresh_ < fabs(fz_bias_)) external_wrench(0) -= fz_bias_;
 
       /// ROS_WARN_STREAM("compensate rotor overlap interfere: fz_bias: " << fz_bias_ << " external wrench: " << external_wrench.transpose());
@@ -318,19 +119,14 @@ void DragonFullVectoringController::rotorInterfereCompensation()
           return;
         }
 
-      // for(int i = 0; i < overlap_rotors_.size(); i++) std::cout << overlap_rotors_.at(i) << " -> " << overlap_segments_.at(i) << "; ";
-      // std::cout << std::endl;
-      // for(int i = 0; i < overlap_positions_.size(); i++) std::cout << overlap_positions_.at(i).transpose() << "; ";
-      // std::cout << std::endl;
-
-      Eigen::MatrixXd A = Eigen::MatrixXd::Zero(3, overlap_positions_.size());
-      for(int j = 0; j < overlap_positions_.size(); j++)
-        A.col(j) = Eigen::Vector3d(1, overlap_positions_.at(j).y(), -overlap_positions_.at(j).x());
+      Eigen::MatrixXd A = Eigen::MatrixXd::Zero(3, overlaps_.size());
+      for(int j = 0; j < overlaps_.size(); j++)
+        A.col(j) = Eigen::Vector3d(1, overlaps_.at(j).position.y(), -overlaps_.at(j).position.x());
 
       Eigen::MatrixXd dev_weight_mat = Eigen::MatrixXd::Identity(A.cols(), A.cols()) - Eigen::MatrixXd::Ones(A.cols(), A.cols())/A.cols();
       Eigen::MatrixXd W_dev = Eigen::MatrixXd::Identity(A.cols(), A.cols());
-      for(int j = 0; j < overlap_weights_.size(); j++)
-        W_dev(j,j) = overlap_weights_.at(j);
+      for(int j = 0; j < overlaps_.size(); j++)
+        W_dev(j,j) = overlaps_.at(j).weight;
 
       Eigen::MatrixXd W_diff = rotor_interfere_torque_xy_weight_ * Eigen::MatrixXd::Identity(A.rows(), A.rows());
       W_diff(0,0) = 1;
@@ -340,26 +136,13 @@ void DragonFullVectoringController::rotorInterfereCompensation()
         {
           while(1)
             {
-              std::vector<Eigen::VectorXd> overlap_positions_tmp = overlap_positions_;
-              std::vector<double> overlap_weights_tmp = overlap_weights_;
-              std::vector<std::string> overlap_segments_tmp = overlap_segments_;
-              std::vector<std::string> overlap_rotors_tmp = overlap_rotors_;
-              overlap_positions_.clear();
-              overlap_weights_.clear();
-              overlap_segments_.clear();
-              overlap_rotors_.clear();
-
+              int valid_num = 0;
               for(int i = 0; i < rotor_interfere_force_.size(); i++)
                 {
-                  if(rotor_interfere_force_(i) < 0)
-                    {
-                      overlap_positions_.push_back(overlap_positions_tmp.at(i));
-                      overlap_weights_.push_back(overlap_weights_tmp.at(i));
-                      overlap_segments_.push_back(overlap_segments_tmp.at(i));
-                      overlap_rotors_.push_back(overlap_rotors_tmp.at(i));
-                    }
+                  if(rotor_interfere_force_(i) < 0) overlaps_.at(valid_num++) = overlaps_.at(i);
                 }
-              if(overlap_positions_.size() == 0)
+              overlaps_.resize(valid_num);
+              if(overlaps_.size() == 0)
                 {
                   rotor_interfere_comp_wrench_.segment(2, 3) = (1 - comp_wrench_lpf_rate_) * rotor_interfere_comp_wrench_.segment(2, 3) +  comp_wrench_lpf_rate_ * Eigen::VectorXd::Zero(3);
                   rotor_interfere_force_.setZero();
@@ -369,14 +152,14 @@ void DragonFullVectoringController::rotorInterfereCompensation()
               else
                 {
                   /// ROS_WARN_STREAM("rotor_interfere force before recalculate: " << rotor_interfere_force_.transpose());
-                  A = Eigen::MatrixXd::Zero(3, overlap_positions_.size());
-                  for(int j = 0; j < overlap_positions_.size(); j++)
-                    A.col(j) = Eigen::Vector3d(1, overlap_positions_.at(j).y(), -overlap_positions_.at(j).x());
+                  A = Eigen::MatrixXd::Zero(3, overlaps_.size());
+                  for(int j = 0; j < overlaps_.size(); j++)
+                    A.col(j) = Eigen::Vector3d(1, overlaps_.at(j).position.y(), -overlaps_.at(j).position.x());
 
                   Eigen::MatrixXd dev_weight_mat = Eigen::MatrixXd::Identity(A.cols(), A.cols()) - Eigen::MatrixXd::Ones(A.cols(), A.cols())/A.cols();
                   Eigen::MatrixXd W_dev = Eigen::MatrixXd::Identity(A.cols(), A.cols());
-                  for(int j = 0; j < overlap_weights_.size(); j++)
-                    W_dev(j,j) = overlap_weights_.at(j);
+                  for(int j = 0; j < overlaps_.size(); j++)
+                    W_dev(j,j) = overlaps_.at(j).weight;
 
                   Eigen::MatrixXd W_diff = rotor_interfere_torque_xy_weight_ * Eigen::MatrixXd::Identity(A.rows(), A.rows());
                   W_diff(0,0) = 1;
@@ -406,20 +189,20 @@ void DragonFullVectoringController::rotorInterfereCompensation()
 
   // visualize the interference
   visualization_msgs::MarkerArray interference_marker_msg;
-  if(overlap_positions_.size() > 0)
+  if(overlaps_.size() > 0)
     {
       int id = 0;
-      for(int i = 0; i < overlap_positions_.size(); i++)
+      for(int i = 0; i < overlaps_.size(); i++)
         {
           visualization_msgs::Marker segment_sphere;
           segment_sphere.header.stamp = ros::Time::now();
-          segment_sphere.header.frame_id = nh_.getNamespace() + std::string("/cog"); //overlap_segments_.at(i);
+          segment_sphere.header.frame_id = nh_.getNamespace() + std::string("/cog");
           segment_sphere.id = id++;
           segment_sphere.action = visualization_msgs::Marker::ADD;
           segment_sphere.type = visualization_msgs::Marker::SPHERE;
-          segment_sphere.pose.position.x = overlap_positions_.at(i).x();
-          segment_sphere.pose.position.y = overlap_positions_.at(i).y();
-          segment_sphere.pose.position.z = overlap_positions_.at(i).z();
+          segment_sphere.pose.position.x = overlaps_.at(i).position.x();
+          segment_sphere.pose.position.y = overlaps_.at(i).position.y();
+          segment_sphere.pose.position.z = overlaps_.at(i).position.z();
           segment_sphere.pose.orientation.w = 1;
           segment_sphere.scale.x = 0.15;
           segment_sphere.scale.y = 0.15;
@@ -431,13 +214,13 @@ void DragonFullVectoringController::rotorInterfereCompensation()
 
           visualization_msgs::Marker force_arrow;
           force_arrow.header.stamp = ros::Time::now();
-          force_arrow.header.frame_id = nh_.getNamespace() + std::string("/cog"); //overlap_segments_.at(i);
+          force_arrow.header.frame_id = nh_.getNamespace() + std::string("/cog");
           force_arrow.id = id++;
           force_arrow.action = visualization_msgs::Marker::ADD;
           force_arrow.type = visualization_msgs::Marker::ARROW;
-          force_arrow.pose.position.x = overlap_positions_.at(i).x();
-          force_arrow.pose.position.y = overlap_positions_.at(i).y();
-          force_arrow.pose.position.z = overlap_positions_.at(i).z() - 0.02;
+          force_arrow.pose.position.x = overlaps_.at(i).position.x();
+          force_arrow.pose.position.y = overlaps_.at(i).position.y();
+          force_arrow.pose.position.z = overlaps_.at(i).position.z() - 0.02;
           force_arrow.pose.orientation = tf::createQuaternionMsgFromRollPitchYaw(0, -M_PI/2, 0);
           force_arrow.scale.x = rotor_interfere_force_(i) / 10.0;
           force_arrow.scale.y = 0.02;
@@ -471,6 +254,16 @@ void DragonFullVectoringController::controlCore()
   /* TODO: saturation of z control */
   PoseLinearController::controlCore();
 
+  if(replay_ && dragon_imu_)
+    {
+      double now = ros::Time::now().toSec();
+      if(now - wrench_estimate_timestamp_ >= 1.0 / wrench_estimate_update_rate_)
+        {
+          externalWrenchEstimate(estimator_->getImuLatestTimeStamp());
+          wrench_estimate_timestamp_ = now;
+        }
+    }
+
   tf::Matrix3x3 uav_rot = estimator_->getOrientation(Frame::COG, estimate_mode_);
   tf::Vector3 target_acc_w(pid_controllers_.at(X).result(),
                            pid_controllers_.at(Y).result(),
@@ -515,17 +308,17 @@ void DragonFullVectoringController::controlCore()
   rotor_interfere_comp_acc(2) = mass_inv * rotor_interfere_comp_wrench_(2);
 
   bool torque_comp = false;
-  if(overlap_positions_.size() == 1)
+  if(overlaps_.size() == 1)
     {
-      ROS_INFO_STREAM("compsensate the torque resulted from rotor interference: " << overlap_rotors_.at(0) << " to " << overlap_segments_.at(0));
+      ROS_INFO_STREAM("compsensate the torque resulted from rotor interference: " << rotor_interference_.getOverlapName(overlaps_.at(0)));
       torque_comp = true;
     }
 
-  if(overlap_positions_.size() == 2)
+  if(overlaps_.size() == 2)
     {
-      if(overlap_rotors_.at(0).substr(0, 6) == overlap_rotors_.at(1).substr(0, 6))
+      if(overlaps_.at(0).rotor / 2 == overlaps_.at(1).rotor / 2) // same rotor module
         {
-          ROS_INFO_STREAM("do rotor interference torque compensation: " << overlap_rotors_.at(0) << " and " << overlap_rotors_.at(1));
+          ROS_INFO_STREAM("do rotor interference torque compensation: " << rotor_interference_.getOverlapName(overlaps_.at(0)) << " and " << rotor_interference_.getOverlapName(overlaps_.at(1)));
           torque_comp = true;
         }
     }
@@ -539,8 +332,8 @@ void DragonFullVectoringController::controlCore()
     target_wrench_acc_cog += rotor_interfere_comp_acc;
 
   std::stringstream ss;
-  for(int i = 0; i < overlap_rotors_.size(); i++) ss << overlap_rotors_.at(i) << " -> " << overlap_segments_.at(i) << "; ";
-  if(overlap_rotors_.size() > 0) ROS_DEBUG_STREAM("rotor interference: " << ss.str());
+  for(int i = 0; i < overlaps_.size(); i++) ss << rotor_interference_.getOverlapName(overlaps_.at(i)) << "; ";
+  if(overlaps_.size() > 0) ROS_DEBUG_STREAM("rotor interference: " << ss.str());
 
   setTargetWrenchAccCog(target_wrench_acc_cog);
 
@@ -559,7 +352,9 @@ void DragonFullVectoringController::controlCore()
   Eigen::MatrixXd full_q_mat = Eigen::MatrixXd::Zero(6, 3 * motor_num_ - gimbal_lock_num);
 
   double t = ros::Time::now().toSec();
-  for(int j = 0; j < allocation_refine_max_iteration_; j++)
+  /* the QP allocation is solved once with the rotor origins from the current gimbal angles, since the thrust and gimbal limits are considered there */
+  const int allocation_refine_max_iteration = wrench_allocation_qp_ ? 1 : allocation_refine_max_iteration_;
+  for(int j = 0; j < allocation_refine_max_iteration; j++)
     {
       /* 5.2.1. update the wrench allocation matrix  */
       std::vector<Eigen::Vector3d> rotors_origin_from_cog = robot_model_for_control_->getRotorsOriginFromCog<Eigen::Vector3d>();
@@ -591,8 +386,21 @@ void DragonFullVectoringController::controlCore()
       inertia_inv = robot_model_for_control_->getInertia<Eigen::Matrix3d>().inverse(); // update
       full_q_mat.topRows(3) =  mass_inv * full_q_mat.topRows(3) ;
       full_q_mat.bottomRows(3) =  inertia_inv * full_q_mat.bottomRows(3);
-      Eigen::MatrixXd full_q_mat_inv = aerial_robot_model::pseudoinverse(full_q_mat);
-      target_vectoring_f_ = full_q_mat_inv * target_wrench_acc_cog;
+      if(wrench_allocation_qp_)
+        {
+          std::vector<int> rotor_dims(motor_num_);
+          for(int i = 0; i < motor_num_; i++) rotor_dims.at(i) = roll_locked_gimbal.at(i) == 0 ? 3 : 2;
+          bool converged = allocation_qp_.solve(full_q_mat, target_wrench_acc_cog, rotor_dims, ctrl_loop_du_, target_vectoring_f_);
+
+          const auto& stats = allocation_qp_.getStats();
+          if(!converged) ROS_WARN_STREAM_THROTTLE(1.0, "wrench allocation QP: not converged in " << stats.iterations << " iterations, primal residual: " << stats.primal_residual << ", dual residual: " << stats.dual_residual);
+          ROS_DEBUG_STREAM_THROTTLE(1.0, "wrench allocation QP: iterations " << stats.iterations << ", warm start " << stats.warm_started << ", solve time " << stats.solve_time << "sec, wrench error " << stats.wrench_error << ", saturated rotors " << stats.saturated_rotors);
+        }
+      else
+        {
+          Eigen::MatrixXd full_q_mat_inv = aerial_robot_model::pseudoinverse(full_q_mat);
+          target_vectoring_f_ = full_q_mat_inv * target_wrench_acc_cog;
+        }
 
       if(control_verbose_) ROS_DEBUG_STREAM("vectoring force for control in iteration "<< j+1 << ": " << target_vectoring_f_.transpose());
       last_col = 0;
@@ -631,6 +439,8 @@ void DragonFullVectoringController::controlCore()
             }
         }
 
+      if(wrench_allocation_qp_) break;
+
       std::vector<Eigen::Vector3d> prev_rotors_origin_from_cog = rotors_origin_from_cog;
       for(int i = 0; i < motor_num_; ++i)
         {
@@ -780,67 +590,47 @@ void DragonFullVectoringController::controlCore()
 #endif
 }
 
-void DragonFullVectoringController::externalWrenchEstimate()
+void DragonFullVectoringController::externalWrenchEstimate(double stamp)
 {
   if(navigator_->getNaviState() != aerial_robot_navigation::HOVER_STATE &&
      navigator_->getNaviState() != aerial_robot_navigation::LAND_STATE)
     {
-      prev_est_wrench_timestamp_ = 0;
-      integrate_term_ = Eigen::VectorXd::Zero(6);
+      wrench_observer_.reset();
+      std::lock_guard<std::mutex> lock(est_wrench_mutex_);
+      est_external_wrench_.setZero();
       return;
     }
 
-  Eigen::Vector3d vel_w, omega_cog; // workaround: use the filtered value
-  auto imu_handler = boost::dynamic_pointer_cast<sensor_plugin::DragonImu>(estimator_->getImuHandler(0));
-  tf::vectorTFToEigen(imu_handler->getFilteredVelCog(), vel_w);
-  tf::vectorTFToEigen(imu_handler->getFilteredOmegaCog(), omega_cog);
-  Eigen::Matrix3d cog_rot;
-  tf::matrixTFToEigen(estimator_->getOrientation(Frame::COG, estimate_mode_), cog_rot);
-
-  Eigen::Matrix3d inertia = robot_model_->getInertia<Eigen::Matrix3d>();
-  double mass = robot_model_->getMass();
-
-  Eigen::VectorXd sum_momentum = Eigen::VectorXd::Zero(6);
-  sum_momentum.head(3) = mass * vel_w;
-  sum_momentum.tail(3) = inertia * omega_cog;
-
-  Eigen::MatrixXd J_t = Eigen::MatrixXd::Identity(6,6);
-  J_t.topLeftCorner(3,3) = cog_rot;
-
-  Eigen::VectorXd N = mass * robot_model_->getGravity();
-  N.tail(3) = aerial_robot_model::skew(omega_cog) * (inertia * omega_cog);
+  ExternalWrenchObserverInput input;
+  input.stamp = stamp;
+  input.mass = robot_model_->getMass();
+  input.inertia = robot_model_->getInertia<Eigen::Matrix3d>();
+  input.gravity = robot_model_->getGravity3d();
+  tf::vectorTFToEigen(dragon_imu_->getFilteredVelCog(), input.vel); // workaround: use the filtered value
+  tf::vectorTFToEigen(dragon_imu_->getFilteredOmegaCog(), input.omega);
+  tf::matrixTFToEigen(estimator_->getOrientation(Frame::COG, estimate_mode_), input.rot);
 
   const Eigen::VectorXd target_wrench_acc_cog = getTargetWrenchAccCog();
-  Eigen::VectorXd target_wrench_cog = Eigen::VectorXd::Zero(6);
-  target_wrench_cog.head(3) = mass * target_wrench_acc_cog.head(3);
-  target_wrench_cog.tail(3) = inertia * target_wrench_acc_cog.tail(3);
-
-  if(prev_est_wrench_timestamp_ == 0)
-    {
-      prev_est_wrench_timestamp_ = ros::Time::now().toSec();
-      init_sum_momentum_ = sum_momentum; // not good
-    }
-
-  double dt = ros::Time::now().toSec() - prev_est_wrench_timestamp_;
-
-  integrate_term_ += (J_t * target_wrench_cog - N + est_external_wrench_) * dt;
+  input.wrench.head<3>() = input.mass * target_wrench_acc_cog.head(3);
+  input.wrench.tail<3>() = input.inertia * target_wrench_acc_cog.tail(3);
 
-  est_external_wrench_ = momentum_observer_matrix_ * (sum_momentum - init_sum_momentum_ - integrate_term_);
+  if(!wrench_observer_.update(input)) return;
+  const Vector6d& est_external_wrench = wrench_observer_.getWrench();
 
-  Eigen::VectorXd est_external_wrench_cog = est_external_wrench_;
-  est_external_wrench_cog.head(3) = cog_rot.inverse() * est_external_wrench_.head(3);
+  {
+    std::lock_guard<std::mutex> lock(est_wrench_mutex_);
+    est_external_wrench_ = est_external_wrench;
+  }
 
   geometry_msgs::WrenchStamped wrench_msg;
-  wrench_msg.header.stamp.fromSec(estimator_->getImuLatestTimeStamp());
-  wrench_msg.wrench.force.x = est_external_wrench_(0);
-  wrench_msg.wrench.force.y = est_external_wrench_(1);
-  wrench_msg.wrench.force.z = est_external_wrench_(2);
-  wrench_msg.wrench.torque.x = est_external_wrench_(3);
-  wrench_msg.wrench.torque.y = est_external_wrench_(4);
-  wrench_msg.wrench.torque.z = est_external_wrench_(5);
+  wrench_msg.header.stamp.fromSec(stamp);
+  wrench_msg.wrench.force.x = est_external_wrench(0);
+  wrench_msg.wrench.force.y = est_external_wrench(1);
+  wrench_msg.wrench.force.z = est_external_wrench(2);
+  wrench_msg.wrench.torque.x = est_external_wrench(3);
+  wrench_msg.wrench.torque.y = est_external_wrench(4);
+  wrench_msg.wrench.torque.z = est_external_wrench(5);
   estimate_external_wrench_pub_.publish(wrench_msg);
-
-  prev_est_wrench_timestamp_ = ros::Time::now().toSec();
 }
 
 
@@ -896,12 +686,50 @@ void DragonFullVectoringController::rosParamInit()
   getParam<double>(control_nh, "allocation_refine_threshold", allocation_refine_threshold_, 0.01);
   getParam<int>(control_nh, "allocation_refine_max_iteration", allocation_refine_max_iteration_, 1);
 
-  momentum_observer_matrix_ = Eigen::MatrixXd::Identity(6,6);
+  getParam<bool>(control_nh, "wrench_allocation_qp", wrench_allocation_qp_, false);
+  ros::NodeHandle qp_nh(control_nh, "allocation_qp");
+  WrenchAllocationQPParams qp_params;
+  getParam<int>(qp_nh, "max_iteration", qp_params.max_iteration, 50);
+  getParam<double>(qp_nh, "tolerance", qp_params.tolerance, 1e-4);
+  getParam<double>(qp_nh, "relative_tolerance", qp_params.relative_tolerance, 1e-3);
+  getParam<double>(qp_nh, "rho", qp_params.rho, 0.1);
+  getParam<double>(qp_nh, "effort_weight", qp_params.effort_weight, 1e-4);
   double force_weight, torque_weight;
+  getParam<double>(qp_nh, "force_weight", force_weight, 1.0);
+  getParam<double>(qp_nh, "torque_weight", torque_weight, 1.0);
+  qp_params.wrench_weight << force_weight, force_weight, force_weight, torque_weight, torque_weight, torque_weight;
+  getParam<double>(qp_nh, "gimbal_max_angle", qp_params.gimbal_max_angle, M_PI / 2);
+  getParam<double>(qp_nh, "gimbal_max_rate", qp_params.gimbal_max_rate, 10.0); // rad/s
+  qp_params.thrust_min = robot_model_->getThrustLowerLimit();
+  qp_params.thrust_max = robot_model_->getThrustUpperLimit();
+  allocation_qp_.setParams(qp_params);
+
+  ExternalWrenchObserverParams observer_params;
   getParam<double>(control_nh, "momentum_observer_force_weight", force_weight, 10.0);
   getParam<double>(control_nh, "momentum_observer_torque_weight", torque_weight, 10.0);
-  momentum_observer_matrix_.topRows(3) *= force_weight;
-  momentum_observer_matrix_.bottomRows(3) *= torque_weight;
+  observer_params.gain << force_weight, force_weight, force_weight, torque_weight, torque_weight, torque_weight;
+  ros::NodeHandle observer_nh(control_nh, "wrench_observer");
+  std::string observer_type;
+  getParam<std::string>(observer_nh, "type", observer_type, std::string("first_order"));
+  if(observer_type == std::string("second_order")) observer_params.type = ExternalWrenchObserverParams::SECOND_ORDER;
+  else if(observer_type == std::string("kalman")) observer_params.type = ExternalWrenchObserverParams::KALMAN;
+  else observer_params.type = ExternalWrenchObserverParams::FIRST_ORDER;
+  getParam<bool>(observer_nh, "imu_sync", wrench_observer_imu_sync_, true);
+  double force_param, torque_param;
+  getParam<double>(observer_nh, "force_bandwidth", force_param, 20.0);
+  getParam<double>(observer_nh, "torque_bandwidth", torque_param, 20.0);
+  observer_params.bandwidth << force_param, force_param, force_param, torque_param, torque_param, torque_param;
+  getParam<double>(observer_nh, "damping", observer_params.damping, 0.7);
+  getParam<double>(observer_nh, "force_momentum_noise", force_param, 0.05);
+  getParam<double>(observer_nh, "torque_momentum_noise", torque_param, 0.05);
+  observer_params.momentum_noise << force_param, force_param, force_param, torque_param, torque_param, torque_param;
+  getParam<double>(observer_nh, "force_momentum_process_noise", force_param, 0.5);
+  getParam<double>(observer_nh, "torque_momentum_process_noise", torque_param, 0.5);
+  observer_params.momentum_process_noise << force_param, force_param, force_param, torque_param, torque_param, torque_param;
+  getParam<double>(observer_nh, "force_process_noise", force_param, 20.0);
+  getParam<double>(observer_nh, "torque_process_noise", torque_param, 20.0);
+  observer_params.wrench_process_noise << force_param, force_param, force_param, torque_param, torque_param, torque_param;
+  wrench_observer_.setParams(observer_params);
 
   getParam<bool>(control_nh, "rotor_interfere_compensate", rotor_interfere_compensate_, true);
   getParam<double>(control_nh, "external_wrench_lpf_rate", wrench_lpf_rate_, 0.5);
@@ -910,11 +738,59 @@ void DragonFullVectoringController::rosParamInit()
   getParam<double>(control_nh, "rotor_interfere_force_dev_weight", rotor_interfere_force_dev_weight_, 1.0);
   getParam<double>(control_nh, "rotor_interfere_torque_xy_weight", rotor_interfere_torque_xy_weight_, 1.0);
 
-  getParam<double>(control_nh, "overlap_dist_link_thresh", overlap_dist_link_thresh_, 0.08);
-  getParam<double>(control_nh, "overlap_dist_rotor_thresh", overlap_dist_rotor_thresh_, 0.08);
-  getParam<double>(control_nh, "overlap_dist_link_relax_thresh", overlap_dist_link_relax_thresh_, 0.08);
-  getParam<double>(control_nh, "overlap_dist_rotor_relax_thresh", overlap_dist_rotor_relax_thresh_, 0.08);
-  getParam<double>(control_nh, "overlap_dist_inter_joint_thresh", overlap_dist_inter_joint_thresh_, 0.08);
+  Dragon::RotorInterferenceParams interference_params;
+  getParam<double>(control_nh, "overlap_dist_link_thresh", interference_params.link_thresh, 0.08);
+  getParam<double>(control_nh, "overlap_dist_rotor_thresh", interference_params.rotor_thresh, 0.08);
+  getParam<double>(control_nh, "overlap_dist_link_relax_thresh", interference_params.link_relax_thresh, 0.08);
+  getParam<double>(control_nh, "overlap_dist_rotor_relax_thresh", interference_params.rotor_relax_thresh, 0.08);
+  getParam<double>(control_nh, "overlap_dist_inter_joint_thresh", interference_params.inter_joint_thresh, 0.08);
+  getParam<double>(control_nh, "overlap_downwash_cone_angle", interference_params.downwash_cone_angle, 0.0);
+  rotor_interference_.setParams(interference_params);
+  rotor_interference_.initialize(motor_num_);
+  interfere_segment_positions_.resize(rotor_interference_.getSegmentNames().size());
+  interfere_link_axes_.resize(motor_num_);
+}
+
+void DragonFullVectoringController::addTelemetryChannels(telemetry::Recorder& recorder)
+{
+  PoseLinearController::addTelemetryChannels(recorder);
+
+  std::vector<std::string> vectoring_fields;
+  for(int i = 0; i < motor_num_; i++)
+    {
+      const std::string rotor = "rotor" + std::to_string(i + 1);
+      for(const auto field: {"base_thrust", "gimbal_roll", "gimbal_pitch"})
+        vectoring_fields.push_back(rotor + "/" + field);
+    }
+  std::vector<std::string> wrench_fields;
+  for(const auto prefix: {"target/", "rotor_interfere_comp/"})
+    for(const auto axis: {"f_x", "f_y", "f_z", "t_x", "t_y", "t_z"})
+      wrench_fields.push_back(std::string(prefix) + axis);
+
+  vectoring_telemetry_channel_ = recorder.addChannel("controller/vectoring", vectoring_fields);
+  wrench_telemetry_channel_ = recorder.addChannel("controller/target_wrench_acc", wrench_fields);
+}
+
+void DragonFullVectoringController::recordTelemetry(telemetry::Recorder& recorder, double stamp)
+{
+  PoseLinearController::recordTelemetry(recorder, stamp);
+
+  std::array<double, telemetry::MAX_FIELDS> values; // no allocation in the control loop
+  size_t n = 0;
+  for(int i = 0; i < motor_num_ && n + 3 <= values.size(); i++)
+    {
+      values[n++] = target_base_thrust_.at(i);
+      values[n++] = target_gimbal_angles_.at(2 * i);
+      values[n++] = target_gimbal_angles_.at(2 * i + 1);
+    }
+  recorder.record(vectoring_telemetry_channel_, stamp, values.data(), n);
+
+  // target_wrench_acc_cog_ is only written in controlCore() of this thread, no need to lock wrench_mutex_
+  if(target_wrench_acc_cog_.size() != 6) return;
+  n = 0;
+  for(int i = 0; i < 6; i++) values[n++] = target_wrench_acc_cog_(i);
+  for(int i = 0; i < 6; i++) values[n++] = rotor_interfere_comp_wrench_(i);
+  recorder.record(wrench_telemetry_channel_, stamp, values.data(), n);
 }
 
 /* plugin registration */
@@ -4,7 +4,8 @@ using namespace aerial_robot_model;
 using namespace aerial_robot_control;
 
 DragonLQIGimbalController::DragonLQIGimbalController():
-  HydrusLQIController()
+  HydrusLQIController(),
+  gimbal_telemetry_channel_(-1)
 {
 }
 
@@ -19,13 +20,9 @@ void DragonLQIGimbalController::initialize(ros::NodeHandle nh, ros::NodeHandle n
 
   dragon_robot_model_ = boost::dynamic_pointer_cast<Dragon::HydrusLikeRobotModel>(robot_model);
 
-  /* initialize the matrix */
-  P_xy_ = Eigen::MatrixXd::Zero(2, motor_num_ * 2);
-  for(int i = 0; i < motor_num_; i++)
-    {
-      P_xy_(0, i * 2) = 1;
-      P_xy_(1, 1 + i * 2) = 1;
-    }
+  /* initialize the allocation kernel */
+  force_allocator_ = createGimbalForceAllocator(motor_num_);
+  f_xy_ = Eigen::VectorXd::Zero(motor_num_ * 2);
 
   lqi_att_terms_.resize(motor_num_);
 
@@ -33,6 +30,7 @@ void DragonLQIGimbalController::initialize(ros::NodeHandle nh, ros::NodeHandle n
   target_gimbal_angles_.resize(motor_num_ * 2, 0);
   /* additional vectoring force for grasping */
   extra_vectoring_force_ = Eigen::VectorXd::Zero(3 * motor_num_);
+  external_wrench_changed_ = true;
 
   gimbal_control_pub_ = nh_.advertise<sensor_msgs::JointState>("gimbals_ctrl", 1);
   gimbal_target_force_pub_ = nh_.advertise<std_msgs::Float32MultiArray>("debug/gimbals_target_force", 1);
@@ -59,12 +57,18 @@ void DragonLQIGimbalController::attControlFeedbackStateCallback(const spinal::Ro
 
   if(!add_lqi_result_) return;
 
+  /* own snapshot of the committed gains, since this callback runs outside the control loop and the gain generator */
+  const auto gains = std::atomic_load(&gains_);
+  if(!gains) return;
+
   /* reproduce the control term about attitude in spinal based on LQI, instead of the roll/pitch control from pose linear controller  */
   /* -- only consider the P term and I term, since D term (angular velocity from gyro) in current Dragon platform is too noisy -- */
 
   for(int i = 0; i < motor_num_; i++)
     {
-      lqi_att_terms_.at(i) = -roll_gains_.at(i)[0] * (msg->roll_p / 1000.0) + roll_gains_.at(i)[1] * (msg->roll_i / 1000.0) + (-pitch_gains_.at(i)[0]) * (msg->pitch_p / 1000.0) + pitch_gains_.at(i)[1] * (msg->pitch_i / 1000.0);
+      const Eigen::Vector3d& roll_gain = gains->roll_gains.at(i);
+      const Eigen::Vector3d& pitch_gain = gains->pitch_gains.at(i);
+      lqi_att_terms_.at(i) = -roll_gain[0] * (msg->roll_p / 1000.0) + roll_gain[1] * (msg->roll_i / 1000.0) + (-pitch_gain[0]) * (msg->pitch_p / 1000.0) + pitch_gain[1] * (msg->pitch_i / 1000.0);
     }
 }
 
@@ -89,8 +93,9 @@ void DragonLQIGimbalController::controlCore()
 
 void DragonLQIGimbalController::gimbalControl()
 {
-  std::vector<Eigen::Vector3d> rotors_origin_from_cog = robot_model_->getRotorsOriginFromCog<Eigen::Vector3d>();
-  Eigen::Matrix3d links_inertia = robot_model_->getInertia<Eigen::Matrix3d>();
+  const std::vector<KDL::Vector> rotors_origin_from_cog = robot_model_->getRotorsOriginFromCog<KDL::Vector>();
+  const std::vector<KDL::Rotation> links_frame_from_cog = dragon_robot_model_->getLinksRotationFromCog<KDL::Rotation>();
+  const Eigen::Matrix3d links_inertia = robot_model_->getInertia<Eigen::Matrix3d>();
 
   const std::vector<float>& z_control_terms = target_base_thrust_;
 
@@ -98,42 +103,29 @@ void DragonLQIGimbalController::gimbalControl()
   double max_y = 1e-6;
   double max_z = 1e-6;
 
-  Eigen::MatrixXd P_att = Eigen::MatrixXd::Zero(3, motor_num_  * 2);
   double acc_z = 0;
   for(int i = 0; i < motor_num_; i++)
     {
-      P_att(0, 2 * i + 1) = -rotors_origin_from_cog.at(i)(2); //x(roll)
-      P_att(1, 2 * i) = rotors_origin_from_cog.at(i)(2); //y(pitch)
-      P_att(2, 2 * i) = -rotors_origin_from_cog.at(i)(1);
-      P_att(2, 2 * i + 1) = rotors_origin_from_cog.at(i)(0);
-
       /* roll pitch condition */
-      if(fabs(rotors_origin_from_cog.at(i)(0)) > max_x) max_x = fabs(rotors_origin_from_cog.at(i)(0));
-      if(fabs(rotors_origin_from_cog.at(i)(1)) > max_y) max_y = fabs(rotors_origin_from_cog.at(i)(1));
-      if(fabs(rotors_origin_from_cog.at(i)(2)) > max_z) max_z = fabs(rotors_origin_from_cog.at(i)(2));
+      if(fabs(rotors_origin_from_cog.at(i).x()) > max_x) max_x = fabs(rotors_origin_from_cog.at(i).x());
+      if(fabs(rotors_origin_from_cog.at(i).y()) > max_y) max_y = fabs(rotors_origin_from_cog.at(i).y());
+      if(fabs(rotors_origin_from_cog.at(i).z()) > max_z) max_z = fabs(rotors_origin_from_cog.at(i).z());
 
       acc_z += (lqi_att_terms_.at(i) + z_control_terms.at(i));
     }
   acc_z /= robot_model_->getMass();
 
-  Eigen::MatrixXd P_att_orig = P_att;
-  P_att = links_inertia.inverse() * P_att_orig;
-
-  Eigen::MatrixXd P = Eigen::MatrixXd::Zero(5, motor_num_  * 2);
-  P.block(0, 0, 3, motor_num_ * 2) = P_att;
-  P.block(3, 0, 2, motor_num_ * 2) = P_xy_ / robot_model_->getMass();
-
-  double P_det = (P * P.transpose()).determinant();
+  /* P = [I^-1 * P_att; P_xy / m], factorized once for both the determinant check and the allocation */
+  double P_det = force_allocator_->update(rotors_origin_from_cog, links_inertia, robot_model_->getMass());
 
   if(control_verbose_)
     {
-      std::cout << "gimbal P original: \n"  << std::endl << P_att_orig << std::endl;
-      std::cout << "gimbal P: \n"  << std::endl << P << std::endl;
+      std::cout << "gimbal P: \n"  << std::endl << force_allocator_->getP() << std::endl;
       std::cout << "P det: "  << std::endl << P_det << std::endl;
       std::cout << "acc_z: " << acc_z  << std::endl;
     }
 
-  Eigen::VectorXd f_xy;
+  Eigen::VectorXd& f_xy = f_xy_;
   tf::Vector3 target_linear_acc_w(pid_controllers_.at(X).result(),
                                   pid_controllers_.at(Y).result(),
                                   pid_controllers_.at(Z).result());
@@ -162,11 +154,7 @@ void DragonLQIGimbalController::gimbalControl()
     {
       // no pitch roll
       if(control_verbose_) ROS_ERROR("low P_det: %f", P_det);
-      P = Eigen::MatrixXd::Zero(3, motor_num_  * 2);
-      P.block(0, 0, 1, motor_num_ * 2) = P_att.block(2, 0, 1, motor_num_ * 2);
-      P.block(1, 0, 2, motor_num_ * 2) = P_xy_ / robot_model_->getMass();
-
-      f_xy = pseudoinverse(P) * Eigen::Vector3d(target_ang_acc_z, target_linear_acc_cog.x() - (rpy_.y() * acc_z), target_linear_acc_cog.y() - (-rpy_.x() * acc_z));
+      force_allocator_->allocateYawXy(Eigen::Vector3d(target_ang_acc_z, target_linear_acc_cog.x() - (rpy_.y() * acc_z), target_linear_acc_cog.y() - (-rpy_.x() * acc_z)), f_xy);
 
       // reset  roll pitch control
       pid_controllers_.at(ROLL).reset();
@@ -202,10 +190,10 @@ void DragonLQIGimbalController::gimbalControl()
           target_ang_acc_y = 0;
         }
 
-      Eigen::VectorXd pid_values(5);
+      Eigen::Matrix<double, 5, 1> pid_values;
       /* F = P# * [roll_pid, pitch_pid, yaw_pid, x_pid, y_pid] */
       pid_values << target_ang_acc_x, target_ang_acc_y, target_ang_acc_z, target_linear_acc_cog.x() - (rpy_.y() * acc_z), target_linear_acc_cog.y() - (-rpy_.x() * acc_z);
-      f_xy = pseudoinverse(P) * pid_values;
+      force_allocator_->allocate(pid_values, f_xy);
     }
 
   pid_msg_.roll.total.at(0) = target_ang_acc_x;
@@ -221,25 +209,42 @@ void DragonLQIGimbalController::gimbalControl()
 
   if(control_verbose_)
     {
-      std::cout << "gimbal P_pseudo_inverse:"  << std::endl << pseudoinverse(P) << std::endl;
       std::cout << "gimbal force for horizontal control:"  << std::endl << f_xy << std::endl;
     }
 
   /* external wrench compensation */
   if(boost::dynamic_pointer_cast<aerial_robot_navigation::DragonNavigator>(navigator_)->getLandingFlag())
     {
-      dragon_robot_model_->resetExternalStaticWrench(); // clear the external wrench
+      std::lock_guard<std::mutex> lock(external_wrench_mutex_);
+      if(!dragon_robot_model_->getExternalWrenchMap().empty())
+        {
+          dragon_robot_model_->resetExternalStaticWrench(); // clear the external wrench
+          external_wrench_changed_ = true;
+        }
       extra_vectoring_force_.setZero(); // clear the extra vectoring force
     }
 
-  Eigen::MatrixXd cog_rot_inv = aerial_robot_model::kdlToEigen(KDL::Rotation::RPY(rpy_.x(), rpy_.y(), rpy_.z()).Inverse());
-  Eigen::MatrixXd extended_cog_rot_inv = Eigen::MatrixXd::Zero(6, 6);
-  extended_cog_rot_inv.topLeftCorner(3,3) = cog_rot_inv;
-  extended_cog_rot_inv.bottomRightCorner(3,3) = cog_rot_inv;
-  std::map<std::string, Dragon::ExternalWrench> external_wrench_map = dragon_robot_model_->getExternalWrenchMap();
-  for(auto& wrench: external_wrench_map) wrench.second.wrench = extended_cog_rot_inv * wrench.second.wrench;
-
-  dragon_robot_model_->calcExternalWrenchCompThrust(external_wrench_map);
+  {
+    std::lock_guard<std::mutex> lock(external_wrench_mutex_);
+    const std::map<std::string, Dragon::ExternalWrench>& model_external_wrench_map = dragon_robot_model_->getExternalWrenchMap();
+    if(external_wrench_changed_ || external_wrench_map_.size() != model_external_wrench_map.size())
+      {
+        external_wrench_map_ = model_external_wrench_map;
+        external_wrench_changed_ = false;
+      }
+
+    /* only rotate the wrenches in place, the keys are same with the robot model */
+    const Eigen::Matrix3d cog_rot_inv = aerial_robot_model::kdlToEigen(KDL::Rotation::RPY(rpy_.x(), rpy_.y(), rpy_.z()).Inverse());
+    auto model_wrench = model_external_wrench_map.begin();
+    for(auto& wrench: external_wrench_map_)
+      {
+        wrench.second.wrench.head<3>() = cog_rot_inv * model_wrench->second.wrench.head<3>();
+        wrench.second.wrench.tail<3>() = cog_rot_inv * model_wrench->second.wrench.tail<3>();
+        model_wrench++;
+      }
+
+    dragon_robot_model_->calcExternalWrenchCompThrust(external_wrench_map_);
+  }
   const Eigen::VectorXd& wrench_comp_thrust = dragon_robot_model_->getExWrenchCompensateVectoringThrust();
   if(control_verbose_)
     {
@@ -265,8 +270,6 @@ void DragonLQIGimbalController::gimbalControl()
         f_i.setValue(f_xy(2 * i), f_xy(2 * i + 1), robot_model_->getStaticThrust()[i]);
 
       /* f -> gimbal angle */
-      std::vector<KDL::Rotation> links_frame_from_cog = dragon_robot_model_->getLinksRotationFromCog<KDL::Rotation>();
-
       /* [S_pitch, -S_roll * C_pitch, C_roll * C_roll]^T = R.transpose * f_i / |f_i| */
       tf::Quaternion q;  tf::quaternionKDLToTF(links_frame_from_cog.at(i), q);
       tf::Vector3 r_f_i = tf::Matrix3x3(q).transpose() * f_i;
@@ -304,17 +307,21 @@ void DragonLQIGimbalController::sendCmd()
 /* external wrench */
 bool DragonLQIGimbalController::addExternalWrenchCallback(gazebo_msgs::ApplyBodyWrench::Request& req, gazebo_msgs::ApplyBodyWrench::Response& res)
 {
+  std::lock_guard<std::mutex> lock(external_wrench_mutex_);
   if(dragon_robot_model_->addExternalStaticWrench(req.body_name, req.reference_frame, req.reference_point, req.wrench))
     res.success  = true;
   else
     res.success  = false;
+  external_wrench_changed_ = true;
 
   return true;
 }
 
 bool DragonLQIGimbalController::clearExternalWrenchCallback(gazebo_msgs::BodyRequest::Request& req, gazebo_msgs::BodyRequest::Response& res)
 {
+  std::lock_guard<std::mutex> lock(external_wrench_mutex_);
   dragon_robot_model_->removeExternalStaticWrench(req.body_name);
+  external_wrench_changed_ = true;
   return true;
 }
 
@@ -348,6 +355,36 @@ void DragonLQIGimbalController::rosParamInit()
   getParam<double>(roll_pitch_nh, "gimbal_control_p_det_thresh", gimbal_roll_pitch_control_p_det_thresh_, 1e-3);
 }
 
+void DragonLQIGimbalController::addTelemetryChannels(telemetry::Recorder& recorder)
+{
+  HydrusLQIController::addTelemetryChannels(recorder);
+
+  std::vector<std::string> fields;
+  for(int i = 0; i < motor_num_; i++)
+    {
+      const std::string rotor = "rotor" + std::to_string(i + 1);
+      for(const auto field: {"f_x", "f_y", "gimbal_roll", "gimbal_pitch"})
+        fields.push_back(rotor + "/" + field);
+    }
+  gimbal_telemetry_channel_ = recorder.addChannel("controller/gimbal", fields);
+}
+
+void DragonLQIGimbalController::recordTelemetry(telemetry::Recorder& recorder, double stamp)
+{
+  HydrusLQIController::recordTelemetry(recorder, stamp);
+
+  std::array<double, telemetry::MAX_FIELDS> values; // no allocation in the control loop
+  size_t n = 0;
+  for(int i = 0; i < motor_num_ && n + 4 <= values.size(); i++)
+    {
+      values[n++] = f_xy_(2 * i);
+      values[n++] = f_xy_(2 * i + 1);
+      values[n++] = target_gimbal_angles_.at(2 * i);
+      values[n++] = target_gimbal_angles_.at(2 * i + 1);
+    }
+  recorder.record(gimbal_telemetry_channel_, stamp, values.data(), n);
+}
+
 /* plugin registration */
 #include <pluginlib/class_list_macros.h>
 PLUGINLIB_EXPORT_CLASS(aerial_robot_control::DragonLQIGimbalController, aerial_robot_control::ControlBase);
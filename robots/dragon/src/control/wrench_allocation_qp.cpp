@@ -0,0 +1,192 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <dragon/control/wrench_allocation_qp.h>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+using namespace aerial_robot_control;
+
+namespace
+{
+  template <int D> using Vector = Eigen::Matrix<double, D, 1>;
+
+  /* projection onto the circular cone {f | c.f >= |f| cos(alpha)}, c: unit axis, alpha <= pi/2 */
+  template <int D> Vector<D> projectCone(const Vector<D>& f, const Vector<D>& c, double alpha)
+  {
+    const double s = c.dot(f);
+    const double norm = f.norm();
+    if(s >= norm * std::cos(alpha)) return f; // inside
+    if(-s >= norm * std::sin(alpha)) return Vector<D>::Zero(); // inside the polar cone
+
+    const Vector<D> f_perp = f - s * c;
+    const double t = f_perp.norm();
+    return (s * std::cos(alpha) + t * std::sin(alpha)) * (std::cos(alpha) * c + std::sin(alpha) / t * f_perp);
+  }
+
+  template <int D> Vector<D> neutralAxis()
+  {
+    Vector<D> c = Vector<D>::Zero();
+    c(D - 1) = 1; // z axis of the link frame, or of the gimbal roll frame for the 2D case
+    return c;
+  }
+}
+
+template <int D> bool WrenchAllocationQP::projectRotor(Eigen::Ref<Eigen::VectorXd> f, const Eigen::Ref<const Eigen::VectorXd>& prev_f, double max_delta_angle) const
+{
+  const Vector<D> f_orig = f;
+  const Vector<D> neutral_axis = neutralAxis<D>();
+  const double gimbal_max_angle = std::min(params_.gimbal_max_angle, M_PI / 2);
+
+  /* the rate limit is only effective with a valid previous direction */
+  const Vector<D> prev = prev_f;
+  const bool rate_limit = max_delta_angle >= 0 && prev.norm() > 1e-6;
+  const Vector<D> prev_axis = rate_limit ? Vector<D>(prev.normalized()) : neutral_axis;
+
+  /* Dykstra's alternating projection: ball, angle cone, rate cone and halfspace of the lower thrust bound */
+  constexpr int set_num = 4;
+  Vector<D> y = f_orig;
+  Vector<D> p[set_num];
+  for(auto& p_k: p) p_k.setZero();
+  for(int pass = 0; pass < params_.projection_iteration; pass++)
+    {
+      const Vector<D> y_start = y;
+      for(int k = 0; k < set_num; k++)
+        {
+          const Vector<D> tmp = y + p[k];
+          switch(k)
+            {
+            case 0:
+              y = tmp.norm() > params_.thrust_max ? Vector<D>(tmp * params_.thrust_max / tmp.norm()) : tmp;
+              break;
+            case 1:
+              y = projectCone<D>(tmp, neutral_axis, gimbal_max_angle);
+              break;
+            case 2:
+              y = rate_limit ? projectCone<D>(tmp, prev_axis, std::min(max_delta_angle, M_PI / 2)) : tmp;
+              break;
+            case 3:
+              y = prev_axis.dot(tmp) < params_.thrust_min ? Vector<D>(tmp + (params_.thrust_min - prev_axis.dot(tmp)) * prev_axis) : tmp;
+              break;
+            }
+          p[k] = tmp - y;
+        }
+      if((y - y_start).norm() < 1e-9) break;
+    }
+
+  f = y;
+  return (y - f_orig).norm() > params_.tolerance;
+}
+
+bool WrenchAllocationQP::solve(const Eigen::MatrixXd& q_mat, const Eigen::VectorXd& target_wrench, const std::vector<int>& rotor_dims, double dt, Eigen::VectorXd& f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const int n = q_mat.cols();
+  assert(std::accumulate(rotor_dims.begin(), rotor_dims.end(), 0) == n);
+  stats_ = WrenchAllocationQPStats();
+
+  /* H = (WQ)^T WQ + effort_weight I, q = (WQ)^T W b; H + rho I is factorized only when rho changes */
+  const Eigen::MatrixXd wq = params_.wrench_weight.asDiagonal() * q_mat;
+  h_mat_.noalias() = wq.transpose() * wq;
+  h_mat_.diagonal().array() += params_.effort_weight;
+  double rho = params_.rho;
+  llt_.compute(h_mat_ + rho * Eigen::MatrixXd::Identity(n, n));
+  q_vec_.noalias() = wq.transpose() * params_.wrench_weight.cwiseProduct(target_wrench);
+
+  /* warm start from the last solution */
+  stats_.warm_started = (rotor_dims == rotor_dims_);
+  if(stats_.warm_started)
+    {
+      prev_f_ = z_;
+    }
+  else
+    {
+      z_ = Eigen::VectorXd::Zero(n);
+      u_ = Eigen::VectorXd::Zero(n);
+      prev_f_ = Eigen::VectorXd::Zero(n); // no rate limit
+    }
+  const double max_delta_angle = dt > 0 ? params_.gimbal_max_rate * dt : -1;
+
+  for(int k = 0; k < params_.max_iteration; k++)
+    {
+      x_ = llt_.solve(q_vec_ + rho * (z_ - u_));
+      x_ = params_.relaxation * x_ + (1 - params_.relaxation) * z_; // over-relaxation
+      z_prev_ = z_;
+      z_ = x_ + u_;
+
+      stats_.saturated_rotors = 0;
+      int col = 0;
+      for(const auto dim: rotor_dims)
+        {
+          bool active = (dim == 3) ?
+            projectRotor<3>(z_.segment(col, 3), prev_f_.segment(col, 3), max_delta_angle) :
+            projectRotor<2>(z_.segment(col, 2), prev_f_.segment(col, 2), max_delta_angle);
+          if(active) stats_.saturated_rotors++;
+          col += dim;
+        }
+
+      u_ += x_ - z_;
+
+      stats_.iterations = k + 1;
+      stats_.primal_residual = (x_ - z_).norm();
+      stats_.dual_residual = rho * (z_ - z_prev_).norm();
+      const double primal_tolerance = std::sqrt(n) * params_.tolerance + params_.relative_tolerance * std::max(x_.norm(), z_.norm());
+      const double dual_tolerance = std::sqrt(n) * params_.tolerance + params_.relative_tolerance * rho * u_.norm();
+      if(stats_.primal_residual < primal_tolerance && stats_.dual_residual < dual_tolerance)
+        {
+          stats_.converged = true;
+          break;
+        }
+
+      /* residual balancing, the scaled dual variable follows rho */
+      double rho_scale = 1;
+      if(stats_.primal_residual > 10 * stats_.dual_residual && rho < 1e2 * params_.rho) rho_scale = 2;
+      if(stats_.dual_residual > 10 * stats_.primal_residual && rho > 1e-2 * params_.rho) rho_scale = 0.5;
+      if(rho_scale != 1)
+        {
+          rho *= rho_scale;
+          u_ /= rho_scale;
+          llt_.compute(h_mat_ + rho * Eigen::MatrixXd::Identity(n, n));
+        }
+    }
+
+  rotor_dims_ = rotor_dims;
+  f = z_; // always feasible
+  stats_.wrench_error = (q_mat * f - target_wrench).norm();
+  stats_.solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  return stats_.converged;
+}
@@ -7,7 +7,6 @@ DragonNavigator::DragonNavigator():
   BaseNavigator(),
   servo_torque_(false),
   level_flag_(false),
-  landing_flag_(false),
   curr_target_baselink_rot_(0, 0, 0),
   final_target_baselink_rot_(0, 0, 0)
 {
@@ -21,6 +20,9 @@ void DragonNavigator::initialize(ros::NodeHandle nh, ros::NodeHandle nhp,
   /* initialize the flight control */
   BaseNavigator::initialize(nh, nhp, robot_model, estimator, loop_du);
 
+  /* hover to level the orientation before landing */
+  state_machine_.setLandingPreparation(true);
+
   curr_target_baselink_rot_pub_ = nh_.advertise<spinal::DesireCoord>("desire_coordinate", 1);
   joint_control_pub_ = nh_.advertise<sensor_msgs::JointState>("joints_ctrl", 1);
   final_target_baselink_rot_sub_ = nh_.subscribe("final_target_baselink_rot", 1, &DragonNavigator::setFinalTargetBaselinkRotCallback, this);
@@ -66,7 +68,7 @@ void DragonNavigator::baselinkRotationProcess()
 
 void DragonNavigator::landingProcess()
 {
-  if(getForceLandingFlag() || getNaviState() == LAND_STATE)
+  if(getForceLandingFlag() || getNaviState() == LAND_STATE || state_machine_.preparingLanding())
     {
       if(!level_flag_)
         {
@@ -101,20 +103,10 @@ void DragonNavigator::landingProcess()
         }
 
       level_flag_ = true;
-
-      if(getNaviState() == LAND_STATE && !landing_flag_)
-        {
-          landing_flag_ = true;
-          setTeleopFlag(false);
-          setTargetPosZ(estimator_->getState(State::Z_COG, estimate_mode_)[0]);
-          setTargetVelZ(0);
-          land_height_ = 0; // reset the land height, since it is updated in the first land_state which is forced to change to hover state to level the orientation. Thus, it is possible to have the same land height just after switching back to land state and thus stop in midair
-          setNaviState(HOVER_STATE);
-        }
     }
 
   /* back to landing process */
-  if(landing_flag_)
+  if(state_machine_.preparingLanding())
     {
       const auto joint_state = robot_model_->kdlJointToMsg(robot_model_->getJointPositions());
       bool already_level = true;
@@ -130,11 +122,7 @@ void DragonNavigator::landingProcess()
       if(curr_target_baselink_rot_.length()) already_level = false;
 
       if(already_level && getNaviState() == HOVER_STATE)
-        {
-          ROS_WARN("gimbal control: back to land state");
-          setNaviState(LAND_STATE);
-          setTeleopFlag(true);
-        }
+        handleEvent(NavigationEvent::LANDING_PREPARED);
     }
 }
 
@@ -188,7 +176,6 @@ void DragonNavigator::reset()
   BaseNavigator::reset();
 
   level_flag_ = false;
-  landing_flag_ = false;
 }
 
 
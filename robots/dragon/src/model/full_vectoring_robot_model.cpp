@@ -45,8 +45,7 @@ namespace
     int rotor_num = model->getRotorNum();
     std::vector<Eigen::Matrix3d> link_rot = model->getLinksRotationFromCog<Eigen::Matrix3d>();
     std::vector<Eigen::Vector3d> gimbal_roll_pos = model->getGimbalRollOriginFromCog<Eigen::Vector3d>();
-    auto model_for_plan = model->getRobotModelForPlan();
-    std::vector<Eigen::Vector3d> rotor_pos = model_for_plan->getRotorsOriginFromCog<Eigen::Vector3d>();
+    std::vector<Eigen::Vector3d> rotor_pos = model->getRotorsOriginFromCogForPlan();
 
     std::vector<int> roll_locked_gimbal = model->getRollLockedGimbalForPlan();
     for(int i = 0; i < rotor_num; i++)
@@ -63,6 +62,12 @@ there is a diffiretial chain about the roll angle. But we here approximate it to
 
     return model->getMinForceNormalizedWeight() * f_min_list.minCoeff() +  model->getMinTorqueNormalizedWeight() * t_min_list.minCoeff();
   }
+
+  double smoothMinimumControlWrench(const std::vector<double> &x, std::vector<double> &grad, void *ptr)
+  {
+    FullVectoringRobotModel *model = reinterpret_cast<FullVectoringRobotModel*>(ptr);
+    return model->calcSmoothMinControlWrench(x, grad);
+  }
 }
 
 FullVectoringRobotModel::FullVectoringRobotModel(bool init_with_rosparam, bool verbose, double edf_radius, double edf_max_tilt) :
@@ -82,8 +87,6 @@ FullVectoringRobotModel::FullVectoringRobotModel(bool init_with_rosparam, bool v
   gimbal_roll_origin_from_cog_.resize(rotor_num);
   setGimbalNominalAngles(std::vector<double>(0)); // for online initialize
 
-  robot_model_for_plan_ = boost::make_shared<aerial_robot_model::transformable::RobotModel>();
-
   if(debug_verbose_)
     {
       if(ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Debug) )
@@ -106,52 +109,138 @@ void FullVectoringRobotModel::getParamFromRos()
   nh.param("gimbal_roll_change_threshold", gimbal_roll_change_threshold_, 0.02); // rad/s
   nh.param("min_force_weight", min_force_weight_, 1.0);
   nh.param("min_torque_weight", min_torque_weight_, 1.0);
+  nh.param("gimbal_roll_lock_gradient_solver", gimbal_roll_lock_gradient_solver_, true); // false: derivative-free COBYLA with the hard minimum
+  nh.param("gimbal_roll_lock_smooth_epsilon", gimbal_roll_lock_smooth_epsilon_, 50.0);
+  nh.param("gimbal_roll_lock_max_eval", gimbal_roll_lock_max_eval_, 100);
+}
+
+void FullVectoringRobotModel::initKinematics()
+{
+  /* flatten the tree in the depth-first order, so the parent is always processed before the children */
+  std::map<std::string, int> slots;
+  std::function<void (const KDL::TreeElement&, int)> addChildren = [this, &slots, &addChildren](const KDL::TreeElement& tree_element, int parent)
+    {
+      for (const auto& elem: GetTreeElementChildren(tree_element))
+        {
+          const KDL::TreeElement& curr_element = elem->second;
+          fk_segments_.push_back(FkSegment{&GetTreeElementSegment(curr_element), parent, GetTreeElementQNr(curr_element)});
+          int slot = fk_segments_.size() - 1;
+          slots[GetTreeElementSegment(curr_element).getName()] = slot;
+          addChildren(curr_element, slot);
+        }
+    };
+  addChildren(getTree().getRootSegment()->second, -1);
+  fk_frames_.resize(fk_segments_.size());
+
+  const int rotor_num = getRotorNum();
+  const auto& joint_index_map = getJointIndexMap();
+  baselink_slot_ = slots.at(getBaselinkName());
+  link_slots_.resize(0);
+  thrust_slots_.resize(0);
+  gimbal_roll_module_slots_.resize(0);
+  edf_slots_.resize(0);
+  gimbal_roll_joint_indices_.resize(0);
+  gimbal_pitch_joint_indices_.resize(0);
+  for(int i = 0; i < rotor_num; ++i)
+    {
+      std::string s = std::to_string(i + 1);
+      link_slots_.push_back(slots.at(std::string("link") + s));
+      thrust_slots_.push_back(slots.at(getThrustLinkName() + s));
+      gimbal_roll_module_slots_.push_back(slots.at(std::string("gimbal") + s + std::string("_roll_module")));
+      edf_slots_.push_back(slots.at(std::string("edf") + s + std::string("_left")));
+      edf_slots_.push_back(slots.at(std::string("edf") + s + std::string("_right")));
+      gimbal_roll_joint_indices_.push_back(joint_index_map.at(std::string("gimbal") + s + std::string("_roll")));
+      gimbal_pitch_joint_indices_.push_back(joint_index_map.at(std::string("gimbal") + s + std::string("_pitch")));
+    }
+
+  inertia_slots_.resize(0);
+  for(const auto& inertia : getInertiaMap())
+    inertia_slots_.push_back(std::make_pair(slots.at(inertia.first), inertia.second));
+
+  rotors_origin_from_cog_for_plan_.resize(rotor_num);
+  prev_rotors_origin_from_cog_for_plan_.resize(rotor_num);
+  gimbal_nominal_angles_level_.resize(rotor_num * 2);
+  links_rotation_from_cog_curr_.resize(rotor_num);
+  roll_locked_gimbal_curr_.resize(rotor_num);
+  edfs_origin_from_cog_curr_.resize(rotor_num * 2);
+  static_thrust_curr_.resize(rotor_num);
+}
+
+void FullVectoringRobotModel::calcSegmentFrames(const KDL::JntArray& joint_positions)
+{
+  if (joint_positions.rows() != getTree().getNrOfJoints())
+    throw std::runtime_error("joint num is invalid");
+
+  for(int i = 0; i < fk_segments_.size(); i++)
+    {
+      const FkSegment& seg = fk_segments_[i];
+      if(seg.parent < 0) fk_frames_[i] = seg.segment->pose(joint_positions(seg.q_nr));
+      else fk_frames_[i] = fk_frames_[seg.parent] * seg.segment->pose(joint_positions(seg.q_nr));
+    }
+}
+
+void FullVectoringRobotModel::updateKinematicsForPlan(const KDL::JntArray& joint_positions, const KDL::Rotation& cog_desire_orientation)
+{
+  /* same as aerial_robot_model::RobotModel::updateRobotModelImpl, but only the CoG, mass and rotor origins */
+  calcSegmentFrames(joint_positions);
+
+  KDL::RigidBodyInertia link_inertia = KDL::RigidBodyInertia::Zero();
+  for(const auto& inertia : inertia_slots_)
+    link_inertia = link_inertia + fk_frames_[inertia.first] * inertia.second;
+
+  cog_for_plan_.M = fk_frames_[baselink_slot_].M * cog_desire_orientation.Inverse();
+  cog_for_plan_.p = link_inertia.getCOG();
+  mass_for_plan_ = link_inertia.getMass();
+
+  const KDL::Frame cog_inv = cog_for_plan_.Inverse();
+  for(int i = 0; i < getRotorNum(); ++i)
+    {
+      const KDL::Vector p = (cog_inv * fk_frames_[thrust_slots_[i]]).p;
+      rotors_origin_from_cog_for_plan_[i] = Eigen::Vector3d(p.x(), p.y(), p.z());
+    }
+}
+
+void FullVectoringRobotModel::setGimbalProcessedAngles(const std::vector<double>& gimbal_angles)
+{
+  for(int i = 0; i < getRotorNum(); ++i)
+    {
+      gimbal_processed_joint_curr_(gimbal_roll_joint_indices_[i]) = gimbal_angles.at(i * 2);
+      gimbal_processed_joint_curr_(gimbal_pitch_joint_indices_[i]) = gimbal_angles.at(i * 2 + 1);
+    }
 }
 
 void FullVectoringRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_positions)
 {
-  KDL::Rotation cog_desire_orientation = getCogDesireOrientation<KDL::Rotation>();
-  robot_model_for_plan_->setCogDesireOrientation(cog_desire_orientation); // update the cog orientation
+  if(fk_segments_.size() == 0) initKinematics();
+
+  const KDL::Rotation cog_desire_orientation = getCogDesireOrientation<KDL::Rotation>();
 
   /* 1. first assume the gimbals are level */
-  KDL::TreeFkSolverPos_recursive fk_solver(getTree());
-  KDL::Frame f_baselink;
-  fk_solver.JntToCart(joint_positions, f_baselink, getBaselinkName());
-  const KDL::Rotation cog_rot = f_baselink.M * cog_desire_orientation.Inverse();
+  calcSegmentFrames(joint_positions); // all links in one pass
+  const KDL::Rotation cog_rot = fk_frames_[baselink_slot_].M * cog_desire_orientation.Inverse();
 
-  const auto joint_index_map = getJointIndexMap();
-  KDL::JntArray gimbal_processed_joint = joint_positions;
-  std::vector<double> gimbal_nominal_angles(0);
-  std::vector<KDL::Rotation> links_rotation_from_cog(0);
-  std::vector<int> roll_locked_gimbal(getRotorNum(), 0);
+  gimbal_processed_joint_curr_ = joint_positions;
+  std::vector<double>& gimbal_nominal_angles = gimbal_nominal_angles_level_;
+  std::vector<KDL::Rotation>& links_rotation_from_cog = links_rotation_from_cog_curr_;
+  std::vector<int>& roll_locked_gimbal = roll_locked_gimbal_curr_;
+  std::fill(roll_locked_gimbal.begin(), roll_locked_gimbal.end(), 0);
 
   for(int i = 0; i < getRotorNum(); ++i)
     {
-      std::string s = std::to_string(i + 1);
-      KDL::Frame f;
-      fk_solver.JntToCart(joint_positions, f, std::string("link") + s);
-
-      links_rotation_from_cog.push_back(cog_rot.Inverse() * f.M);
+      links_rotation_from_cog[i] = cog_rot.Inverse() * fk_frames_[link_slots_[i]].M;
       double r, p, y;
-      links_rotation_from_cog.back().GetRPY(r, p, y);
+      links_rotation_from_cog[i].GetRPY(r, p, y);
 
-      gimbal_nominal_angles.push_back(-r);
-      gimbal_nominal_angles.push_back(-p);
+      gimbal_nominal_angles[i * 2] = -r;
+      gimbal_nominal_angles[i * 2 + 1] = -p;
     }
   setLinksRotationFromCog(links_rotation_from_cog);
 
   // online initialization
-  if(getGimbalNominalAngles().size() == 0)
+  if(gimbal_nominal_angles_curr_.size() == 0)
     {
-      for(int i = 0; i < getRotorNum(); ++i)
-        {
-          std::string s = std::to_string(i + 1);
-          gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_roll"))->second) = gimbal_nominal_angles.at(i * 2);
-          gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_pitch"))->second) = gimbal_nominal_angles.at(i * 2 + 1);
-        }
-      robot_model_for_plan_->updateRobotModel(gimbal_processed_joint);
-
-      setGimbalNominalAngles(gimbal_nominal_angles);
+      gimbal_nominal_angles_curr_ = gimbal_nominal_angles;
+      setGimbalNominalAngles(gimbal_nominal_angles_curr_);
     }
 
   /* 2. check the orientation (pitch angle) of link to decide whether to lock gimbal roll */
@@ -225,21 +314,10 @@ void FullVectoringRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_po
       if(roll_lock_status_change)
         {
           /* roughly update the CoG and gimbal roll origin based on the level (horizontal) nominal gimbal angles and joints for search the optimiazed locked gimbal roll angles*/
+          setGimbalProcessedAngles(gimbal_nominal_angles);
+          updateKinematicsForPlan(gimbal_processed_joint_curr_, cog_desire_orientation);
           for(int i = 0; i < getRotorNum(); ++i)
-            {
-              std::string s = std::to_string(i + 1);
-              gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_roll"))->second) = gimbal_nominal_angles.at(i * 2);
-              gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_pitch"))->second) = gimbal_nominal_angles.at(i * 2 + 1);
-            }
-          robot_model_for_plan_->updateRobotModel(gimbal_processed_joint);
-          std::map<std::string, KDL::Frame> seg_tf_map = robot_model_for_plan_->getSegmentsTf();
-          for(int i = 0; i < getRotorNum(); ++i)
-            {
-              std::string s = std::to_string(i + 1);
-              std::string gimbal_roll = std::string("gimbal") + s + std::string("_roll_module");
-              KDL::Frame f  = seg_tf_map.at(gimbal_roll);
-              gimbal_roll_origin_from_cog_.at(i) = (robot_model_for_plan_->getCog<KDL::Frame>().Inverse() * f).p;
-            }
+            gimbal_roll_origin_from_cog_.at(i) = (cog_for_plan_.Inverse() * fk_frames_[gimbal_roll_module_slots_[i]]).p;
 
           setRollLockedGimbalForPlan(roll_locked_gimbal);
           locked_angles_ = calcBestLockGimbalRoll(roll_locked_gimbal, prev_roll_locked_gimbal_, locked_angles_);
@@ -256,7 +334,7 @@ void FullVectoringRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_po
 
   /* 4: smooth the nominal gimbal angles, to avoid sudden change */
   int gimbal_lock_index = 0;
-  std::vector<double>  gimbal_nominal_angles_curr = getGimbalNominalAngles();
+  std::vector<double>& gimbal_nominal_angles_curr = gimbal_nominal_angles_curr_;
   for(int i = 0; i < getRotorNum(); ++i)
     {
       /* only smooth roll angles */
@@ -307,24 +385,20 @@ void FullVectoringRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_po
 
   /* 5: (new) refine the rotor origin from cog */
   /* 5.1. init update the CoG and gimbal roll origin based on the level (horizontal) nominal gimbal angles and joints */
-  for(int i = 0; i < getRotorNum(); ++i)
-    {
-      std::string s = std::to_string(i + 1);
-      gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_roll"))->second) = gimbal_nominal_angles_curr.at(i * 2);
-      gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_pitch"))->second) = gimbal_nominal_angles_curr.at(i * 2 + 1);
-    }
-  robot_model_for_plan_->updateRobotModel(gimbal_processed_joint);
+  setGimbalProcessedAngles(gimbal_nominal_angles_curr);
+  updateKinematicsForPlan(gimbal_processed_joint_curr_, cog_desire_orientation);
 
   /* 5.2. convergence  */
   double t = ros::Time::now().toSec();
   for(int j = 0; j < robot_model_refine_max_iteration_; j++)
     {
       /* 5.2.1. update the wrench allocation matrix  */
-      std::vector<Eigen::Vector3d> rotors_origin_from_cog = robot_model_for_plan_->getRotorsOriginFromCog<Eigen::Vector3d>();
-      Eigen::MatrixXd full_q_mat = Eigen::MatrixXd::Zero(6, 3 * getRotorNum() - gimbal_lock_num);
-      Eigen::MatrixXd wrench_map = Eigen::MatrixXd::Zero(6, 3);
-      wrench_map.block(0, 0, 3, 3) = Eigen::MatrixXd::Identity(3, 3);
-      Eigen::MatrixXd mask(3,2);
+      const std::vector<Eigen::Vector3d>& rotors_origin_from_cog = rotors_origin_from_cog_for_plan_;
+      Eigen::MatrixXd& full_q_mat = full_q_mat_;
+      full_q_mat.setZero(6, 3 * getRotorNum() - gimbal_lock_num);
+      Eigen::Matrix<double, 6, 3> wrench_map = Eigen::Matrix<double, 6, 3>::Zero();
+      wrench_map.block(0, 0, 3, 3) = Eigen::Matrix3d::Identity();
+      Eigen::Matrix<double, 3, 2> mask;
       mask << 1, 0, 0, 0, 0, 1;
       int last_col = 0;
       for(int i = 0; i < getRotorNum(); i++)
@@ -346,8 +420,9 @@ void FullVectoringRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_po
         }
 
       /* 5.2.2. update the vectoring force for hovering and the gimbal angles */
-      Eigen::VectorXd hover_vectoring_f = aerial_robot_model::pseudoinverse(full_q_mat) * getGravity() * robot_model_for_plan_->getMass();
-      Eigen::VectorXd static_thrust = Eigen::VectorXd::Zero(getRotorNum());
+      Eigen::VectorXd hover_vectoring_f = aerial_robot_model::pseudoinverse(full_q_mat) * getGravity() * mass_for_plan_;
+      Eigen::VectorXd& static_thrust = static_thrust_curr_;
+      static_thrust.setZero();
       if(debug_verbose_) ROS_DEBUG_STREAM("vectoring force for hovering in iteration "<< j+1 << ": " << hover_vectoring_f.transpose());
       last_col = 0;
       for(int i = 0; i < getRotorNum(); i++)
@@ -373,15 +448,10 @@ void FullVectoringRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_po
         }
 
       /* 5.2.3. check the change of the rotor origin whether converge*/
-      std::vector<Eigen::Vector3d> prev_rotors_origin_from_cog = rotors_origin_from_cog;
-      for(int i = 0; i < getRotorNum(); ++i)
-        {
-          std::string s = std::to_string(i + 1);
-          gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_roll"))->second) = gimbal_nominal_angles_curr.at(i * 2);
-          gimbal_processed_joint(joint_index_map.find(std::string("gimbal") + s + std::string("_pitch"))->second) = gimbal_nominal_angles_curr.at(i * 2 + 1);
-        }
-      robot_model_for_plan_->updateRobotModel(gimbal_processed_joint);
-      rotors_origin_from_cog = robot_model_for_plan_->getRotorsOriginFromCog<Eigen::Vector3d>();
+      std::vector<Eigen::Vector3d>& prev_rotors_origin_from_cog = prev_rotors_origin_from_cog_for_plan_;
+      prev_rotors_origin_from_cog = rotors_origin_from_cog;
+      setGimbalProcessedAngles(gimbal_nominal_angles_curr);
+      updateKinematicsForPlan(gimbal_processed_joint_curr_, cog_desire_orientation);
 
       double max_diff = 1e-6;
       for(int i = 0; i < getRotorNum(); i++)
@@ -411,29 +481,21 @@ void FullVectoringRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_po
     }
 
   /* 7. update */
-  aerial_robot_model::RobotModel::updateRobotModelImpl(gimbal_processed_joint);
+  aerial_robot_model::RobotModel::updateRobotModelImpl(gimbal_processed_joint_curr_);
 
-  std::vector<KDL::Vector> f_edfs;
-  auto seg_tf_map = getSegmentsTf();
+  /* the segment frames of the last plan update are with the same joints */
+  const KDL::Frame cog_inv = getCog<KDL::Frame>().Inverse();
+  std::vector<KDL::Vector>& f_edfs = edfs_origin_from_cog_curr_;
   for(int i = 0; i < getRotorNum(); ++i)
     {
-      std::string s = std::to_string(i + 1);
-      std::string edf = std::string("edf") + s + std::string("_left");
-      KDL::Frame f  = seg_tf_map.at(edf);
-      f_edfs.push_back((getCog<KDL::Frame>().Inverse() * f).p);
-
-      edf = std::string("edf") + s + std::string("_right");
-      f  = seg_tf_map.at(edf);
-      f_edfs.push_back((getCog<KDL::Frame>().Inverse() * f).p);
-
-      std::string gimbal_roll = std::string("gimbal") + s + std::string("_roll_module");
-      f  = seg_tf_map.at(gimbal_roll);
-      gimbal_roll_origin_from_cog_.at(i) = ((getCog<KDL::Frame>().Inverse() * f).p);
+      f_edfs[i * 2] = (cog_inv * fk_frames_[edf_slots_[i * 2]]).p;
+      f_edfs[i * 2 + 1] = (cog_inv * fk_frames_[edf_slots_[i * 2 + 1]]).p;
+      gimbal_roll_origin_from_cog_.at(i) = (cog_inv * fk_frames_[gimbal_roll_module_slots_[i]]).p;
     }
   setEdfsOriginFromCog(f_edfs);
 
   setGimbalNominalAngles(gimbal_nominal_angles_curr);
-  setGimbalProcessedJoint(gimbal_processed_joint);
+  setGimbalProcessedJoint(gimbal_processed_joint_curr_);
   setRollLockedGimbal(roll_locked_gimbal);
 
   return;
@@ -550,10 +612,17 @@ Eigen::VectorXd FullVectoringRobotModel::calcFeasibleControlTDists(const std::ve
 }
 
 
+double FullVectoringRobotModel::calcSmoothMinControlWrench(const std::vector<double>& locked_angles, std::vector<double>& grad)
+{
+  return Dragon::smoothMinControlWrench(lock_plan_rotor_pos_, lock_plan_link_rot_, getRollLockedGimbalForPlan(), locked_angles,
+                                        getMinForceNormalizedWeight(), getMinTorqueNormalizedWeight(), gimbal_roll_lock_smooth_epsilon_, grad);
+}
+
 std::vector<double> FullVectoringRobotModel::calcBestLockGimbalRoll(const std::vector<int>& roll_locked_gimbal, const std::vector<int>& prev_roll_locked_gimbal, const std::vector<double>& prev_opt_locked_angles)
 {
   int rotor_num = getRotorNum();
-  std::vector<Eigen::Vector3d> rotor_pos = robot_model_for_plan_->getRotorsOriginFromCog<Eigen::Vector3d>();
+  std::vector<Eigen::Vector3d>& rotor_pos = lock_plan_rotor_pos_;
+  rotor_pos = rotors_origin_from_cog_for_plan_;
   std::vector<Eigen::Vector3d> gimbal_roll_pos = getGimbalRollOriginFromCog<Eigen::Vector3d>();
   for(int i = 0; i < rotor_num; i++)
     {
@@ -563,49 +632,61 @@ there is a diffiretial chain about the roll angle. But we here approximate it to
        */
       if(roll_locked_gimbal.at(i) == 1) rotor_pos.at(i) = gimbal_roll_pos.at(i);
     }
-  const std::vector<Eigen::Matrix3d> link_rot = getLinksRotationFromCog<Eigen::Matrix3d>();
+  lock_plan_link_rot_ = getLinksRotationFromCog<Eigen::Matrix3d>();
+  const std::vector<Eigen::Matrix3d>& link_rot = lock_plan_link_rot_;
 
 #if 1
-  /* TODO: use nonlinear differentiable optimization methods, such as SQP */
-
   /* nonlinear optimization for vectoring angles planner */
   double start_t = ros::Time::now().toSec();
   int num = std::accumulate(roll_locked_gimbal.begin(), roll_locked_gimbal.end(), 0);
-  nlopt::opt nl_solver(nlopt::LN_COBYLA, num);
-  nl_solver.set_max_objective(minimumControlWrench, this);
+  nlopt::opt nl_solver(gimbal_roll_lock_gradient_solver_ ? nlopt::LD_SLSQP : nlopt::LN_COBYLA, num);
+  if(gimbal_roll_lock_gradient_solver_)
+    {
+      nl_solver.set_max_objective(smoothMinimumControlWrench, this);
+      nl_solver.set_maxeval(gimbal_roll_lock_max_eval_);
+    }
+  else
+    {
+      nl_solver.set_max_objective(minimumControlWrench, this);
+      nl_solver.set_maxeval(1000); // 1000 times
+    }
   nl_solver.set_xtol_rel(1e-4); //1e-4
-  nl_solver.set_maxeval(1000); // 1000 times
-  ROS_DEBUG_NAMED("robot_model", "nlopt init time: %f", ros::Time::now().toSec() - start_t); // TODO: change to DEBUG
+  ROS_DEBUG_NAMED("robot_model", "nlopt init time: %f", ros::Time::now().toSec() - start_t);
 
   std::vector<double> lb(num, - M_PI / 2 - 0.1);
   std::vector<double> ub(num, M_PI / 2 + 0.1);
   std::vector<double> opt_locked_angles(num);
 
-  int lock_cnt = 0;
   assert(prev_opt_locked_angles.size() == std::accumulate(prev_roll_locked_gimbal.begin(), prev_roll_locked_gimbal.end(), 0));
 
+  /* warm start: the last optimization result for the gimbals which are kept locked, and the current roll angle for the newly locked gimbals */
+  bool same_lock = (roll_locked_gimbal == prev_roll_locked_gimbal);
+  int lock_cnt = 0, prev_lock_cnt = 0;
   for(int i = 0; i < roll_locked_gimbal.size(); i++)
     {
-      if(roll_locked_gimbal.at(i) == prev_roll_locked_gimbal.at(i))
+      if(roll_locked_gimbal.at(i) == 1)
         {
-          if(roll_locked_gimbal.at(i) == 1)
+          if(prev_roll_locked_gimbal.at(i) == 1)
             {
+              opt_locked_angles.at(lock_cnt) = prev_opt_locked_angles.at(prev_lock_cnt);
+
               /* update the range by using the last optimization result with the assumption that the motion is cotinuous */
-              lb.at(lock_cnt) = prev_opt_locked_angles.at(lock_cnt) - gimbal_delta_angle_;
-              ub.at(lock_cnt) = prev_opt_locked_angles.at(lock_cnt) + gimbal_delta_angle_;
-              opt_locked_angles.at(lock_cnt) = prev_opt_locked_angles.at(lock_cnt);
-              lock_cnt++;
+              if(same_lock)
+                {
+                  lb.at(lock_cnt) = prev_opt_locked_angles.at(prev_lock_cnt) - gimbal_delta_angle_;
+                  ub.at(lock_cnt) = prev_opt_locked_angles.at(prev_lock_cnt) + gimbal_delta_angle_;
+                }
             }
+          else
+            {
+              opt_locked_angles.at(lock_cnt) = gimbal_nominal_angles_curr_.at(i * 2);
+            }
+          opt_locked_angles.at(lock_cnt) = std::clamp(opt_locked_angles.at(lock_cnt), lb.at(lock_cnt), ub.at(lock_cnt));
+          lock_cnt++;
         }
-      else
-        {
-          /* reset all range */
-          lb.resize(num, - M_PI / 2 - 0.1);
-          ub.resize(num, M_PI / 2 + 0.1);
-          opt_locked_angles.resize(num, 0);
-          break;
-        }
+      if(prev_roll_locked_gimbal.at(i) == 1) prev_lock_cnt++;
     }
+  const std::vector<double> init_locked_angles = opt_locked_angles;
 
   nl_solver.set_lower_bounds(lb);
   nl_solver.set_upper_bounds(ub);
@@ -617,16 +698,36 @@ there is a diffiretial chain about the roll angle. But we here approximate it to
 
   min_torque_normalized_weight_ = min_torque_weight_ / max_min_torque;
 
-  double max_min_control_wrench;
+  std::vector<double> grad;
+  const double init_control_wrench = minimumControlWrench(init_locked_angles, grad, this);
+
+  double max_min_control_wrench = 0;
+  nlopt::result result = nlopt::FAILURE;
   start_t = ros::Time::now().toSec();
-  nlopt::result result = nl_solver.optimize(opt_locked_angles, max_min_control_wrench);
+  try
+    {
+      result = nl_solver.optimize(opt_locked_angles, max_min_control_wrench);
+    }
+  catch(std::exception &e)
+    {
+      ROS_WARN_STREAM_NAMED("robot_model", "nlopt failed: " << e.what());
+    }
+
+  /* evaluate the result with the hard minimum, and never return a worse solution than the warm start */
+  double opt_control_wrench = minimumControlWrench(opt_locked_angles, grad, this);
+  if(result < 0 || !(opt_control_wrench >= init_control_wrench))
+    {
+      opt_locked_angles = init_locked_angles;
+      opt_control_wrench = init_control_wrench;
+    }
 
-  ROS_DEBUG_STREAM_NAMED("robot_model", "nlopt process time: " << ros::Time::now().toSec() - start_t);  // change to DEBUG
   ROS_DEBUG_STREAM_NAMED("robot_model", "nlopt: opt result: " << max_min_control_wrench);
 
   std::stringstream ss;
   for(auto angle: opt_locked_angles) ss << angle << ", ";
   ROS_INFO_STREAM_NAMED("robot_model", "nlopt: locked angles: " << ss.str());
+  ROS_INFO_STREAM_NAMED("robot_model", "nlopt: result " << result << ", evaluations: " << nl_solver.get_numevals()
+                        << ", solve time: " << ros::Time::now().toSec() - start_t << "sec, min control wrench: " << init_control_wrench << " -> " << opt_control_wrench);
 
   const auto f_min_list = calcFeasibleControlFxyDists(roll_locked_gimbal, opt_locked_angles, rotor_num, link_rot);
   const auto t_min_list = calcFeasibleControlTDists(roll_locked_gimbal, opt_locked_angles, rotor_num, rotor_pos, link_rot);
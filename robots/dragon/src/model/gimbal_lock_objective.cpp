@@ -0,0 +1,162 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <aerial_robot_model/utils/math_utils.h>
+#include <dragon/model/gimbal_lock_objective.h>
+
+namespace Dragon
+{
+  double smoothMinControlWrench(const std::vector<Eigen::Vector3d>& rotor_pos,
+                                const std::vector<Eigen::Matrix3d>& link_rot,
+                                const std::vector<int>& roll_locked_gimbal,
+                                const std::vector<double>& locked_angles,
+                                double f_weight, double t_weight, double epsilon,
+                                std::vector<double>& grad)
+  {
+    /*
+       smooth version of the objective of FullVectoringRobotModel::minimumControlWrench:
+       |x| is approximated by absApprox and min() by softmin, thus the weighted distances are differentiable w.r.t. the locked roll angles.
+       The roll rotation only changes the direction of the gimbal z axis: d(R e_z)/d(roll) = - R e_y, and R e_x is invariant.
+    */
+    const int rotor_num = rotor_pos.size();
+    const int num = locked_angles.size();
+
+    /* control vectors, their differentials w.r.t. the roll angle of the owner gimbal, and the owner index in locked_angles (-1: not locked) */
+    std::vector<Eigen::Vector2d> u, du;
+    std::vector<Eigen::Vector3d> v, dv;
+    std::vector<int> u_owner, v_owner;
+
+    int gimbal_lock_index = 0;
+    for (int i = 0; i < rotor_num; ++i)
+      {
+        const Eigen::Vector3d& p = rotor_pos.at(i);
+        if(roll_locked_gimbal.at(i) == 0)
+          {
+            for(int j = 0; j < 3; j++)
+              {
+                const Eigen::Vector3d e = Eigen::Vector3d::Unit(j);
+                if(j < 2)
+                  {
+                    u.push_back(e.head<2>());
+                    du.push_back(Eigen::Vector2d::Zero());
+                    u_owner.push_back(-1);
+                  }
+                v.push_back(p.cross(e));
+                dv.push_back(Eigen::Vector3d::Zero());
+                v_owner.push_back(-1);
+              }
+          }
+        else
+          {
+            const Eigen::Matrix3d gimbal_roll_rot = link_rot.at(i) * Eigen::AngleAxisd(locked_angles.at(gimbal_lock_index), Eigen::Vector3d::UnitX()).toRotationMatrix();
+            const Eigen::Vector3d z_axis = gimbal_roll_rot.col(2);
+            const Eigen::Vector3d d_z_axis = - gimbal_roll_rot.col(1);
+
+            const double xy_norm = z_axis.head<2>().norm();
+            const Eigen::Vector2d u_i = z_axis.head<2>() / xy_norm;
+            u.push_back(u_i);
+            du.push_back((d_z_axis.head<2>() - u_i * u_i.dot(d_z_axis.head<2>())) / xy_norm);
+            u_owner.push_back(gimbal_lock_index);
+
+            v.push_back(p.cross(gimbal_roll_rot.col(0)));
+            dv.push_back(Eigen::Vector3d::Zero());
+            v_owner.push_back(gimbal_lock_index);
+            v.push_back(p.cross(z_axis));
+            dv.push_back(p.cross(d_z_axis));
+            v_owner.push_back(gimbal_lock_index);
+
+            gimbal_lock_index++;
+          }
+      }
+
+    /* feasible control force (x, y) */
+    Eigen::VectorXd f_min = Eigen::VectorXd::Zero(u.size());
+    Eigen::MatrixXd f_min_jacobian = Eigen::MatrixXd::Zero(u.size(), num);
+    auto cross2 = [](const Eigen::Vector2d& a, const Eigen::Vector2d& b) { return a.x() * b.y() - b.x() * a.y(); };
+    for (int i = 0; i < u.size(); ++i)
+      {
+        for (int j = 0; j < u.size(); ++j)
+          {
+            if (i == j) continue;
+            const double c = f_weight * cross2(u.at(i), u.at(j));
+            f_min(i) += aerial_robot_model::absApprox(c, epsilon);
+            const double d_abs = f_weight * aerial_robot_model::tanh(c, epsilon);
+            if(u_owner.at(i) >= 0) f_min_jacobian(i, u_owner.at(i)) += d_abs * cross2(du.at(i), u.at(j));
+            if(u_owner.at(j) >= 0) f_min_jacobian(i, u_owner.at(j)) += d_abs * cross2(u.at(i), du.at(j));
+          }
+      }
+
+    /* feasible control torque */
+    Eigen::VectorXd t_min = Eigen::VectorXd::Zero(v.size() * (v.size() - 1) / 2);
+    Eigen::MatrixXd t_min_jacobian = Eigen::MatrixXd::Zero(t_min.size(), num);
+    int t_min_index = 0;
+    for (int i = 0; i < v.size(); ++i)
+      {
+        for (int j = i + 1; j < v.size(); ++j)
+          {
+            const Eigen::Vector3d v_ij = v.at(i).cross(v.at(j));
+            if(v_ij.norm() < 1e-5)
+              {
+                t_min(t_min_index) = 1e6; // no plane, same as calcFeasibleControlTDists
+              }
+            else
+              {
+                for (int k = 0; k < v.size(); ++k)
+                  {
+                    if (i == k || j == k) continue;
+                    const double triple_product = t_weight * v_ij.dot(v.at(k));
+                    t_min(t_min_index) += aerial_robot_model::absApprox(triple_product, epsilon);
+                    const double d_abs = t_weight * aerial_robot_model::tanh(triple_product, epsilon);
+                    if(v_owner.at(i) >= 0) t_min_jacobian(t_min_index, v_owner.at(i)) += d_abs * dv.at(i).dot(v.at(j).cross(v.at(k)));
+                    if(v_owner.at(j) >= 0) t_min_jacobian(t_min_index, v_owner.at(j)) += d_abs * v.at(i).dot(dv.at(j).cross(v.at(k)));
+                    if(v_owner.at(k) >= 0) t_min_jacobian(t_min_index, v_owner.at(k)) += d_abs * v_ij.dot(dv.at(k));
+                  }
+              }
+            t_min_index++;
+          }
+      }
+
+    Eigen::VectorXd f_softmin_grad, t_softmin_grad;
+    const double wrench = aerial_robot_model::softmin(f_min, f_softmin_grad, epsilon) + aerial_robot_model::softmin(t_min, t_softmin_grad, epsilon);
+
+    if(grad.size() > 0)
+      {
+        const Eigen::VectorXd wrench_grad = f_min_jacobian.transpose() * f_softmin_grad + t_min_jacobian.transpose() * t_softmin_grad;
+        for(int i = 0; i < num; i++) grad.at(i) = wrench_grad(i);
+      }
+
+    return wrench;
+  }
+};
@@ -38,11 +38,25 @@ HydrusLikeRobotModel::HydrusLikeRobotModel(bool init_with_rosparam, bool verbose
       if(joint_indices.at(i) == link_joint_indices.at(j))
         {
           gimbal_jacobian_(6 + i, 6 + j) = 1;
+          link_joint_cols_.push_back(6 + i);
           j++;
         }
       if(j == link_joint_indices.size()) break;
     }
 
+  // the rows of gimbal joints in gimbal_jacobian_ are dense, and are updated in calcBasicKinematicsJacobian()
+  const auto& joint_names = getJointNames();
+  gimbal_cols_.resize(rotor_num);
+  for(int i = 0; i < rotor_num; i++)
+    {
+      std::string gimbal = std::string("gimbal") + std::to_string(i + 1);
+      for(int k = 0; k < joint_names.size(); k++)
+        {
+          if(joint_names.at(k) == gimbal + std::string("_roll")) gimbal_cols_.at(i).first = 6 + k;
+          if(joint_names.at(k) == gimbal + std::string("_pitch")) gimbal_cols_.at(i).second = 6 + k;
+        }
+    }
+
   // external wrench
   vectoring_q_mat_ = Eigen::MatrixXd::Zero(6, rotor_num * 3); // init
   vectoring_thrust_ = Eigen::VectorXd::Zero(rotor_num * 3); // init
@@ -72,29 +86,11 @@ bool HydrusLikeRobotModel::stabilityCheck(bool verbose)
 
 bool HydrusLikeRobotModel::overlapCheck(bool verbose)
 {
-  const std::vector<Eigen::Vector3d> edfs_origin_from_cog = getEdfsOriginFromCog<Eigen::Vector3d>();
-  const int rotor_num = getRotorNum();
+  const auto overlap = RotorInterference::findRotorPairOverlap(getEdfsOriginFromCog<Eigen::Vector3d>(), edf_radius_, edf_max_tilt_);
+  if(overlap.first < 0) return true;
 
-  for(int i = 0; i < rotor_num * 2; ++i)
-    {
-      for(int j = i + 1; j < rotor_num * 2; ++j)
-        {
-          /* special for dual rotor */
-          if(i / 2 == j / 2) continue;
-
-          Eigen::Vector3d diff = edfs_origin_from_cog.at(i) - edfs_origin_from_cog.at(j); //dual
-          double projected_dist = sqrt(diff(0) * diff(0) + diff(1) * diff(1));
-          double dist_thre = edf_radius_ + fabs(diff(2)) * tan(edf_max_tilt_) + edf_radius_;
-
-          /* debug */
-          if(dist_thre > projected_dist)
-            {
-              ROS_ERROR_STREAM(edf_names_.at(i) << " and " << edf_names_.at(j) << " is overlapped");
-              return false;
-            }
-        }
-    }
-  return true;
+  ROS_ERROR_STREAM(edf_names_.at(overlap.first) << " and " << edf_names_.at(overlap.second) << " is overlapped");
+  return false;
 }
 
 void HydrusLikeRobotModel::updateRobotModelImpl(const KDL::JntArray& joint_positions)
@@ -157,41 +153,25 @@ void HydrusLikeRobotModel::calcBasicKinematicsJacobian()
 {
   aerial_robot_model::transformable::RobotModel::calcBasicKinematicsJacobian();
 
-  const auto& joint_names = getJointNames();
-  const auto& link_joint_names = getLinkJointNames();
-  const auto& link_joint_indices = getLinkJointIndices();
-  const auto& joint_index_map = getJointIndexMap();
-
-  std::vector<Eigen::MatrixXd> thrust_coord_jacobians = getThrustCoordJacobians();
+  const auto& thrust_coord_jacobians = getThrustCoordJacobians();
 
-  // the rotor normal of gimbal is always vertial
+  // the rotor normal of gimbal is always vertial, only the roll and pitch components of the angular velocity are relevant
   for(int i = 0; i < getRotorNum(); i++)
     {
-      Eigen::MatrixXd joint_rot_jacobian = Eigen::MatrixXd::Zero(3, 6 + link_joint_indices.size());
+      const Eigen::MatrixXd& thrust_coord_jacobian = thrust_coord_jacobians.at(i);
+      const int gimbal_roll_index = gimbal_cols_.at(i).first;
+      const int gimbal_pitch_index = gimbal_cols_.at(i).second;
 
-      joint_rot_jacobian.leftCols(6) = thrust_coord_jacobians.at(i).bottomLeftCorner(3, 6); // root
-      std::string gimbal = std::string("gimbal") + std::to_string(i + 1);
-      int gimbal_roll_index, gimbal_pitch_index;
-      int j = 0;
-      for(int k = 0; k < joint_names.size(); k++)
-        {
-          if(j < link_joint_names.size())
-            {
-              if(joint_names.at(k) == link_joint_names.at(j))
-                {
-                  joint_rot_jacobian.col(6 + j) = thrust_coord_jacobians.at(i).block(3, 6 + k, 3, 1);
-                  j++;
-                }
-            }
-          if(joint_names.at(k) == gimbal + std::string("_roll")) gimbal_roll_index = 6 + k;
-          if(joint_names.at(k) == gimbal + std::string("_pitch")) gimbal_pitch_index = 6 + k;
-        }
+      Eigen::MatrixXd joint_rot_jacobian(2, gimbal_jacobian_.cols());
+      joint_rot_jacobian.leftCols(6) = thrust_coord_jacobian.block(3, 0, 2, 6); // root
+      for(int j = 0; j < link_joint_cols_.size(); j++)
+        joint_rot_jacobian.col(6 + j) = thrust_coord_jacobian.block(3, link_joint_cols_.at(j), 2, 1);
 
-      Eigen::MatrixXd gimbal_rot_jacobian = Eigen::MatrixXd::Zero(3, 2);
-      gimbal_rot_jacobian.col(0) = thrust_coord_jacobians.at(i).block(3, gimbal_roll_index, 3, 1);
-      gimbal_rot_jacobian.col(1) = thrust_coord_jacobians.at(i).block(3, gimbal_pitch_index, 3, 1);
+      Eigen::Matrix2d gimbal_rot_jacobian;
+      gimbal_rot_jacobian.col(0) = thrust_coord_jacobian.block(3, gimbal_roll_index, 2, 1);
+      gimbal_rot_jacobian.col(1) = thrust_coord_jacobian.block(3, gimbal_pitch_index, 2, 1);
 
-      Eigen::MatrixXd gimbal_joint_jacobian = - (Eigen::MatrixXd::Identity(2,3) * gimbal_rot_jacobian).inverse() * Eigen::MatrixXd::Identity(2,3) * joint_rot_jacobian;
+      Eigen::MatrixXd gimbal_joint_jacobian = - gimbal_rot_jacobian.inverse() * joint_rot_jacobian;
 
       gimbal_jacobian_.row(gimbal_roll_index) = gimbal_joint_jacobian.row(0);
       gimbal_jacobian_.row(gimbal_pitch_index) = gimbal_joint_jacobian.row(1);
@@ -315,14 +295,28 @@ void HydrusLikeRobotModel::calcRotorOverlapJacobian()
         }
     }
 
-  Eigen::MatrixXd p_i_jacobian = getJacobian(getJointPositions(), edf_names_.at(rotor_i_)).topRows(3);
-  Eigen::MatrixXd p_j_jacobian = getJacobian(getJointPositions(), edf_names_.at(rotor_j_)).topRows(3);
+  Eigen::MatrixXd p_i_jacobian = getEdfPositionJacobian(rotor_i_);
+  Eigen::MatrixXd p_j_jacobian = getEdfPositionJacobian(rotor_j_);
   Eigen::MatrixXd p_v_jacobian = p_i_jacobian + (closest_p_j(2) - closest_p_i(2)) / u.at(rotor_i_/2)(2) * u_jacobians.at(rotor_i_/2) + u.at(rotor_i_/2) / u.at(rotor_i_/2)(2) * (p_j_jacobian.row(2) - p_i_jacobian.row(2)) - u.at(rotor_i_/2) / std::pow(u.at(rotor_i_/2)(2), 2) * (closest_p_j(2) - closest_p_i(2)) * u_jacobians.at(rotor_i_/2).row(2);
   rotor_overlap_jacobian_ = (closest_p_v - closest_p_j).transpose() * (p_v_jacobian - p_j_jacobian) / (closest_p_v - closest_p_j).norm();
   rotor_overlap_jacobian_ -= tan(edf_max_tilt_) * (p_i_jacobian.row(2) - p_j_jacobian.row(2));
 }
 
 
+Eigen::MatrixXd HydrusLikeRobotModel::getEdfPositionJacobian(int edf_index)
+{
+  /*
+    the edf is fixed to the gimbal pitch module as well as the thrust frame,
+    so the jacobian is derived from the (link joint) thrust jacobian without solving the kinematics tree again:
+    J_edf = J_thrust_p - [p_edf - p_thrust]x J_thrust_w
+  */
+  const int rotor_index = edf_index / 2;
+  const Eigen::MatrixXd& thrust_coord_jacobian = getThrustCoordJacobians().at(rotor_index);
+  const Eigen::Vector3d r = aerial_robot_model::kdlToEigen(edfs_origin_from_cog_.at(edf_index) - getRotorsOriginFromCog<KDL::Vector>().at(rotor_index));
+
+  return thrust_coord_jacobian.topRows(3) - aerial_robot_model::skew(r) * thrust_coord_jacobian.bottomRows(3);
+}
+
 std::vector<int> HydrusLikeRobotModel::getClosestRotorIndices()
 {
   std::vector<int> rotor_indices;
@@ -395,6 +389,12 @@ void HydrusLikeRobotModel::calcExternalWrenchCompThrust()
 
 void HydrusLikeRobotModel::calcExternalWrenchCompThrust(const std::map<std::string, Dragon::ExternalWrench>& external_wrench_map)
 {
+  if(external_wrench_map.empty())
+    {
+      wrench_comp_thrust_.setZero(3 * getRotorNum()); // no need of the pseudoinverse
+      return;
+    }
+
   const auto seg_frames = getSegmentsTf();
   const int rotor_num = getRotorNum();
   const int joint_num = getJointNum();
@@ -416,7 +416,8 @@ void HydrusLikeRobotModel::calcExternalWrenchCompThrust(const std::map<std::stri
   // TODO: redandunt!
   for (unsigned int i = 0; i < rotor_num; ++i)
     vectoring_q_mat_.middleCols(3 * i, 3) = thrust_wrench_allocations.at(i).leftCols(3);
-  wrench_comp_thrust_ = aerial_robot_model::pseudoinverse(vectoring_q_mat_) * (-wrench_sum);
+  q_pseudo_inv_ = aerial_robot_model::pseudoinverse(vectoring_q_mat_); // reused in calcCompThrustJacobian()
+  wrench_comp_thrust_ = q_pseudo_inv_ * (-wrench_sum);
 
   ROS_DEBUG_STREAM("wrench_comp_thrust: " << wrench_comp_thrust_.transpose());
 }
@@ -462,11 +463,17 @@ void HydrusLikeRobotModel::addCompThrustToJointTorque()
 void HydrusLikeRobotModel::calcCompThrustJacobian()
 {
   // w.r.t root
-  const auto& joint_positions = getJointPositions();
   const int rotor_num = getRotorNum();
-  const int joint_num = getJointNum();
   const int ndof = getThrustCoordJacobians().at(0).cols();
-  Eigen::MatrixXd q_pseudo_inv = aerial_robot_model::pseudoinverse(vectoring_q_mat_);
+
+  if(!hasCompThrust())
+    {
+      // all of the following terms are proportional to the external wrench
+      comp_thrust_jacobian_.setZero(3 * rotor_num, ndof);
+      return;
+    }
+
+  const Eigen::MatrixXd& q_pseudo_inv = q_pseudo_inv_;
 
   /* derivative for external wrench jacobian */
   Eigen::MatrixXd wrench_external_wrench_jacobian = Eigen::MatrixXd::Zero(6, ndof);
@@ -522,6 +529,8 @@ void HydrusLikeRobotModel::addCompThrustToLambdaJacobian()
 
 void HydrusLikeRobotModel::addCompThrustToJointTorqueJacobian()
 {
+  if(!hasCompThrust()) return; // comp_thrust_jacobian_ is zero
+
   const int rotor_num = getRotorNum();
   const int joint_num = getJointNum();
   const int ndof = getLambdaJacobian().cols();
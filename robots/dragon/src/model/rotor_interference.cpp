@@ -0,0 +1,313 @@
+// -*- mode: c++ -*-
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, JSK Lab
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/o2r other materials provided
+ *     with the distribution.
+ *   * Neither the name of the JSK Lab nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <dragon/model/rotor_interference.h>
+
+using namespace Dragon;
+
+namespace
+{
+  /* 1 inside thresh, quadratic decay to 0 at relax_thresh */
+  double relaxWeight(double dist, double thresh, double relax_thresh)
+  {
+    if(dist <= thresh) return 1;
+    if(dist > relax_thresh) return 0;
+    double diff = (relax_thresh - dist) / (relax_thresh - thresh);
+    return diff * diff;
+  }
+}
+
+RotorInterference::RotorInterference(int rotor_num, const RotorInterferenceParams& params):
+  rotor_num_(0), pruned_pair_num_(0)
+{
+  setParams(params);
+  initialize(rotor_num);
+}
+
+void RotorInterference::initialize(int rotor_num)
+{
+  rotor_num_ = rotor_num;
+  segment_names_.clear();
+  overlaps_.clear();
+  if(rotor_num_ == 0) return;
+
+  for(int i = 0; i < rotor_num_; i++)
+    segment_names_.push_back(std::string("link") + std::to_string(i + 1));
+  for(int i = 0; i < rotor_num_ - 1; i++)
+    segment_names_.push_back(std::string("inter_joint") + std::to_string(i + 1));
+  for(int i = 0; i < rotor_num_; i++)
+    {
+      segment_names_.push_back(std::string("edf") + std::to_string(i + 1) + std::string("_left"));
+      segment_names_.push_back(std::string("edf") + std::to_string(i + 1) + std::string("_right"));
+    }
+
+  overlaps_.reserve(rotor_num_ * 2);
+  p_inters_.resize(rotor_num_);
+  bound_centers_.resize(rotor_num_);
+  bound_radiuses_.resize(rotor_num_);
+}
+
+void RotorInterference::setParams(const RotorInterferenceParams& params)
+{
+  params_ = params;
+  tan_cone_ = std::tan(params_.downwash_cone_angle);
+  max_thresh_ = std::max({params_.rotor_thresh, params_.rotor_relax_thresh, params_.link_thresh,
+                          params_.link_relax_thresh, params_.inter_joint_thresh});
+}
+
+const std::vector<RotorOverlap>& RotorInterference::update(const std::vector<Eigen::Vector3d>& segment_positions,
+                                                            const std::vector<Eigen::Vector3d>& link_axes,
+                                                            const std::vector<Eigen::Vector3d>& rotor_normals)
+{
+  overlaps_.clear();
+  pruned_pair_num_ = 0;
+  if(rotor_num_ < 2 || segment_positions.size() != segment_names_.size()) return overlaps_;
+
+  const double link_length = (segment_positions.at(interJointIndex(0)) - segment_positions.at(linkIndex(0))).norm();
+
+  /* bounding sphere of each link module */
+  for(int j = 0; j < rotor_num_; j++)
+    {
+      const Eigen::Vector3d& p_link = segment_positions.at(linkIndex(j));
+      const Eigen::Vector3d p_link_end = p_link + link_axes.at(j) * link_length;
+      if(j == rotor_num_ - 1)
+        p_inters_.at(j) = p_link_end;
+      else
+        p_inters_.at(j) = (segment_positions.at(interJointIndex(j)) + segment_positions.at(linkIndex(j + 1))) / 2;
+
+      const Eigen::Vector3d* points[] = {&p_link, &p_link_end, &p_inters_.at(j),
+                                         &segment_positions.at(edfIndex(j, 0)), &segment_positions.at(edfIndex(j, 1))};
+      Eigen::Vector3d center = Eigen::Vector3d::Zero();
+      for(const auto p: points) center += *p;
+      center /= 5;
+      double radius = 0;
+      for(const auto p: points) radius = std::max(radius, (*p - center).norm());
+
+      bound_centers_.at(j) = center;
+      bound_radiuses_.at(j) = radius;
+    }
+
+  for(int i = 0; i < rotor_num_; i++)
+    {
+      for(int side = 0; side < 2; side++)
+        rotorInterfere(2 * i + side, segment_positions.at(edfIndex(i, side)), rotor_normals.at(i), link_length, segment_positions, link_axes);
+    }
+
+  return overlaps_;
+}
+
+void RotorInterference::rotorInterfere(int edf, const Eigen::Vector3d& p_rotor, const Eigen::Vector3d& u_rotor, double link_length,
+                                       const std::vector<Eigen::Vector3d>& segment_positions, const std::vector<Eigen::Vector3d>& link_axes)
+{
+  const int i = edf / 2;
+
+  for(int j = 0; j < rotor_num_; ++j)
+    {
+      /* early-out: the link module is above the rotor, or out of the downwash cone (the relax margin for the link end is included) */
+      if(params_.prune)
+        {
+          const Eigen::Vector3d& center = bound_centers_.at(j);
+          const double radius = bound_radiuses_.at(j);
+          if(center.z() - radius > p_rotor.z())
+            {
+              pruned_pair_num_++;
+              continue;
+            }
+          const Eigen::Vector3d d_center = center - p_rotor;
+          const double depth = std::max(0.0, - d_center.dot(u_rotor)) + radius + 2 * max_thresh_;
+          if((d_center - d_center.dot(u_rotor) * u_rotor).norm() > radius + 2 * max_thresh_ + depth * tan_cone_)
+            {
+              pruned_pair_num_++;
+              continue;
+            }
+        }
+
+      const Eigen::Vector3d& u_link = link_axes.at(j);
+      const Eigen::Vector3d& p_link = segment_positions.at(linkIndex(j));
+      const Eigen::Vector3d& p_inter = p_inters_.at(j);
+
+      if(p_inter.z() > p_rotor.z() && p_link.z() > p_rotor.z()) continue; // never overlap
+
+      // case1: inter joint
+      bool overlap_inter = false;
+      const double inter_thresh = params_.inter_joint_thresh + spread(p_rotor, u_rotor, p_inter);
+      double dist_inter = inter_thresh;
+      if(p_inter.z() <= p_rotor.z())
+        {
+          dist_inter = (p_rotor + (p_inter - p_rotor).dot(u_rotor) * u_rotor - p_inter).norm();
+          if(dist_inter < inter_thresh) overlap_inter = true;
+        }
+
+      if(j == i) // self overlap never
+        {
+          if(overlap_inter) overlaps_.push_back(RotorOverlap{edf, j, INTERFERE_INTER_JOINT, p_inter, 1});
+          continue;
+        }
+
+      // case2: rotor
+      const Eigen::Vector3d& p_rotor_l = segment_positions.at(edfIndex(j, 0));
+      const Eigen::Vector3d& p_rotor_r = segment_positions.at(edfIndex(j, 1));
+      bool overlap_rotor = false;
+      double linear_rotor_weight = 0;
+
+      if(p_rotor.z() > p_rotor_l.z() && p_rotor.z() > p_rotor_r.z())
+        {
+          const double dist_rotor_l = (p_rotor + (p_rotor_l.z() - p_rotor.z()) / u_rotor.z() * u_rotor - p_rotor_l).norm();
+          const double dist_rotor_r = (p_rotor + (p_rotor_r.z() - p_rotor.z()) / u_rotor.z() * u_rotor - p_rotor_r).norm();
+          const double spread_l = spread(p_rotor, u_rotor, p_rotor_l);
+          const double spread_r = spread(p_rotor, u_rotor, p_rotor_r);
+          const double relax_thresh_l = params_.rotor_relax_thresh + spread_l;
+          const double relax_thresh_r = params_.rotor_relax_thresh + spread_r;
+
+          if(dist_rotor_l < relax_thresh_l || dist_rotor_r < relax_thresh_r)
+            {
+              const double rotor_l_weight = relaxWeight(dist_rotor_l, params_.rotor_thresh + spread_l, relax_thresh_l);
+              const double rotor_r_weight = relaxWeight(dist_rotor_r, params_.rotor_thresh + spread_r, relax_thresh_r);
+
+              if(dist_rotor_l > relax_thresh_l)
+                {
+                  linear_rotor_weight = (relax_thresh_r - dist_rotor_r) / relax_thresh_r;
+                  overlaps_.push_back(RotorOverlap{edf, j, INTERFERE_ROTOR_RIGHT, p_rotor_r, rotor_r_weight});
+                }
+              else if(dist_rotor_r > relax_thresh_r)
+                {
+                  linear_rotor_weight = (relax_thresh_l - dist_rotor_l) / relax_thresh_l;
+                  overlaps_.push_back(RotorOverlap{edf, j, INTERFERE_ROTOR_LEFT, p_rotor_l, rotor_l_weight});
+                }
+              else
+                {
+                  linear_rotor_weight = ((relax_thresh_l - dist_rotor_l) / relax_thresh_l + (relax_thresh_r - dist_rotor_r) / relax_thresh_r) / 2;
+                  overlaps_.push_back(RotorOverlap{edf, j, INTERFERE_ROTOR_LEFT | INTERFERE_ROTOR_RIGHT,
+                                                   (rotor_l_weight * p_rotor_l + rotor_r_weight * p_rotor_r) / (rotor_l_weight + rotor_r_weight),
+                                                   (rotor_l_weight + rotor_r_weight) / 2});
+                }
+
+              overlap_rotor = true;
+            }
+        }
+
+      // case3: link (closest points between the link axis and the downwash axis)
+      Eigen::Matrix2d A; A << u_link.dot(u_link), -u_link.dot(u_rotor), u_link.dot(u_rotor), - u_rotor.dot(u_rotor);
+      Eigen::Vector2d diff(-u_link.dot(p_link - p_rotor), -u_rotor.dot(p_link - p_rotor));
+      Eigen::Vector2d t = A.inverse() * diff;
+      if(t(1) >= 0) continue; // above the rotor
+
+      const Eigen::Vector3d p_link_overlap = p_link + u_link * t(0);
+      const double dist_link = (p_link_overlap - (p_rotor + u_rotor * t(1))).norm();
+      const double spread_link = - t(1) * tan_cone_;
+      const double link_relax_thresh = params_.link_relax_thresh + spread_link;
+      if(dist_link >= link_relax_thresh) continue;
+
+      bool overlap_link = true;
+      if(t(0) < 0)
+        {
+          if(j == 0 && t(0) > link_relax_thresh) overlap_link = true; // relax for the end of the link
+          else overlap_link = false;
+        }
+      if(t(0) > link_length)
+        {
+          if(j == rotor_num_ - 1 && t(0) < link_length + link_relax_thresh) overlap_link = true; // relax for the end of the link
+          else overlap_link = false;
+        }
+      if(!overlap_link) continue;
+
+      const double linear_link_weight = (link_relax_thresh - dist_link) / link_relax_thresh;
+      const double weight = relaxWeight(dist_link, params_.link_thresh + spread_link, link_relax_thresh);
+
+      if(overlap_rotor)
+        {
+          RotorOverlap& overlap = overlaps_.back();
+          overlap.position = (linear_rotor_weight * overlap.position + linear_link_weight * p_link_overlap) / (linear_rotor_weight + linear_link_weight);
+          overlap.weight = (overlap.weight + weight) / 2;
+          overlap.segment |= INTERFERE_LINK;
+        }
+      else if(overlap_inter)
+        {
+          const double linear_inter_weight = (inter_thresh - dist_inter) / inter_thresh;
+          overlaps_.push_back(RotorOverlap{edf, j, INTERFERE_LINK | INTERFERE_INTER_JOINT,
+                                           (linear_inter_weight * p_inter + linear_link_weight * p_link_overlap) / (linear_inter_weight + linear_link_weight),
+                                           weight});
+        }
+      else
+        {
+          overlaps_.push_back(RotorOverlap{edf, j, INTERFERE_LINK, p_link_overlap, weight});
+        }
+    }
+}
+
+std::string RotorInterference::getOverlapName(const RotorOverlap& overlap) const
+{
+  std::string name = std::string("rotor") + std::to_string(overlap.rotor / 2 + 1) + (overlap.rotor % 2 ? std::string("_right") : std::string("_left")) + std::string(" -> ");
+  const std::string s = std::to_string(overlap.link + 1);
+
+  std::vector<std::string> segments;
+  if(overlap.segment & (INTERFERE_ROTOR_LEFT | INTERFERE_ROTOR_RIGHT))
+    {
+      std::string rotor = std::string("rotor") + s;
+      if((overlap.segment & INTERFERE_ROTOR_LEFT) && (overlap.segment & INTERFERE_ROTOR_RIGHT)) rotor += std::string("_left&right");
+      else if(overlap.segment & INTERFERE_ROTOR_LEFT) rotor += std::string("_left");
+      else rotor += std::string("_right");
+      segments.push_back(rotor);
+    }
+  if(overlap.segment & INTERFERE_LINK) segments.push_back(std::string("link") + s);
+  if(overlap.segment & INTERFERE_INTER_JOINT) segments.push_back(std::string("inter_joint") + s);
+
+  for(size_t k = 0; k < segments.size(); k++) name += (k > 0 ? std::string("&") : std::string("")) + segments.at(k);
+  return name;
+}
+
+bool RotorInterference::rotorPairOverlap(const Eigen::Vector3d& p_i, const Eigen::Vector3d& p_j, double edf_radius, double edf_max_tilt)
+{
+  const Eigen::Vector3d diff = p_i - p_j;
+  const double projected_dist = std::sqrt(diff(0) * diff(0) + diff(1) * diff(1));
+  return edf_radius + std::fabs(diff(2)) * std::tan(edf_max_tilt) + edf_radius > projected_dist;
+}
+
+std::pair<int, int> RotorInterference::findRotorPairOverlap(const std::vector<Eigen::Vector3d>& edf_positions, double edf_radius, double edf_max_tilt)
+{
+  const int edf_num = edf_positions.size();
+  for(int i = 0; i < edf_num; ++i)
+    {
+      for(int j = i + 1; j < edf_num; ++j)
+        {
+          /* special for dual rotor */
+          if(i / 2 == j / 2) continue;
+
+          if(rotorPairOverlap(edf_positions.at(i), edf_positions.at(j), edf_radius, edf_max_tilt))
+            return std::make_pair(i, j);
+        }
+    }
+  return std::make_pair(-1, -1);
+}
@@ -107,6 +107,9 @@ namespace sensor_plugin
 
     estimateProcess();
     updateHealthStamp();
+
+    boost::lock_guard<boost::mutex> lock(callback_mutex_);
+    if(update_callback_) update_callback_(imu_stamp_.toSec());
   }
 
 };
@@ -0,0 +1,189 @@
+#include <dragon/control/external_wrench_observer.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace aerial_robot_control;
+
+namespace
+{
+  /*
+     offline test bench: a rigid body hovering with a velocity damping controller,
+     a step of the external wrench at step_time, and the imu samples with jittered stamps
+  */
+  struct TestBench
+  {
+    double mass = 4.0;
+    Eigen::Matrix3d inertia = Eigen::Vector3d(0.1, 0.12, 0.2).asDiagonal();
+    Eigen::Vector3d gravity = Eigen::Vector3d(0, 0, 9.80665);
+    double sample_period = 0.005;
+    double sample_jitter = 0.0005;
+    double sim_step = 1e-4;
+    double vel_noise = 0;
+    double omega_noise = 0;
+    double step_time = 1.0;
+    Vector6d external_wrench = (Vector6d() << 2.0, -1.0, -3.0, 0.3, -0.2, 0.1).finished(); // force: world frame, torque: CoG frame
+
+    /* return the estimated wrench of each sample, the attitude is kept by a PD controller */
+    std::vector<std::pair<double, Vector6d>> run(ExternalWrenchObserver& observer, double duration)
+    {
+      std::mt19937 gen(0);
+      std::uniform_real_distribution<double> jitter(-sample_jitter, sample_jitter);
+      std::normal_distribution<double> normal(0, 1);
+
+      Eigen::Vector3d vel = Eigen::Vector3d::Zero();
+      Eigen::Vector3d omega = Eigen::Vector3d::Zero();
+      const Eigen::Matrix3d rot_ref = Eigen::AngleAxisd(0.1, Eigen::Vector3d(1, 1, 0).normalized()).toRotationMatrix();
+      Eigen::Matrix3d rot = rot_ref;
+      Vector6d command = Vector6d::Zero();
+
+      std::vector<std::pair<double, Vector6d>> result;
+      double t = 0;
+      double next_sample = 0;
+      while(t < duration)
+        {
+          if(t >= next_sample)
+            {
+              /* controller and observer, synchronized with the sample */
+              const Eigen::Vector3d f_w = mass * gravity - 2.0 * mass * vel;
+              command.head<3>() = rot.transpose() * f_w;
+              const Eigen::AngleAxisd rot_err(rot_ref.transpose() * rot);
+              command.tail<3>() = omega.cross(inertia * omega) - inertia * (25.0 * rot_err.angle() * rot_err.axis() + 10.0 * omega);
+
+              ExternalWrenchObserverInput input;
+              input.stamp = next_sample;
+              input.mass = mass;
+              input.inertia = inertia;
+              input.rot = rot;
+              input.vel = vel + vel_noise * Eigen::Vector3d(normal(gen), normal(gen), normal(gen));
+              input.omega = omega + omega_noise * Eigen::Vector3d(normal(gen), normal(gen), normal(gen));
+              input.gravity = gravity;
+              input.wrench = command;
+              if(observer.update(input)) result.push_back(std::make_pair(t, observer.getWrench()));
+
+              next_sample += sample_period + jitter(gen);
+            }
+
+          const Vector6d w = t >= step_time ? external_wrench : Vector6d::Zero();
+          const Eigen::Vector3d acc = (rot * command.head<3>() - mass * gravity + w.head<3>()) / mass;
+          const Eigen::Vector3d omega_dot = inertia.inverse() * (command.tail<3>() - omega.cross(inertia * omega) + w.tail<3>());
+          vel += acc * sim_step;
+          omega += omega_dot * sim_step;
+          const Eigen::Vector3d d_rot = omega * sim_step;
+          if(d_rot.norm() > 0) rot = rot * Eigen::AngleAxisd(d_rot.norm(), d_rot.normalized()).toRotationMatrix();
+          t += sim_step;
+        }
+      return result;
+    }
+
+    /* time to reach 90% of the step in every axis */
+    double riseTime(const std::vector<std::pair<double, Vector6d>>& result) const
+    {
+      for(const auto& sample: result)
+        {
+          if(sample.first < step_time) continue;
+          bool reached = true;
+          for(int i = 0; i < 6; i++)
+            if(sample.second(i) / external_wrench(i) < 0.9) reached = false;
+          if(reached) return sample.first - step_time;
+        }
+      return 1e6;
+    }
+
+    /* RMS of the estimation error in the last part */
+    double steadyError(const std::vector<std::pair<double, Vector6d>>& result, double from) const
+    {
+      double sum = 0;
+      int n = 0;
+      for(const auto& sample: result)
+        {
+          if(sample.first < from) continue;
+          sum += (sample.second - external_wrench).cwiseQuotient(external_wrench).squaredNorm() / 6;
+          n++;
+        }
+      return std::sqrt(sum / n);
+    }
+  };
+
+  ExternalWrenchObserverParams observerParams(int type)
+  {
+    ExternalWrenchObserverParams params;
+    params.type = type;
+    return params;
+  }
+}
+
+TEST(ExternalWrenchObserver, noWrenchBeforeStep)
+{
+  for(int type: {ExternalWrenchObserverParams::FIRST_ORDER, ExternalWrenchObserverParams::SECOND_ORDER, ExternalWrenchObserverParams::KALMAN})
+    {
+      TestBench bench;
+      ExternalWrenchObserver observer(observerParams(type));
+      const auto result = bench.run(observer, bench.step_time);
+      ASSERT_FALSE(result.empty());
+      for(const auto& sample: result) EXPECT_LT(sample.second.norm(), 1e-6) << "type: " << type;
+    }
+}
+
+TEST(ExternalWrenchObserver, wrenchStep)
+{
+  for(int type: {ExternalWrenchObserverParams::FIRST_ORDER, ExternalWrenchObserverParams::SECOND_ORDER, ExternalWrenchObserverParams::KALMAN})
+    {
+      TestBench bench;
+      ExternalWrenchObserver observer(observerParams(type));
+      const auto result = bench.run(observer, 3.0);
+      EXPECT_LT(bench.riseTime(result), 0.5) << "type: " << type;
+      EXPECT_LT(bench.steadyError(result, 2.0), 0.02) << "type: " << type;
+    }
+}
+
+TEST(ExternalWrenchObserver, fasterRejection)
+{
+  TestBench bench;
+  ExternalWrenchObserver first_order(observerParams(ExternalWrenchObserverParams::FIRST_ORDER));
+  ExternalWrenchObserver second_order(observerParams(ExternalWrenchObserverParams::SECOND_ORDER));
+  ExternalWrenchObserver kalman(observerParams(ExternalWrenchObserverParams::KALMAN));
+
+  const double first_order_rise = bench.riseTime(bench.run(first_order, 2.0));
+  EXPECT_LT(bench.riseTime(bench.run(second_order, 2.0)), first_order_rise);
+  EXPECT_LT(bench.riseTime(bench.run(kalman, 2.0)), first_order_rise);
+}
+
+TEST(ExternalWrenchObserver, noisyMeasurement)
+{
+  TestBench bench;
+  bench.vel_noise = 0.005;
+  bench.omega_noise = 0.01;
+
+  for(int type: {ExternalWrenchObserverParams::FIRST_ORDER, ExternalWrenchObserverParams::SECOND_ORDER, ExternalWrenchObserverParams::KALMAN})
+    {
+      ExternalWrenchObserver observer(observerParams(type));
+      EXPECT_LT(bench.steadyError(bench.run(observer, 3.0), 2.0), 0.3) << "type: " << type;
+    }
+}
+
+TEST(ExternalWrenchObserver, restartAfterGap)
+{
+  ExternalWrenchObserver observer(observerParams(ExternalWrenchObserverParams::SECOND_ORDER));
+  ExternalWrenchObserverInput input;
+  input.mass = 1.0;
+  input.wrench(2) = input.mass * input.gravity.z();
+
+  input.stamp = 1.0;
+  EXPECT_FALSE(observer.update(input)); // initialize
+  input.stamp = 1.005;
+  input.vel.z() = 0.01; // 2 N upward
+  EXPECT_TRUE(observer.update(input));
+  EXPECT_GT(observer.getWrench()(2), 0);
+
+  EXPECT_FALSE(observer.update(input)); // same stamp
+  input.stamp = 2.0;
+  EXPECT_FALSE(observer.update(input)); // gap in the stream
+  EXPECT_EQ(observer.getWrench().norm(), 0);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
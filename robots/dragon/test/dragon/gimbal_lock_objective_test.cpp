@@ -0,0 +1,95 @@
+#include <dragon/model/gimbal_lock_objective.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+using namespace Dragon;
+
+namespace
+{
+  /* quad dragon in a zigzag form: the links turn by +/- 90 deg in yaw, with a small pitch of each link */
+  struct LockPlan
+  {
+    std::vector<Eigen::Vector3d> rotor_pos;
+    std::vector<Eigen::Matrix3d> link_rot;
+    std::vector<int> roll_locked_gimbal;
+  };
+
+  LockPlan zigzagQuad(const std::vector<int>& roll_locked_gimbal)
+  {
+    LockPlan plan;
+    const double yaws[] = {0, M_PI / 2, 0, M_PI / 2};
+    const double pitches[] = {0.4, -0.3, 0.2, -0.5};
+    Eigen::Vector3d origin(-0.3, -0.3, 0);
+    for(int i = 0; i < 4; i++)
+      {
+        const Eigen::Matrix3d rot = (Eigen::AngleAxisd(yaws[i], Eigen::Vector3d::UnitZ()) *
+                                     Eigen::AngleAxisd(pitches[i], Eigen::Vector3d::UnitY())).toRotationMatrix();
+        plan.link_rot.push_back(rot);
+        plan.rotor_pos.push_back(origin + rot * Eigen::Vector3d(0.2, 0, 0));
+        origin += rot * Eigen::Vector3d(0.4, 0, 0);
+      }
+    plan.roll_locked_gimbal = roll_locked_gimbal;
+    return plan;
+  }
+
+  double evaluate(const LockPlan& plan, const std::vector<double>& angles, double epsilon, std::vector<double>& grad)
+  {
+    return smoothMinControlWrench(plan.rotor_pos, plan.link_rot, plan.roll_locked_gimbal, angles, 0.5, 10.0, epsilon, grad);
+  }
+
+  void checkGradient(const LockPlan& plan, const std::vector<double>& angles, double epsilon)
+  {
+    std::vector<double> grad(angles.size());
+    const double value = evaluate(plan, angles, epsilon, grad);
+    ASSERT_TRUE(std::isfinite(value));
+
+    /* central difference */
+    const double delta = 1e-6;
+    std::vector<double> no_grad;
+    for(int i = 0; i < angles.size(); i++)
+      {
+        std::vector<double> plus = angles, minus = angles;
+        plus.at(i) += delta;
+        minus.at(i) -= delta;
+        const double numerical = (evaluate(plan, plus, epsilon, no_grad) - evaluate(plan, minus, epsilon, no_grad)) / (2 * delta);
+        EXPECT_NEAR(grad.at(i), numerical, 1e-5 + 1e-4 * std::abs(numerical)) << "locked gimbal " << i << ", epsilon " << epsilon;
+      }
+  }
+}
+
+TEST(GimbalLockObjective, gradientMatchesFiniteDifference)
+{
+  const LockPlan one_lock = zigzagQuad({0, 1, 0, 0});
+  const LockPlan two_locks = zigzagQuad({1, 0, 0, 1});
+  for(const double epsilon: {10.0, 50.0})
+    {
+      checkGradient(one_lock, {0.3}, epsilon);
+      checkGradient(one_lock, {-1.2}, epsilon);
+      checkGradient(two_locks, {0.1, -0.4}, epsilon);
+      checkGradient(two_locks, {1.0, 0.7}, epsilon);
+    }
+}
+
+TEST(GimbalLockObjective, largeEpsilonIsFinite)
+{
+  /* exp(x * epsilon) of the raw log-sum-exp overflows here */
+  const LockPlan plan = zigzagQuad({1, 0, 0, 1});
+  std::vector<double> grad(2);
+  for(const double epsilon: {50.0, 1e3, 1e5})
+    {
+      const double value = evaluate(plan, {0.1, -0.4}, epsilon, grad);
+      EXPECT_TRUE(std::isfinite(value)) << "epsilon " << epsilon;
+      EXPECT_TRUE(std::isfinite(grad.at(0)) && std::isfinite(grad.at(1))) << "epsilon " << epsilon;
+    }
+
+  /* converges to the non-smooth objective: min of the sums of |x| */
+  std::vector<double> no_grad;
+  EXPECT_NEAR(evaluate(plan, {0.1, -0.4}, 1e5, no_grad), evaluate(plan, {0.1, -0.4}, 1e4, no_grad), 1e-3);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -8,6 +8,7 @@ DragonNumericalJacobian::DragonNumericalJacobian(ros::NodeHandle nh, ros::NodeHa
 
   nhp_.param("comp_thrust_diff_thre", comp_thrust_diff_thre_, 0.001);
   nhp_.param("rotor_overlap_diff_thre", rotor_overlap_diff_thre_, 0.001);
+  nhp_.param("benchmark_iteration", benchmark_iteration_, 0);
 
   Eigen::Vector3d f;
   nhp_.param("external_fx", f.x(), 0.0);
@@ -39,9 +40,26 @@ bool DragonNumericalJacobian::checkJacobians()
   if(check_rotor_overlap_) flag &= checkRotorOverlapJacobian();
   if(check_feasible_control_roll_pitch_) flag &= checkFeasibleControlRollPitchJacobian(link_joint_indices);
 
+  benchmarkJacobians();
+
   return flag;
 }
 
+void DragonNumericalJacobian::benchmarkJacobians()
+{
+  if(benchmark_iteration_ <= 0) return;
+
+  const KDL::JntArray joint_positions = getRobotModel().getJointPositions();
+  getRobotModel().updateRobotModel(joint_positions);
+
+  ros::WallTime start = ros::WallTime::now();
+  for(int i = 0; i < benchmark_iteration_; i++)
+    getRobotModel().updateJacobians(joint_positions, false);
+  double t = (ros::WallTime::now() - start).toSec() / benchmark_iteration_;
+
+  ROS_INFO_STREAM("average time of updateJacobians: " << t * 1000 << " [ms] (" << benchmark_iteration_ << " iterations, " << getDragonRobotModel().getExternalWrenchMap().size() << " external wrench)");
+}
+
 const Eigen::MatrixXd DragonNumericalJacobian::thrustForceNumericalJacobian(std::vector<int> joint_indices)
 {
   const auto seg_frames = getRobotModel().getSegmentsTf();
@@ -49,6 +49,7 @@ public:
   virtual bool checkRotorOverlapJacobian();
   virtual bool checkExternalWrenchCompensateThrustJacobian();
   virtual bool checkThrsutForceJacobian(std::vector<int> joint_indices = std::vector<int>()) override;
+  virtual void benchmarkJacobians();
 
 protected:
 
@@ -56,6 +57,7 @@ protected:
   bool check_comp_thrust_;
   double rotor_overlap_diff_thre_;
   double comp_thrust_diff_thre_;
+  int benchmark_iteration_;
 
   Dragon::HydrusLikeRobotModel& getDragonRobotModel() const {return dynamic_cast<Dragon::HydrusLikeRobotModel&>(*robot_model_);}
 
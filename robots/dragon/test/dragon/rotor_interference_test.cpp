@@ -0,0 +1,409 @@
+#include <dragon/model/rotor_interference.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace Dragon;
+
+namespace
+{
+  /* link1 is level along x, link2 runs along y under the edfs of link1 (shifted by offset_x) */
+  struct Links
+  {
+    std::vector<Eigen::Vector3d> positions;
+    std::vector<Eigen::Vector3d> axes;
+    std::vector<Eigen::Vector3d> normals;
+  };
+
+  Links foldedLinks(const RotorInterference& model, double offset_x, double depth = 0.2)
+  {
+    Links links;
+    links.positions.resize(model.getSegmentNames().size());
+    links.positions.at(model.linkIndex(0)) = Eigen::Vector3d(0, 0, 0);
+    links.positions.at(model.interJointIndex(0)) = Eigen::Vector3d(0.4, 0, 0);
+    links.positions.at(model.edfIndex(0, 0)) = Eigen::Vector3d(0.2, 0.1, 0);
+    links.positions.at(model.edfIndex(0, 1)) = Eigen::Vector3d(0.2, -0.1, 0);
+    links.positions.at(model.linkIndex(1)) = Eigen::Vector3d(0.2 + offset_x, -0.2, -depth);
+    links.positions.at(model.edfIndex(1, 0)) = Eigen::Vector3d(0.1 + offset_x, 0, -depth);
+    links.positions.at(model.edfIndex(1, 1)) = Eigen::Vector3d(0.3 + offset_x, 0, -depth);
+    links.axes = {Eigen::Vector3d::UnitX(), Eigen::Vector3d::UnitY()};
+    links.normals = {Eigen::Vector3d::UnitZ(), Eigen::Vector3d::UnitZ()};
+    return links;
+  }
+
+  /* random folded chain of link modules, each rotated by random pitch and yaw joints from the previous one, with slightly tilted rotors */
+  Links randomLinks(const RotorInterference& model, int rotor_num, std::mt19937& engine)
+  {
+    const double link_length = 0.42;
+    const double joint_offset = 0.03; // from the inter joint to the origin of the next link
+    std::uniform_real_distribution<double> joint(-1.5, 1.5);
+    std::uniform_real_distribution<double> tilt(-0.3, 0.3);
+
+    Links links;
+    links.positions.resize(model.getSegmentNames().size());
+    Eigen::Matrix3d rot = Eigen::Matrix3d::Identity();
+    Eigen::Vector3d p_link = Eigen::Vector3d::Zero();
+    for(int j = 0; j < rotor_num; j++)
+      {
+        if(j > 0)
+          {
+            rot = rot * Eigen::AngleAxisd(joint(engine), Eigen::Vector3d::UnitY()) * Eigen::AngleAxisd(joint(engine), Eigen::Vector3d::UnitZ());
+            p_link = links.positions.at(model.interJointIndex(j - 1)) + rot * Eigen::Vector3d(joint_offset, 0, 0);
+          }
+        links.positions.at(model.linkIndex(j)) = p_link;
+        if(j < rotor_num - 1) links.positions.at(model.interJointIndex(j)) = p_link + rot * Eigen::Vector3d(link_length, 0, 0);
+        links.positions.at(model.edfIndex(j, 0)) = p_link + rot * Eigen::Vector3d(link_length / 2, 0.1, 0.02);
+        links.positions.at(model.edfIndex(j, 1)) = p_link + rot * Eigen::Vector3d(link_length / 2, -0.1, 0.02);
+        links.axes.push_back(rot.col(0));
+        links.normals.push_back((Eigen::AngleAxisd(tilt(engine), Eigen::Vector3d::UnitX()) * Eigen::AngleAxisd(tilt(engine), Eigen::Vector3d::UnitY())).toRotationMatrix().col(2));
+      }
+    /* the last link has no inter joint, the link length is taken from the first one */
+    if(rotor_num == 1) links.positions.at(model.interJointIndex(0)) = p_link + rot * Eigen::Vector3d(link_length, 0, 0);
+    return links;
+  }
+
+  /* per-pair evaluation of the full vectoring controller before the shared model (cylindrical downwash, no pruning) */
+  std::vector<RotorOverlap> legacyOverlaps(const RotorInterference& model, int rotor_num, const Links& links)
+  {
+    const RotorInterferenceParams& params = model.getParams();
+    const std::vector<Eigen::Vector3d>& positions = links.positions;
+    const double link_length = (positions.at(model.interJointIndex(0)) - positions.at(model.linkIndex(0))).norm();
+    std::vector<RotorOverlap> overlaps;
+
+    auto rotorInterfere = [&](int i, int side, const Eigen::Vector3d& p_rotor, const Eigen::Vector3d& u_rotor)
+      {
+        for(int j = 0; j < rotor_num; ++j)
+          {
+            bool overlap_inter = false;
+            const Eigen::Vector3d& u_link = links.axes.at(j);
+            const Eigen::Vector3d& p_link = positions.at(model.linkIndex(j));
+            Eigen::Vector3d p_inter;
+            double dist_inter = params.inter_joint_thresh;
+            if(j == rotor_num - 1)
+              p_inter = p_link + u_link * link_length;
+            else
+              p_inter = (positions.at(model.interJointIndex(j)) + positions.at(model.linkIndex(j + 1))) / 2;
+
+            if(p_inter.z() > p_rotor.z() && p_link.z() > p_rotor.z()) continue;
+
+            if(p_inter.z() <= p_rotor.z())
+              {
+                dist_inter = (p_rotor + (p_inter - p_rotor).dot(u_rotor) * u_rotor - p_inter).norm();
+                if(dist_inter < params.inter_joint_thresh) overlap_inter = true;
+              }
+
+            if(j == i)
+              {
+                if(overlap_inter) overlaps.push_back(RotorOverlap{2 * i + side, j, INTERFERE_INTER_JOINT, p_inter, 1});
+                continue;
+              }
+
+            const Eigen::Vector3d& p_rotor_l = positions.at(model.edfIndex(j, 0));
+            const Eigen::Vector3d& p_rotor_r = positions.at(model.edfIndex(j, 1));
+            bool overlap_rotor = false;
+            double linear_rotor_weight = 0;
+            if(p_rotor.z() > p_rotor_l.z() && p_rotor.z() > p_rotor_r.z())
+              {
+                double dist_rotor_l = (p_rotor + (p_rotor_l.z() - p_rotor.z()) / u_rotor.z() * u_rotor - p_rotor_l).norm();
+                double dist_rotor_r = (p_rotor + (p_rotor_r.z() - p_rotor.z()) / u_rotor.z() * u_rotor - p_rotor_r).norm();
+                if(dist_rotor_l < params.rotor_relax_thresh || dist_rotor_r < params.rotor_relax_thresh)
+                  {
+                    double rotor_l_weight = 1;
+                    double rotor_r_weight = 1;
+                    double relax_range = params.rotor_relax_thresh - params.rotor_thresh;
+                    if(dist_rotor_l > params.rotor_thresh)
+                      {
+                        if(dist_rotor_l > params.rotor_relax_thresh) rotor_l_weight = 0;
+                        else if(relax_range > 0) rotor_l_weight = std::pow((params.rotor_relax_thresh - dist_rotor_l) / relax_range, 2);
+                      }
+                    if(dist_rotor_r > params.rotor_thresh)
+                      {
+                        if(dist_rotor_r > params.rotor_relax_thresh) rotor_r_weight = 0;
+                        else if(relax_range > 0) rotor_r_weight = std::pow((params.rotor_relax_thresh - dist_rotor_r) / relax_range, 2);
+                      }
+
+                    if(dist_rotor_l > params.rotor_relax_thresh)
+                      {
+                        linear_rotor_weight = (params.rotor_relax_thresh - dist_rotor_r) / params.rotor_relax_thresh;
+                        overlaps.push_back(RotorOverlap{2 * i + side, j, INTERFERE_ROTOR_RIGHT, p_rotor_r, rotor_r_weight});
+                      }
+                    else if(dist_rotor_r > params.rotor_relax_thresh)
+                      {
+                        linear_rotor_weight = (params.rotor_relax_thresh - dist_rotor_l) / params.rotor_relax_thresh;
+                        overlaps.push_back(RotorOverlap{2 * i + side, j, INTERFERE_ROTOR_LEFT, p_rotor_l, rotor_l_weight});
+                      }
+                    else
+                      {
+                        linear_rotor_weight = (params.rotor_relax_thresh - (dist_rotor_l + dist_rotor_r) / 2) / params.rotor_relax_thresh;
+                        overlaps.push_back(RotorOverlap{2 * i + side, j, INTERFERE_ROTOR_LEFT | INTERFERE_ROTOR_RIGHT,
+                                                        (rotor_l_weight * p_rotor_l + rotor_r_weight * p_rotor_r) / (rotor_l_weight + rotor_r_weight),
+                                                        (rotor_l_weight + rotor_r_weight) / 2});
+                      }
+                    overlap_rotor = true;
+                  }
+              }
+
+            Eigen::Matrix2d A; A << u_link.dot(u_link), -u_link.dot(u_rotor), u_link.dot(u_rotor), - u_rotor.dot(u_rotor);
+            Eigen::Vector2d diff(-u_link.dot(p_link - p_rotor), -u_rotor.dot(p_link - p_rotor));
+            Eigen::Vector2d t = A.inverse() * diff;
+            Eigen::Vector3d p_link_overlap = p_link + u_link * t(0);
+            double dist_link = (p_link_overlap - (p_rotor + u_rotor * t(1))).norm();
+            if(t(1) >= 0) continue;
+
+            bool overlap_link = false;
+            if(dist_link < params.link_relax_thresh)
+              {
+                overlap_link = true;
+                if(t(0) < 0)
+                  {
+                    if(j == 0 && t(0) > params.link_relax_thresh) overlap_link = true;
+                    else overlap_link = false;
+                  }
+                if(t(0) > link_length)
+                  {
+                    if(j == rotor_num - 1 && t(0) < link_length + params.link_relax_thresh) overlap_link = true;
+                    else overlap_link = false;
+                  }
+              }
+            if(!overlap_link) continue;
+
+            double linear_link_weight = (params.link_relax_thresh - dist_link) / params.link_relax_thresh;
+            double weight = 1;
+            if(dist_link > params.link_thresh)
+              weight = std::pow((params.link_relax_thresh - dist_link) / (params.link_relax_thresh - params.link_thresh), 2);
+
+            if(overlap_rotor)
+              {
+                RotorOverlap& overlap = overlaps.back();
+                overlap.position = (linear_rotor_weight * overlap.position + linear_link_weight * p_link_overlap) / (linear_rotor_weight + linear_link_weight);
+                overlap.weight = (overlap.weight + weight) / 2;
+                overlap.segment |= INTERFERE_LINK;
+              }
+            else if(overlap_inter)
+              {
+                double linear_inter_weight = (params.inter_joint_thresh - dist_inter) / params.inter_joint_thresh;
+                overlaps.push_back(RotorOverlap{2 * i + side, j, INTERFERE_LINK | INTERFERE_INTER_JOINT,
+                                                (linear_inter_weight * p_inter + linear_link_weight * p_link_overlap) / (linear_inter_weight + linear_link_weight),
+                                                weight});
+              }
+            else
+              {
+                overlaps.push_back(RotorOverlap{2 * i + side, j, INTERFERE_LINK, p_link_overlap, weight});
+              }
+          }
+      };
+
+    for(int i = 0; i < rotor_num; ++i)
+      for(int side = 0; side < 2; side++)
+        rotorInterfere(i, side, positions.at(model.edfIndex(i, side)), links.normals.at(i));
+    return overlaps;
+  }
+
+  void expectSameOverlaps(const RotorInterference& model, const std::vector<RotorOverlap>& expected, const std::vector<RotorOverlap>& overlaps)
+  {
+    ASSERT_EQ(overlaps.size(), expected.size());
+    for(size_t k = 0; k < overlaps.size(); k++)
+      {
+        EXPECT_EQ(model.getOverlapName(overlaps.at(k)), model.getOverlapName(expected.at(k)));
+        EXPECT_EQ(overlaps.at(k).segment, expected.at(k).segment);
+        EXPECT_LT((overlaps.at(k).position - expected.at(k).position).norm(), 1e-9);
+        EXPECT_NEAR(overlaps.at(k).weight, expected.at(k).weight, 1e-9);
+      }
+  }
+}
+
+TEST(RotorInterference, segmentTable)
+{
+  RotorInterference model(4);
+  const auto& names = model.getSegmentNames();
+  ASSERT_EQ(names.size(), 15);
+  EXPECT_EQ(names.at(model.linkIndex(2)), "link3");
+  EXPECT_EQ(names.at(model.interJointIndex(0)), "inter_joint1");
+  EXPECT_EQ(names.at(model.interJointIndex(2)), "inter_joint3");
+  EXPECT_EQ(names.at(model.edfIndex(0, 0)), "edf1_left");
+  EXPECT_EQ(names.at(model.edfIndex(3, 1)), "edf4_right");
+}
+
+TEST(RotorInterference, noOverlapInLevelLinks)
+{
+  RotorInterference model(2);
+  Links links = foldedLinks(model, 0);
+  /* unfold link2 along x */
+  links.positions.at(model.linkIndex(1)) = Eigen::Vector3d(0.4, 0, 0);
+  links.positions.at(model.edfIndex(1, 0)) = Eigen::Vector3d(0.6, 0.1, 0);
+  links.positions.at(model.edfIndex(1, 1)) = Eigen::Vector3d(0.6, -0.1, 0);
+  links.axes.at(1) = Eigen::Vector3d::UnitX();
+
+  EXPECT_TRUE(model.update(links.positions, links.axes, links.normals).empty());
+  EXPECT_EQ(model.getPrunedPairNum(), 2); // the pairs of the edfs and the other link are pruned by the bounding test
+}
+
+TEST(RotorInterference, linkUnderRotor)
+{
+  RotorInterference model(2);
+  const Links links = foldedLinks(model, 0);
+
+  const auto& overlaps = model.update(links.positions, links.axes, links.normals);
+  ASSERT_EQ(overlaps.size(), 2);
+  for(int k = 0; k < 2; k++)
+    {
+      const auto& overlap = overlaps.at(k);
+      EXPECT_EQ(overlap.rotor, k); // edf1_left, edf1_right
+      EXPECT_EQ(overlap.link, 1);
+      EXPECT_EQ(overlap.segment, INTERFERE_LINK);
+      EXPECT_DOUBLE_EQ(overlap.weight, 1);
+      EXPECT_LT((overlap.position - Eigen::Vector3d(0.2, k == 0 ? 0.1 : -0.1, -0.2)).norm(), 1e-9);
+    }
+  EXPECT_EQ(model.getOverlapName(overlaps.at(0)), "rotor1_left -> link2");
+}
+
+TEST(RotorInterference, downwashCone)
+{
+  RotorInterferenceParams params;
+  params.rotor_thresh = 0.05;
+  params.rotor_relax_thresh = 0.05;
+  params.link_thresh = 0.05;
+  params.link_relax_thresh = 0.05;
+  RotorInterference model(2, params);
+
+  /* link2 is 0.1 m beside the downwash axis */
+  const Links links = foldedLinks(model, 0.1);
+  EXPECT_TRUE(model.update(links.positions, links.axes, links.normals).empty());
+
+  params.downwash_cone_angle = 0.3; // 0.05 + 0.2 * tan(0.3) > 0.1
+  model.setParams(params);
+  const auto& overlaps = model.update(links.positions, links.axes, links.normals);
+  ASSERT_EQ(overlaps.size(), 2);
+  EXPECT_TRUE(overlaps.at(0).segment & INTERFERE_LINK);
+  EXPECT_EQ(overlaps.at(0).link, 1);
+}
+
+TEST(RotorInterference, randomFoldedLinks)
+{
+  const int rotor_num = 4;
+  RotorInterferenceParams params;
+  params.link_thresh = 0.05;
+  params.link_relax_thresh = 0.1;
+  params.rotor_thresh = 0.05;
+  params.rotor_relax_thresh = 0.1;
+  RotorInterference model(rotor_num, params);
+  params.prune = false;
+  RotorInterference unpruned_model(rotor_num, params);
+
+  std::mt19937 engine(0);
+  int overlap_num = 0, pruned_pair_num = 0;
+  for(int trial = 0; trial < 2000; trial++)
+    {
+      const Links links = randomLinks(model, rotor_num, engine);
+      const std::vector<RotorOverlap> expected = legacyOverlaps(model, rotor_num, links);
+
+      SCOPED_TRACE(trial);
+      expectSameOverlaps(model, expected, unpruned_model.update(links.positions, links.axes, links.normals));
+      expectSameOverlaps(model, expected, model.update(links.positions, links.axes, links.normals));
+      EXPECT_EQ(unpruned_model.getPrunedPairNum(), 0);
+
+      overlap_num += expected.size();
+      pruned_pair_num += model.getPrunedPairNum();
+    }
+  /* not vacuous: both the overlaps and the pruned pairs occur */
+  EXPECT_GT(overlap_num, 100);
+  EXPECT_GT(pruned_pair_num, 1000);
+}
+
+TEST(RotorInterference, randomFoldedLinksInCone)
+{
+  /* the bounding test has to include the spread of the thresholds */
+  const int rotor_num = 4;
+  RotorInterferenceParams params;
+  params.downwash_cone_angle = 0.2;
+  RotorInterference model(rotor_num, params);
+  params.prune = false;
+  RotorInterference unpruned_model(rotor_num, params);
+
+  std::mt19937 engine(1);
+  int overlap_num = 0;
+  for(int trial = 0; trial < 2000; trial++)
+    {
+      const Links links = randomLinks(model, rotor_num, engine);
+      const std::vector<RotorOverlap> expected = unpruned_model.update(links.positions, links.axes, links.normals);
+
+      SCOPED_TRACE(trial);
+      expectSameOverlaps(model, expected, model.update(links.positions, links.axes, links.normals));
+      overlap_num += expected.size();
+    }
+  EXPECT_GT(overlap_num, 100);
+}
+
+TEST(RotorInterference, steepLinkUnderRotor)
+{
+  /* link2 rises from under edf1_left, the center of its bounding sphere is above the edf */
+  RotorInterference model(2);
+  Links links = foldedLinks(model, 0);
+  const Eigen::Vector3d u_link = Eigen::Vector3d(0, 0.2, 1).normalized();
+  links.positions.at(model.linkIndex(1)) = Eigen::Vector3d(0.25, 0.09, -0.1);
+  links.positions.at(model.edfIndex(1, 0)) = Eigen::Vector3d(0.15, 0.09, -0.1) + u_link * 0.2;
+  links.positions.at(model.edfIndex(1, 1)) = Eigen::Vector3d(0.35, 0.09, -0.1) + u_link * 0.2;
+  links.axes.at(1) = u_link;
+
+  const std::vector<RotorOverlap> expected = legacyOverlaps(model, 2, links);
+  ASSERT_FALSE(expected.empty());
+  EXPECT_EQ(model.getOverlapName(expected.at(0)), "rotor1_left -> link2");
+  expectSameOverlaps(model, expected, model.update(links.positions, links.axes, links.normals));
+}
+
+TEST(RotorInterference, linkEndRelax)
+{
+  RotorInterferenceParams params;
+  params.link_thresh = 0.05;
+  params.link_relax_thresh = 0.1;
+  RotorInterference model(2, params);
+  params.prune = false;
+  RotorInterference unpruned_model(2, params);
+
+  /* j == N - 1: the edfs of link1 are beyond the end of link2 (along y), inside the relax range and close to the end point */
+  Links links = foldedLinks(model, 0);
+  links.positions.at(model.edfIndex(0, 0)) = Eigen::Vector3d(0.2, 0.25, 0);
+  links.positions.at(model.edfIndex(0, 1)) = Eigen::Vector3d(0.2, 0.15, 0);
+  std::vector<RotorOverlap> expected = legacyOverlaps(model, 2, links);
+  ASSERT_EQ(expected.size(), 2);
+  EXPECT_EQ(model.getOverlapName(expected.at(0)), "rotor1_left -> link2&inter_joint2");
+  expectSameOverlaps(model, expected, unpruned_model.update(links.positions, links.axes, links.normals));
+  expectSameOverlaps(model, expected, model.update(links.positions, links.axes, links.normals));
+
+  /* beyond the relax range */
+  links.positions.at(model.edfIndex(0, 0)) = Eigen::Vector3d(0.2, 0.35, 0);
+  expected = legacyOverlaps(model, 2, links);
+  ASSERT_EQ(expected.size(), 1);
+  EXPECT_EQ(model.getOverlapName(expected.at(0)), "rotor1_right -> link2&inter_joint2");
+  expectSameOverlaps(model, expected, model.update(links.positions, links.axes, links.normals));
+
+  /* j == 0: link2 is folded above link1, one edf of link2 is 0.05 m before the origin of link1.
+     the start of the first link keeps the strict bound of the previous implementation */
+  links = foldedLinks(model, -0.15, -0.2);
+  expected = legacyOverlaps(model, 2, links);
+  expectSameOverlaps(model, expected, unpruned_model.update(links.positions, links.axes, links.normals));
+  expectSameOverlaps(model, expected, model.update(links.positions, links.axes, links.normals));
+  ASSERT_EQ(expected.size(), 1);
+  EXPECT_EQ(model.getOverlapName(expected.at(0)), "rotor2_right -> link1");
+}
+
+TEST(RotorInterference, rotorPair)
+{
+  const double radius = 0.035;
+  const double tilt = 0.26;
+  EXPECT_FALSE(RotorInterference::rotorPairOverlap(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(0.2, 0, 0), radius, tilt));
+  EXPECT_TRUE(RotorInterference::rotorPairOverlap(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(0.06, 0, 0), radius, tilt));
+  EXPECT_TRUE(RotorInterference::rotorPairOverlap(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(0.2, 0, -0.6), radius, tilt)); // inside the cone
+
+  /* the dual rotor on the same link is skipped */
+  std::vector<Eigen::Vector3d> edfs = {{0, 0.05, 0}, {0, -0.05, 0}, {0.4, 0.05, 0}, {0.4, -0.05, 0}};
+  EXPECT_EQ(RotorInterference::findRotorPairOverlap(edfs, radius, tilt), std::make_pair(-1, -1));
+  edfs.at(3) = Eigen::Vector3d(0.02, 0.05, -0.1);
+  EXPECT_EQ(RotorInterference::findRotorPairOverlap(edfs, radius, tilt), std::make_pair(0, 3));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
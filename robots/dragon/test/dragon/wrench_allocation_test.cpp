@@ -0,0 +1,181 @@
+#include <dragon/control/wrench_allocation_qp.h>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+using namespace aerial_robot_control;
+
+namespace
+{
+  /* normalized allocation matrix of a planar quad (all links level), the force of each rotor in the link (= CoG) frame */
+  Eigen::MatrixXd quadQMat(const std::vector<int>& rotor_dims, double mass = 4.0, double inertia = 0.1)
+  {
+    const std::vector<Eigen::Vector3d> rotor_pos = {{0.3, 0.3, 0}, {-0.3, 0.3, 0}, {-0.3, -0.3, 0}, {0.3, -0.3, 0}};
+    Eigen::MatrixXd q_mat = Eigen::MatrixXd::Zero(6, std::accumulate(rotor_dims.begin(), rotor_dims.end(), 0));
+    int col = 0;
+    for(size_t i = 0; i < rotor_pos.size(); i++)
+      {
+        Eigen::MatrixXd wrench_map = Eigen::MatrixXd::Zero(6, 3);
+        wrench_map.topRows(3) = Eigen::Matrix3d::Identity() / mass;
+        Eigen::Matrix3d skew;
+        const Eigen::Vector3d& p = rotor_pos.at(i);
+        skew << 0, -p.z(), p.y(), p.z(), 0, -p.x(), -p.y(), p.x(), 0;
+        wrench_map.bottomRows(3) = skew / inertia;
+
+        if(rotor_dims.at(i) == 3)
+          {
+            q_mat.middleCols(col, 3) = wrench_map;
+          }
+        else
+          {
+            /* roll locked gimbal: (x, z) */
+            q_mat.col(col) = wrench_map.col(0);
+            q_mat.col(col + 1) = wrench_map.col(2);
+          }
+        col += rotor_dims.at(i);
+      }
+    return q_mat;
+  }
+
+  Eigen::VectorXd hoverWrench(double acc_z = 9.8)
+  {
+    Eigen::VectorXd b = Eigen::VectorXd::Zero(6);
+    b(2) = acc_z;
+    return b;
+  }
+
+  double rotorAngle(const Eigen::VectorXd& f1, const Eigen::VectorXd& f2)
+  {
+    return std::acos(std::min(1.0, f1.normalized().dot(f2.normalized())));
+  }
+}
+
+TEST(WrenchAllocationQP, unconstrainedMatchesLeastSquares)
+{
+  WrenchAllocationQPParams params;
+  params.effort_weight = 0;
+  params.tolerance = 1e-8;
+  params.relative_tolerance = 0;
+  params.max_iteration = 500;
+  WrenchAllocationQP qp(params);
+
+  const std::vector<int> dims(4, 3);
+  const Eigen::MatrixXd q_mat = quadQMat(dims);
+  Eigen::VectorXd b = hoverWrench();
+  b(0) = 0.5; b(4) = 0.3; b(5) = -0.2;
+
+  Eigen::VectorXd f;
+  EXPECT_TRUE(qp.solve(q_mat, b, dims, 0, f));
+  EXPECT_LT((q_mat * f - b).norm(), 1e-5);
+
+  /* minimum norm solution */
+  const Eigen::VectorXd f_pinv = q_mat.completeOrthogonalDecomposition().solve(b);
+  EXPECT_LT((f - f_pinv).norm(), 1e-4);
+}
+
+TEST(WrenchAllocationQP, thrustUpperBound)
+{
+  WrenchAllocationQPParams params;
+  params.thrust_max = 8.0; // hovering needs 9.8 N per rotor
+  params.max_iteration = 200;
+  WrenchAllocationQP qp(params);
+
+  const std::vector<int> dims(4, 3);
+  const Eigen::MatrixXd q_mat = quadQMat(dims);
+  Eigen::VectorXd f;
+  qp.solve(q_mat, hoverWrench(), dims, 0, f);
+
+  for(int i = 0; i < 4; i++) EXPECT_LE(f.segment(3 * i, 3).norm(), params.thrust_max + 1e-6);
+  EXPECT_GT(qp.getStats().wrench_error, 1.0); // visible wrench error from the saturation
+  EXPECT_EQ(qp.getStats().saturated_rotors, 4);
+}
+
+TEST(WrenchAllocationQP, gimbalAngleAndRateLimit)
+{
+  WrenchAllocationQPParams params;
+  params.gimbal_max_angle = 0.3;
+  params.gimbal_max_rate = 2.0;
+  params.max_iteration = 200;
+  WrenchAllocationQP qp(params);
+
+  const std::vector<int> dims(4, 3);
+  const Eigen::MatrixXd q_mat = quadQMat(dims);
+  const double dt = 0.025;
+
+  Eigen::VectorXd prev_f;
+  qp.solve(q_mat, hoverWrench(), dims, dt, prev_f);
+
+  /* sudden large lateral acceleration */
+  Eigen::VectorXd b = hoverWrench();
+  b(0) = 8.0;
+  for(int k = 0; k < 20; k++)
+    {
+      Eigen::VectorXd f;
+      qp.solve(q_mat, b, dims, dt, f);
+      for(int i = 0; i < 4; i++)
+        {
+          const Eigen::Vector3d f_i = f.segment(3 * i, 3);
+          EXPECT_LE(rotorAngle(f_i, Eigen::Vector3d::UnitZ()), params.gimbal_max_angle + 1e-3);
+          EXPECT_LE(rotorAngle(f_i, prev_f.segment(3 * i, 3)), params.gimbal_max_rate * dt + 1e-3);
+        }
+      prev_f = f;
+    }
+
+  /* finally reach the angle limit */
+  EXPECT_NEAR(rotorAngle(prev_f.segment(0, 3), Eigen::Vector3d::UnitZ()), params.gimbal_max_angle, 1e-2);
+}
+
+TEST(WrenchAllocationQP, rollLockedGimbal)
+{
+  WrenchAllocationQPParams params;
+  params.effort_weight = 0;
+  params.tolerance = 1e-6;
+  params.relative_tolerance = 0;
+  params.max_iteration = 500;
+  WrenchAllocationQP qp(params);
+
+  const std::vector<int> dims = {3, 2, 3, 2};
+  const Eigen::MatrixXd q_mat = quadQMat(dims);
+  Eigen::VectorXd b = hoverWrench();
+  b(0) = 0.5;
+  b(1) = 0.5;
+
+  Eigen::VectorXd f;
+  EXPECT_TRUE(qp.solve(q_mat, b, dims, 0, f));
+  EXPECT_EQ(f.size(), 10);
+  EXPECT_LT(qp.getStats().wrench_error, 1e-3);
+}
+
+TEST(WrenchAllocationQP, warmStart)
+{
+  WrenchAllocationQPParams params;
+  params.thrust_max = 9.0;
+  params.max_iteration = 500;
+  WrenchAllocationQP qp(params);
+
+  const std::vector<int> dims(4, 3);
+  const Eigen::MatrixXd q_mat = quadQMat(dims);
+  Eigen::VectorXd b = hoverWrench();
+  b(3) = 1.0;
+
+  Eigen::VectorXd f;
+  qp.solve(q_mat, b, dims, 0, f);
+  EXPECT_FALSE(qp.getStats().warm_started);
+  const int cold_iterations = qp.getStats().iterations;
+
+  qp.solve(q_mat, b, dims, 0, f);
+  EXPECT_TRUE(qp.getStats().warm_started);
+  EXPECT_LT(qp.getStats().iterations, cold_iterations);
+
+  /* the dimension changes by the gimbal roll lock */
+  const std::vector<int> locked_dims = {3, 2, 3, 3};
+  qp.solve(quadQMat(locked_dims), b, locked_dims, 0, f);
+  EXPECT_FALSE(qp.getStats().warm_started);
+  EXPECT_EQ(f.size(), 11);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -56,6 +56,7 @@ public:
   virtual void calcStaticThrust() override;
 
   inline const uint8_t getWrenchDof() const { return wrench_dof_; }
+  inline const bool getEarlyReject() const { return early_reject_; }
   inline const double getRollPitchPositionMargin() const { return rp_position_margin_; }
   inline const double getRollPitchPositionMarginThresh() const { return rp_position_margin_thre_; }
   inline const double getWrenchMatDeterminant() const { return wrench_mat_det_; }
@@ -69,6 +70,8 @@ public:
   bool rollPitchPositionMarginCheck(); // deprecated
 
   inline void setWrenchDof(uint8_t dof) { wrench_dof_ = dof; }
+  // only for the feasibility (e.g., planner): skip the deprecated margins and stop at the first infeasible rotor
+  inline void setEarlyReject(bool early_reject) { early_reject_ = early_reject; }
   virtual bool stabilityCheck(bool verbose = true) override;
 
   virtual void updateJacobians(const KDL::JntArray& joint_positions, bool update_model = true) override;
@@ -79,6 +82,7 @@ private:
 
   // private attributes
   int wrench_dof_;
+  bool early_reject_;
 
   Eigen::VectorXd approx_fc_rp_dists_;
   Eigen::VectorXd fc_rp_dists_;
@@ -86,6 +90,11 @@ private:
   double fc_rp_min_thre_;
   Eigen::MatrixXd fc_rp_dists_jacobian_;
 
+  // buffers for the roll/pitch margins, reused to avoid the reallocation
+  Eigen::Matrix2Xd v_xy_; // xy component of the torque vector of each rotor
+  Eigen::MatrixXd v_xy_jacobian_; // stacked jacobian of v_xy_
+  Eigen::MatrixXd fc_rp_dists_coeff_; // fc_rp_dists_jacobian_ = fc_rp_dists_coeff_ * v_xy_jacobian_
+
   // following variables will be replaced by fc_t_min, fc_f_min in the furture
   double wrench_mat_det_;
   double wrench_mat_det_thre_;
@@ -5,7 +5,10 @@ using namespace aerial_robot_model::transformable;
 HydrusRobotModel::HydrusRobotModel(bool init_with_rosparam, bool verbose, double fc_t_min_thre, double fc_rp_min_thre, double epsilon, int wrench_dof):
   RobotModel(init_with_rosparam, verbose, 0, fc_t_min_thre, epsilon),
   fc_rp_min_thre_(fc_rp_min_thre),
-  wrench_dof_(wrench_dof)
+  wrench_dof_(wrench_dof),
+  early_reject_(false),
+  wrench_mat_det_(0),
+  rp_position_margin_(0)
 {
   if (init_with_rosparam)
     {
@@ -24,29 +27,78 @@ HydrusRobotModel::HydrusRobotModel(bool init_with_rosparam, bool verbose, double
 
 void HydrusRobotModel::calcFeasibleControlRollPitchDists()
 {
-  /* only consider Moment for roll and pitch */
+  /*
+    single pass over the rotors for all of the roll/pitch margins:
+    1. the feasible control roll/pitch distances (only consider moment for roll and pitch)
+    2. (deprecated) the position margin of rotors and the determinant of the normalized wrench matrix
+  */
   const int rotor_num = getRotorNum();
   const double thrust_max = getThrustUpperLimit();
+  const double m_f_rate = getMFRate();
+  const auto& sigma = getRotorDirection();
+  const std::vector<KDL::Vector>& p = getRotorsOriginFromCogCache(); // updated just before in updateRobotModelImpl()
+  const std::vector<KDL::Vector>& u = getRotorsNormalFromCogCache();
+
+  const double mass_inv = 1 / getMass();
+  const Eigen::Matrix3d inertia_inv = getInertia<Eigen::Matrix3d>().inverse();
+  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6> wrench_mat_gram = Eigen::MatrixXd::Zero(wrench_dof_, wrench_dof_);
+  Eigen::Matrix<double, 6, 1> wrench;
+  Eigen::Vector2d p_sum = Eigen::Vector2d::Zero();
+  Eigen::Matrix2d p_square_sum = Eigen::Matrix2d::Zero();
+
+  v_xy_.resize(2, rotor_num);
+  for (int i = 0; i < rotor_num; ++i) {
+    const Eigen::Vector3d p_i = aerial_robot_model::kdlToEigen(p.at(i));
+    const Eigen::Vector3d u_i = aerial_robot_model::kdlToEigen(u.at(i));
+    const Eigen::Vector3d v = p_i.cross(u_i) + m_f_rate * sigma.at(i + 1) * u_i;
+    v_xy_.col(i) = v.head<2>();
+
+    if(early_reject_) continue;
 
-  auto v = calcV();
+    const Eigen::Vector2d p_xy = p_i.head<2>();
+    p_sum += p_xy;
+    p_square_sum += p_xy * p_xy.transpose();
+
+    // column of the normalized wrench matrix on CoG, Q Q^T is accumulated
+    wrench.head<3>() = u_i * mass_inv;
+    wrench.tail<3>() = inertia_inv * v;
+    wrench_mat_gram.noalias() += wrench.segment(2, wrench_dof_) * wrench.segment(2, wrench_dof_).transpose();
+  }
 
-  for (auto& v_i: v) v_i.z() = 0;
+  if(!early_reject_)
+    {
+      // the smaller eigen value of the covariance of the rotor positions in closed form
+      const Eigen::Vector2d p_mean = p_sum / rotor_num;
+      const Eigen::Matrix2d s = p_square_sum / rotor_num - p_mean * p_mean.transpose();
+      const double s_mean = (s(0, 0) + s(1, 1)) / 2;
+      const double s_diff = (s(0, 0) - s(1, 1)) / 2;
+      const double s_min = s_mean - std::sqrt(s_diff * s_diff + s(0, 1) * s(0, 1));
+      rp_position_margin_ = std::sqrt(std::max(s_min, 0.0)) / getLinkLength();
+
+      wrench_mat_det_ = wrench_mat_gram.determinant();
+    }
+  else
+    {
+      // not evaluated: the values of the deprecated checks are invalid, rather than the ones of the last joint angles
+      rp_position_margin_ = 0;
+      wrench_mat_det_ = 0;
+    }
 
+  fc_rp_min_ = std::numeric_limits<double>::max();
   for (int i = 0; i < rotor_num; ++i) {
+    const Eigen::Vector2d v_i_normalized = v_xy_.col(i).normalized();
     double t_min_i = 0.0;
-    auto v_i_normalized = v.at(i).normalized();
     for (int j = 0; j < rotor_num; ++j) {
       if (i == j) continue;
-      double cross_product = (v.at(j).cross(v_i_normalized)).z();
+      double cross_product = v_xy_(0, j) * v_i_normalized(1) - v_xy_(1, j) * v_i_normalized(0); // z of v_j x v_i_normalized
 
       t_min_i += std::max(0.0, cross_product * thrust_max);
-      //ROS_INFO("i: %d, j: %d, cross_product: %f, t_min_ij: %f" , i, j, cross_product, std::max(0.0, cross_product * thrust_max));
     }
     fc_rp_dists_(i) = t_min_i;
-  }
+    fc_rp_min_ = std::min(fc_rp_min_, t_min_i);
 
-  //  ROS_INFO_STREAM("fc_rp_distsj_: " << fc_rp_distsj_.transpose());
-  fc_rp_min_ = fc_rp_dists_.minCoeff();
+    if(early_reject_ && fc_rp_min_ < fc_rp_min_thre_) break; // infeasible, the remaining distances are not updated
+  }
 }
 
 void HydrusRobotModel::calcFeasibleControlRollPitchDistsJacobian()
@@ -65,40 +117,57 @@ void HydrusRobotModel::calcFeasibleControlRollPitchDistsJacobian()
   const auto& p_jacobians = getPJacobians();
   const double epsilon = getEpsilon();
 
-  fc_rp_dists_jacobian_.resize(rotor_num, 6 + joint_num);
-
-  auto v = calcV();
-  for (auto& v_i: v) v_i.z() = 0; // 2D
-
-  std::vector<Eigen::MatrixXd> v_jacobians;
+  /*
+    only the xy components of v are relevant (2D), thus only two rows of the jacobian of v = p x u + m_f_rate * sigma * u
+    are calculated from the rows of the jacobians of p and u, instead of the full skew products.
+  */
+  v_xy_.resize(2, rotor_num);
+  v_xy_jacobian_.resize(2 * rotor_num, ndof);
   for (int i = 0; i < rotor_num; ++i) {
-    v_jacobians.push_back(-skew(u.at(i)) * p_jacobians.at(i) + skew(p.at(i)) * u_jacobians.at(i) + m_f_rate * sigma.at(i + 1) * u_jacobians.at(i));
-    v_jacobians.back().row(2).setZero(); // 2D
+    const Eigen::Vector3d& p_i = p.at(i);
+    const Eigen::Vector3d& u_i = u.at(i);
+    const Eigen::MatrixXd& d_p_i = p_jacobians.at(i);
+    const Eigen::MatrixXd& d_u_i = u_jacobians.at(i);
+    const double k = m_f_rate * sigma.at(i + 1);
+
+    v_xy_.col(i) = (p_i.cross(u_i) + k * u_i).head<2>();
+    v_xy_jacobian_.row(2 * i) = u_i.z() * d_p_i.row(1) - u_i.y() * d_p_i.row(2) - p_i.z() * d_u_i.row(1) + p_i.y() * d_u_i.row(2) + k * d_u_i.row(0);
+    v_xy_jacobian_.row(2 * i + 1) = - u_i.z() * d_p_i.row(0) + u_i.x() * d_p_i.row(2) + p_i.z() * d_u_i.row(0) - p_i.x() * d_u_i.row(2) + k * d_u_i.row(1);
   }
 
+  /*
+    d(v_j x n_i)_z = [n_i_y, -n_i_x] d_v_j + [-v_j_y, v_j_x] d_n_i,
+    d_n_i = (I - n_i n_i^T) / |v_i| d_v_i
+    so the jacobian of each distance is a linear combination of d_v, and the coefficients are accumulated in one pass.
+  */
+  fc_rp_dists_coeff_.setZero(rotor_num, 2 * rotor_num);
   for (int i = 0; i < rotor_num; ++i)
     {
-      const Eigen::Vector3d& v_i = v.at(i);
-      const Eigen::Vector3d v_i_normalized = v.at(i).normalized();
-      const Eigen::MatrixXd& d_v_i = v_jacobians.at(i);
+      const Eigen::Vector2d v_i = v_xy_.col(i);
+      const Eigen::Vector2d v_i_normalized = v_i.normalized();
 
       double approx_dist = 0.0;
-      Eigen::MatrixXd d_dist = Eigen::MatrixXd::Zero(1, ndof);
+      Eigen::Vector2d d_n_i_coeff = Eigen::Vector2d::Zero();
       for (int j = 0; j < rotor_num; ++j)
         {
           if (i == j) continue;
 
-          const Eigen::Vector3d& v_j = v.at(j);
-          const Eigen::MatrixXd& d_v_j = v_jacobians.at(j);
-          const double v_cross_product = (v_j.cross(v_i_normalized)).z();
-          Eigen::MatrixXd d_v_cross_product = -skew(v_i_normalized) * d_v_j + skew(v_j) * (1 / v_i.norm() * d_v_i - v_i_normalized / v_i.squaredNorm() * v_i.transpose() * d_v_i);
+          const Eigen::Vector2d v_j = v_xy_.col(j);
+          const double v_cross_product = v_j.x() * v_i_normalized.y() - v_j.y() * v_i_normalized.x();
+          const double weight = sigmoid(v_cross_product * thrust_max, epsilon) * thrust_max;
           approx_dist += reluApprox(v_cross_product * thrust_max, epsilon);
-          d_dist += sigmoid(v_cross_product * thrust_max, epsilon) * d_v_cross_product.row(2) * thrust_max;
+
+          fc_rp_dists_coeff_(i, 2 * j) += weight * v_i_normalized.y();
+          fc_rp_dists_coeff_(i, 2 * j + 1) -= weight * v_i_normalized.x();
+          d_n_i_coeff += weight * Eigen::Vector2d(-v_j.y(), v_j.x());
         } //j
 
+      fc_rp_dists_coeff_.block(i, 2 * i, 1, 2) += ((Eigen::Matrix2d::Identity() - v_i_normalized * v_i_normalized.transpose()) * d_n_i_coeff / v_i.norm()).transpose();
       approx_fc_rp_dists_(i) = approx_dist;
-      fc_rp_dists_jacobian_.row(i) = d_dist;
     } //i
+
+  fc_rp_dists_jacobian_.resize(rotor_num, ndof);
+  fc_rp_dists_jacobian_.noalias() = fc_rp_dists_coeff_ * v_xy_jacobian_;
 }
 
 void HydrusRobotModel::calcWrenchMatrixOnRoot()
@@ -133,36 +202,7 @@ void HydrusRobotModel::getParamFromRos()
 bool HydrusRobotModel::rollPitchPositionMarginCheck()
 {
   // TODO: depreacated
-  /* calcuate the average */
-  double average_x = 0, average_y = 0;
-  const std::vector<Eigen::Vector3d> rotors_origin_from_cog = getRotorsOriginFromCog<Eigen::Vector3d>();
-  const int rotor_num = getRotorNum();
-
-  for(int i = 0; i < rotor_num; i++)
-    {
-      average_x += rotors_origin_from_cog.at(i)(0);
-      average_y += rotors_origin_from_cog.at(i)(1);
-      ROS_DEBUG("rotor%d x: %f, y: %f", i + 1, rotors_origin_from_cog.at(i)(0), rotors_origin_from_cog.at(i)(1));
-    }
-  average_x /= rotor_num;
-  average_y /= rotor_num;
-
-  double s_xy = 0, s_xx = 0, s_yy = 0;
-  for(const auto& rotor_pos : rotors_origin_from_cog)
-    {
-      double x_diff = rotor_pos(0) - average_x;
-      double y_diff = rotor_pos(1) - average_y;
-      s_xy += (x_diff * y_diff);
-      s_xx += (x_diff * x_diff);
-      s_yy += (y_diff * y_diff);
-    }
-
-  Eigen::Matrix2d S;
-  S << s_xx / rotor_num, s_xy / rotor_num, s_xy / rotor_num, s_yy / rotor_num;
-  Eigen::SelfAdjointEigenSolver<Eigen::Matrix2d> es(S);
-
-  rp_position_margin_ = sqrt(es.eigenvalues()[0]) / getLinkLength();
-
+  // rp_position_margin_ is updated in calcFeasibleControlRollPitchDists()
   if(rp_position_margin_ < rp_position_margin_thre_)
     {
       ROS_WARN("Invalid old control margin against threshold: %f vs %f", rp_position_margin_, rp_position_margin_thre_);
@@ -181,6 +221,8 @@ bool HydrusRobotModel::stabilityCheck(bool verbose)
       return false;
     }
 
+  if(early_reject_) return true;
+
   // deprecated statbility check method
   rollPitchPositionMarginCheck();
   wrenchMatrixDeterminantCheck();
@@ -208,14 +250,7 @@ void HydrusRobotModel::updateJacobians(const KDL::JntArray& joint_positions, boo
 bool HydrusRobotModel::wrenchMatrixDeterminantCheck()
 {
   /* Wrench matrix determinant, should use wrench on CoG */
-  Eigen::MatrixXd wrench_mat = calcWrenchMatrixOnCoG();
-
-  // normalized
-  wrench_mat.topRows(3) = wrench_mat.topRows(3) / getMass();
-  wrench_mat.bottomRows(3) = getInertia<Eigen::Matrix3d>().inverse() *  wrench_mat.bottomRows(3);
-  Eigen::MatrixXd valid_wrench_mat = wrench_mat.middleRows(2, wrench_dof_);
-  wrench_mat_det_ = (valid_wrench_mat * valid_wrench_mat.transpose()).determinant();
-
+  // wrench_mat_det_ is updated in calcFeasibleControlRollPitchDists()
   if(wrench_mat_det_ < wrench_mat_det_thre_)
     {
       ROS_WARN("Invalid wrench matrix determinant against threshold: %f vs %f", wrench_mat_det_, wrench_mat_det_thre_);
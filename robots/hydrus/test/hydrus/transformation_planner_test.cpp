@@ -0,0 +1,121 @@
+#include <aerial_robot_model/model/transformation_planner.h>
+#include <hydrus/hydrus_robot_model.h>
+#include <gtest/gtest.h>
+
+using namespace aerial_robot_model::transformable;
+
+class TransformationPlannerTest : public testing::Test
+{
+protected:
+  boost::shared_ptr<HydrusRobotModel> robot_model_;
+  KDL::JntArray start_;
+
+  virtual void SetUp()
+  {
+    ::testing::Test::SetUp();
+
+    robot_model_ = boost::make_shared<HydrusRobotModel>(true);
+
+    /* square form */
+    start_.resize(robot_model_->getJointNum());
+    start_.data.setZero();
+    for(const auto index: robot_model_->getLinkJointIndices()) start_(index) = M_PI / 2;
+  }
+
+  Eigen::VectorXd linkJointAngles(const KDL::JntArray& joint_positions)
+  {
+    const auto& indices = robot_model_->getLinkJointIndices();
+    Eigen::VectorXd angles(indices.size());
+    for(int i = 0; i < indices.size(); i++) angles(i) = joint_positions(indices.at(i));
+    return angles;
+  }
+};
+
+TEST_F(TransformationPlannerTest, Converge)
+{
+  TransformationPlanner planner(robot_model_);
+  const auto& params = planner.getParams();
+
+  Eigen::VectorXd goal = linkJointAngles(start_);
+  goal(1) = 1.2;
+  ASSERT_TRUE(planner.plan(start_, goal));
+
+  const auto& stats = planner.getStats();
+  EXPECT_TRUE(stats.feasible);
+  EXPECT_LT(stats.iterations, params.max_iteration);
+  EXPECT_GE(stats.min_fc_t_margin, 0);
+  EXPECT_GE(stats.min_thrust_margin, 0);
+
+  /* both ends, the joint limits and the velocity limits in urdf (0.5 rad/s) */
+  const auto& trajectory = planner.getTrajectory();
+  ASSERT_GE(trajectory.positions.size(), 2);
+  EXPECT_LT((trajectory.positions.front() - linkJointAngles(start_)).norm(), 1e-9);
+  EXPECT_LT((trajectory.positions.back() - goal).norm(), 1e-9);
+  for(int k = 0; k < trajectory.positions.size(); k++)
+    {
+      for(int i = 0; i < goal.size(); i++)
+        {
+          EXPECT_GE(trajectory.positions.at(k)(i), robot_model_->getLinkJointLowerLimits().at(i));
+          EXPECT_LE(trajectory.positions.at(k)(i), robot_model_->getLinkJointUpperLimits().at(i));
+        }
+      if(k == 0) continue;
+
+      const double du = trajectory.times.at(k) - trajectory.times.at(k - 1);
+      ASSERT_GT(du, 0);
+      EXPECT_LE((trajectory.positions.at(k) - trajectory.positions.at(k - 1)).cwiseAbs().maxCoeff() / du, 0.5 * params.joint_vel_rate + 1e-9);
+    }
+
+  /* interpolation into a preallocated buffer */
+  Eigen::VectorXd positions(goal.size());
+  for(const double t: {-1.0, 0.3 * trajectory.getDuration(), trajectory.getDuration() + 1.0})
+    {
+      trajectory.getPositions(t, positions);
+      EXPECT_LT((positions - trajectory.getPositions(t)).norm(), 1e-12);
+    }
+}
+
+TEST_F(TransformationPlannerTest, GoalOutOfJointLimits)
+{
+  TransformationPlanner planner(robot_model_);
+
+  Eigen::VectorXd goal = linkJointAngles(start_);
+  goal(0) = robot_model_->getLinkJointUpperLimits().at(0) + 0.1;
+  EXPECT_FALSE(planner.plan(start_, goal));
+  EXPECT_TRUE(planner.getTrajectory().empty());
+
+  EXPECT_FALSE(planner.plan(start_, Eigen::VectorXd::Zero(goal.size() + 1)));
+}
+
+TEST_F(TransformationPlannerTest, RejectInfeasiblePath)
+{
+  /* the feasible control torque threshold above the margin of any form */
+  robot_model_->setFeasibleControlTMinThre(1e3);
+  TransformationPlanner planner(robot_model_);
+
+  Eigen::VectorXd goal = linkJointAngles(start_);
+  goal(1) = 1.2;
+  EXPECT_FALSE(planner.plan(start_, goal));
+  EXPECT_FALSE(planner.getStats().feasible);
+  EXPECT_LT(planner.getStats().min_fc_t_margin, 0);
+  EXPECT_TRUE(planner.getTrajectory().empty());
+}
+
+TEST_F(TransformationPlannerTest, RejectJointTorqueLimit)
+{
+  /* no usable effort of the joints */
+  TransformationPlannerParams params;
+  params.joint_torque_rate = 0;
+  TransformationPlanner planner(robot_model_, params);
+
+  Eigen::VectorXd goal = linkJointAngles(start_);
+  goal(1) = 1.2;
+  EXPECT_FALSE(planner.plan(start_, goal));
+  EXPECT_LT(planner.getStats().min_joint_torque_margin, 0);
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "transformation_planner_test");
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
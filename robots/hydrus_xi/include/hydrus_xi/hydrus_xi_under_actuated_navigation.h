@@ -37,15 +37,36 @@
 
 #include <aerial_robot_control/flight_navigation.h>
 #include <algorithm>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include <hydrus/hydrus_tilted_robot_model.h>
 #include <nlopt.hpp>
 #include <OsqpEigen/OsqpEigen.h>
+#include <random>
 
 namespace aerial_robot_navigation
 {
   class HydrusXiUnderActuatedNavigator : public BaseNavigator
   {
   public:
+    /* one start of the vectoring planner: the objective and constraints are evaluated on its own robot model and LP solver, so the starts can run concurrently */
+    struct PlanContext
+    {
+      HydrusXiUnderActuatedNavigator* planner;
+      boost::shared_ptr<HydrusTiltedRobotModel> robot_model;
+      OsqpEigen::Solver yaw_range_lp_solver;
+      boost::shared_ptr<nlopt::opt> nl_solver;
+      KDL::JntArray joint_positions;
+      double max_min_yaw = 0;
+      int cnt = 0;
+      int invalid_cnt = 0;
+      std::mt19937 random_engine;
+
+      // result of the last optimization
+      std::vector<double> x;
+      double f = 0;
+      bool feasible = false;
+    };
+
     HydrusXiUnderActuatedNavigator();
     ~HydrusXiUnderActuatedNavigator();
 
@@ -55,7 +76,7 @@ namespace aerial_robot_navigation
                     double loop_du) override;
 
     inline boost::shared_ptr<HydrusTiltedRobotModel> getRobotModelForPlan() { return robot_model_for_plan_;}
-    inline OsqpEigen::Solver& getYawRangeLPSolver() { return yaw_range_lp_solver_;}
+    inline OsqpEigen::Solver& getYawRangeLPSolver() { return plan_contexts_.at(0)->yaw_range_lp_solver;}
 
     inline KDL::JntArray& getJointPositionsForPlan()  {return joint_positions_for_plan_;}
     inline const double& getMaxMinYaw() const { return max_min_yaw_;}
@@ -76,9 +97,8 @@ namespace aerial_robot_navigation
   private:
     ros::Publisher gimbal_ctrl_pub_;
     std::thread plan_thread_;
-    boost::shared_ptr<HydrusTiltedRobotModel> robot_model_for_plan_;
-    OsqpEigen::Solver yaw_range_lp_solver_;
-    boost::shared_ptr<nlopt::opt> vectoring_nl_solver_;
+    boost::shared_ptr<HydrusTiltedRobotModel> robot_model_for_plan_; // model of the first context
+    std::vector<boost::shared_ptr<PlanContext> > plan_contexts_;
 
     KDL::JntArray joint_positions_for_plan_;
     std::vector<std::string> control_gimbal_names_;
@@ -95,10 +115,29 @@ namespace aerial_robot_navigation
     double fc_t_min_thresh_; // constraint func
     double gimbal_delta_angle_; // configuration state
 
+    /* multi-start: the first start is warm-started from the last solution, the second one is extrapolated along the joint trajectory, and the others are random */
+    int plan_starts_;
+    double plan_ftol_; // stop the start if the improvement is below this
+    double plan_max_time_; // time budget of one start [sec]
+    double plan_switch_thresh_; // min improvement to leave the warm-started solution
+    double plan_stats_rate_;
+
     std::vector<double> opt_gimbal_angles_, prev_opt_gimbal_angles_;
+    KDL::JntArray opt_joint_positions_, prev_opt_joint_positions_; // joint positions of the solutions
+
+    /* statistics */
+    ros::Publisher plan_stats_pub_;
+    ros::WallTime plan_stats_stamp_;
+    int plan_cnt_, plan_fail_cnt_, plan_switch_cnt_;
+    long plan_eval_cnt_;
+    double plan_time_sum_, plan_time_max_;
+    double plan_improvement_sum_, plan_improvement_max_;
 
     void threadFunc();
     bool plan();
+    void initPlanContext(PlanContext& context);
+    void solve(PlanContext& context, std::vector<double> x0, const std::vector<double>& lb, const std::vector<double>& ub);
+    void publishPlanStats(double objective);
 
     void rosParamInit() override;
   };
@@ -4,16 +4,19 @@ using namespace aerial_robot_navigation;
 
 namespace
 {
-  int cnt = 0;
-  int invalid_cnt = 0;
+  using PlanContext = HydrusXiUnderActuatedNavigator::PlanContext;
 
-  double maximizeFCTMin(const std::vector<double> &x, std::vector<double> &grad, void *planner_ptr)
+  const double feasibility_tol = 1e-4; // constraint violation allowed for the result of COBYLA
+
+  double maximizeFCTMin(const std::vector<double> &x, std::vector<double> &grad, void *context_ptr)
   {
-    cnt++;
-    HydrusXiUnderActuatedNavigator *planner = reinterpret_cast<HydrusXiUnderActuatedNavigator*>(planner_ptr);
-    auto robot_model = planner->getRobotModelForPlan();
+    PlanContext *context = reinterpret_cast<PlanContext*>(context_ptr);
+    HydrusXiUnderActuatedNavigator *planner = context->planner;
+    auto robot_model = context->robot_model;
+    context->cnt++;
+    int& invalid_cnt = context->invalid_cnt;
     /* update robot model */
-    KDL::JntArray joint_positions = planner->getJointPositionsForPlan();
+    KDL::JntArray& joint_positions = context->joint_positions;
     for(int i = 0; i < x.size(); i++)
       joint_positions(planner->getControlIndices().at(i)) = x.at(i);
 
@@ -42,14 +45,16 @@ namespace
     return planner->getForceNormWeight() * robot_model->getMass() / force_v.norm()  + planner->getForceVariantWeight() / variant + planner->getFCTMinWeight() * robot_model->getFeasibleControlTMin();
   }
 
-  double maximizeMinYawTorque(const std::vector<double> &x, std::vector<double> &grad, void *planner_ptr)
+  double maximizeMinYawTorque(const std::vector<double> &x, std::vector<double> &grad, void *context_ptr)
   {
-    cnt++;
-    HydrusXiUnderActuatedNavigator *planner = reinterpret_cast<HydrusXiUnderActuatedNavigator*>(planner_ptr);
-    auto robot_model = planner->getRobotModelForPlan();
+    PlanContext *context = reinterpret_cast<PlanContext*>(context_ptr);
+    HydrusXiUnderActuatedNavigator *planner = context->planner;
+    auto robot_model = context->robot_model;
+    context->cnt++;
+    int& invalid_cnt = context->invalid_cnt;
 
     /* update robot model */
-    KDL::JntArray joint_positions = planner->getJointPositionsForPlan();
+    KDL::JntArray& joint_positions = context->joint_positions;
     for(int i = 0; i < x.size(); i++)
       joint_positions(planner->getControlIndices().at(i)) = x.at(i);
 
@@ -73,15 +78,15 @@ namespace
         //std::cout << "yaw torque map: " << gradient.transpose() << std::endl;
 
         /* get min u and min yaw */
-        planner->getYawRangeLPSolver().updateGradient(gradient);
-        if(!planner->getYawRangeLPSolver().solve())
+        context->yaw_range_lp_solver.updateGradient(gradient);
+        if(!context->yaw_range_lp_solver.solve())
           {
             ROS_ERROR("cat not calcualte the min u by LP");
-            planner->setMaxMinYaw(0);
+            context->max_min_yaw = 0;
           }
         else
           {
-            min_u = planner->getYawRangeLPSolver().getSolution();
+            min_u = context->yaw_range_lp_solver.getSolution();
             //std::cout << "min_u: " << min_u.transpose() << std::endl;
             min_yaw = (gradient.transpose() * min_u)(0);
             if(min_yaw > 0)
@@ -93,20 +98,20 @@ namespace
 
         /* get max u and max yaw */
         Eigen::VectorXd reverse_gradient = - gradient;
-        planner->getYawRangeLPSolver().updateGradient(reverse_gradient);
-        if(!planner->getYawRangeLPSolver().solve())
+        context->yaw_range_lp_solver.updateGradient(reverse_gradient);
+        if(!context->yaw_range_lp_solver.solve())
           {
             ROS_ERROR("cat not calcualte the max u by LP");
-            planner->setMaxMinYaw(0);
+            context->max_min_yaw = 0;
           }
         else
           {
-            max_u = planner->getYawRangeLPSolver().getSolution();
+            max_u = context->yaw_range_lp_solver.getSolution();
             max_yaw = (gradient.transpose() * max_u)(0);
           }
 
         //ROS_INFO("LP: max: %f, min: %f", max_yaw, min_yaw); //debug
-        planner->setMaxMinYaw(std::min(max_yaw, -min_yaw));
+        context->max_min_yaw = std::min(max_yaw, -min_yaw);
       }
 
     Eigen::VectorXd force_v = robot_model->getStaticThrust();
@@ -118,13 +123,14 @@ namespace
 
     variant = sqrt(variant / force_v.size());
 
-    return planner->getForceNormWeight() * robot_model->getMass() / force_v.norm()  + planner->getForceVariantWeight() / variant + planner->getYawTorqueWeight() * planner->getMaxMinYaw();
+    return planner->getForceNormWeight() * robot_model->getMass() / force_v.norm()  + planner->getForceVariantWeight() / variant + planner->getYawTorqueWeight() * context->max_min_yaw;
   }
 
-  double baselinkRotConstraint(const std::vector<double> &x, std::vector<double> &grad, void *planner_ptr)
+  double baselinkRotConstraint(const std::vector<double> &x, std::vector<double> &grad, void *context_ptr)
   {
-    HydrusXiUnderActuatedNavigator *planner = reinterpret_cast<HydrusXiUnderActuatedNavigator*>(planner_ptr);
-    auto baselink_rot = planner->getRobotModelForPlan()->getCogDesireOrientation<Eigen::Matrix3d>();
+    PlanContext *context = reinterpret_cast<PlanContext*>(context_ptr);
+    HydrusXiUnderActuatedNavigator *planner = context->planner;
+    auto baselink_rot = context->robot_model->getCogDesireOrientation<Eigen::Matrix3d>();
 
     double ez_x = baselink_rot(0,2);
     double ez_y = baselink_rot(1,2);
@@ -135,10 +141,10 @@ namespace
   }
 
 
-  double fcTMinConstraint(const std::vector<double> &x, std::vector<double> &grad, void *planner_ptr)
+  double fcTMinConstraint(const std::vector<double> &x, std::vector<double> &grad, void *context_ptr)
   {
-    HydrusXiUnderActuatedNavigator *planner = reinterpret_cast<HydrusXiUnderActuatedNavigator*>(planner_ptr);
-    return planner->getFCTMinThresh() - planner->getRobotModelForPlan()->getFeasibleControlTMin();
+    PlanContext *context = reinterpret_cast<PlanContext*>(context_ptr);
+    return context->planner->getFCTMinThresh() - context->robot_model->getFeasibleControlTMin();
   }
 
 };
@@ -148,7 +154,10 @@ HydrusXiUnderActuatedNavigator::HydrusXiUnderActuatedNavigator():
     prev_opt_gimbal_angles_(0),
     max_min_yaw_(0),
     control_gimbal_names_(0),
-    control_gimbal_indices_(0)
+    control_gimbal_indices_(0),
+    plan_cnt_(0), plan_fail_cnt_(0), plan_switch_cnt_(0), plan_eval_cnt_(0),
+    plan_time_sum_(0), plan_time_max_(0),
+    plan_improvement_sum_(0), plan_improvement_max_(0)
 {
 }
 
@@ -164,11 +173,10 @@ void HydrusXiUnderActuatedNavigator::initialize(ros::NodeHandle nh, ros::NodeHan
 {
   BaseNavigator::initialize(nh, nhp, robot_model, estimator, loop_du);
 
-  robot_model_for_plan_ = boost::make_shared<HydrusTiltedRobotModel>(); // for planning, not the real robot model
-
   rosParamInit();
 
   gimbal_ctrl_pub_ = nh_.advertise<sensor_msgs::JointState>("gimbals_ctrl", 1);
+  plan_stats_pub_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", 1);
 
   if(nh.hasParam("control_gimbal_names"))
     {
@@ -187,30 +195,52 @@ void HydrusXiUnderActuatedNavigator::initialize(ros::NodeHandle nh, ros::NodeHan
         }
     }
 
+  /* one robot model for planning (not the real robot model), LP solver and nonlinear optimizer per start */
+  for(int i = 0; i < plan_starts_; i++)
+    {
+      auto context = boost::make_shared<PlanContext>();
+      context->planner = this;
+      context->robot_model = boost::make_shared<HydrusTiltedRobotModel>();
+      context->robot_model->setEarlyReject(true); // only the feasibility is necessary for planning
+      context->random_engine.seed(i);
+      initPlanContext(*context);
+      plan_contexts_.push_back(context);
+    }
+  robot_model_for_plan_ = plan_contexts_.at(0)->robot_model;
+
+  plan_thread_ = std::thread(boost::bind(&HydrusXiUnderActuatedNavigator::threadFunc, this));
+}
+
+void HydrusXiUnderActuatedNavigator::initPlanContext(PlanContext& context)
+{
   /* nonlinear optimization for vectoring angles planner */
-  vectoring_nl_solver_ = boost::make_shared<nlopt::opt>(nlopt::LN_COBYLA, control_gimbal_names_.size());
+  context.nl_solver = boost::make_shared<nlopt::opt>(nlopt::LN_COBYLA, control_gimbal_names_.size());
   if(maximize_yaw_)
     {
-      vectoring_nl_solver_->set_max_objective(maximizeMinYawTorque, this);
-      vectoring_nl_solver_->add_inequality_constraint(fcTMinConstraint, this, 1e-8);
+      context.nl_solver->set_max_objective(maximizeMinYawTorque, &context);
+      context.nl_solver->add_inequality_constraint(fcTMinConstraint, &context, 1e-8);
     }
   else
-    vectoring_nl_solver_->set_max_objective(maximizeFCTMin, this);
+    context.nl_solver->set_max_objective(maximizeFCTMin, &context);
+
+  context.nl_solver->add_inequality_constraint(baselinkRotConstraint, &context, 1e-8);
 
-  vectoring_nl_solver_->add_inequality_constraint(baselinkRotConstraint, this, 1e-8);
+  context.nl_solver->set_xtol_rel(1e-4); //1e-4
+  context.nl_solver->set_maxeval(1000); // 1000 times
+  if(plan_ftol_ > 0) context.nl_solver->set_ftol_abs(plan_ftol_);
+  if(plan_max_time_ > 0) context.nl_solver->set_maxtime(plan_max_time_);
 
-  vectoring_nl_solver_->set_xtol_rel(1e-4); //1e-4
-  vectoring_nl_solver_->set_maxeval(1000); // 1000 times
   /* linear optimization for yaw range */
-  double rotor_num = robot_model->getRotorNum();
+  double rotor_num = robot_model_->getRotorNum();
+  OsqpEigen::Solver& lp_solver = context.yaw_range_lp_solver;
 
   // settings the LP solver
-  yaw_range_lp_solver_.settings()->setVerbosity(false);
-  yaw_range_lp_solver_.settings()->setWarmStart(true);
+  lp_solver.settings()->setVerbosity(false);
+  lp_solver.settings()->setWarmStart(true);
 
   // set the initial data of the QP solver
-  yaw_range_lp_solver_.data()->setNumberOfVariables(rotor_num);
-  yaw_range_lp_solver_.data()->setNumberOfConstraints(rotor_num);
+  lp_solver.data()->setNumberOfVariables(rotor_num);
+  lp_solver.data()->setNumberOfConstraints(rotor_num);
 
   // allocate LP problem matrices and vectores
   Eigen::SparseMatrix<double> hessian;
@@ -221,20 +251,18 @@ void HydrusXiUnderActuatedNavigator::initialize(ros::NodeHandle nh, ros::NodeHan
   linear_cons.resize(rotor_num, rotor_num);
   for(int i = 0; i < linear_cons.cols(); i++) linear_cons.insert(i,i) = 1;
 
-  Eigen::VectorXd lower_bound = Eigen::VectorXd::Ones(rotor_num) * robot_model->getThrustLowerLimit();
-  Eigen::VectorXd upper_bound = Eigen::VectorXd::Ones(rotor_num) * robot_model->getThrustUpperLimit();
+  Eigen::VectorXd lower_bound = Eigen::VectorXd::Ones(rotor_num) * robot_model_->getThrustLowerLimit();
+  Eigen::VectorXd upper_bound = Eigen::VectorXd::Ones(rotor_num) * robot_model_->getThrustUpperLimit();
 
-  yaw_range_lp_solver_.data()->setHessianMatrix(hessian);
-  yaw_range_lp_solver_.data()->setGradient(gradient);
-  yaw_range_lp_solver_.data()->setLinearConstraintsMatrix(linear_cons);
-  yaw_range_lp_solver_.data()->setLowerBound(lower_bound);
-  yaw_range_lp_solver_.data()->setUpperBound(upper_bound);
+  lp_solver.data()->setHessianMatrix(hessian);
+  lp_solver.data()->setGradient(gradient);
+  lp_solver.data()->setLinearConstraintsMatrix(linear_cons);
+  lp_solver.data()->setLowerBound(lower_bound);
+  lp_solver.data()->setUpperBound(upper_bound);
 
   // instantiate the yaw_range_lp_solver
-  if(!yaw_range_lp_solver_.initSolver())
+  if(!lp_solver.initSolver())
     throw std::runtime_error("can not init LP solver based on osqp");
-
-  plan_thread_ = std::thread(boost::bind(&HydrusXiUnderActuatedNavigator::threadFunc, this));
 }
 
 void HydrusXiUnderActuatedNavigator::threadFunc()
@@ -256,6 +284,35 @@ void HydrusXiUnderActuatedNavigator::threadFunc()
     }
 }
 
+void HydrusXiUnderActuatedNavigator::solve(PlanContext& context, std::vector<double> x0, const std::vector<double>& lb, const std::vector<double>& ub)
+{
+  context.joint_positions = joint_positions_for_plan_;
+  context.cnt = 0;
+  context.invalid_cnt = 0;
+  context.feasible = false;
+
+  for(int i = 0; i < x0.size(); i++) x0.at(i) = std::clamp(x0.at(i), lb.at(i), ub.at(i));
+
+  try
+    {
+      context.nl_solver->set_lower_bounds(lb);
+      context.nl_solver->set_upper_bounds(ub);
+      context.nl_solver->optimize(x0, context.f);
+    }
+  catch(std::exception &e)
+    {
+      // the random starts often fail, only the warm start is reported
+      if(plan_verbose_ || &context == plan_contexts_.at(0).get()) std::cout << "nlopt failed: " << e.what() << std::endl;
+    }
+
+  /* evaluate the result again, since the model holds the last evaluation */
+  std::vector<double> grad;
+  context.f = maximize_yaw_ ? maximizeMinYawTorque(x0, grad, &context) : maximizeFCTMin(x0, grad, &context);
+  context.feasible = context.invalid_cnt == 0 && baselinkRotConstraint(x0, grad, &context) < feasibility_tol;
+  if(maximize_yaw_ && fcTMinConstraint(x0, grad, &context) > feasibility_tol) context.feasible = false;
+  context.x = x0;
+}
+
 bool HydrusXiUnderActuatedNavigator::plan()
 {
   joint_positions_for_plan_ = robot_model_->getJointPositions(); // real
@@ -284,6 +341,7 @@ bool HydrusXiUnderActuatedNavigator::plan()
   /* find the optimal gimbal vectoring angles from nlopt */
   std::vector<double> lb(control_gimbal_indices_.size(), - M_PI);
   std::vector<double> ub(control_gimbal_indices_.size(), M_PI);
+  const std::vector<double> global_lb = lb, global_ub = ub;
 
   /* update the range by using the last optimization result with the assumption that the motion is cotinuous */
   if(opt_gimbal_angles_.size() != 0)
@@ -328,42 +386,96 @@ bool HydrusXiUnderActuatedNavigator::plan()
         }
     }
 
-  vectoring_nl_solver_->set_lower_bounds(lb);
-  vectoring_nl_solver_->set_upper_bounds(ub);
+  ros::WallTime start_time = ros::WallTime::now();
 
-  double start_time = ros::Time::now().toSec();
-  double max_f = 0;
-  try
+  /* other starts in parallel with the warm start */
+  std::vector<std::thread> workers;
+  for(int i = 1; i < plan_contexts_.size(); i++)
     {
-      nlopt::result result = vectoring_nl_solver_->optimize(opt_gimbal_angles_, max_f);
+      PlanContext& context = *plan_contexts_.at(i);
+      std::vector<double> x0 = opt_gimbal_angles_;
+      bool predict = i == 1 && prev_opt_gimbal_angles_.size() == x0.size() && prev_opt_joint_positions_.rows() == joint_positions_for_plan_.rows();
+      if(predict)
+        {
+          /* follow the change of the solution per joint motion in the last period */
+          double prev_motion = (opt_joint_positions_.data - prev_opt_joint_positions_.data).norm();
+          double motion = (joint_positions_for_plan_.data - opt_joint_positions_.data).norm();
+          double rate = prev_motion > 1e-6 ? std::min(motion / prev_motion, 2.0) : 0;
+          for(int j = 0; j < x0.size(); j++)
+            x0.at(j) += rate * (opt_gimbal_angles_.at(j) - prev_opt_gimbal_angles_.at(j));
+          workers.emplace_back(&HydrusXiUnderActuatedNavigator::solve, this, std::ref(context), x0, lb, ub);
+        }
+      else
+        {
+          std::uniform_real_distribution<double> dist(-M_PI, M_PI);
+          for(auto& angle: x0) angle = dist(context.random_engine);
+          workers.emplace_back(&HydrusXiUnderActuatedNavigator::solve, this, std::ref(context), x0, global_lb, global_ub);
+        }
+    }
 
-      double roll,pitch,yaw;
-      robot_model_for_plan_->getCogDesireOrientation<KDL::Rotation>().GetRPY(roll, pitch, yaw);
+  PlanContext& warm_context = *plan_contexts_.at(0);
+  solve(warm_context, opt_gimbal_angles_, lb, ub);
+  for(auto& worker: workers) worker.join();
 
-      if(prev_opt_gimbal_angles_.size() == 0) prev_opt_gimbal_angles_ = opt_gimbal_angles_;
+  double solve_time = (ros::WallTime::now() - start_time).toSec();
 
-      if(plan_verbose_)
-        {
-          std::cout << "nlopt: " << std::setprecision(7)
-                    << ros::Time::now().toSec() - start_time  <<  "[sec], cnt: " << cnt;
-          std::cout << ", found optimal gimbal angles: ";
-          for(auto it: opt_gimbal_angles_) std::cout << std::setprecision(5) << it << " ";
-          std::cout << ", max min yaw: " << max_min_yaw_;
-          std::cout << ", fc t min: " << robot_model_for_plan_->getFeasibleControlTMin();
-          std::cout << ", atttidue: [" << roll << ", " << pitch;
-          std::cout << "], force: [" << robot_model_for_plan_->getStaticThrust().transpose();
-          std::cout << "]" << std::endl;
-        }
+  /* keep the warm-started solution unless an other start is clearly better, to avoid the jump of the gimbals */
+  int best = 0;
+  for(int i = 1; i < plan_contexts_.size(); i++)
+    {
+      const PlanContext& context = *plan_contexts_.at(i);
+      if(!context.feasible) continue;
+      const PlanContext& current = *plan_contexts_.at(best);
+      if(!current.feasible || context.f > current.f + (best == 0 ? plan_switch_thresh_ : 0)) best = i;
+    }
+  PlanContext& best_context = *plan_contexts_.at(best);
+
+  int eval_cnt = 0;
+  for(const auto& context: plan_contexts_) eval_cnt += context->cnt;
 
+  plan_cnt_++;
+  plan_eval_cnt_ += eval_cnt;
+  plan_time_sum_ += solve_time;
+  plan_time_max_ = std::max(plan_time_max_, solve_time);
+  if(!best_context.feasible) plan_fail_cnt_++;
 
-      cnt = 0;
-      invalid_cnt = 0;
+  if(best != 0)
+    {
+      plan_switch_cnt_++;
+      double improvement = warm_context.feasible ? best_context.f - warm_context.f : 0;
+      plan_improvement_sum_ += improvement;
+      plan_improvement_max_ = std::max(plan_improvement_max_, improvement);
+
+      /* the model for plan has the state of the solution, which is used in the next plan */
+      std::vector<double> grad;
+      if(maximize_yaw_) maximizeMinYawTorque(best_context.x, grad, &warm_context);
+      else maximizeFCTMin(best_context.x, grad, &warm_context);
     }
-  catch(std::exception &e)
+
+  prev_opt_gimbal_angles_ = opt_gimbal_angles_;
+  prev_opt_joint_positions_ = opt_joint_positions_;
+  opt_gimbal_angles_ = best_context.x;
+  opt_joint_positions_ = joint_positions_for_plan_;
+  max_min_yaw_ = best_context.max_min_yaw;
+
+  if(plan_verbose_)
     {
-      std::cout << "nlopt failed: " << e.what() << std::endl;
+      double roll,pitch,yaw;
+      robot_model_for_plan_->getCogDesireOrientation<KDL::Rotation>().GetRPY(roll, pitch, yaw);
+
+      std::cout << "nlopt: " << std::setprecision(7)
+                << solve_time <<  "[sec], cnt: " << eval_cnt << ", start: " << best;
+      std::cout << ", found optimal gimbal angles: ";
+      for(auto it: opt_gimbal_angles_) std::cout << std::setprecision(5) << it << " ";
+      std::cout << ", max min yaw: " << max_min_yaw_;
+      std::cout << ", fc t min: " << robot_model_for_plan_->getFeasibleControlTMin();
+      std::cout << ", atttidue: [" << roll << ", " << pitch;
+      std::cout << "], force: [" << robot_model_for_plan_->getStaticThrust().transpose();
+      std::cout << "]" << std::endl;
     }
 
+  publishPlanStats(best_context.f);
+
   /* publish the gimbal angles if necessary */
   sensor_msgs::JointState gimbal_msg;
   gimbal_msg.header.stamp = ros::Time::now();
@@ -375,11 +487,60 @@ bool HydrusXiUnderActuatedNavigator::plan()
     }
   gimbal_ctrl_pub_.publish(gimbal_msg);
 
-  prev_opt_gimbal_angles_ = opt_gimbal_angles_;
-
   return true;
 }
 
+void HydrusXiUnderActuatedNavigator::publishPlanStats(double objective)
+{
+  ros::WallTime now = ros::WallTime::now();
+  if(plan_stats_rate_ <= 0 || plan_cnt_ == 0) return;
+  if(plan_stats_stamp_.isZero()) plan_stats_stamp_ = now;
+  if((now - plan_stats_stamp_).toSec() < 1.0 / plan_stats_rate_) return;
+  plan_stats_stamp_ = now;
+
+  diagnostic_msgs::DiagnosticStatus status;
+  status.name = "vectoring_planner";
+  status.hardware_id = nh_.getNamespace();
+  if(plan_fail_cnt_ > 0)
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+      status.message = std::to_string(plan_fail_cnt_) + " plans failed";
+    }
+  else
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::OK;
+      status.message = "OK";
+    }
+
+  auto add_value = [&status](const std::string& key, const std::string& value)
+    {
+      diagnostic_msgs::KeyValue kv;
+      kv.key = key;
+      kv.value = value;
+      status.values.push_back(kv);
+    };
+  add_value("starts", std::to_string(plan_contexts_.size()));
+  add_value("plans", std::to_string(plan_cnt_));
+  add_value("failed", std::to_string(plan_fail_cnt_));
+  add_value("mean_solve_time_ms", std::to_string(plan_time_sum_ / plan_cnt_ * 1000));
+  add_value("max_solve_time_ms", std::to_string(plan_time_max_ * 1000));
+  add_value("mean_evaluations", std::to_string((double)plan_eval_cnt_ / plan_cnt_));
+  add_value("objective", std::to_string(objective));
+  add_value("switched_start", std::to_string(plan_switch_cnt_));
+  add_value("mean_improvement", std::to_string(plan_switch_cnt_ > 0 ? plan_improvement_sum_ / plan_switch_cnt_ : 0.0));
+  add_value("max_improvement", std::to_string(plan_improvement_max_));
+
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+  msg.status.push_back(status);
+  plan_stats_pub_.publish(msg);
+
+  plan_cnt_ = plan_fail_cnt_ = plan_switch_cnt_ = 0;
+  plan_eval_cnt_ = 0;
+  plan_time_sum_ = plan_time_max_ = 0;
+  plan_improvement_sum_ = plan_improvement_max_ = 0;
+}
+
 void HydrusXiUnderActuatedNavigator::rosParamInit()
 {
   BaseNavigator::rosParamInit();
@@ -393,6 +554,12 @@ void HydrusXiUnderActuatedNavigator::rosParamInit()
   getParam<double>(navi_nh, "fc_t_min_weight", fc_t_min_weight_, 1.0);
   getParam<double>(navi_nh, "baselink_rot_thresh", baselink_rot_thresh_, 0.02);
   getParam<double>(navi_nh, "fc_t_min_thresh", fc_t_min_thresh_, 2.0);
+  getParam<int>(navi_nh, "plan_starts", plan_starts_, 1);
+  getParam<double>(navi_nh, "plan_ftol", plan_ftol_, 0.0);
+  getParam<double>(navi_nh, "plan_max_time", plan_max_time_, 0.0);
+  getParam<double>(navi_nh, "plan_switch_thresh", plan_switch_thresh_, 0.01);
+  getParam<double>(navi_nh, "plan_stats_rate", plan_stats_rate_, 1.0);
+  plan_starts_ = std::max(plan_starts_, 1);
 }
 
 /* plugin registration */